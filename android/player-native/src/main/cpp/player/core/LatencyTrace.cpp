@@ -0,0 +1,207 @@
+#include "player/core/LatencyTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace reallive::player {
+
+namespace {
+
+constexpr size_t kTimingPayloadSize = 16 + 8 + 8 + 6 * 4;
+
+// "RealLiveTimeSEI2"
+constexpr uint8_t kTimingUuid[16] = {
+    0x52, 0x65, 0x61, 0x6C, 0x4C, 0x69, 0x76, 0x65,
+    0x54, 0x69, 0x6D, 0x65, 0x53, 0x45, 0x49, 0x32
+};
+
+uint64_t readLE(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i += 1) {
+        v |= static_cast<uint64_t>(p[i]) << (i * 8);
+    }
+    return v;
+}
+
+bool parseSei(const uint8_t* nal, size_t size, FrameTiming& out) {
+    if (!nal || size < 3 || (nal[0] & 0x1F) != 0x06) return false;
+
+    uint8_t rbsp[2 + kTimingPayloadSize];
+    size_t n = 0;
+    int zeros = 0;
+    for (size_t i = 1; i < size && n < sizeof(rbsp); i += 1) {
+        const uint8_t b = nal[i];
+        if (zeros >= 2 && b == 0x03) {
+            zeros = 0;
+            continue;
+        }
+        rbsp[n++] = b;
+        zeros = (b == 0x00) ? zeros + 1 : 0;
+    }
+    if (n < sizeof(rbsp) || rbsp[0] != 0x05 || rbsp[1] != kTimingPayloadSize) return false;
+    if (std::memcmp(rbsp + 2, kTimingUuid, sizeof(kTimingUuid)) != 0) return false;
+
+    const uint8_t* p = rbsp + 18;
+    out.sensorUs = static_cast<int64_t>(readLE(p, 8));
+    out.sentUs = static_cast<int64_t>(readLE(p + 8, 8));
+    out.captureUs = static_cast<uint32_t>(readLE(p + 16, 4));
+    out.overlayUs = static_cast<uint32_t>(readLE(p + 20, 4));
+    out.encodeUs = static_cast<uint32_t>(readLE(p + 24, 4));
+    out.queueUs = static_cast<uint32_t>(readLE(p + 28, 4));
+    out.sendUs = static_cast<uint32_t>(readLE(p + 32, 4));
+    out.frameSeq = static_cast<uint32_t>(readLE(p + 36, 4));
+    return true;
+}
+
+size_t findStartCode(const uint8_t* data, size_t size, size_t from) {
+    for (size_t i = from; i + 3 <= size; i += 1) {
+        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01) return i;
+    }
+    return size;
+}
+
+bool isVcl(uint8_t nalHeader) {
+    const uint8_t type = nalHeader & 0x1F;
+    return type >= 1 && type <= 5;
+}
+
+}  // namespace
+
+void LatencyHistogram::add(int64_t us) {
+    if (us < 0) us = 0;
+    const int64_t ms = us / 1000;
+    size_t bucket = 0;
+    while (bucket < kBoundsMs.size() && ms >= kBoundsMs[bucket]) bucket += 1;
+    buckets_[bucket] += 1;
+    count_ += 1;
+    maxUs_ = std::max(maxUs_, us);
+}
+
+void LatencyHistogram::reset() {
+    buckets_.fill(0);
+    count_ = 0;
+    maxUs_ = 0;
+}
+
+double LatencyHistogram::percentileMs(double q) const {
+    if (count_ == 0) return 0.0;
+    const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); i += 1) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            if (i == kBoundsMs.size()) return maxMs();
+            return std::min(static_cast<double>(kBoundsMs[i]), maxMs());
+        }
+    }
+    return maxMs();
+}
+
+int64_t LatencyTrace::wallClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool LatencyTrace::extract(const uint8_t* data, size_t size, FrameTiming& out) {
+    if (!data || size < 5) return false;
+
+    const bool annexB = data[0] == 0x00 && data[1] == 0x00 &&
+                        (data[2] == 0x01 || (data[2] == 0x00 && data[3] == 0x01));
+    if (annexB) {
+        size_t pos = findStartCode(data, size, 0);
+        while (pos < size) {
+            const size_t nalStart = pos + 3;
+            const size_t next = findStartCode(data, size, nalStart);
+            if (nalStart < size) {
+                if (isVcl(data[nalStart])) return false;
+                if (parseSei(data + nalStart, next - nalStart, out)) return true;
+            }
+            pos = next;
+        }
+        return false;
+    }
+
+    // FLV/MP4 demuxers hand out AVCC (4-byte length prefixed) packets.
+    size_t pos = 0;
+    while (pos + 4 < size) {
+        const size_t len = (static_cast<size_t>(data[pos]) << 24) | (static_cast<size_t>(data[pos + 1]) << 16) |
+                           (static_cast<size_t>(data[pos + 2]) << 8) | static_cast<size_t>(data[pos + 3]);
+        pos += 4;
+        if (len == 0 || len > size - pos) return false;
+        if (isVcl(data[pos])) return false;
+        if (parseSei(data + pos, len, out)) return true;
+        pos += len;
+    }
+    return false;
+}
+
+void LatencyTrace::onPacket(int64_t pts, const FrameTiming& timing, int64_t nowUs) {
+    if (timing.sensorUs <= 0 || timing.sentUs < timing.sensorUs) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    device_.add(timing.sentUs - timing.sensorUs);
+    network_.add(nowUs - timing.sentUs);
+    pending_[pendingNext_] = Pending{pts, timing.sensorUs, nowUs};
+    pendingNext_ = (pendingNext_ + 1) % pending_.size();
+}
+
+int64_t LatencyTrace::onDecoded(int64_t pts, int64_t nowUs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& p : pending_) {
+        if (p.sensorUs == 0 || p.pts != pts) continue;
+        decode_.add(nowUs - p.recvUs);
+        const int64_t sensorUs = p.sensorUs;
+        p = Pending{};
+        return sensorUs;
+    }
+    return 0;
+}
+
+void LatencyTrace::onRendered(int64_t sensorUs, int64_t nowUs) {
+    if (sensorUs <= 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    glass_.add(nowUs - sensorUs);
+}
+
+std::string LatencyTrace::takeSummary(int64_t nowUs, int intervalSec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (windowStartUs_ == 0) {
+        windowStartUs_ = nowUs;
+        return {};
+    }
+    if (nowUs - windowStartUs_ < static_cast<int64_t>(intervalSec) * 1000000) return {};
+    windowStartUs_ = nowUs;
+    if (device_.count() == 0) return {};
+
+    char buf[384];
+    std::snprintf(
+        buf,
+        sizeof(buf),
+        "frames=%llu device p50=%.0f p95=%.0f max=%.1f | network p50=%.0f p95=%.0f max=%.1f | "
+        "decode p50=%.0f p95=%.0f max=%.1f | glass p50=%.0f p95=%.0f max=%.1f (ms)",
+        static_cast<unsigned long long>(device_.count()),
+        device_.percentileMs(0.5), device_.percentileMs(0.95), device_.maxMs(),
+        network_.percentileMs(0.5), network_.percentileMs(0.95), network_.maxMs(),
+        decode_.percentileMs(0.5), decode_.percentileMs(0.95), decode_.maxMs(),
+        glass_.percentileMs(0.5), glass_.percentileMs(0.95), glass_.maxMs()
+    );
+    device_.reset();
+    network_.reset();
+    decode_.reset();
+    glass_.reset();
+    return buf;
+}
+
+void LatencyTrace::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.fill(Pending{});
+    pendingNext_ = 0;
+    device_.reset();
+    network_.reset();
+    decode_.reset();
+    glass_.reset();
+    windowStartUs_ = 0;
+}
+
+}  // namespace reallive::player
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace reallive::player {
+
+// Per-frame timing from the pusher's "RealLiveTimeSEI2" SEI. Absolute times
+// are wall-clock microseconds, stage times are durations.
+struct FrameTiming {
+    int64_t sensorUs = 0;
+    int64_t sentUs = 0;
+    uint32_t captureUs = 0;
+    uint32_t overlayUs = 0;
+    uint32_t encodeUs = 0;
+    uint32_t queueUs = 0;
+    uint32_t sendUs = 0;
+    uint32_t frameSeq = 0;
+};
+
+// Fixed-bucket latency histogram in milliseconds.
+class LatencyHistogram {
+public:
+    static constexpr std::array<int64_t, 14> kBoundsMs = {
+        5, 10, 20, 35, 50, 75, 100, 150, 200, 300, 500, 750, 1000, 2000};
+
+    void add(int64_t us);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    double maxMs() const { return static_cast<double>(maxUs_) / 1000.0; }
+    double percentileMs(double q) const;
+
+private:
+    std::array<uint64_t, kBoundsMs.size() + 1> buckets_{};
+    uint64_t count_ = 0;
+    int64_t maxUs_ = 0;
+};
+
+// Capture-to-glass latency per hop, fed from the demux, decode and render
+// threads:
+//   device  = sensor -> sent by the pusher
+//   network = sent -> demuxed here
+//   decode  = demuxed -> decoded and converted
+//   glass   = sensor -> first swap showing the frame
+// Cross-host hops assume NTP-synced wall clocks.
+class LatencyTrace {
+public:
+    static bool extract(const uint8_t* data, size_t size, FrameTiming& out);
+    static int64_t wallClockUs();
+
+    void onPacket(int64_t pts, const FrameTiming& timing, int64_t nowUs);
+    // Returns the frame's sensor time (0 if it carried no timing).
+    int64_t onDecoded(int64_t pts, int64_t nowUs);
+    void onRendered(int64_t sensorUs, int64_t nowUs);
+
+    // One-line summary once |intervalSec| has passed, empty otherwise.
+    std::string takeSummary(int64_t nowUs, int intervalSec = 10);
+    void reset();
+
+private:
+    struct Pending {
+        int64_t pts = 0;
+        int64_t sensorUs = 0;
+        int64_t recvUs = 0;
+    };
+
+    std::mutex mutex_;
+    std::array<Pending, 16> pending_{};
+    size_t pendingNext_ = 0;
+    LatencyHistogram device_;
+    LatencyHistogram network_;
+    LatencyHistogram decode_;
+    LatencyHistogram glass_;
+    int64_t windowStartUs_ = 0;
+};
+
+}  // namespace reallive::player
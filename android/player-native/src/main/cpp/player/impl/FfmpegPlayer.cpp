@@ -1,4 +1,5 @@
 #include "player/impl/FfmpegPlayer.h"
+#include "player/core/LatencyTrace.h"
 
 #include <android/log.h>
 #include <android/native_window.h>
@@ -78,6 +79,7 @@ struct NativePlayerContext {
     uint64_t statsLastRendered = 0;
     double decodeFps = 0.0;
     double renderFps = 0.0;
+    LatencyTrace latency;
 
     std::string liveUrl;
     std::string historyUrl;
@@ -89,6 +91,7 @@ struct NativePlayerContext {
     int frameWidth = 0;
     int frameHeight = 0;
     uint64_t frameSerial = 0;
+    int64_t frameSensorUs = 0;
     bool frameReady = false;
     bool loggedFirstViewport = false;
 };
@@ -542,6 +545,7 @@ void renderLoop(NativePlayerContext* ctx) {
     std::vector<uint8_t> localFrame;
     int localW = 0;
     int localH = 0;
+    int64_t localSensorUs = 0;
 
     while (ctx->running.load()) {
         bool isPlaying = ctx->playing.load();
@@ -555,6 +559,7 @@ void renderLoop(NativePlayerContext* ctx) {
                     localFrame = ctx->frameRgba;
                     localW = ctx->frameWidth;
                     localH = ctx->frameHeight;
+                    localSensorUs = ctx->frameSensorUs;
                 } else {
                     localFrame.clear();
                     localW = 0;
@@ -624,6 +629,11 @@ void renderLoop(NativePlayerContext* ctx) {
                         const EGLint eglErr = eglGetError();
                         RL_LOGE("eglSwapBuffers failed: 0x%x", static_cast<unsigned>(eglErr));
                     } else {
+                        if (hasFrame && localSensorUs > 0) {
+                            // Only the first swap showing a frame counts as its glass time.
+                            ctx->latency.onRendered(localSensorUs, LatencyTrace::wallClockUs());
+                            localSensorUs = 0;
+                        }
                         const auto swaps = ctx->swapCount.fetch_add(1, std::memory_order_relaxed) + 1;
                         if (swaps % kFrameLogInterval == 0) {
                             RL_LOGI(
@@ -711,6 +721,7 @@ void closeDecoder(DecoderSession& s) {
 
 bool openDecoder(NativePlayerContext* ctx, DecoderSession& s, const std::string& url, PlayMode mode, uint64_t serial) {
     closeDecoder(s);
+    ctx->latency.reset();
 
     s.fmtCtx = avformat_alloc_context();
     if (!s.fmtCtx) {
@@ -904,7 +915,7 @@ bool ensureScaler(DecoderSession& s, AVFrame* srcFrame) {
     return true;
 }
 
-void pushFrameToRender(NativePlayerContext* ctx, DecoderSession& s) {
+void pushFrameToRender(NativePlayerContext* ctx, DecoderSession& s, int64_t sensorUs) {
     const int width = s.swsWidth;
     const int height = s.swsHeight;
     if (width <= 0 || height <= 0) return;
@@ -926,6 +937,7 @@ void pushFrameToRender(NativePlayerContext* ctx, DecoderSession& s) {
 
     ctx->frameWidth = width;
     ctx->frameHeight = height;
+    ctx->frameSensorUs = sensorUs;
     ctx->frameReady = true;
     ctx->frameSerial += 1;
     const auto queued = ctx->queuedFrameCount.fetch_add(1, std::memory_order_relaxed) + 1;
@@ -1072,6 +1084,13 @@ void decodeLoop(NativePlayerContext* ctx) {
                     session.packet->flags
                 );
             }
+            // Timing SEI only describes live latency; recorded segments replay old stamps.
+            if (mode == PlayMode::Live && session.packet->data && session.packet->size > 0) {
+                FrameTiming timing;
+                if (LatencyTrace::extract(session.packet->data, static_cast<size_t>(session.packet->size), timing)) {
+                    ctx->latency.onPacket(session.packet->pts, timing, LatencyTrace::wallClockUs());
+                }
+            }
             ret = avcodec_send_packet(session.codecCtx, session.packet);
             if (ret < 0 && ret != AVERROR(EAGAIN)) {
                 RL_LOGE("avcodec_send_packet failed: %d", ret);
@@ -1145,7 +1164,10 @@ void decodeLoop(NativePlayerContext* ctx) {
                         }
                     }
 
-                    pushFrameToRender(ctx, session);
+                    const int64_t sensorUs = mode == PlayMode::Live
+                        ? ctx->latency.onDecoded(session.frame->pts, LatencyTrace::wallClockUs())
+                        : 0;
+                    pushFrameToRender(ctx, session, sensorUs);
                     ctx->decodedFrameCount.fetch_add(1, std::memory_order_relaxed);
                     session.decodedFrames += 1;
                     setRuntimeState(ctx, PlaybackState::Playing, "decoded-frame-ready");
@@ -1158,6 +1180,12 @@ void decodeLoop(NativePlayerContext* ctx) {
                             static_cast<unsigned long long>(ctx->renderedFrameCount.load(std::memory_order_relaxed))
                         );
                     }
+                    if (sensorUs > 0) {
+                        const std::string latencySummary = ctx->latency.takeSummary(LatencyTrace::wallClockUs());
+                        if (!latencySummary.empty()) {
+                            RL_LOGI("latency %s", latencySummary.c_str());
+                        }
+                    }
                     if (!session.loggedFirstDecodedFrame) {
                         session.loggedFirstDecodedFrame = true;
                         RL_LOGI(
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace reallive {
+namespace puller {
+
+/// Per-frame timing parsed from the pusher's "RealLiveTimeSEI2" SEI.
+/// Absolute times are wall-clock microseconds, stage times are durations.
+struct FrameTiming {
+    int64_t sensorUs = 0;
+    int64_t sentUs = 0;
+    uint32_t captureUs = 0;
+    uint32_t overlayUs = 0;
+    uint32_t encodeUs = 0;
+    uint32_t queueUs = 0;
+    uint32_t sendUs = 0;
+    uint32_t frameSeq = 0;
+};
+
+/// Fixed-bucket latency histogram (milliseconds), cheap enough to update
+/// per frame and to estimate percentiles from.
+class LatencyHistogram {
+public:
+    static constexpr std::array<int64_t, 14> kBoundsMs = {
+        5, 10, 20, 35, 50, 75, 100, 150, 200, 300, 500, 750, 1000, 2000};
+
+    void add(int64_t us);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    double avgMs() const;
+    double maxMs() const { return static_cast<double>(maxUs_) / 1000.0; }
+    /// Upper bound of the bucket holding quantile |q| (0..1).
+    double percentileMs(double q) const;
+
+private:
+    std::array<uint64_t, kBoundsMs.size() + 1> buckets_{};
+    uint64_t count_ = 0;
+    int64_t sumUs_ = 0;
+    int64_t maxUs_ = 0;
+};
+
+/// Extracts timing SEI from received H.264 packets (Annex-B or AVCC) and
+/// keeps per-hop latency histograms:
+///   device  = sensor -> handed to the streamer (pusher internal)
+///   network = handed to the streamer -> received here
+///   total   = sensor -> received here
+/// Cross-host hops assume NTP-synced wall clocks.
+class LatencyTrace {
+public:
+    /// Scan one video packet; returns true if it carried a timing SEI.
+    bool observe(const uint8_t* data, size_t size, int64_t recvWallUs);
+
+    /// Log and reset the window once |intervalSec| has passed.
+    void maybeReport(int64_t nowWallUs, int intervalSec = 10);
+
+    static bool parseSei(const uint8_t* nal, size_t size, FrameTiming& out);
+    static int64_t wallClockUs();
+
+private:
+    void record(const FrameTiming& timing, int64_t recvWallUs);
+
+    LatencyHistogram device_;
+    LatencyHistogram network_;
+    LatencyHistogram total_;
+    std::array<uint64_t, 5> stageSumUs_{};
+    uint32_t lastSeq_ = 0;
+    uint64_t seqGaps_ = 0;
+    int64_t windowStartUs_ = 0;
+};
+
+} // namespace puller
+} // namespace reallive
@@ -4,6 +4,7 @@
 #include "../platform/IDecoder.h"
 #include "../platform/IStorage.h"
 #include "Config.h"
+#include "LatencyTrace.h"
 
 #include <atomic>
 #include <memory>
@@ -46,6 +47,7 @@ private:
     std::unique_ptr<IDecoder> decoder_;
     std::unique_ptr<IStorage> storage_;
     StreamInfo streamInfo_;
+    LatencyTrace latencyTrace_;
 
     std::thread workerThread_;
     std::atomic<bool> running_{false};
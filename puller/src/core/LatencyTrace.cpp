@@ -0,0 +1,221 @@
+#include "core/LatencyTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace reallive {
+namespace puller {
+
+namespace {
+
+constexpr size_t kTimingPayloadSize = 16 + 8 + 8 + 6 * 4;
+
+// "RealLiveTimeSEI2"
+constexpr uint8_t kTimingUuid[16] = {
+    0x52, 0x65, 0x61, 0x6C, 0x4C, 0x69, 0x76, 0x65,
+    0x54, 0x69, 0x6D, 0x65, 0x53, 0x45, 0x49, 0x32
+};
+
+uint64_t readLE(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) {
+        v |= static_cast<uint64_t>(p[i]) << (i * 8);
+    }
+    return v;
+}
+
+bool isAnnexB(const uint8_t* data, size_t size) {
+    return size >= 4 && data[0] == 0x00 && data[1] == 0x00 &&
+           (data[2] == 0x01 || (data[2] == 0x00 && data[3] == 0x01));
+}
+
+// Offset of the next 00 00 01 start code at or after |from|, or |size|.
+size_t findStartCode(const uint8_t* data, size_t size, size_t from) {
+    for (size_t i = from; i + 3 <= size; i++) {
+        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01) return i;
+    }
+    return size;
+}
+
+} // namespace
+
+void LatencyHistogram::add(int64_t us) {
+    if (us < 0) us = 0;
+    const int64_t ms = us / 1000;
+    size_t bucket = 0;
+    while (bucket < kBoundsMs.size() && ms >= kBoundsMs[bucket]) bucket++;
+    buckets_[bucket]++;
+    count_++;
+    sumUs_ += us;
+    maxUs_ = std::max(maxUs_, us);
+}
+
+void LatencyHistogram::reset() {
+    buckets_.fill(0);
+    count_ = 0;
+    sumUs_ = 0;
+    maxUs_ = 0;
+}
+
+double LatencyHistogram::avgMs() const {
+    if (count_ == 0) return 0.0;
+    return static_cast<double>(sumUs_) / static_cast<double>(count_) / 1000.0;
+}
+
+double LatencyHistogram::percentileMs(double q) const {
+    if (count_ == 0) return 0.0;
+    const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); i++) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            // The overflow bucket has no upper bound; report the max instead.
+            if (i == kBoundsMs.size()) return maxMs();
+            return std::min(static_cast<double>(kBoundsMs[i]), maxMs());
+        }
+    }
+    return maxMs();
+}
+
+int64_t LatencyTrace::wallClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool LatencyTrace::parseSei(const uint8_t* nal, size_t size, FrameTiming& out) {
+    if (!nal || size < 3 || (nal[0] & 0x1F) != 0x06) return false;
+
+    // Unescape just the first SEI message: type + size + payload.
+    uint8_t rbsp[2 + kTimingPayloadSize];
+    size_t n = 0;
+    int zeros = 0;
+    for (size_t i = 1; i < size && n < sizeof(rbsp); i++) {
+        const uint8_t b = nal[i];
+        if (zeros >= 2 && b == 0x03) {
+            zeros = 0;
+            continue;
+        }
+        rbsp[n++] = b;
+        zeros = (b == 0x00) ? zeros + 1 : 0;
+    }
+    if (n < sizeof(rbsp) || rbsp[0] != 0x05 || rbsp[1] != kTimingPayloadSize) return false;
+    if (std::memcmp(rbsp + 2, kTimingUuid, sizeof(kTimingUuid)) != 0) return false;
+
+    const uint8_t* p = rbsp + 18;
+    out.sensorUs = static_cast<int64_t>(readLE(p, 8)); p += 8;
+    out.sentUs = static_cast<int64_t>(readLE(p, 8)); p += 8;
+    out.captureUs = static_cast<uint32_t>(readLE(p, 4)); p += 4;
+    out.overlayUs = static_cast<uint32_t>(readLE(p, 4)); p += 4;
+    out.encodeUs = static_cast<uint32_t>(readLE(p, 4)); p += 4;
+    out.queueUs = static_cast<uint32_t>(readLE(p, 4)); p += 4;
+    out.sendUs = static_cast<uint32_t>(readLE(p, 4)); p += 4;
+    out.frameSeq = static_cast<uint32_t>(readLE(p, 4));
+    return true;
+}
+
+bool LatencyTrace::observe(const uint8_t* data, size_t size, int64_t recvWallUs) {
+    if (!data || size < 5) return false;
+
+    FrameTiming timing;
+    if (isAnnexB(data, size)) {
+        size_t pos = findStartCode(data, size, 0);
+        while (pos < size) {
+            const size_t nalStart = pos + 3;
+            const size_t next = findStartCode(data, size, nalStart);
+            // SEI precedes the slices, so stop at the first VCL NAL.
+            if (nalStart < size) {
+                const uint8_t nalType = data[nalStart] & 0x1F;
+                if (nalType >= 1 && nalType <= 5) break;
+                if (parseSei(data + nalStart, next - nalStart, timing)) {
+                    record(timing, recvWallUs);
+                    return true;
+                }
+            }
+            pos = next;
+        }
+        return false;
+    }
+
+    size_t pos = 0;
+    while (pos + 4 < size) {
+        const size_t len = (static_cast<size_t>(data[pos]) << 24) | (static_cast<size_t>(data[pos + 1]) << 16) |
+                           (static_cast<size_t>(data[pos + 2]) << 8) | static_cast<size_t>(data[pos + 3]);
+        pos += 4;
+        if (len == 0 || len > size - pos) break;
+        const uint8_t nalType = data[pos] & 0x1F;
+        if (nalType >= 1 && nalType <= 5) break;
+        if (parseSei(data + pos, len, timing)) {
+            record(timing, recvWallUs);
+            return true;
+        }
+        pos += len;
+    }
+    return false;
+}
+
+void LatencyTrace::record(const FrameTiming& timing, int64_t recvWallUs) {
+    if (timing.sensorUs <= 0 || timing.sentUs < timing.sensorUs) return;
+
+    device_.add(timing.sentUs - timing.sensorUs);
+    network_.add(recvWallUs - timing.sentUs);
+    total_.add(recvWallUs - timing.sensorUs);
+    stageSumUs_[0] += timing.captureUs;
+    stageSumUs_[1] += timing.overlayUs;
+    stageSumUs_[2] += timing.encodeUs;
+    stageSumUs_[3] += timing.queueUs;
+    stageSumUs_[4] += timing.sendUs;
+
+    // Pusher-side drops show up as holes in the frame sequence.
+    if (lastSeq_ != 0 && timing.frameSeq > lastSeq_ + 1) {
+        seqGaps_ += timing.frameSeq - lastSeq_ - 1;
+    }
+    lastSeq_ = timing.frameSeq;
+}
+
+void LatencyTrace::maybeReport(int64_t nowWallUs, int intervalSec) {
+    if (windowStartUs_ == 0) {
+        windowStartUs_ = nowWallUs;
+        return;
+    }
+    if (nowWallUs - windowStartUs_ < static_cast<int64_t>(intervalSec) * 1000000) return;
+    windowStartUs_ = nowWallUs;
+
+    const uint64_t frames = total_.count();
+    if (frames == 0) return;
+
+    // Formatted apart so the fixed/precision flags stay off std::cout.
+    std::ostringstream line;
+    auto hop = [&line](const char* name, const LatencyHistogram& h) {
+        line << " | " << name << " p50=" << h.percentileMs(0.5)
+             << " p95=" << h.percentileMs(0.95)
+             << " max=" << h.maxMs() << "ms";
+    };
+    auto stageAvg = [&](size_t i) {
+        return static_cast<double>(stageSumUs_[i]) / static_cast<double>(frames) / 1000.0;
+    };
+
+    line << "[Latency] frames=" << frames << std::fixed << std::setprecision(1);
+    hop("device", device_);
+    hop("network", network_);
+    hop("total", total_);
+    line << " | stages avg capture=" << stageAvg(0)
+         << " overlay=" << stageAvg(1)
+         << " encode=" << stageAvg(2)
+         << " queue=" << stageAvg(3)
+         << " send=" << stageAvg(4) << "ms"
+         << " | seq_gaps=" << seqGaps_;
+    std::cout << line.str() << std::endl;
+
+    device_.reset();
+    network_.reset();
+    total_.reset();
+    stageSumUs_.fill(0);
+    seqGaps_ = 0;
+}
+
+} // namespace puller
+} // namespace reallive
@@ -125,6 +125,12 @@ void PullPipeline::workerLoop() {
             break;
         }
 
+        if (packet.type == MediaType::Video) {
+            const int64_t recvWallUs = LatencyTrace::wallClockUs();
+            latencyTrace_.observe(packet.data.data(), packet.data.size(), recvWallUs);
+            latencyTrace_.maybeReport(recvWallUs);
+        }
+
         // Check if we need to rotate to a new segment
         auto now = std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::steady_clock::now().time_since_epoch()).count();
@@ -0,0 +1,147 @@
+/**
+ * Puller Latency Trace Tests
+ *
+ * Feeds timing SEI written by the pusher's own SeiTimestamp::inject()
+ * through the puller's LatencyTrace parser, in both Annex-B and AVCC
+ * framing, including payloads that need emulation-prevention bytes.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+#include "core/LatencyTrace.h"
+#include "core/SeiTimestamp.h"  // pusher side, header-only
+
+namespace pusher = reallive;
+using namespace reallive::puller;
+
+namespace {
+
+const std::vector<uint8_t> kIdrSlice = {0x65, 0x88, 0x84, 0x21, 0xA0};
+
+pusher::EncodedPacket makePacket(bool annexB) {
+    pusher::EncodedPacket packet;
+    packet.offset = pusher::EncodedPacket::kHeadroom;
+    packet.data.assign(packet.offset, 0);
+    if (annexB) {
+        packet.data.insert(packet.data.end(), {0x00, 0x00, 0x00, 0x01});
+    } else {
+        packet.data.insert(packet.data.end(), {0x00, 0x00, 0x00, static_cast<uint8_t>(kIdrSlice.size())});
+    }
+    packet.data.insert(packet.data.end(), kIdrSlice.begin(), kIdrSlice.end());
+    return packet;
+}
+
+pusher::FrameTiming sampleTiming() {
+    pusher::FrameTiming t;
+    t.sensorUs = 1700000000123456LL;
+    t.sentUs = 1700000000156789LL;
+    t.captureUs = 4100;
+    t.overlayUs = 900;
+    t.encodeUs = 12000;
+    t.queueUs = 300;
+    t.sendUs = 700;
+    t.frameSeq = 42;
+    return t;
+}
+
+void expectSame(const pusher::FrameTiming& in, const FrameTiming& out) {
+    EXPECT_EQ(out.sensorUs, in.sensorUs);
+    EXPECT_EQ(out.sentUs, in.sentUs);
+    EXPECT_EQ(out.captureUs, in.captureUs);
+    EXPECT_EQ(out.overlayUs, in.overlayUs);
+    EXPECT_EQ(out.encodeUs, in.encodeUs);
+    EXPECT_EQ(out.queueUs, in.queueUs);
+    EXPECT_EQ(out.sendUs, in.sendUs);
+    EXPECT_EQ(out.frameSeq, in.frameSeq);
+}
+
+bool hasEmulationPrevention(const uint8_t* data, size_t size) {
+    for (size_t i = 2; i < size; i++) {
+        if (data[i - 2] == 0x00 && data[i - 1] == 0x00 && data[i] == 0x03) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+TEST(LatencyTraceTest, ParsesAnnexBTimingSei) {
+    pusher::EncodedPacket packet = makePacket(true);
+    const pusher::FrameTiming in = sampleTiming();
+    pusher::SeiTimestamp::inject(packet, in);
+
+    // 00 00 00 01 | SEI NAL | 00 00 00 01 | slice
+    const uint8_t* nal = packet.bytes() + 4;
+    const size_t nalSize = packet.size() - 4 - 4 - kIdrSlice.size();
+    FrameTiming out;
+    ASSERT_TRUE(LatencyTrace::parseSei(nal, nalSize, out));
+    expectSame(in, out);
+
+    LatencyTrace trace;
+    EXPECT_TRUE(trace.observe(packet.bytes(), packet.size(), in.sentUs + 5000));
+}
+
+TEST(LatencyTraceTest, ParsesAvccTimingSei) {
+    pusher::EncodedPacket packet = makePacket(false);
+    const pusher::FrameTiming in = sampleTiming();
+    pusher::SeiTimestamp::inject(packet, in);
+
+    const uint8_t* p = packet.bytes();
+    const size_t nalSize = (static_cast<size_t>(p[0]) << 24) | (static_cast<size_t>(p[1]) << 16) |
+                           (static_cast<size_t>(p[2]) << 8) | p[3];
+    ASSERT_EQ(4 + nalSize + 4 + kIdrSlice.size(), packet.size());
+    FrameTiming out;
+    ASSERT_TRUE(LatencyTrace::parseSei(p + 4, nalSize, out));
+    expectSame(in, out);
+
+    LatencyTrace trace;
+    EXPECT_TRUE(trace.observe(packet.bytes(), packet.size(), in.sentUs + 5000));
+}
+
+TEST(LatencyTraceTest, UnescapesEmulationPreventionBytes) {
+    pusher::EncodedPacket packet = makePacket(true);
+    pusher::FrameTiming in;
+    // Runs of zero bytes followed by 0x00..0x03 force escaping.
+    in.sensorUs = 0x0000000100000002LL;
+    in.sentUs = 0x0000000300000001LL;
+    in.captureUs = 0;
+    in.overlayUs = 1;
+    in.encodeUs = 0x00000300;
+    in.queueUs = 0;
+    in.sendUs = 2;
+    in.frameSeq = 3;
+    pusher::SeiTimestamp::inject(packet, in);
+
+    const uint8_t* nal = packet.bytes() + 4;
+    const size_t nalSize = packet.size() - 4 - 4 - kIdrSlice.size();
+    ASSERT_TRUE(hasEmulationPrevention(nal, nalSize));
+    ASSERT_GT(nalSize, 3 + pusher::SeiTimestamp::kPayloadSize + 1);
+    FrameTiming out;
+    ASSERT_TRUE(LatencyTrace::parseSei(nal, nalSize, out));
+    expectSame(in, out);
+}
+
+TEST(LatencyTraceTest, RejectsForeignSei) {
+    pusher::EncodedPacket packet = makePacket(true);
+    pusher::SeiTimestamp::inject(packet, sampleTiming());
+    std::vector<uint8_t> nal(packet.bytes() + 4, packet.bytes() + packet.size() - 4 - kIdrSlice.size());
+
+    FrameTiming out;
+    std::vector<uint8_t> otherUuid = nal;
+    otherUuid[3] ^= 0xFF;  // first UUID byte
+    EXPECT_FALSE(LatencyTrace::parseSei(otherUuid.data(), otherUuid.size(), out));
+
+    std::vector<uint8_t> truncated(nal.begin(), nal.begin() + 20);
+    EXPECT_FALSE(LatencyTrace::parseSei(truncated.data(), truncated.size(), out));
+
+    EXPECT_FALSE(LatencyTrace::parseSei(kIdrSlice.data(), kIdrSlice.size(), out));
+}
+
+TEST(LatencyTraceTest, IgnoresPacketsWithoutTiming) {
+    const pusher::EncodedPacket annexB = makePacket(true);
+    const pusher::EncodedPacket avcc = makePacket(false);
+    LatencyTrace trace;
+    EXPECT_FALSE(trace.observe(annexB.bytes(), annexB.size(), 0));
+    EXPECT_FALSE(trace.observe(avcc.bytes(), avcc.size(), 0));
+}
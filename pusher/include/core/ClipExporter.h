@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace reallive {
+
+// Cuts [startMs, endMs] (wall clock) out of consecutive recorded segments
+// into one fragmented MP4, stream-copied and handed to a sink as each
+// fragment is produced: no temporary file and no re-encode.
+//
+// Start handling:
+// - Keyframe: the clip starts on the keyframe nearest to startMs.
+// - Exact: the GOP leading into startMs is included and timestamps are
+//   rebased so startMs is t=0; the muxer covers the lead-in with an edit
+//   list, so players that honour it start exactly at startMs.
+// The end is always cut at the last frame <= endMs. Timestamps are rebased
+// onto one continuous timeline across segment boundaries.
+class ClipExporter {
+public:
+    enum class StartMode { Keyframe, Exact };
+
+    struct Segment {
+        std::string path;
+        std::string indexPath;
+        int64_t startMs = 0;  // wall clock of the segment's first frame
+    };
+
+    struct Options {
+        std::vector<Segment> segments;  // oldest first, covering the range
+        int64_t startMs = 0;
+        int64_t endMs = 0;
+        StartMode startMode = StartMode::Keyframe;
+    };
+
+    // Returns false to abort the export (client went away).
+    using Sink = std::function<bool(const uint8_t* data, size_t size)>;
+
+    struct Result {
+        bool ok = false;
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        int64_t durationMs = 0;
+    };
+
+    static Result run(const Options& options, const Sink& sink, const std::atomic<bool>& cancel);
+};
+
+} // namespace reallive
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "platform/IAudioCapture.h"
+#include "platform/ICameraCapture.h"
+#include "platform/IEncoder.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace reallive {
+
+// Named factories for the platform components, so the pipeline picks its
+// camera, audio and encoder backends from config (camera_backend, ...)
+// instead of hard-coding the Raspberry Pi ones. Backends whose libraries
+// were not found at build time are simply not registered. The first one
+// registered of each kind is the default: libcamera/ALSA where built, else
+// the synthetic generators, so a plain Linux box runs headless.
+class ComponentRegistry {
+public:
+    using CameraFactory = std::function<CameraCapturePtr()>;
+    using AudioFactory = std::function<AudioCapturePtr()>;
+    using EncoderFactory = std::function<EncoderPtr()>;
+
+    static ComponentRegistry& instance();
+
+    // Re-registering a name replaces its factory.
+    void registerCamera(const std::string& name, CameraFactory factory);
+    void registerAudio(const std::string& name, AudioFactory factory);
+    void registerEncoder(const std::string& name, EncoderFactory factory);
+
+    // |name| empty: the default backend. Null for an unknown name.
+    CameraCapturePtr createCamera(const std::string& name) const;
+    AudioCapturePtr createAudio(const std::string& name) const;
+    EncoderPtr createEncoder(const std::string& name) const;
+
+    std::vector<std::string> cameraBackends() const;
+    std::vector<std::string> audioBackends() const;
+    std::vector<std::string> encoderBackends() const;
+
+private:
+    template <typename Factory>
+    struct Backend {
+        std::string name;
+        Factory factory;
+    };
+
+    ComponentRegistry();
+
+    template <typename Factory>
+    static void put(std::vector<Backend<Factory>>& backends, const std::string& name, Factory factory);
+    template <typename Factory>
+    static const Backend<Factory>* pick(const std::vector<Backend<Factory>>& backends, const std::string& name,
+                                        const char* kind);
+    template <typename Factory>
+    static std::vector<std::string> names(const std::vector<Backend<Factory>>& backends);
+
+    mutable std::mutex mutex_;
+    std::vector<Backend<CameraFactory>> cameras_;
+    std::vector<Backend<AudioFactory>> audio_;
+    std::vector<Backend<EncoderFactory>> encoders_;
+};
+
+} // namespace reallive
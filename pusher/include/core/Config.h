@@ -5,6 +5,8 @@
 #include "platform/IEncoder.h"
 #include "platform/IStreamer.h"
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace reallive {
 
@@ -14,7 +16,20 @@ struct RecordConfig {
     int segmentDurationSec = 60;
     int minFreePercent = 15;
     int targetFreePercent = 20;
+    int quotaMb = 0;             // per-stream segment budget, 0 = disk-free policy only
+    int maxAgeHours = 0;         // 0 = no age limit
+    int eventMaxAgeHours = 0;    // segments with person events; 0 = maxAgeHours
+    int retentionIntervalSec = 60;
+    int writeBufferKb = 1024;    // AVIO buffer; segments grow in chunks of this size
+    bool preallocate = true;     // fallocate bitrate x segment duration up front
+    int syncChunkKb = 4096;      // sync_file_range pacing, 0 = off
     bool generateThumbnails = true;
+    // "continuous" records 24/7; "event" keeps a pre-roll of GOPs in RAM and
+    // only writes clips around detections (segmentDurationSec caps clip length).
+    std::string mode = "continuous";
+    int preRollSec = 5;
+    int postRollSec = 10;
+    bool eventOnMotion = false;  // also trigger on raw motion, not just persons
 };
 
 struct ControlConfig {
@@ -22,7 +37,64 @@ struct ControlConfig {
     std::string host = "0.0.0.0";
     int port = 8090;
     std::string replayRtmpBase = "rtmp://localhost:1935/history";
-    std::string ffmpegBin = "ffmpeg";
+    double replayMaxSpeed = 16.0;
+    double replayKeyframeOnlySpeed = 4.0;  // speeds above this send keyframes only
+    int fileRateKbps = 8000;               // per-download cap for /api/record/file, 0 = none
+};
+
+// Extra push target fed from the same encode; url + "/" + streamKey like the
+// primary stream. Only the primary follows live-push demand.
+struct PushDestinationConfig {
+    std::string name;
+    std::string url;
+    std::string streamKey;
+    bool enabled = true;
+    int queueMax = 8;
+    std::string dropPolicy = "gop";  // "frame" or "gop", see PushOutput
+};
+
+struct PushConfig {
+    int queueMax = 4;                  // primary send queue, video packets
+    std::string dropPolicy = "frame";  // primary drop policy
+    std::vector<PushDestinationConfig> destinations;
+};
+
+// One camera of a multi-camera process (`cameras` array). Unset fields take
+// the top-level value; stream_key is required and routes control/MQTT
+// commands to this camera.
+struct CameraInstanceConfig {
+    std::string streamKey;
+    std::string cameraId;  // libcamera id, part of one, or an index
+    size_t index = 0;      // position in the array; the camera_id fallback
+    std::string cameraBackend;
+    std::string cameraSource;
+    std::string url;
+    int width = 0;
+    int height = 0;
+    int fps = 0;
+    int bitrate = 0;
+    int lanFlvPort = 0;    // default: lan_flv_port + camera index
+    std::string overlayCameraName;
+};
+
+// HTTP-FLV / WebSocket-FLV served by the pusher itself for LAN viewers.
+struct LanFlvConfig {
+    bool enabled = false;
+    std::string host = "0.0.0.0";
+    int port = 8091;
+    int maxClients = 32;
+    int queueKb = 4096;  // per-viewer backlog before a slow viewer is dropped
+};
+
+// Polygon in normalized [0,1] frame coordinates. Exclude zones never count as
+// motion; include zones restrict motion to their area and may override the
+// global diff threshold / motion ratio (0 keeps the global value).
+struct MotionZoneConfig {
+    std::string name;
+    bool exclude = true;
+    std::vector<std::pair<double, double>> points;
+    int diffThreshold = 0;
+    double motionRatio = 0.0;
 };
 
 struct DetectionConfig {
@@ -42,6 +114,35 @@ struct DetectionConfig {
     int tfliteInputSize = 320;
     double personScoreThreshold = 0.55;
     int inferMinIntervalMs = 220;
+    bool adaptiveEnabled = false;
+    double adaptiveTargetCpuPct = 75.0;
+    int adaptiveMaxIntervalFrames = 8;
+    int adaptiveMinInferIntervalMs = 100;
+    int adaptiveMaxInferIntervalMs = 1000;
+    int adaptiveMaxTiles = 2;
+    std::vector<MotionZoneConfig> zones;
+};
+
+struct OverlayConfig {
+    std::string cameraName;
+    int scale = 2;
+    bool trackLabels = true;
+};
+
+struct TraceConfig {
+    bool enabled = false;
+    int bufferEvents = 16384;  // per thread
+    std::string outputDir = "/tmp/reallive-traces";
+    int dumpSeconds = 30;
+};
+
+// Per-stage deadlines; a stage that misses its deadline is restarted on its
+// own (camera reopened, encoder reinitialized, detector respawned). 0
+// disables the check for that stage.
+struct WatchdogConfig {
+    int cameraMs = 3000;    // no frame delivered
+    int encoderMs = 3000;   // frames fed, no packet out
+    int detectorMs = 10000; // one detect() call
 };
 
 struct MqttConfig {
@@ -55,7 +156,10 @@ struct MqttConfig {
     int keepaliveSec = 30;
     int commandQos = 1;
     int stateQos = 0;
-    int stateIntervalMs = 1000;
+    int stateIntervalMs = 250;   // change poll / coalescing window
+    int stateHeartbeatMs = 5000; // republish unchanged state; keep below server stateStaleMs
+    int eventQos = 1;            // detection events on <prefix>/<stream_key>/event
+    int eventQueueMax = 256;     // events buffered while the broker is unreachable
 };
 
 struct PusherConfig {
@@ -64,10 +168,16 @@ struct PusherConfig {
     AudioConfig audio;
     EncoderConfig encoder;
     RecordConfig record;
+    PushConfig push;
     ControlConfig control;
+    LanFlvConfig lanFlv;
     DetectionConfig detection;
+    OverlayConfig overlay;
+    TraceConfig trace;
+    WatchdogConfig watchdog;
     MqttConfig mqtt;
     bool enableAudio = false;
+    std::vector<CameraInstanceConfig> cameras;  // empty: one camera, the top-level settings
 };
 
 class Config {
@@ -77,6 +187,9 @@ public:
     bool loadFromFile(const std::string& path);
     bool loadFromArgs(int argc, char* argv[]);
     const PusherConfig& get() const;
+    // One config per camera the process should run: the top-level config
+    // alone, or each `cameras` entry applied over it.
+    std::vector<PusherConfig> cameraConfigs() const;
 
     // Override individual fields from command line
     void setServerUrl(const std::string& url);
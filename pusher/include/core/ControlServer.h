@@ -1,8 +1,14 @@
 #pragma once
 
+#include "core/ClipExporter.h"
 #include "core/Config.h"
+#include "core/HlsPackager.h"
+#include "core/ReplayStreamer.h"
 
 #include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -11,11 +17,11 @@
 
 namespace reallive {
 
-class Pipeline;
+class PipelineHost;
 
 class ControlServer {
 public:
-    ControlServer(const PusherConfig& config, Pipeline* pipeline);
+    ControlServer(const PusherConfig& config, PipelineHost* host);
     ~ControlServer();
 
     bool start();
@@ -30,6 +36,7 @@ private:
         int64_t endMs = 0;
         int64_t durationMs = 0;
         std::string thumbnailPath;
+        std::string indexPath;
     };
 
     struct ReplaySession {
@@ -40,25 +47,61 @@ private:
         std::string playbackUrl;
         int64_t requestedTs = 0;
         int offsetSec = 0;
-        int pid = -1;
+        std::shared_ptr<ReplayStreamer> streamer;
         int64_t startedAtMs = 0;
     };
 
+    // A response streamed from its own thread (clip export, large file).
+    struct StreamJob {
+        enum class Kind { Export, File };
+        Kind kind = Kind::Export;
+        std::thread thread;
+        int fd = -1;  // owned by the export thread; -1 once it closed it
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+
     void serveLoop();
-    void handleClient(int clientFd);
+    // True when a handler consumed the socket (answered and closed it, or
+    // handed it to a streaming worker); the caller must not close it.
+    bool handleClient(int clientFd);
 
     std::string handleRequest(
         const std::string& method,
         const std::string& pathWithQuery,
+        const std::string& headers,
         const std::string& body,
-        int& statusCode
+        int& statusCode,
+        std::string& contentType,
+        int clientFd,
+        bool& handedOff
     );
 
     std::string handleOverview(const std::string& streamKey);
     std::string handleTimeline(const std::string& streamKey, int64_t startMs, int64_t endMs);
-    std::string handleReplayStart(const std::string& streamKey, int64_t tsMs);
+    std::string handleBitrate(const std::string& streamKey, int64_t startMs, int64_t endMs);
+    std::string handleFile(int clientFd, const std::string& method, const std::string& headers,
+                           const std::string& streamKey, const std::string& name,
+                           int& statusCode, bool& handedOff);
+    std::string handleExport(int clientFd, const std::string& streamKey, int64_t startMs, int64_t endMs,
+                             ClipExporter::StartMode startMode, int& statusCode, bool& handedOff);
+    void runExport(int clientFd, const ClipExporter::Options& options, const std::string& fileName);
+    std::string handleHlsPlaylist(const std::string& streamKey, int64_t startMs, int64_t endMs, int64_t atMs,
+                                  int& statusCode, std::string& contentType);
+    // gopCount == 0 asks for the recording's init segment.
+    std::string handleHlsMedia(int clientFd, const std::string& streamKey, int64_t recordingMs,
+                               uint32_t firstGop, uint32_t gopCount, int& statusCode, std::string& contentType,
+                               bool& handedOff);
+    HlsPackager::LiveSource liveRecording(const std::string& streamKey);
+    // False when |kind| is already at its concurrency limit; otherwise the
+    // worker owns |clientFd| and closes it after |work|.
+    bool spawnStream(StreamJob::Kind kind, int clientFd, std::function<void()> work);
+    void reapFinishedStreams();
+    void cancelAllStreams();
+    std::string handleReplayStart(const std::string& streamKey, int64_t tsMs, double speed);
+    std::string handleReplaySpeed(const std::string& sessionId, double speed, int& statusCode);
     std::string handleReplayStop(const std::string& streamKey, const std::string& sessionId);
-    std::string handleRuntimeStatus();
+    // |streamKey| empty: the first camera.
+    std::string handleRuntimeStatus(const std::string& streamKey, int& statusCode);
     std::string handleRuntimeLive(const std::string& body, int& statusCode);
 
     std::vector<Segment> loadSegments(const std::string& streamKey) const;
@@ -71,12 +114,16 @@ private:
     void terminateAllSessions();
 
     PusherConfig config_;
-    Pipeline* pipeline_ = nullptr;
+    PipelineHost* host_ = nullptr;
     std::atomic<bool> running_{false};
     int serverFd_ = -1;
     std::thread serverThread_;
     mutable std::mutex sessionMutex_;
     std::unordered_map<std::string, ReplaySession> sessions_;
+    std::mutex streamMutex_;
+    std::list<StreamJob> streams_;
+    std::atomic<bool> streamCancel_{false};
+    HlsPackager hls_;
 };
 
 } // namespace reallive
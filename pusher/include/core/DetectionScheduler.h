@@ -0,0 +1,82 @@
+#pragma once
+
+#include "core/Config.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace reallive {
+
+struct DetectionCadence {
+    int intervalFrames = 2;
+    int inferMinIntervalMs = 220;
+    int inferTiles = 1;
+};
+
+// Picks the detector cadence (motion frame interval, inference interval and
+// inference tile count) from measured encode/detect cost and CPU load, so the
+// detector backs off before it can starve the encoder and uses idle headroom
+// for more frequent or finer-grained inference.
+class DetectionScheduler {
+public:
+    enum class State { Fixed, Steady, Backoff, Boost, Overload };
+
+    struct Snapshot {
+        bool adaptive = false;
+        State state = State::Fixed;
+        DetectionCadence cadence;
+        double cpuPct = 0.0;
+        double encodeAvgMs = 0.0;
+        double encodeMaxMs = 0.0;
+        double detectAvgMs = 0.0;
+        double inferAvgMs = 0.0;
+        uint64_t skippedFrames = 0;
+    };
+
+    DetectionScheduler(const DetectionConfig& config, int fps);
+
+    // Video thread: per-frame encode cost and the hard latency guard. While
+    // the last encode overran one frame interval no frame is offered to the
+    // detector at all.
+    void recordEncode(int64_t encodeUs);
+    bool shouldOfferFrame() const;
+    void noteSkippedFrame();
+
+    // Detect thread: cost of one detect() call and the inference part of it.
+    void recordDetect(int64_t detectUs, int64_t inferUs);
+
+    // Video thread, roughly once per second with the current CPU usage.
+    void update(double cpuPct);
+
+    DetectionCadence cadence() const;
+    Snapshot snapshot() const;
+
+    static const char* stateName(State state);
+
+private:
+    void apply(State state, const DetectionCadence& next);
+
+    DetectionConfig config_;
+    int64_t frameBudgetUs_ = 33333;
+
+    std::atomic<int> intervalFrames_{2};
+    std::atomic<int> inferIntervalMs_{220};
+    std::atomic<int> inferTiles_{1};
+
+    int64_t lastEncodeUs_ = 0;
+    int64_t encodeSumUs_ = 0;
+    int64_t encodeMaxUs_ = 0;
+    int encodeCount_ = 0;
+
+    std::atomic<int64_t> detectSumUs_{0};
+    std::atomic<int64_t> inferSumUs_{0};
+    std::atomic<int> detectCount_{0};
+    std::atomic<int> inferCount_{0};
+
+    int calmWindows_ = 0;
+    int64_t inferEstimateUs_ = 0;
+    uint64_t skippedFrames_ = 0;
+    Snapshot last_;
+};
+
+} // namespace reallive
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "platform/ICameraCapture.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace reallive {
+
+// Process-wide recycler for frame-sized buffers, shared by every camera and
+// stage (capture, detector copy). A 1080p NV12 frame is 3 MB; allocating and
+// zero-filling one per capture costs more than filling it. Buffers keep
+// their size while pooled, so acquiring the same size again initializes
+// nothing.
+class FramePool {
+public:
+    static FramePool& instance();
+
+    std::vector<uint8_t> acquire(size_t size);
+    void release(std::vector<uint8_t>&& buffer);
+    // Buffers kept for reuse; beyond this, released buffers are freed.
+    void setCapacity(size_t buffers);
+
+private:
+    FramePool() = default;
+
+    std::mutex mutex_;
+    std::vector<std::vector<uint8_t>> free_;
+    size_t capacity_ = 8;
+};
+
+// Hands a frame's buffer back to the pool when it leaves scope.
+class FrameRecycler {
+public:
+    explicit FrameRecycler(Frame& frame) : frame_(frame) {}
+    ~FrameRecycler() { FramePool::instance().release(std::move(frame_.data)); }
+
+    FrameRecycler(const FrameRecycler&) = delete;
+    FrameRecycler& operator=(const FrameRecycler&) = delete;
+
+private:
+    Frame& frame_;
+};
+
+} // namespace reallive
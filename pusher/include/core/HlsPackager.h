@@ -0,0 +1,96 @@
+#pragma once
+
+#include "core/LocalRecorder.h"
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct AVCodecParameters;
+
+namespace reallive {
+
+// HLS over the recordings as they sit on disk: no transcoding, no helper
+// process, no extra files.
+// - Recordings are plain MP4 (moov at the end), which byte-range playlists
+//   cannot address, so every media segment is a CMAF fragment (moof+mdat)
+//   built on request from the samples the .idx sidecar points at, and every
+//   recording gets its own init segment (ftyp+moov).
+// - Media segments are whole GOPs, about kTargetSegmentMs each. Fragment
+//   times are recording-relative; each recording opens a discontinuity with
+//   EXT-X-PROGRAM-DATE-TIME, so any wall-clock time in range is seekable.
+// - The recording still being written is listed as LL-HLS parts, one per
+//   closed GOP, from LocalRecorder::liveSegment().
+// Segment tables are cached per stream and refreshed only when the stream
+// directory changes (a segment finalized or was deleted); then only the new
+// recordings have their index read.
+class HlsPackager {
+public:
+    using LiveSource = std::function<bool(LocalRecorder::LiveSegment&)>;
+
+    static constexpr uint32_t kTargetSegmentMs = 4000;
+
+    explicit HlsPackager(std::string recordRoot);
+    ~HlsPackager();
+
+    HlsPackager(const HlsPackager&) = delete;
+    HlsPackager& operator=(const HlsPackager&) = delete;
+
+    // Media playlist for [startMs, endMs] (endMs < 0 = open-ended: an EVENT
+    // playlist that follows the live recording). |atMs| >= 0 adds an
+    // EXT-X-START at that time. Empty when nothing in range is packageable.
+    std::string playlist(const std::string& streamKey, int64_t startMs, int64_t endMs, int64_t atMs,
+                         const LiveSource& live);
+    // Recordings are addressed by their start time, which survives the
+    // rename from .writing to .mp4 at finalize.
+    bool initSegment(const std::string& streamKey, int64_t recordingMs, const LiveSource& live,
+                     std::string& out);
+    bool fragment(const std::string& streamKey, int64_t recordingMs, uint32_t firstGop, uint32_t gopCount,
+                  const LiveSource& live, std::string& out);
+
+private:
+    struct Chunk {
+        uint32_t firstGop = 0;
+        uint32_t gopCount = 0;
+        uint32_t ptsMs = 0;
+        uint32_t durationMs = 0;
+    };
+
+    struct Recording {
+        std::string path;
+        std::string indexPath;  // empty for the live recording
+        int64_t startMs = 0;
+        std::vector<uint32_t> gopDurationsMs;
+        std::vector<Chunk> chunks;
+        std::string lines;      // EXTINF + URI of every chunk, rendered once
+        std::shared_ptr<AVCodecParameters> codecpar;
+        std::string init;
+    };
+    using RecordingPtr = std::shared_ptr<Recording>;
+
+    struct StreamCache {
+        bool scanned = false;
+        timespec dirMtime{};
+        std::map<int64_t, RecordingPtr> recordings;  // finalized, by start time
+    };
+
+    void refresh(const std::string& streamKey, StreamCache& cache);
+    RecordingPtr findFinalized(const std::string& streamKey, int64_t recordingMs);
+    static RecordingPtr fromIndex(const SegmentIndex& index, uint32_t endPtsMs, bool closed);
+    static RecordingPtr fromLive(const LocalRecorder::LiveSegment& live);
+    static bool ensureInit(Recording& rec);
+    static std::string chunkUri(const std::string& streamKey, int64_t recordingMs, uint32_t firstGop,
+                                uint32_t gopCount);
+
+    std::string root_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, StreamCache> streams_;
+};
+
+} // namespace reallive
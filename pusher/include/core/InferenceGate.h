@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace reallive {
+
+// Process-wide turnstile for model inference. With several cameras in one
+// process each detector keeps its own interpreter, but invocations run one
+// at a time in arrival order, so the cameras share the inference cores the
+// way a single worker would and none can starve another. Uncontended with
+// one camera. A turn held past kStuckMs (a hung Invoke(), see the detector
+// watchdog) is skipped by the next in line so one wedged camera cannot stall
+// inference for the others.
+class InferenceGate {
+public:
+    static constexpr int64_t kStuckMs = 5000;
+
+    static InferenceGate& instance();
+
+    class Turn {
+    public:
+        explicit Turn(InferenceGate& gate);
+        ~Turn();
+
+        Turn(const Turn&) = delete;
+        Turn& operator=(const Turn&) = delete;
+
+        // Time spent queued behind other cameras.
+        int64_t waitedUs() const { return waitedUs_; }
+
+    private:
+        InferenceGate& gate_;
+        uint64_t ticket_ = 0;
+        int64_t waitedUs_ = 0;
+    };
+
+private:
+    InferenceGate() = default;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t nextTicket_ = 0;
+    uint64_t serving_ = 0;
+    std::chrono::steady_clock::time_point turnStarted_;
+};
+
+} // namespace reallive
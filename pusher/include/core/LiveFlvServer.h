@@ -0,0 +1,138 @@
+#pragma once
+
+#include "platform/IEncoder.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct AVFormatContext;
+
+namespace reallive {
+
+class Counter;
+class Gauge;
+class MetricsRegistry;
+
+// Serves the live stream to LAN viewers as HTTP-FLV and WebSocket-FLV
+// straight from the encoder output, skipping the RTMP -> SRS hop.
+// - Every packet is muxed into an FLV tag once; all subscribers share the
+//   same bytes, so a viewer costs a queue entry and a writev(), not a mux.
+// - The tags since the last keyframe are kept as a GOP cache, so a new
+//   viewer gets a decodable picture at once instead of waiting for a GOP.
+// - One epoll thread accepts, parses requests and writes with non-blocking
+//   sockets. Each subscriber's backlog is capped in bytes; a viewer that
+//   cannot keep up is disconnected rather than slowing anyone else down.
+//
+// GET /live/<stream_key>.flv (or /<stream_key>.flv); with "Upgrade:
+// websocket" each tag goes out as one binary frame. Video only.
+class LiveFlvServer {
+public:
+    struct Options {
+        std::string host = "0.0.0.0";
+        int port = 8091;
+        std::string streamKey;
+        size_t maxSubscribers = 32;
+        size_t queueBytes = 4 * 1024 * 1024;  // per subscriber before eviction
+        std::vector<uint8_t> extraData;       // SPS/PPS
+        int width = 0;
+        int height = 0;
+        MetricsRegistry* metrics = nullptr;
+    };
+
+    LiveFlvServer() = default;
+    ~LiveFlvServer();
+
+    LiveFlvServer(const LiveFlvServer&) = delete;
+    LiveFlvServer& operator=(const LiveFlvServer&) = delete;
+
+    bool start(const Options& options);
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // Called on the video thread for every encoded packet.
+    void publish(const EncodedPacket& packet);
+
+private:
+    struct Chunk {
+        std::string wsHeader;  // frame header for WebSocket subscribers; empty = raw bytes
+        std::string data;
+    };
+    using ChunkPtr = std::shared_ptr<const Chunk>;
+
+    struct Published {
+        ChunkPtr chunk;
+        bool keyframe = false;
+    };
+
+    struct Subscriber {
+        enum class State { Request, Streaming };
+        int fd = -1;
+        State state = State::Request;
+        bool websocket = false;
+        bool wantKeyframe = false;
+        bool writeArmed = false;
+        int64_t acceptedMs = 0;
+        std::string inbuf;
+        std::deque<ChunkPtr> queue;
+        size_t frontOffset = 0;
+        size_t queuedBytes = 0;
+    };
+
+    bool openMuxer();
+    void closeMuxer();
+
+    void run();
+    void acceptClients();
+    void drainPublished();
+    void onReadable(Subscriber& sub);
+    void handleRequest(Subscriber& sub);
+    void join(Subscriber& sub);
+    bool enqueue(Subscriber& sub, const ChunkPtr& chunk);
+    // False when the connection failed and has to be closed.
+    bool flush(Subscriber& sub);
+    void setWriteInterest(Subscriber& sub, bool on);
+    void closeClient(int fd);
+    void rejectAndClose(Subscriber& sub, int status, const char* reason);
+    void wake();
+
+    static ChunkPtr makeChunk(std::string data, bool websocketFramed);
+
+    Options options_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+
+    // Muxer state: video thread (publish) and start/stop.
+    std::mutex muxMutex_;
+    AVFormatContext* mux_ = nullptr;
+    std::string muxOut_;
+    ChunkPtr header_;
+    int64_t firstDtsUs_ = -1;
+    int64_t lastDtsMs_ = 0;
+
+    std::mutex pendingMutex_;
+    std::vector<Published> pending_;
+
+    // Epoll thread only.
+    std::unordered_map<int, Subscriber> clients_;
+    size_t streaming_ = 0;
+    std::vector<ChunkPtr> gop_;
+    size_t gopBytes_ = 0;
+    bool gopComplete_ = false;  // gop_ starts on a keyframe and was not truncated
+
+    Gauge* subscribersGauge_ = nullptr;
+    Counter* evictions_ = nullptr;
+    Counter* bytesOut_ = nullptr;
+};
+
+} // namespace reallive
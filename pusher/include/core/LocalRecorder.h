@@ -1,9 +1,14 @@
 #pragma once
 
 #include "core/Config.h"
+#include "core/RecordFileWriter.h"
+#include "core/RetentionEngine.h"
+#include "core/SegmentIndex.h"
 #include "platform/IEncoder.h"
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -14,8 +19,25 @@ extern "C" {
 
 namespace reallive {
 
+class Histogram;
+class MetricsRegistry;
+
 class LocalRecorder {
 public:
+    // The segment currently being written, cut to the GOPs that are closed
+    // and already on disk.
+    struct LiveSegment {
+        std::string path;          // still the .writing temp file
+        int64_t startMs = 0;
+        SegmentIndex index;
+        uint32_t endPtsMs = 0;     // pts of the keyframe that closed the last GOP
+        // avcC record to go with the samples, which the muxer has already
+        // written length-prefixed; the encoder's Annex-B SPS/PPS would not.
+        std::vector<uint8_t> avcc;
+        int width = 0;
+        int height = 0;
+    };
+
     LocalRecorder();
     ~LocalRecorder();
 
@@ -25,22 +47,52 @@ public:
         const uint8_t* videoExtraData,
         int videoExtraDataSize,
         int width,
-        int height
+        int height,
+        int bitrate,
+        MetricsRegistry* metrics = nullptr
     );
 
     bool writeVideoPacket(const EncodedPacket& packet);
+    // Whether |packet|, written next, starts a segment. In event mode any
+    // keyframe may become the first packet of a clip, since the pre-roll
+    // ring always begins at one.
+    bool startsSegment(const EncodedPacket& packet) const;
     void close();
     bool isEnabled() const;
+    bool isEventMode() const;
+
+    // Event mode: keeps the current clip open (or opens one, pre-roll
+    // included) until post-roll seconds from now. Overlapping events extend
+    // the same clip. Safe to call from any thread.
+    void markEvent();
     bool setCleanupPolicy(int minFreePercent, int targetFreePercent);
     void getCleanupPolicy(int& minFreePercent, int& targetFreePercent) const;
 
+    // Snapshot for HLS parts; false when no segment is open. Calling it also
+    // makes the recorder flush its write buffer at every keyframe for the
+    // next few seconds, so a followed segment is on disk one GOP behind live
+    // rather than one write buffer behind. Safe to call from any thread.
+    bool liveSegment(LiveSegment& out);
+
 private:
+    struct BufferedPacket {
+        std::vector<uint8_t> data;
+        int64_t pts = 0;
+        int64_t dts = 0;
+        int64_t wallMs = 0;
+        bool isKeyframe = false;
+    };
+
+    bool writeEventPacket(const EncodedPacket& packet, int64_t nowMs);
+    void bufferPreRoll(const EncodedPacket& packet, int64_t nowMs);
+    void dropPreRollFront(size_t count);
+    bool writeRaw(const uint8_t* data, size_t size, int64_t ptsUs, int64_t dtsUs, bool isKeyframe);
     bool openSegment(int64_t startMs);
     bool rotateIfNeeded(const EncodedPacket& packet, int64_t nowMs);
     bool finalizeCurrentSegment(int64_t endMs);
-    void maybeCleanupOldSegments();
+    void recoverOrphanSegments();
+    RetentionEngine::Policy retentionPolicy() const;
     void generateThumbnail(const std::string& mp4Path) const;
-    std::vector<std::string> listSegmentsOldestFirst() const;
 
     std::string makeTempPath(int64_t startMs) const;
     std::string makeFinalPath(int64_t startMs, int64_t endMs) const;
@@ -51,18 +103,37 @@ private:
     std::string streamDir_;
 
     std::vector<uint8_t> videoExtraData_;
+    std::vector<uint8_t> liveAvcc_;
     int width_ = 0;
     int height_ = 0;
+    int bitrate_ = 0;
+
+    RecordFileWriter file_;
+    SegmentIndex index_;
+    Histogram* writeHist_ = nullptr;
+    Histogram* syncHist_ = nullptr;
 
     AVFormatContext* formatCtx_ = nullptr;
     int videoStreamIdx_ = -1;
     bool headerWritten_ = false;
     bool initialized_ = false;
     mutable std::mutex policyMutex_;
+    RetentionEngine retention_;
 
     int64_t segmentStartWallMs_ = 0;
     int64_t segmentStartPtsUs_ = -1;
     std::string currentTempPath_;
+    // Guards index_, currentTempPath_, segmentStartWallMs_ and liveOpen_
+    // against liveSegment().
+    mutable std::mutex liveMutex_;
+    bool liveOpen_ = false;
+    std::atomic<int64_t> liveReadersUntilMs_{0};
+
+    bool eventMode_ = false;
+    std::atomic<int64_t> eventUntilMs_{0};
+    std::deque<BufferedPacket> preRoll_;  // starts on a keyframe
+    size_t preRollBytes_ = 0;
+    std::vector<std::vector<uint8_t>> spareBuffers_;
 };
 
 } // namespace reallive
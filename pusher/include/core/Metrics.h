@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace reallive {
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    Counter& operator++(int) { inc(); return *this; }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void set(double v) { value_.store(v, std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+// Log-linear latency histogram in microseconds: every power-of-two range is
+// split into kSubBuckets linear buckets (<= 12.5% relative error). observe()
+// is two relaxed atomic adds, so it can sit on the per-frame path; quantiles
+// come from bucket counts instead of sorting samples.
+class Histogram {
+public:
+    static constexpr int kSubBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kMaxExponent = 27;  // ~134 s
+    static constexpr size_t kBuckets = kSubBuckets + (kMaxExponent - kSubBits + 1) * kSubBuckets;
+
+    struct Snapshot {
+        std::array<uint64_t, kBuckets> counts{};
+        uint64_t count = 0;
+        uint64_t sumUs = 0;
+
+        // Counts observed after |earlier| was taken.
+        Snapshot since(const Snapshot& earlier) const;
+        double meanUs() const;
+        // Upper bound of the bucket holding quantile |q| (0..1).
+        uint64_t quantileUs(double q) const;
+    };
+
+    void observe(int64_t us);
+    Snapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t us);
+    static uint64_t bucketUpperUs(size_t index);  // inclusive
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> sumUs_{0};
+};
+
+// Process metrics exported in the Prometheus text format. Registration takes a
+// lock and returns a reference that stays valid for the registry's lifetime;
+// updates through that reference are lock-free. Registering an existing name
+// returns the existing metric.
+class MetricsRegistry {
+public:
+    Counter& counter(const std::string& name, const std::string& help);
+    Gauge& gauge(const std::string& name, const std::string& help);
+    Histogram& histogram(const std::string& name, const std::string& help);
+    // Same metric, for holders that may outlive the registry.
+    std::shared_ptr<Histogram> sharedHistogram(const std::string& name, const std::string& help);
+
+    // Values owned elsewhere, read at scrape time.
+    void counterFn(const std::string& name, const std::string& help, std::function<double()> fn);
+    void gaugeFn(const std::string& name, const std::string& help, std::function<double()> fn);
+
+    std::string renderPrometheus() const;
+
+private:
+    enum class Kind { Counter, Gauge, Histogram, CounterFn, GaugeFn };
+
+    struct Entry {
+        std::string name;
+        std::string help;
+        Kind kind = Kind::Counter;
+        Counter counter;
+        Gauge gauge;
+        std::shared_ptr<Histogram> histogram;
+        std::function<double()> fn;
+    };
+
+    Entry& entry(const std::string& name, const std::string& help, Kind kind);
+    static const char* typeName(Kind kind);
+
+    mutable std::mutex mutex_;
+    std::deque<Entry> entries_;
+};
+
+} // namespace reallive
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "core/Config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace reallive {
+
+// Motion zones rasterized onto the detector's processing grid. Polygons are
+// rasterized once per grid size into a per-cell threshold map and packed
+// bitmasks; the per-frame work is a SIMD diff/compare followed by word-wise
+// AND + popcount against each zone mask.
+class MotionZones {
+public:
+    struct Result {
+        bool triggered = false;
+        double ratio = 0.0;     // highest changed ratio over all regions, triggering or not
+        int changedCells = 0;   // changed cells inside the active area
+        int minX = 0;
+        int minY = 0;
+        int maxX = -1;
+        int maxY = -1;
+    };
+
+    void configure(const std::vector<MotionZoneConfig>& zones, int diffThreshold, double motionRatio);
+    bool hasZones() const { return !zones_.empty(); }
+
+    // Rebuilds the masks when the grid size changes. Cheap no-op otherwise.
+    void prepare(int gridW, int gridH);
+
+    // out[i] = 0xFF where |cur[i] - prev[i]| > threshold of the cell and
+    // the cell is not excluded, 0 otherwise. Buffers are gridW*gridH, contiguous.
+    void thresholdDiff(const uint8_t* cur, const uint8_t* prev, uint8_t* out) const;
+
+    // Packs a 0x00/0xFF cell map into bits and scores every region.
+    Result score(const uint8_t* cells);
+
+    // 0xFF for cells that count as motion, 0 for excluded ones (gridW*gridH).
+    const uint8_t* activeCells() const { return activeBytes_.data(); }
+
+private:
+    struct Region {
+        std::vector<uint64_t> mask;
+        int cellCount = 0;
+        double motionRatio = 0.0;
+    };
+
+    void rasterize();
+    static bool insidePolygon(const std::vector<std::pair<double, double>>& poly, double x, double y);
+
+    std::vector<MotionZoneConfig> zones_;
+    int diffThreshold_ = 22;
+    double motionRatio_ = 0.015;
+
+    int gridW_ = 0;
+    int gridH_ = 0;
+    size_t wordsPerRow_ = 0;
+    std::vector<uint8_t> thresholds_;
+    std::vector<uint8_t> activeBytes_;
+    std::vector<uint64_t> activeMask_;
+    std::vector<Region> regions_;
+    std::vector<uint64_t> changedBits_;
+};
+
+} // namespace reallive
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "core/Config.h"
+#include "core/PushOutput.h"
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 struct mosquitto;
 struct mosquitto_message;
@@ -13,24 +17,65 @@ struct mosquitto_message;
 namespace reallive {
 
 class Pipeline;
+class PipelineHost;
+struct DetectionEvent;
 
 class MqttRuntimeClient {
 public:
-    MqttRuntimeClient(const PusherConfig& config, Pipeline* pipeline);
+    MqttRuntimeClient(const PusherConfig& config, PipelineHost* host);
     ~MqttRuntimeClient();
 
     bool start();
     void stop();
     bool isRunning() const;
 
+    // Queues the event (bounded, oldest dropped first) and wakes the state
+    // thread to publish it, right away when connected, otherwise on
+    // reconnect. Never waits on the broker, so the detect thread can call it.
+    void publishDetectionEvent(const std::string& streamKey, const DetectionEvent& event);
+
 private:
+    struct RuntimeState {
+        bool running = false;
+        bool desiredLive = false;
+        bool activeLive = false;
+        int minFreePercent = 0;
+        double storagePct = 0.0;
+        double storageUsedGb = 0.0;
+        double storageTotalGb = 0.0;
+        std::vector<PushOutput::Stats> push;
+    };
+
+    // Topics and state bookkeeping of one camera.
+    struct Route {
+        std::string streamKey;
+        Pipeline* pipeline = nullptr;
+        std::string commandTopic;
+        std::string stateTopic;
+        std::string eventTopic;
+        RuntimeState lastState;          // guarded by stateMutex_
+        int64_t lastStatePublishMs = 0;  // guarded by stateMutex_
+        bool statePublished = false;     // guarded by stateMutex_
+        int64_t commandSeq = 0;          // mosquitto callback thread only
+    };
+
+    struct QueuedEvent {
+        std::string topic;
+        std::string payload;
+    };
+
     static int64_t nowMs();
     static std::string trim(const std::string& s);
     static std::string lower(const std::string& s);
     static std::string sanitizeToken(const std::string& raw);
     static std::string jsonValue(const std::string& body, const std::string& key);
 
-    void publishState(const char* reason = nullptr, int64_t commandSeq = -1);
+    Route* findRoute(const std::string& streamKey);
+    RuntimeState collectState(const Route& route) const;
+    static bool sameState(const RuntimeState& a, const RuntimeState& b);
+    void publishState(Route& route, const char* reason = nullptr, int64_t commandSeq = -1);
+    void flushEventQueue();
+    void wakeEventPublisher();
     void stateLoop();
     void onConnect(int rc);
     void onDisconnect(int rc);
@@ -41,19 +86,25 @@ private:
     static void handleMessage(::mosquitto* mosq, void* obj, const ::mosquitto_message* msg);
 
     PusherConfig config_;
-    Pipeline* pipeline_ = nullptr;
+    std::vector<Route> routes_;
 
     std::atomic<bool> running_{false};
     std::atomic<bool> connected_{false};
-    std::atomic<int64_t> commandSeq_{0};
 
     std::thread stateThread_;
     std::mutex mqttMutex_;
     ::mosquitto* mosq_ = nullptr;
 
     std::string clientId_;
-    std::string commandTopic_;
-    std::string stateTopic_;
+
+    std::mutex stateMutex_;
+
+    std::mutex eventMutex_;
+    std::condition_variable eventCv_;  // stateLoop waits here between passes
+    bool eventWake_ = false;
+    std::deque<QueuedEvent> eventQueue_;
+    uint64_t eventSeq_ = 0;
+    uint64_t eventsDropped_ = 0;
 };
 
 } // namespace reallive
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace reallive {
+
+// Text label on a darkened background box; (x, y) is the box's top-left.
+struct OverlayText {
+    int x = 0;
+    int y = 0;
+    std::string text;
+};
+
+// Rectangle outline, e.g. a detection box.
+struct OverlayRect {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+    int thickness = 3;
+};
+
+// Burns layered text and rectangles into NV12 frames.
+//
+// Glyphs come from a printable-ASCII 8x16 atlas pre-rasterized at the
+// configured scale. Layer content is rasterized into frame-sized
+// set/value/darken planes only where a layer changed (dirty rects), and every
+// frame is composited in a single SIMD pass over the row spans the overlays
+// cover, so a static overlay costs one blend per covered pixel.
+class OverlayCompositor {
+public:
+    explicit OverlayCompositor(int scale = 2);
+
+    int textBoxWidth(const std::string& text) const;
+    int textBoxHeight() const;
+
+    // Replaces a layer's content. Layers draw in ascending id order.
+    // Identical content is a no-op.
+    void setLayer(int id, const std::vector<OverlayText>& texts, const std::vector<OverlayRect>& rects = {});
+    void clearLayer(int id);
+
+    void composite(uint8_t* data, int width, int height);
+
+private:
+    struct Rect {
+        int x = 0;
+        int y = 0;
+        int w = 0;
+        int h = 0;
+    };
+    struct Span {
+        int x0 = 0;
+        int x1 = 0;  // exclusive
+    };
+    struct Layer {
+        int id = 0;
+        std::vector<OverlayText> texts;
+        std::vector<OverlayRect> rects;
+    };
+
+    void buildAtlas();
+    void resize(int width, int height);
+    Rect textBox(const OverlayText& text) const;
+    bool clampRect(const OverlayRect& rect, Rect& box, int& band, int& bandW) const;
+    void elementRects(const Layer& layer, std::vector<Rect>& out) const;
+    void markDirty(const Layer& layer);
+    void redrawDirty();
+    void rasterizeText(const OverlayText& text, const Rect& clip);
+    void rasterizeRect(const OverlayRect& rect, const Rect& clip);
+    void rebuildSpans();
+
+    int scale_ = 2;
+    int cellW_ = 16;
+    int cellH_ = 32;
+    std::vector<uint8_t> atlas_;
+
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<Layer> layers_;
+    std::vector<Rect> dirty_;
+    bool spansDirty_ = false;
+
+    std::vector<uint8_t> lumaSet_;
+    std::vector<uint8_t> lumaVal_;
+    std::vector<uint8_t> lumaDark_;
+    std::vector<uint8_t> chromaSet_;
+    std::vector<uint8_t> chromaVal_;
+    std::vector<uint8_t> chromaDark_;
+    std::vector<std::vector<Span>> lumaSpans_;
+    std::vector<std::vector<Span>> chromaSpans_;
+};
+
+} // namespace reallive
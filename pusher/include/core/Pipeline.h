@@ -6,13 +6,32 @@
 #include "platform/IEncoder.h"
 #include "platform/IStreamer.h"
 #include "core/LocalRecorder.h"
+#include "core/LiveFlvServer.h"
+#include "core/PushOutput.h"
+#include "core/Metrics.h"
 #include <atomic>
+#include <functional>
 #include <thread>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace reallive {
 
+struct DetectionEvent {
+    int64_t tsMs = 0;       // frame timestamp (wall clock)
+    double score = 0.0;
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+    uint32_t trackId = 0;
+};
+
+// Called on the detect thread as soon as a person event fires; must not block.
+using DetectionEventHandler = std::function<void(const DetectionEvent&)>;
+
 class Pipeline {
 public:
     Pipeline();
@@ -32,30 +51,56 @@ public:
     bool isLivePushActive() const;
     bool setRecordCleanupPolicy(int minFreePercent, int targetFreePercent);
     bool getRecordCleanupPolicy(int& minFreePercent, int& targetFreePercent) const;
+    bool getLiveRecording(LocalRecorder::LiveSegment& out);
+    // Extra push destinations, fed from the same encode. Runtime changes are
+    // not written back to the config file.
+    bool addPushDestination(const PushDestinationConfig& dest, std::string& error);
+    bool removePushDestination(const std::string& name);
+    std::vector<PushOutput::Stats> getPushStats() const;
+    MetricsRegistry& metrics() { return metrics_; }
+    void setDetectionEventHandler(DetectionEventHandler handler);
 
 private:
     void videoLoop();
     void audioLoop();
 
     bool createComponents(const PusherConfig& config);
+    PushOutputPtr makePushOutput(const PushDestinationConfig& dest, std::string& error);
+    std::vector<PushOutputPtr> pushOutputs() const;
+    // Logs a startup phase and exports it as reallive_startup_<phase>_seconds.
+    void noteStartupPhase(const char* phase, int64_t sinceUs);
+    void recordStartupPhase(const char* phase, int64_t elapsedUs);
+    // Watchdog restarts, each run on the thread that owns the component.
+    bool reopenCamera();
+    bool reinitEncoder();
 
     CameraCapturePtr camera_;
     AudioCapturePtr audio_;
     EncoderPtr encoder_;
-    StreamerPtr streamer_;
-    std::unique_ptr<LocalRecorder> recorder_;
+    std::vector<uint8_t> videoExtraData_;  // SPS/PPS, stable across encoder reinit
+    PushOutputPtr primary_;  // stream.url; follows live-push demand
+    std::shared_ptr<LocalRecorder> recorder_;  // shared with the detect thread
+    std::unique_ptr<LiveFlvServer> lanFlv_;
+    LiveFlvServer::Options lanFlvOptions_;
 
     std::thread videoThread_;
     std::thread audioThread_;
     std::atomic<bool> running_{false};
+    int64_t cameraStartUs_ = 0;  // steady clock, for the first_frame phase
+
+    mutable std::mutex outputsMutex_;
+    std::vector<PushOutputPtr> destinations_;
 
     // Stats
-    std::atomic<uint64_t> framesSent_{0};
-    std::atomic<uint64_t> bytesSent_{0};
     std::atomic<double> currentFps_{0.0};
-    std::atomic<bool> livePushDesired_{true};
-    std::atomic<bool> livePushActive_{false};
-    mutable std::mutex streamerMutex_;
+    MetricsRegistry metrics_;
+    // Shared with detect threads, which can outlive the pipeline once the
+    // watchdog abandons them.
+    struct DetectionEventSink {
+        std::mutex mutex;
+        DetectionEventHandler handler;
+    };
+    std::shared_ptr<DetectionEventSink> eventSink_ = std::make_shared<DetectionEventSink>();
 
     PusherConfig config_;
 };
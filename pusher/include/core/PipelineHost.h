@@ -0,0 +1,53 @@
+#pragma once
+
+#include "core/Config.h"
+#include "core/Pipeline.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace reallive {
+
+// Called on a camera's detect thread; must not block.
+using HostDetectionEventHandler = std::function<void(const std::string& streamKey, const DetectionEvent&)>;
+
+// Runs one Pipeline per configured camera in a single process. The control
+// server and MQTT client reach a camera through its stream key; everything
+// else (recorder, LAN FLV server, detector) stays per pipeline.
+class PipelineHost {
+public:
+    struct Camera {
+        std::string streamKey;
+        PusherConfig config;
+        std::unique_ptr<Pipeline> pipeline;
+        bool initialized = false;
+    };
+
+    explicit PipelineHost(const Config& config);
+    ~PipelineHost();
+
+    // Succeeds when at least one camera comes up; the others are logged and
+    // left stopped.
+    bool init();
+    bool start();
+    void stop();
+    // True while any camera is running.
+    bool isRunning() const;
+
+    // The camera streaming under |streamKey|; an empty key names the first.
+    Pipeline* find(const std::string& streamKey) const;
+    const std::vector<Camera>& cameras() const { return cameras_; }
+
+    void setDetectionEventHandler(HostDetectionEventHandler handler);
+
+    // Every camera's metrics; with several, each sample carries a
+    // stream_key label.
+    std::string renderMetrics() const;
+
+private:
+    std::vector<Camera> cameras_;
+};
+
+} // namespace reallive
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "platform/IStreamer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace reallive {
+
+class Counter;
+class Gauge;
+class Histogram;
+class MetricsRegistry;
+
+// One push destination fed from the shared encode: its own streamer, send
+// thread, bounded queue, drop policy and reconnect backoff. The video loop
+// only appends a shared reference to each output's queue, so a destination
+// that stalls (slow uplink, dead ingest, long connect timeout) drops its own
+// packets and never holds up the encoder, the recorder or the other outputs.
+class PushOutput {
+public:
+    enum class DropPolicy {
+        Frame,  // queue full: drop the oldest non-keyframe (lowest latency)
+        Gop,    // queue full: drop everything queued, resume at the next keyframe
+    };
+
+    // Runs on the send thread on this output's copy of the packet just before
+    // it is sent, with the duration of the previous send (timing SEI).
+    using BeforeSend = std::function<void(EncodedPacket& packet, int64_t lastSendUs)>;
+
+    struct Options {
+        std::string name;
+        StreamConfig stream;
+        size_t queueMax = 4;  // video packets
+        DropPolicy dropPolicy = DropPolicy::Frame;
+        bool enabled = true;
+        int reconnectMinMs = 250;
+        int reconnectMaxMs = 8000;
+        // Metrics are <prefix>_queue_wait_seconds, <prefix>_seconds,
+        // <prefix>_dropped_total, <prefix>_errors_total, <prefix>_queue_depth,
+        // <prefix>_connect_seconds.
+        std::string metricPrefix;
+        MetricsRegistry* metrics = nullptr;
+        BeforeSend beforeSend;
+    };
+
+    struct Stats {
+        std::string name;
+        std::string url;
+        bool enabled = false;
+        bool connected = false;
+        uint64_t packetsSent = 0;
+        uint64_t bytesSent = 0;
+        uint64_t dropped = 0;
+        uint64_t errors = 0;
+        uint64_t reconnects = 0;
+        size_t queued = 0;
+    };
+
+    PushOutput(Options options, StreamerPtr streamer);
+    ~PushOutput();
+
+    PushOutput(const PushOutput&) = delete;
+    PushOutput& operator=(const PushOutput&) = delete;
+
+    // Synchronous first connect, for outputs that must be up before start().
+    // Otherwise the send thread connects as soon as it starts, in the
+    // background, and retries with backoff.
+    bool connect();
+    void start();
+    void stop();
+
+    void pushVideo(std::shared_ptr<const EncodedPacket> packet);
+    void pushAudio(std::shared_ptr<const AudioFrame> frame);
+
+    // Disabling disconnects at once. Enabling connects synchronously while
+    // the output runs, so the caller learns whether the push came up.
+    bool setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_.load(); }
+    bool isConnected() const { return connected_.load(); }
+
+    const std::string& name() const { return options_.name; }
+    uint64_t packetsSent() const { return packetsSent_.load(); }
+    uint64_t bytesSent() const { return bytesSent_.load(); }
+    Stats stats() const;
+
+    static bool parseDropPolicy(const std::string& text, DropPolicy& out);
+
+private:
+    struct Item {
+        std::shared_ptr<const EncodedPacket> video;
+        std::shared_ptr<const AudioFrame> audio;
+        int64_t queuedAt = 0;
+    };
+
+    void sendLoop();
+    void dropForVideo();
+    // Called with streamerMutex_ held.
+    bool ensureConnected();
+    void sendVideo(const Item& item);
+    void sendAudio(const Item& item);
+
+    Options options_;
+    StreamerPtr streamer_;
+
+    std::string threadName_;  // the tracer keeps the pointer
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> enabled_{true};
+    std::atomic<bool> connected_{false};
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::deque<Item> queue_;
+    size_t queuedVideo_ = 0;
+    bool skipToKeyframe_ = false;  // Gop policy after a drop
+    bool stopping_ = false;
+
+    // Guards the streamer: send thread vs. setEnabled().
+    std::mutex streamerMutex_;
+    bool needKeyframe_ = true;  // fresh connection must start on a keyframe
+    bool everConnected_ = false;
+    int64_t nextConnectUs_ = 0;
+    int backoffMs_ = 0;
+    int64_t lastSendUs_ = 0;
+    EncodedPacket stamped_;  // beforeSend target, reused across packets
+
+    std::atomic<uint64_t> packetsSent_{0};
+    std::atomic<uint64_t> bytesSent_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> reconnects_{0};
+    std::atomic<size_t> queued_{0};
+
+    Histogram* queueWaitHist_ = nullptr;
+    Histogram* sendHist_ = nullptr;
+    Counter* droppedCounter_ = nullptr;
+    Counter* errorsCounter_ = nullptr;
+    Gauge* queueDepth_ = nullptr;
+    Histogram* connectHist_ = nullptr;
+};
+
+using PushOutputPtr = std::shared_ptr<PushOutput>;
+
+} // namespace reallive
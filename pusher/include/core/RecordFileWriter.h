@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+namespace reallive {
+
+class Histogram;
+
+// File sink for recorded segments, handed to the muxer as a custom
+// AVIOContext. Compared to avio_open() it:
+// - uses one large buffer, so the file grows in big sequential pwrite()s;
+// - fallocate()s the expected segment size up front to keep extents
+//   contiguous on SD cards, and truncates to the real size on close;
+// - optionally paces writeback with sync_file_range() every syncChunkBytes,
+//   so the kernel never builds up a segment's worth of dirty pages that
+//   later stalls the encoder thread in one flush.
+class RecordFileWriter {
+public:
+    struct Options {
+        size_t bufferBytes = 1024 * 1024;
+        uint64_t preallocateBytes = 0;   // 0 = no preallocation
+        uint64_t syncChunkBytes = 0;     // 0 = leave writeback to the kernel
+        Histogram* writeHist = nullptr;  // per pwrite()
+        Histogram* syncHist = nullptr;   // blocking writeback waits + final fdatasync
+    };
+
+    RecordFileWriter() = default;
+    ~RecordFileWriter();
+
+    RecordFileWriter(const RecordFileWriter&) = delete;
+    RecordFileWriter& operator=(const RecordFileWriter&) = delete;
+
+    bool open(const std::string& path, const Options& options);
+    AVIOContext* avio() const { return avio_; }
+    // Bytes already handed to the kernel (readable through another fd);
+    // anything past this is still in the AVIO buffer. Safe from any thread.
+    uint64_t bytesWritten() const { return static_cast<uint64_t>(written_.load()); }
+
+    // Flushes the AVIO buffer, truncates to the written size and syncs.
+    // Safe to call when not open.
+    bool close();
+
+private:
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+    using WriteBuf = const uint8_t*;
+#else
+    using WriteBuf = uint8_t*;
+#endif
+    static int writePacket(void* opaque, WriteBuf buf, int size);
+    static int64_t seekPacket(void* opaque, int64_t offset, int whence);
+
+    int write(const uint8_t* buf, int size);
+    void paceWriteback();
+
+    Options options_;
+    std::string path_;
+    int fd_ = -1;
+    AVIOContext* avio_ = nullptr;
+    int64_t pos_ = 0;
+    int64_t size_ = 0;
+    std::atomic<int64_t> written_{0};
+    int64_t syncStart_ = 0;       // start of the range not yet handed to writeback
+    int64_t pendingStart_ = 0;    // range handed off last time, waited on next time
+    int64_t pendingLen_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace reallive
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct AVCodecParameters;
+struct AVFormatContext;
+struct AVPacket;
+
+namespace reallive {
+
+// Republishes recorded segments as a live FLV/RTMP stream from inside the
+// pusher, replacing the per-session "ffmpeg -re" child.
+// - Packets are stream-copied and paced by their DTS divided by the speed,
+//   so 2x/4x/8x cost the same CPU as 1x.
+// - Output timestamps are rewritten onto one continuous timeline: segment
+//   boundaries and recording gaps collapse to a single frame step, and speed
+//   changes never make time jump backwards.
+// - Above keyframeOnlyAbove only the first frame of every GOP is sent, so the
+//   viewer decodes a flat ~GOP-rate regardless of speed. With a .idx sidecar
+//   the frames are pread() by offset and skipped frames are never read.
+class ReplayStreamer {
+public:
+    struct Segment {
+        std::string path;
+        std::string indexPath;  // empty = demux the mp4
+    };
+
+    struct Options {
+        std::vector<Segment> segments;  // oldest first, playback starts in segments[0]
+        int64_t startOffsetMs = 0;      // into segments[0], rounded down to a keyframe
+        double speed = 1.0;
+        double keyframeOnlyAbove = 4.0;
+        std::string url;
+    };
+
+    static constexpr double kMinSpeed = 0.25;
+    static constexpr double kMaxSpeed = 64.0;
+
+    ReplayStreamer() = default;
+    ~ReplayStreamer();
+
+    ReplayStreamer(const ReplayStreamer&) = delete;
+    ReplayStreamer& operator=(const ReplayStreamer&) = delete;
+
+    bool start(const Options& options);
+    void stop();
+    bool running() const { return running_.load(); }
+
+    // Takes effect from the next packet; the keyframe-only switch from the
+    // next GOP.
+    void setSpeed(double speed);
+    double speed() const { return speed_.load(); }
+    bool keyframeOnly() const { return speed_.load() > options_.keyframeOnlyAbove; }
+
+private:
+    void run();
+    bool playSegment(const Segment& segment, int64_t offsetMs);
+    bool openOutput(const AVCodecParameters* codecpar);
+    void closeOutput();
+    bool emit(AVPacket* pkt, int64_t ptsUs, int64_t dtsUs, bool keyframe);
+    bool waitUntilUs(int64_t steadyUs);
+    static int interruptCallback(void* opaque);
+
+    Options options_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopRequested_{false};
+    std::atomic<double> speed_{1.0};
+    std::mutex waitMutex_;
+    std::condition_variable waitCv_;
+
+    AVFormatContext* out_ = nullptr;
+    bool headerWritten_ = false;
+    bool outputFailed_ = false;
+
+    // Continuous timeline bookkeeping (worker thread only).
+    int64_t segmentBaseUs_ = 0;     // media time where the current segment starts
+    int64_t segmentFirstDtsUs_ = -1;
+    int64_t lastMediaUs_ = -1;
+    int64_t frameStepUs_ = 33333;   // last observed inter-frame delta
+    int64_t outUs_ = 0;             // rewritten output timeline
+    int64_t lastOutMs_ = -1;
+    int64_t anchorSteadyUs_ = -1;   // steady clock at outUs_ == 0
+    uint64_t packetsSent_ = 0;
+};
+
+} // namespace reallive
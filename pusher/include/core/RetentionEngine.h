@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace reallive {
+
+// Background retention for one stream directory. Each pass scans the
+// segment files once, tags the ones overlapping person events from
+// events.ndjson as the "event" tier, plans a batch of deletions and then
+// removes it:
+//   1. age: normal segments older than maxAgeHours, event segments older
+//      than eventMaxAgeHours;
+//   2. quota: the stream's segments (mp4 + thumbnails) above quotaBytes;
+//   3. disk: below minFreePercent free, enough bytes to reach
+//      targetFreePercent, computed from a single statvfs.
+// Quota and disk pressure take normal segments oldest-first before any
+// event segment. The newest segment is never removed, and the .writing file
+// of the segment being recorded counts toward the quota but is left alone.
+class RetentionEngine {
+public:
+    struct Policy {
+        uint64_t quotaBytes = 0;     // 0 = no per-stream quota
+        int maxAgeHours = 0;         // 0 = keep until quota/disk pressure
+        int eventMaxAgeHours = 0;    // 0 = same as maxAgeHours
+        int minFreePercent = 15;
+        int targetFreePercent = 20;
+    };
+
+    RetentionEngine() = default;
+    ~RetentionEngine();
+
+    RetentionEngine(const RetentionEngine&) = delete;
+    RetentionEngine& operator=(const RetentionEngine&) = delete;
+
+    void start(const std::string& streamDir, const Policy& policy, int intervalSec);
+    void stop();
+
+    void setPolicy(const Policy& policy);
+    Policy policy() const;
+
+    // Wakes the thread for a pass now (e.g. after a segment was finalized).
+    void requestPass();
+
+private:
+    struct Segment {
+        int64_t startMs = 0;
+        int64_t endMs = 0;
+        uint64_t bytes = 0;
+        std::string path;
+        bool eventTier = false;
+    };
+
+    void run();
+    void runPass();
+    std::vector<Segment> scanSegments(uint64_t& openBytes) const;
+    void loadNewEvents();
+    bool overlapsEvent(int64_t startMs, int64_t endMs) const;
+    static uint64_t removeSegment(const Segment& seg);
+
+    std::string streamDir_;
+    int intervalSec_ = 60;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    Policy policy_;
+    bool running_ = false;
+    bool passRequested_ = false;
+    std::thread thread_;
+
+    // Person event timestamps (sorted), read incrementally from events.ndjson.
+    std::vector<int64_t> eventTs_;
+    uint64_t eventsOffset_ = 0;
+};
+
+} // namespace reallive
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace reallive {
+
+// Per-segment sidecar ("segment_<start>_<end>.idx") written next to the mp4
+// when it is finalized, so seek/replay/export can go straight to a keyframe's
+// byte offset without demuxing, and bitrate graphs come from the GOP table.
+//
+// Little-endian layout:
+//   header  "RLIX" version(u8) reserved(3) frameCount(u32) gopCount(u32)
+//   frames  frameCount x { ptsMs(u32) offset(u64) sizeAndKey(u32) }
+//   gops    gopCount   x { ptsMs(u32) firstFrame(u32) bytes(u32) durationMs(u32) }
+// ptsMs is relative to the segment start, offset/size locate the sample data
+// inside the mp4 and the top bit of sizeAndKey marks keyframes.
+// server/src/services/historyService.js reads the same format.
+class SegmentIndex {
+public:
+    static constexpr uint8_t kVersion = 1;
+
+    struct Frame {
+        uint32_t ptsMs = 0;
+        uint64_t offset = 0;
+        uint32_t size = 0;
+        bool keyframe = false;
+    };
+
+    struct Gop {
+        uint32_t ptsMs = 0;
+        uint32_t firstFrame = 0;
+        uint32_t bytes = 0;
+        uint32_t durationMs = 0;
+    };
+
+    void clear();
+    // Frames must arrive in decode order; a keyframe starts a new GOP.
+    void addFrame(uint32_t ptsMs, uint64_t offset, uint32_t size, bool keyframe);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    const std::vector<Frame>& frames() const { return frames_; }
+    const std::vector<Gop>& gops() const { return gops_; }
+    bool empty() const { return frames_.empty(); }
+
+    // Latest keyframe with pts <= |ptsMs| (the first keyframe if none is
+    // earlier); nullptr for an index without keyframes.
+    const Frame* keyframeAtOrBefore(uint32_t ptsMs) const;
+
+    // "x/segment_a_b.mp4" -> "x/segment_a_b.idx"
+    static std::string pathFor(const std::string& mp4Path);
+
+private:
+    std::vector<Frame> frames_;
+    std::vector<Gop> gops_;
+};
+
+} // namespace reallive
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "core/SegmentIndex.h"
+
+#include <cstdint>
+#include <string>
+
+struct AVCodecParameters;
+struct AVFormatContext;
+struct AVIOInterruptCB;
+struct AVPacket;
+
+namespace reallive {
+
+// Reads the video packets of one recorded segment for stream copy. With a
+// .idx sidecar, packets are pread() straight from their sample offsets and
+// frames skipped in keyframe-only mode are never touched; otherwise the
+// mp4 is demuxed. avformat_open_input() is done either way, since the
+// codec parameters come from the moov.
+//
+// Packet pts/dts are in microseconds relative to the segment start.
+class SegmentReader {
+public:
+    SegmentReader() = default;
+    ~SegmentReader();
+
+    SegmentReader(const SegmentReader&) = delete;
+    SegmentReader& operator=(const SegmentReader&) = delete;
+
+    bool open(const std::string& path, const std::string& indexPath,
+              const AVIOInterruptCB* interrupt = nullptr);
+    void close();
+
+    const AVCodecParameters* codecpar() const;
+    bool indexed() const { return fd_ >= 0; }
+
+    // Positions on the keyframe at or before |offsetMs|.
+    void seekKeyframe(int64_t offsetMs);
+    // Keyframe closest to |offsetMs| in either direction; falls back to
+    // at-or-before without an index. Returns the chosen keyframe time.
+    int64_t seekNearestKeyframe(int64_t offsetMs);
+
+    // 1 = packet, 0 = end of segment, < 0 = error. The packet always starts
+    // on a keyframe after a seek; with |keyframesOnly| the rest of each GOP
+    // is skipped.
+    int read(AVPacket* pkt, bool keyframesOnly);
+
+private:
+    int readIndexed(AVPacket* pkt, bool keyframesOnly);
+    int readDemuxed(AVPacket* pkt, bool keyframesOnly);
+
+    std::string path_;
+    AVFormatContext* in_ = nullptr;
+    int streamIdx_ = -1;
+    int fd_ = -1;
+    SegmentIndex index_;
+    size_t gop_ = 0;
+    size_t frame_ = 0;
+    bool needKeyframe_ = true;
+};
+
+} // namespace reallive
@@ -1,74 +1,109 @@
 #pragma once
 
+#include "platform/IEncoder.h"
+
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <chrono>
 
 namespace reallive {
 
-struct PipelineTimestamps {
-    int64_t capture_ms = 0;
-    int64_t encode_start_ms = 0;
-    int64_t encode_end_ms = 0;
+// Per-frame timing carried from the sensor to the viewer. Absolute times are
+// wall-clock microseconds so receivers on other hosts can compare them with
+// their own (NTP-synced) clock; stage durations are measured locally with the
+// monotonic clock.
+struct FrameTiming {
+    int64_t sensorUs = 0;    // sensor exposure start (wall clock)
+    int64_t sentUs = 0;      // handed to the streamer (wall clock)
+    uint32_t captureUs = 0;  // sensor -> dequeued by the video loop
+    uint32_t overlayUs = 0;  // overlay compositing
+    uint32_t encodeUs = 0;   // encoder call
+    uint32_t queueUs = 0;    // wait in the send queue
+    uint32_t sendUs = 0;     // duration of the previous packet's send
+    uint32_t frameSeq = 0;
 };
 
-// Creates H.264 SEI NALUs (Annex B) carrying wall-clock timestamps.
-// UUID "RealLiveTimeSEI1" identifies the payload.
+// Creates H.264 SEI NALUs (user_data_unregistered) carrying FrameTiming.
+// UUID "RealLiveTimeSEI2" identifies the payload; all fields are
+// little-endian. Receivers parse it in their LatencyTrace (puller/, android/).
 class SeiTimestamp {
 public:
+    static constexpr size_t kPayloadSize = 16 + 8 + 8 + 6 * 4;
+
     static int64_t nowMs() {
         return std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::system_clock::now().time_since_epoch()).count();
     }
 
-    // Build an Annex-B SEI NALU and prepend it to |packet|.
-    static void inject(std::vector<uint8_t>& packet, const PipelineTimestamps& ts) {
-        // --- build raw RBSP (before emulation-prevention) ---
-        //  SEI message: type=5 (user_data_unregistered), size=40
-        //  Payload: 16-byte UUID + 3x int64 LE = 40 bytes
-        uint8_t rbsp[44]; // NAL hdr(1) + type(1) + size(1) + payload(40) + stop(1)
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Build a timing SEI NALU and prepend it to |packet| (into its headroom),
+    // using the same framing (Annex-B start code or 4-byte length) as the
+    // packet itself.
+    static void inject(EncodedPacket& packet, const FrameTiming& ts) {
+        // NAL hdr(1) + type(1) + size(1) + payload + stop(1)
+        uint8_t rbsp[3 + kPayloadSize + 1];
         rbsp[0] = 0x06;   // NAL type = SEI
         rbsp[1] = 0x05;   // payload type = user_data_unregistered
-        rbsp[2] = 40;     // payload size
-
-        // UUID "RealLiveTimeSEI1"
-        static const uint8_t kUUID[16] = {
-            0x52,0x65,0x61,0x6C, 0x4C,0x69,0x76,0x65,
-            0x54,0x69,0x6D,0x65, 0x53,0x45,0x49,0x31
-        };
-        std::memcpy(rbsp + 3, kUUID, 16);
+        rbsp[2] = static_cast<uint8_t>(kPayloadSize);
 
-        // 3 timestamps, little-endian
-        writeLE64(rbsp + 19, ts.capture_ms);
-        writeLE64(rbsp + 27, ts.encode_start_ms);
-        writeLE64(rbsp + 35, ts.encode_end_ms);
-
-        rbsp[43] = 0x80;  // RBSP stop bit
-
-        // --- emit Annex-B NALU with emulation-prevention ---
-        std::vector<uint8_t> nalu;
-        nalu.reserve(52);
-        nalu.push_back(0x00); nalu.push_back(0x00);
-        nalu.push_back(0x00); nalu.push_back(0x01); // start code
+        uint8_t* p = rbsp + 3;
+        std::memcpy(p, kUUID, 16);
+        p += 16;
+        writeLE(p, static_cast<uint64_t>(ts.sensorUs), 8); p += 8;
+        writeLE(p, static_cast<uint64_t>(ts.sentUs), 8); p += 8;
+        writeLE(p, ts.captureUs, 4); p += 4;
+        writeLE(p, ts.overlayUs, 4); p += 4;
+        writeLE(p, ts.encodeUs, 4); p += 4;
+        writeLE(p, ts.queueUs, 4); p += 4;
+        writeLE(p, ts.sendUs, 4); p += 4;
+        writeLE(p, ts.frameSeq, 4); p += 4;
+        *p = 0x80;  // RBSP stop bit
 
+        // --- escape with emulation-prevention bytes ---
+        uint8_t ebsp[8 + sizeof(rbsp) * 3 / 2];
+        size_t n = 4;
         int zeros = 0;
-        for (int i = 0; i < 44; i++) {
-            uint8_t b = rbsp[i];
+        for (size_t i = 0; i < sizeof(rbsp); i++) {
+            const uint8_t b = rbsp[i];
             if (zeros >= 2 && b <= 0x03) {
-                nalu.push_back(0x03); // emulation prevention
+                ebsp[n++] = 0x03;
                 zeros = 0;
             }
-            nalu.push_back(b);
+            ebsp[n++] = b;
             zeros = (b == 0x00) ? zeros + 1 : 0;
         }
 
+        const uint8_t* data = packet.bytes();
+        const bool annexB = packet.size() >= 4 && data[0] == 0x00 && data[1] == 0x00 &&
+                            (data[2] == 0x01 || (data[2] == 0x00 && data[3] == 0x01));
+        if (annexB) {
+            ebsp[0] = 0x00; ebsp[1] = 0x00; ebsp[2] = 0x00; ebsp[3] = 0x01;
+        } else {
+            const uint32_t naluSize = static_cast<uint32_t>(n - 4);
+            ebsp[0] = static_cast<uint8_t>((naluSize >> 24) & 0xFF);
+            ebsp[1] = static_cast<uint8_t>((naluSize >> 16) & 0xFF);
+            ebsp[2] = static_cast<uint8_t>((naluSize >> 8) & 0xFF);
+            ebsp[3] = static_cast<uint8_t>(naluSize & 0xFF);
+        }
+
         // Prepend SEI before existing slice NALUs
-        packet.insert(packet.begin(), nalu.begin(), nalu.end());
+        std::memcpy(packet.prepend(n), ebsp, n);
     }
 
 private:
-    static void writeLE64(uint8_t* p, int64_t v) {
-        for (int i = 0; i < 8; i++)
+    static constexpr uint8_t kUUID[16] = {
+        0x52,0x65,0x61,0x6C, 0x4C,0x69,0x76,0x65,
+        0x54,0x69,0x6D,0x65, 0x53,0x45,0x49,0x32
+    };
+
+    static void writeLE(uint8_t* p, uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; i++)
             p[i] = static_cast<uint8_t>((v >> (i * 8)) & 0xFF);
     }
 };
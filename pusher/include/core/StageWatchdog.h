@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace reallive {
+
+class Counter;
+class MetricsRegistry;
+
+// Deadline for one pipeline stage (camera, encoder, detector). The stage
+// calls beat() whenever it makes progress and idle() while it has nothing to
+// do; whoever supervises it polls overdue() and, when that fires, restarts
+// only that stage and reports the outcome with restarted(). The other stages
+// keep running throughout.
+//
+// Exports reallive_watchdog_<name>_restarts_total and
+// reallive_watchdog_<name>_restart_failures_total. A deadline of 0 disables
+// the check.
+class StageWatchdog {
+public:
+    StageWatchdog(std::string name, int deadlineMs, MetricsRegistry* metrics);
+
+    void beat();
+    void idle();
+    bool overdue() const;
+    // Milliseconds since the last beat, 0 while idle.
+    int64_t stalledMs() const;
+
+    // Counts the restart and re-arms the deadline, so a stage that does not
+    // come back is retried once per deadline rather than in a tight loop.
+    void restarted(bool ok);
+
+    const std::string& name() const { return name_; }
+    uint64_t restarts() const;
+
+private:
+    std::string name_;
+    int64_t deadlineUs_ = 0;
+    std::atomic<int64_t> lastBeatUs_{0};  // 0 while idle
+    Counter* restarts_ = nullptr;
+    Counter* failures_ = nullptr;
+};
+
+} // namespace reallive
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace reallive {
+
+struct SystemTelemetry {
+    double cpuPct = 0.0;
+    std::vector<double> cpuCorePct;
+    double memoryPct = 0.0;
+    double memoryUsedMb = 0.0;
+    double memoryTotalMb = 0.0;
+    double storagePct = 0.0;
+    double storageUsedGb = 0.0;
+    double storageTotalGb = 0.0;
+};
+
+// Process-wide CPU/memory/storage sampler. One background thread keeps
+// /proc/stat and /proc/meminfo open and re-reads them with pread(), so
+// consumers on hot paths (encode loop, MQTT state) only copy the latest
+// snapshot. Storage is refreshed less often since statvfs can block on slow
+// media. start()/stop() are reference counted.
+class SystemSampler {
+public:
+    static SystemSampler& instance();
+
+    void start(int intervalMs = 1000);
+    void stop();
+
+    SystemTelemetry latest() const;
+
+private:
+    struct CpuCounters {
+        uint64_t total = 0;
+        uint64_t idle = 0;
+        bool valid = false;
+    };
+
+    SystemSampler() = default;
+    ~SystemSampler();
+
+    void run();
+    void sample(bool withStorage);
+    bool readProc(int fd, std::vector<char>& buf, size_t& len);
+    void sampleCpu(SystemTelemetry& out);
+    void sampleMemory(SystemTelemetry& out);
+    static void sampleStorage(SystemTelemetry& out);
+
+    std::mutex lifecycleMutex_;
+    int users_ = 0;
+    int intervalMs_ = 1000;
+    std::thread thread_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    std::atomic<bool> running_{false};
+
+    int statFd_ = -1;
+    int meminfoFd_ = -1;
+    std::vector<char> statBuf_;
+    std::vector<char> meminfoBuf_;
+    CpuCounters prevTotal_;
+    std::vector<CpuCounters> prevCores_;
+
+    mutable std::mutex mutex_;
+    SystemTelemetry latest_;
+};
+
+} // namespace reallive
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "core/DetectionScheduler.h"
+#include "core/SystemSampler.h"
+#include "platform/IEncoder.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace reallive {
+
+struct TelemetryPerson {
+    bool active = false;
+    double score = 0.0;
+    int64_t ts = 0;
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+struct TelemetrySnapshot {
+    int64_t tsMs = 0;
+
+    // Static: only sent with key messages or when they change.
+    std::string streamKey;
+    int width = 0;
+    int height = 0;
+    int fps = 0;
+    int bitrate = 0;
+    int gop = 0;
+    std::string pixelFormat;
+    std::string codec;
+    std::string profile;
+    bool audioEnabled = false;
+    bool tfliteEnabled = false;
+    bool inferOnMotionOnly = false;
+    double personScoreThreshold = 0.0;
+
+    // Dynamic: delta-encoded against the previous message.
+    SystemTelemetry device;
+    DetectionScheduler::Snapshot detectSched;
+    TelemetryPerson person;
+    std::vector<TelemetryPerson> events;
+};
+
+// Compact binary telemetry SEI (user_data_unregistered, UUID
+// "RealLiveTelemTLV"), replacing the per-second JSON blob.
+//
+// Payload after the UUID: version(u8) flags(u8) seq(varint), then records of
+// tag(u8) len(varint) value; unknown tags are skipped. Dynamic records are
+// lists of zigzag varints holding fixed-point values; in a key message (flag
+// bit 0) they are absolute, otherwise tag|0x80 marks field-wise deltas against
+// the previous message and an unchanged record is left out (the timestamp is
+// always absolute). Static records go out with key messages (first keyframe
+// after kKeyRefreshMs, or one asked for with requestKeyMessage()) and
+// whenever they change. A decoder that sees a sequence gap drops deltas until
+// the next key message. See server/src/services/seiMonitor.js for the reference decoder.
+class TelemetrySeiEncoder {
+public:
+    static constexpr uint8_t kVersion = 1;
+    static constexpr int64_t kKeyRefreshMs = 5000;
+
+    enum Tag : uint8_t {
+        kTagStreamKey = 0x01,
+        kTagCamera = 0x02,
+        kTagConfigurable = 0x03,
+        kTagTimestamp = 0x10,
+        kTagDevice = 0x11,
+        kTagDetectSched = 0x12,
+        kTagPerson = 0x13,
+        kTagEvents = 0x20,
+        kTagDelta = 0x80,
+    };
+
+    // Whether a keyframe at |nowMs| should carry a key message even though
+    // the regular telemetry tick is not due.
+    bool wantsKeyMessage(bool isKeyframe, int64_t nowMs) const;
+    // Makes the next keyframe carry a key message, e.g. the first keyframe
+    // of a recording segment, so playback from there can decode deltas.
+    void requestKeyMessage() { keyRequested_ = true; }
+
+    // Encodes |snap| and prepends it to |packet| as an SEI NALU.
+    void inject(EncodedPacket& packet, const TelemetrySnapshot& snap);
+
+    size_t lastPayloadSize() const { return payload_.size(); }
+
+private:
+    static constexpr size_t kDynamicRecords = 4;
+
+    void encode(const TelemetrySnapshot& snap, bool key);
+    void putDynamic(size_t slot, uint8_t tag, const std::vector<int64_t>& values, bool key);
+
+    std::vector<uint8_t> payload_;
+    std::vector<uint8_t> staticRecords_;
+    std::vector<uint8_t> lastStatic_;
+    std::array<std::vector<int64_t>, kDynamicRecords> lastDynamic_;
+    std::vector<int64_t> values_;
+    std::vector<uint8_t> record_;
+    std::vector<uint8_t> rbsp_;
+    std::vector<uint8_t> ebsp_;
+    uint32_t seq_ = 0;
+    int64_t lastKeyMs_ = 0;
+    bool haveBase_ = false;
+    bool keyRequested_ = false;
+};
+
+} // namespace reallive
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace reallive {
+
+// Opt-in span tracer for offline profiling. Each thread records complete
+// spans into its own fixed-size ring (single writer, no locks on the hot
+// path); a dump merges the rings into Chrome trace JSON that loads in
+// Perfetto or chrome://tracing. Slots are seqlocked, so a dump racing the
+// writer skips the events being overwritten instead of reading them torn.
+// While disabled a span costs one relaxed load.
+class Tracer {
+public:
+    static Tracer& instance();
+
+    void configure(bool enabled, size_t eventsPerThread);
+    void setEnabled(bool enabled);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Names the calling thread in the trace (shown as the track name).
+    void setThreadName(const char* name);
+
+    // |name| must be a string literal (stored by pointer).
+    void record(const char* name, int64_t startUs, int64_t endUs, uint32_t frameId);
+
+    // Chrome trace JSON with the spans that ended within the last |seconds|
+    // (0 = everything still buffered).
+    std::string dumpJson(int seconds) const;
+    bool dumpToFile(const std::string& dir, int seconds, std::string& pathOut) const;
+
+    static int64_t nowUs();
+
+private:
+    // seq is 2n+1 while event n is being written and 2n+2 once it is
+    // complete; the fields are atomics only so a racing dump is well defined.
+    struct Event {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int64_t> startUs{0};
+        std::atomic<uint32_t> durUs{0};
+        std::atomic<uint32_t> frameId{0};
+    };
+
+    struct ThreadRing {
+        int tid = 0;
+        std::string threadName;
+        std::unique_ptr<Event[]> events;
+        size_t capacity = 0;
+        std::atomic<uint64_t> head{0};  // total events written
+    };
+
+    ThreadRing* ring();
+    void release(ThreadRing* r);
+
+    std::atomic<bool> enabled_{false};
+    size_t eventsPerThread_ = 16384;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadRing>> rings_;
+    // Rings of exited threads: still dumped until a new thread takes one.
+    std::vector<ThreadRing*> freeRings_;
+};
+
+// RAII span: records [construction, destruction) on the current thread.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, uint32_t frameId = 0)
+        : name_(name), frameId_(frameId) {
+        if (Tracer::instance().enabled()) startUs_ = Tracer::nowUs();
+    }
+    ~TraceSpan() {
+        if (startUs_ > 0) Tracer::instance().record(name_, startUs_, Tracer::nowUs(), frameId_);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void setFrameId(uint32_t frameId) { frameId_ = frameId; }
+
+private:
+    const char* name_;
+    uint32_t frameId_;
+    int64_t startUs_ = 0;
+};
+
+} // namespace reallive
@@ -12,6 +12,8 @@ struct AudioConfig {
     int channels = 1;
     int bitsPerSample = 16;
     std::string device;  // e.g. "default" or "hw:0,0"
+    std::string backend; // ComponentRegistry name; empty = platform default
+    std::string source;  // file backend: .wav or raw s16le
 };
 
 struct AudioFrame {
@@ -13,6 +13,8 @@ struct CaptureConfig {
     int fps = 30;
     std::string device;   // e.g. "/dev/video0" or camera index
     std::string pixelFormat; // e.g. "NV12", "YUV420"
+    std::string backend;  // ComponentRegistry name; empty = platform default
+    std::string source;   // file backend: .y4m, raw .nv12/.yuv, or any container FFmpeg reads
 };
 
 struct Frame {
@@ -33,6 +35,8 @@ public:
     virtual bool open(const CaptureConfig& config) = 0;
     virtual bool start() = 0;
     virtual bool stop() = 0;
+    // Releases the device so open() can start from scratch (watchdog reopen).
+    virtual void close() = 0;
     virtual Frame captureFrame() = 0;
     virtual bool isOpen() const = 0;
     virtual std::string getName() const = 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ICameraCapture.h"
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -17,17 +18,41 @@ struct EncoderConfig {
     std::string profile = "main"; // baseline, main, high
     int gopSize = 60;             // keyframe interval in frames
     std::string inputFormat = "NV12";
+    int threads = 0;              // encoder threads, 0 = codec default
+    std::string backend;          // ComponentRegistry name; empty = platform default
 };
 
 struct EncodedPacket {
+    // The bitstream starts at data[offset]. Encoders leave kHeadroom bytes in
+    // front of it so SEI NALUs can be prepended without moving the payload.
+    static constexpr size_t kHeadroom = 512;
+
     std::vector<uint8_t> data;
+    size_t offset = 0;
     int64_t pts = 0;   // presentation timestamp in microseconds
     int64_t dts = 0;   // decode timestamp in microseconds
     bool isKeyframe = false;
     int64_t captureTime = 0;  // capture timestamp (steady_clock microseconds since start)
     int64_t encodeTime = 0;  // encoding duration in microseconds
+    int64_t sensorTime = 0;   // sensor timestamp of the source frame (steady_clock microseconds)
+    int64_t overlayTime = 0;  // overlay compositing duration in microseconds
+    int64_t queuedAt = 0;     // pushed to the send queue (steady_clock microseconds)
+    uint32_t frameSeq = 0;
+
+    const uint8_t* bytes() const { return data.data() + offset; }
+    size_t size() const { return data.size() - offset; }
+    bool empty() const { return size() == 0; }
 
-    bool empty() const { return data.empty(); }
+    // Extends the bitstream by |n| bytes at the front and returns the new
+    // start; falls back to shifting the buffer when the headroom is used up.
+    uint8_t* prepend(size_t n) {
+        if (n > offset) {
+            data.insert(data.begin(), n - offset, 0);
+            offset = n;
+        }
+        offset -= n;
+        return data.data() + offset;
+    }
 };
 
 class IEncoder {
@@ -13,12 +13,14 @@ struct StreamConfig {
     bool enableAudio = false;
     int connectTimeoutMs = 5000;
     int writeTimeoutMs = 3000;
+    bool latencySei = false;  // per-frame timing SEI (see core/SeiTimestamp.h)
 
     // Video codec parameters for the muxer (SPS/PPS extradata)
     const uint8_t* videoExtraData = nullptr;
     int videoExtraDataSize = 0;
     int videoWidth = 0;
     int videoHeight = 0;
+    int videoBitrate = 0;  // bits per second, for streamers that pace output
 };
 
 class IStreamer {
@@ -0,0 +1,209 @@
+#include "core/ClipExporter.h"
+#include "core/SegmentReader.h"
+
+#include <algorithm>
+#include <iostream>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace reallive {
+
+namespace {
+
+constexpr int kAvioBufferBytes = 64 * 1024;
+constexpr int64_t kDefaultFrameStepUs = 33333;
+constexpr AVRational kMicros = {1, 1000000};
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+using WriteBuf = const uint8_t*;
+#else
+using WriteBuf = uint8_t*;
+#endif
+
+struct SinkState {
+    const ClipExporter::Sink* sink = nullptr;
+    const std::atomic<bool>* cancel = nullptr;
+    uint64_t bytes = 0;
+    bool failed = false;
+};
+
+int writePacket(void* opaque, WriteBuf buf, int size) {
+    auto* state = static_cast<SinkState*>(opaque);
+    if (state->failed || state->cancel->load() || !(*state->sink)(buf, static_cast<size_t>(size))) {
+        state->failed = true;
+        return AVERROR(EPIPE);
+    }
+    state->bytes += static_cast<uint64_t>(size);
+    return size;
+}
+
+int interruptCallback(void* opaque) {
+    return static_cast<SinkState*>(opaque)->cancel->load() ? 1 : 0;
+}
+
+std::string ffErr(int code) {
+    char buf[256];
+    av_strerror(code, buf, sizeof(buf));
+    return std::string(buf);
+}
+
+AVFormatContext* openOutput(const AVCodecParameters* codecpar, SinkState* state, bool exactStart) {
+    AVFormatContext* out = nullptr;
+    int ret = avformat_alloc_output_context2(&out, nullptr, "mp4", nullptr);
+    if (ret < 0 || !out) {
+        std::cerr << "[Export] Failed to allocate output context: " << ffErr(ret) << std::endl;
+        return nullptr;
+    }
+    out->interrupt_callback = {&interruptCallback, state};
+    out->flags |= AVFMT_FLAG_FLUSH_PACKETS;
+
+    AVStream* stream = avformat_new_stream(out, nullptr);
+    auto* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferBytes));
+    if (!stream || !buffer || avcodec_parameters_copy(stream->codecpar, codecpar) < 0) {
+        av_free(buffer);
+        avformat_free_context(out);
+        return nullptr;
+    }
+    stream->codecpar->codec_tag = 0;
+    stream->time_base = {1, 90000};
+
+    // Non-seekable: the client receives bytes as soon as they are muxed.
+    out->pb = avio_alloc_context(buffer, kAvioBufferBytes, 1, state, nullptr, &writePacket, nullptr);
+    if (!out->pb) {
+        av_free(buffer);
+        avformat_free_context(out);
+        return nullptr;
+    }
+    out->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    // One fragment per GOP. delay_moov lets the muxer see the negative
+    // lead-in timestamps before writing the moov, so it can emit the edit list.
+    AVDictionary* opts = nullptr;
+    av_dict_set(&opts, "movflags",
+                exactStart ? "frag_keyframe+empty_moov+default_base_moof+delay_moov"
+                           : "frag_keyframe+empty_moov+default_base_moof",
+                0);
+    ret = avformat_write_header(out, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        std::cerr << "[Export] Failed to write header: " << ffErr(ret) << std::endl;
+        av_freep(&out->pb->buffer);
+        avio_context_free(&out->pb);
+        avformat_free_context(out);
+        return nullptr;
+    }
+    return out;
+}
+
+void closeOutput(AVFormatContext* out, bool writeTrailer, bool& ok) {
+    if (!out) return;
+    if (writeTrailer) {
+        const int ret = av_write_trailer(out);
+        if (ret < 0) ok = false;
+    }
+    avio_flush(out->pb);
+    av_freep(&out->pb->buffer);
+    avio_context_free(&out->pb);
+    avformat_free_context(out);
+}
+
+} // namespace
+
+ClipExporter::Result ClipExporter::run(const Options& options, const Sink& sink, const std::atomic<bool>& cancel) {
+    Result result;
+    if (options.segments.empty() || options.endMs <= options.startMs) return result;
+
+    SinkState state;
+    state.sink = &sink;
+    state.cancel = &cancel;
+    const AVIOInterruptCB interrupt{&interruptCallback, &state};
+    const bool exact = options.startMode == StartMode::Exact;
+    const int64_t endUs = options.endMs * 1000;
+
+    AVFormatContext* out = nullptr;
+    AVPacket* pkt = av_packet_alloc();
+    bool ok = pkt != nullptr;
+    bool done = false;
+
+    int64_t segmentBaseUs = 0;   // output time where the current segment's zero lands
+    int64_t lastOutUs = -1;
+    int64_t firstOutUs = -1;
+    int64_t frameStepUs = kDefaultFrameStepUs;
+    int64_t lastDts = 0;         // in the output stream time base
+
+    for (size_t i = 0; ok && !done && !cancel && i < options.segments.size(); i++) {
+        const Segment& segment = options.segments[i];
+        SegmentReader reader;
+        if (!reader.open(segment.path, segment.indexPath, &interrupt)) continue;
+        if (!out) {
+            out = openOutput(reader.codecpar(), &state, exact);
+            if (!out) {
+                ok = false;
+                break;
+            }
+        }
+
+        // Segment-relative time that maps to segmentBaseUs on the output.
+        int64_t zeroUs = -1;
+        if (lastOutUs < 0) {
+            const int64_t offsetMs = std::max<int64_t>(0, options.startMs - segment.startMs);
+            if (exact) {
+                reader.seekKeyframe(offsetMs);
+                zeroUs = offsetMs * 1000;
+            } else {
+                reader.seekNearestKeyframe(offsetMs);
+            }
+        }
+
+        int ret = 0;
+        while (ok && !cancel && (ret = reader.read(pkt, false)) > 0) {
+            if ((segment.startMs * 1000 + pkt->pts) > endUs) {
+                done = true;
+                av_packet_unref(pkt);
+                break;
+            }
+            if (zeroUs < 0) zeroUs = pkt->dts;
+            const int64_t outUs = segmentBaseUs + (pkt->dts - zeroUs);
+            if (lastOutUs >= 0 && outUs > lastOutUs) frameStepUs = outUs - lastOutUs;
+            lastOutUs = outUs;
+            if (firstOutUs < 0) firstOutUs = outUs;
+
+            // Lead-in frames of an exact start come out negative; the muxer
+            // turns that into the edit list.
+            AVStream* stream = out->streams[0];
+            const int64_t ctsUs = std::max<int64_t>(0, pkt->pts - pkt->dts);
+            int64_t dts = av_rescale_q(outUs, kMicros, stream->time_base);
+            if (result.packets > 0) dts = std::max(lastDts + 1, dts);
+            lastDts = dts;
+            pkt->dts = dts;
+            pkt->pts = dts + av_rescale_q(ctsUs, kMicros, stream->time_base);
+            pkt->stream_index = 0;
+            pkt->duration = 0;
+            pkt->pos = -1;
+            const int wret = av_write_frame(out, pkt);
+            av_packet_unref(pkt);
+            if (wret < 0) {
+                if (!state.failed) std::cerr << "[Export] write failed: " << ffErr(wret) << std::endl;
+                ok = false;
+                break;
+            }
+            result.packets++;
+        }
+        if (ret < 0) ok = false;
+        // Continue the next segment one frame step after this one.
+        if (lastOutUs >= 0) segmentBaseUs = lastOutUs + frameStepUs;
+    }
+
+    av_packet_free(&pkt);
+    closeOutput(out, out && ok && !cancel, ok);
+    result.ok = ok && !cancel && !state.failed && result.packets > 0;
+    result.bytes = state.bytes;
+    if (firstOutUs >= 0) result.durationMs = (lastOutUs - firstOutUs + frameStepUs) / 1000;
+    return result;
+}
+
+} // namespace reallive
@@ -0,0 +1,128 @@
+#include "core/ComponentRegistry.h"
+
+#include "platform/generic/AvcodecEncoder.h"
+#include "platform/generic/FileAudioCapture.h"
+#include "platform/generic/FileCapture.h"
+#include "platform/generic/SyntheticAudioCapture.h"
+#include "platform/generic/SyntheticCapture.h"
+#ifdef REALLIVE_HAS_LIBCAMERA
+#include "platform/rpi5/LibcameraCapture.h"
+#endif
+#ifdef REALLIVE_HAS_ALSA
+#include "platform/rpi5/AlsaCapture.h"
+#endif
+
+#include <iostream>
+#include <utility>
+
+namespace reallive {
+
+ComponentRegistry& ComponentRegistry::instance() {
+    static ComponentRegistry registry;
+    return registry;
+}
+
+ComponentRegistry::ComponentRegistry() {
+    // Registration order sets the defaults: real hardware first.
+#ifdef REALLIVE_HAS_LIBCAMERA
+    registerCamera("libcamera", [] { return std::make_unique<LibcameraCapture>(); });
+#endif
+    registerCamera("synthetic", [] { return std::make_unique<SyntheticCapture>(); });
+    registerCamera("file", [] { return std::make_unique<FileCapture>(); });
+
+#ifdef REALLIVE_HAS_ALSA
+    registerAudio("alsa", [] { return std::make_unique<AlsaCapture>(); });
+#endif
+    registerAudio("synthetic", [] { return std::make_unique<SyntheticAudioCapture>(); });
+    registerAudio("file", [] { return std::make_unique<FileAudioCapture>(); });
+
+    registerEncoder("avcodec", [] { return std::make_unique<AvcodecEncoder>(); });
+}
+
+template <typename Factory>
+void ComponentRegistry::put(std::vector<Backend<Factory>>& backends, const std::string& name, Factory factory) {
+    for (auto& backend : backends) {
+        if (backend.name == name) {
+            backend.factory = std::move(factory);
+            return;
+        }
+    }
+    backends.push_back(Backend<Factory>{name, std::move(factory)});
+}
+
+template <typename Factory>
+const ComponentRegistry::Backend<Factory>* ComponentRegistry::pick(const std::vector<Backend<Factory>>& backends,
+                                                                   const std::string& name, const char* kind) {
+    if (name.empty()) {
+        if (!backends.empty()) return &backends.front();
+    } else {
+        for (const auto& backend : backends) {
+            if (backend.name == name) return &backend;
+        }
+    }
+    std::cerr << "[Registry] No " << kind << " backend '" << name << "'; available:";
+    for (const auto& backend : backends) {
+        std::cerr << " " << backend.name;
+    }
+    std::cerr << std::endl;
+    return nullptr;
+}
+
+template <typename Factory>
+std::vector<std::string> ComponentRegistry::names(const std::vector<Backend<Factory>>& backends) {
+    std::vector<std::string> out;
+    for (const auto& backend : backends) {
+        out.push_back(backend.name);
+    }
+    return out;
+}
+
+void ComponentRegistry::registerCamera(const std::string& name, CameraFactory factory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    put(cameras_, name, std::move(factory));
+}
+
+void ComponentRegistry::registerAudio(const std::string& name, AudioFactory factory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    put(audio_, name, std::move(factory));
+}
+
+void ComponentRegistry::registerEncoder(const std::string& name, EncoderFactory factory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    put(encoders_, name, std::move(factory));
+}
+
+CameraCapturePtr ComponentRegistry::createCamera(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto* backend = pick(cameras_, name, "camera");
+    return backend ? backend->factory() : nullptr;
+}
+
+AudioCapturePtr ComponentRegistry::createAudio(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto* backend = pick(audio_, name, "audio");
+    return backend ? backend->factory() : nullptr;
+}
+
+EncoderPtr ComponentRegistry::createEncoder(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto* backend = pick(encoders_, name, "encoder");
+    return backend ? backend->factory() : nullptr;
+}
+
+std::vector<std::string> ComponentRegistry::cameraBackends() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names(cameras_);
+}
+
+std::vector<std::string> ComponentRegistry::audioBackends() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names(audio_);
+}
+
+std::vector<std::string> ComponentRegistry::encoderBackends() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names(encoders_);
+}
+
+} // namespace reallive
@@ -61,12 +61,169 @@ bool jsonBool(const std::string& json, const std::string& key, bool defaultVal)
     return val == "true";
 }
 
+// Extract the raw text of an array/object value (brackets included).
+std::string jsonRaw(const std::string& json, const std::string& key) {
+    std::string search = "\"" + key + "\"";
+    size_t pos = json.find(search);
+    if (pos == std::string::npos) return "";
+    pos = json.find(':', pos + search.size());
+    if (pos == std::string::npos) return "";
+    pos = json.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == std::string::npos) return "";
+    const char open = json[pos];
+    if (open != '[' && open != '{') return "";
+
+    int depth = 0;
+    bool inString = false;
+    for (size_t i = pos; i < json.size(); i++) {
+        const char c = json[i];
+        if (inString) {
+            if (c == '\\') i++;
+            else if (c == '"') inString = false;
+            continue;
+        }
+        if (c == '"') inString = true;
+        else if (c == '[' || c == '{') depth++;
+        else if (c == ']' || c == '}') {
+            if (--depth == 0) return json.substr(pos, i - pos + 1);
+        }
+    }
+    return "";
+}
+
+// Split a raw JSON array into its top-level object elements.
+std::vector<std::string> jsonObjects(const std::string& rawArray) {
+    std::vector<std::string> out;
+    int depth = 0;
+    bool inString = false;
+    size_t start = std::string::npos;
+    for (size_t i = 0; i < rawArray.size(); i++) {
+        const char c = rawArray[i];
+        if (inString) {
+            if (c == '\\') i++;
+            else if (c == '"') inString = false;
+            continue;
+        }
+        if (c == '"') {
+            inString = true;
+        } else if (c == '{') {
+            if (depth++ == 1) start = i;
+        } else if (c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 1 && c == '}' && start != std::string::npos) {
+                out.push_back(rawArray.substr(start, i - start + 1));
+                start = std::string::npos;
+            }
+        }
+    }
+    return out;
+}
+
+// Parse "points": [[x, y], ...] into normalized coordinate pairs.
+std::vector<std::pair<double, double>> jsonPoints(const std::string& rawArray) {
+    std::vector<double> numbers;
+    const char* p = rawArray.c_str();
+    while (*p) {
+        if (*p == '-' || *p == '.' || (*p >= '0' && *p <= '9')) {
+            char* end = nullptr;
+            numbers.push_back(std::strtod(p, &end));
+            if (end == p) break;
+            p = end;
+        } else {
+            p++;
+        }
+    }
+    std::vector<std::pair<double, double>> points;
+    for (size_t i = 0; i + 1 < numbers.size(); i += 2) {
+        points.emplace_back(std::max(0.0, std::min(1.0, numbers[i])),
+                            std::max(0.0, std::min(1.0, numbers[i + 1])));
+    }
+    return points;
+}
+
+std::vector<MotionZoneConfig> parseMotionZones(const std::string& json) {
+    std::vector<MotionZoneConfig> zones;
+    for (const std::string& obj : jsonObjects(jsonRaw(json, "detect_zones"))) {
+        MotionZoneConfig zone;
+        zone.name = jsonValue(obj, "name");
+        zone.exclude = jsonValue(obj, "mode") != "include";
+        zone.points = jsonPoints(jsonRaw(obj, "points"));
+        zone.diffThreshold = std::max(0, std::min(255, jsonInt(obj, "diff_threshold", 0)));
+        const std::string ratio = jsonValue(obj, "motion_ratio");
+        if (!ratio.empty()) {
+            const double value = std::atof(ratio.c_str());
+            if (value > 0.0 && value < 1.0) zone.motionRatio = value;
+        }
+        if (zone.points.size() < 3) {
+            std::cerr << "[Config] Ignoring motion zone '" << zone.name
+                      << "': needs at least 3 points" << std::endl;
+            continue;
+        }
+        zones.push_back(std::move(zone));
+    }
+    return zones;
+}
+
+std::vector<PushDestinationConfig> parsePushDestinations(const std::string& json) {
+    std::vector<PushDestinationConfig> destinations;
+    for (const std::string& obj : jsonObjects(jsonRaw(json, "push_destinations"))) {
+        PushDestinationConfig dest;
+        dest.name = jsonValue(obj, "name");
+        dest.url = jsonValue(obj, "url");
+        dest.streamKey = jsonValue(obj, "stream_key");
+        dest.enabled = jsonBool(obj, "enable", dest.enabled);
+        dest.queueMax = std::max(1, jsonInt(obj, "queue_max", dest.queueMax));
+        const std::string policy = jsonValue(obj, "drop_policy");
+        if (!policy.empty()) dest.dropPolicy = policy;
+        if (dest.name.empty() || dest.url.empty()) {
+            std::cerr << "[Config] Ignoring push destination '" << dest.name
+                      << "': needs name and url" << std::endl;
+            continue;
+        }
+        destinations.push_back(std::move(dest));
+    }
+    return destinations;
+}
+
+std::vector<CameraInstanceConfig> parseCameras(const std::string& json) {
+    std::vector<CameraInstanceConfig> cameras;
+    size_t index = 0;
+    for (const std::string& obj : jsonObjects(jsonRaw(json, "cameras"))) {
+        CameraInstanceConfig cam;
+        cam.index = index++;
+        cam.streamKey = jsonValue(obj, "stream_key");
+        cam.cameraId = jsonValue(obj, "camera_id");
+        cam.cameraBackend = jsonValue(obj, "camera_backend");
+        cam.cameraSource = jsonValue(obj, "camera_source");
+        cam.url = jsonValue(obj, "url");
+        cam.width = std::max(0, jsonInt(obj, "width", 0));
+        cam.height = std::max(0, jsonInt(obj, "height", 0));
+        cam.fps = std::max(0, jsonInt(obj, "fps", 0));
+        cam.bitrate = std::max(0, jsonInt(obj, "bitrate", 0));
+        cam.lanFlvPort = std::max(0, jsonInt(obj, "lan_flv_port", 0));
+        cam.overlayCameraName = jsonValue(obj, "overlay_camera_name");
+        if (!jsonBool(obj, "enable", true)) continue;
+        const bool duplicate = std::any_of(cameras.begin(), cameras.end(), [&](const CameraInstanceConfig& c) {
+            return c.streamKey == cam.streamKey;
+        });
+        if (cam.streamKey.empty() || duplicate) {
+            std::cerr << "[Config] Ignoring camera '" << cam.cameraId
+                      << "': needs a unique stream_key" << std::endl;
+            continue;
+        }
+        cameras.push_back(std::move(cam));
+    }
+    return cameras;
+}
+
 } // anonymous namespace
 
 Config::Config() {
     // Set defaults - 720p @ 15fps for software encoding on Pi 5
     config_.stream.url = "rtmp://localhost:1935/live";
     config_.stream.streamKey = "";
+    config_.stream.latencySei = false;
     config_.camera.width = 1280;
     config_.camera.height = 720;
     config_.camera.fps = 15;
@@ -78,6 +235,7 @@ Config::Config() {
     config_.encoder.bitrate = 2000000;  // 2Mbps for 720p
     config_.encoder.profile = "main";
     config_.encoder.gopSize = 30;
+    config_.encoder.threads = 0;
     config_.encoder.inputFormat = "NV12";
     config_.audio.sampleRate = 44100;
     config_.audio.channels = 1;
@@ -88,12 +246,32 @@ Config::Config() {
     config_.record.segmentDurationSec = 60;
     config_.record.minFreePercent = 15;
     config_.record.targetFreePercent = 20;
+    config_.record.quotaMb = 0;
+    config_.record.maxAgeHours = 0;
+    config_.record.eventMaxAgeHours = 0;
+    config_.record.retentionIntervalSec = 60;
+    config_.record.writeBufferKb = 1024;
+    config_.record.preallocate = true;
+    config_.record.syncChunkKb = 4096;
     config_.record.generateThumbnails = true;
+    config_.record.mode = "continuous";
+    config_.record.preRollSec = 5;
+    config_.record.postRollSec = 10;
+    config_.record.eventOnMotion = false;
     config_.control.enabled = false;
     config_.control.host = "0.0.0.0";
     config_.control.port = 8090;
     config_.control.replayRtmpBase = "rtmp://localhost:1935/history";
-    config_.control.ffmpegBin = "ffmpeg";
+    config_.control.replayMaxSpeed = 16.0;
+    config_.control.replayKeyframeOnlySpeed = 4.0;
+    config_.control.fileRateKbps = 8000;
+    config_.push.queueMax = 4;
+    config_.push.dropPolicy = "frame";
+    config_.lanFlv.enabled = false;
+    config_.lanFlv.host = "0.0.0.0";
+    config_.lanFlv.port = 8091;
+    config_.lanFlv.maxClients = 32;
+    config_.lanFlv.queueKb = 4096;
     config_.detection.enabled = true;
     config_.detection.drawOverlay = true;
     config_.detection.intervalFrames = 2;
@@ -110,6 +288,22 @@ Config::Config() {
     config_.detection.tfliteInputSize = 320;
     config_.detection.personScoreThreshold = 0.55;
     config_.detection.inferMinIntervalMs = 220;
+    config_.detection.adaptiveEnabled = false;
+    config_.detection.adaptiveTargetCpuPct = 75.0;
+    config_.detection.adaptiveMaxIntervalFrames = 8;
+    config_.detection.adaptiveMinInferIntervalMs = 100;
+    config_.detection.adaptiveMaxInferIntervalMs = 1000;
+    config_.detection.adaptiveMaxTiles = 2;
+    config_.overlay.cameraName = "";
+    config_.overlay.scale = 2;
+    config_.overlay.trackLabels = true;
+    config_.trace.enabled = false;
+    config_.trace.bufferEvents = 16384;
+    config_.trace.outputDir = "/tmp/reallive-traces";
+    config_.trace.dumpSeconds = 30;
+    config_.watchdog.cameraMs = 3000;
+    config_.watchdog.encoderMs = 3000;
+    config_.watchdog.detectorMs = 10000;
     config_.mqtt.enabled = false;
     config_.mqtt.host = "127.0.0.1";
     config_.mqtt.port = 1883;
@@ -120,7 +314,10 @@ Config::Config() {
     config_.mqtt.keepaliveSec = 30;
     config_.mqtt.commandQos = 1;
     config_.mqtt.stateQos = 0;
-    config_.mqtt.stateIntervalMs = 1000;
+    config_.mqtt.stateIntervalMs = 250;
+    config_.mqtt.stateHeartbeatMs = 5000;
+    config_.mqtt.eventQos = 1;
+    config_.mqtt.eventQueueMax = 256;
     config_.enableAudio = false;
 }
 
@@ -145,6 +342,7 @@ bool Config::parseJson(const std::string& jsonStr) {
 
     std::string streamKey = jsonValue(jsonStr, "stream_key");
     if (!streamKey.empty()) config_.stream.streamKey = streamKey;
+    config_.stream.latencySei = jsonBool(jsonStr, "latency_sei_enable", config_.stream.latencySei);
 
     // Camera section
     int w = jsonInt(jsonStr, "width", 0);
@@ -163,6 +361,13 @@ bool Config::parseJson(const std::string& jsonStr) {
         config_.encoder.fps = fps;
     }
 
+    std::string cameraId = jsonValue(jsonStr, "camera_id");
+    if (!cameraId.empty()) config_.camera.device = cameraId;
+    std::string cameraBackend = jsonValue(jsonStr, "camera_backend");
+    if (!cameraBackend.empty()) config_.camera.backend = cameraBackend;
+    std::string cameraSource = jsonValue(jsonStr, "camera_source");
+    if (!cameraSource.empty()) config_.camera.source = cameraSource;
+
     // Encoder section
     std::string codec = jsonValue(jsonStr, "codec");
     if (!codec.empty()) config_.encoder.codec = codec;
@@ -175,6 +380,9 @@ bool Config::parseJson(const std::string& jsonStr) {
 
     int gop = jsonInt(jsonStr, "gop", 0);
     if (gop > 0) config_.encoder.gopSize = gop;
+    config_.encoder.threads = std::max(0, jsonInt(jsonStr, "encoder_threads", config_.encoder.threads));
+    std::string encoderBackend = jsonValue(jsonStr, "encoder_backend");
+    if (!encoderBackend.empty()) config_.encoder.backend = encoderBackend;
 
     // Audio section
     config_.enableAudio = jsonBool(jsonStr, "enable_audio", false);
@@ -187,6 +395,10 @@ bool Config::parseJson(const std::string& jsonStr) {
 
     std::string audioDevice = jsonValue(jsonStr, "audio_device");
     if (!audioDevice.empty()) config_.audio.device = audioDevice;
+    std::string audioBackend = jsonValue(jsonStr, "audio_backend");
+    if (!audioBackend.empty()) config_.audio.backend = audioBackend;
+    std::string audioSource = jsonValue(jsonStr, "audio_source");
+    if (!audioSource.empty()) config_.audio.source = audioSource;
 
     // Local recording section
     config_.record.enabled = jsonBool(jsonStr, "enable_record", config_.record.enabled);
@@ -202,9 +414,36 @@ bool Config::parseJson(const std::string& jsonStr) {
     int targetFreePct = jsonInt(jsonStr, "record_target_free_percent", 0);
     if (targetFreePct > 0) config_.record.targetFreePercent = targetFreePct;
 
+    config_.record.quotaMb = std::max(0, jsonInt(jsonStr, "record_quota_mb", config_.record.quotaMb));
+    config_.record.maxAgeHours = std::max(
+        0, jsonInt(jsonStr, "record_max_age_hours", config_.record.maxAgeHours));
+    config_.record.eventMaxAgeHours = std::max(
+        0, jsonInt(jsonStr, "record_event_max_age_hours", config_.record.eventMaxAgeHours));
+    config_.record.retentionIntervalSec = std::max(
+        5, jsonInt(jsonStr, "record_retention_interval_sec", config_.record.retentionIntervalSec));
+    config_.record.writeBufferKb = std::max(
+        64, std::min(16384, jsonInt(jsonStr, "record_write_buffer_kb", config_.record.writeBufferKb)));
+    config_.record.preallocate = jsonBool(jsonStr, "record_preallocate", config_.record.preallocate);
+    config_.record.syncChunkKb = std::max(
+        0, jsonInt(jsonStr, "record_sync_chunk_kb", config_.record.syncChunkKb));
+
     config_.record.generateThumbnails = jsonBool(
         jsonStr, "record_thumbnail", config_.record.generateThumbnails);
 
+    std::string recordMode = jsonValue(jsonStr, "record_mode");
+    if (recordMode == "continuous" || recordMode == "event") {
+        config_.record.mode = recordMode;
+    } else if (!recordMode.empty()) {
+        std::cerr << "[Config] Unknown record_mode '" << recordMode << "', using "
+                  << config_.record.mode << std::endl;
+    }
+    config_.record.preRollSec = std::max(
+        0, std::min(60, jsonInt(jsonStr, "record_preroll_seconds", config_.record.preRollSec)));
+    config_.record.postRollSec = std::max(
+        1, jsonInt(jsonStr, "record_postroll_seconds", config_.record.postRollSec));
+    config_.record.eventOnMotion = jsonBool(
+        jsonStr, "record_event_on_motion", config_.record.eventOnMotion);
+
     config_.control.enabled = jsonBool(
         jsonStr, "control_enable", config_.control.enabled);
     std::string controlHost = jsonValue(jsonStr, "control_host");
@@ -213,8 +452,34 @@ bool Config::parseJson(const std::string& jsonStr) {
     if (controlPort > 0) config_.control.port = controlPort;
     std::string replayRtmpBase = jsonValue(jsonStr, "replay_rtmp_base");
     if (!replayRtmpBase.empty()) config_.control.replayRtmpBase = replayRtmpBase;
-    std::string ffmpegBin = jsonValue(jsonStr, "ffmpeg_bin");
-    if (!ffmpegBin.empty()) config_.control.ffmpegBin = ffmpegBin;
+    const int replayMaxSpeed = jsonInt(jsonStr, "replay_max_speed", 0);
+    if (replayMaxSpeed > 0) config_.control.replayMaxSpeed = std::min(64, replayMaxSpeed);
+    const int keyframeOnlySpeed = jsonInt(jsonStr, "replay_keyframe_only_speed", -1);
+    if (keyframeOnlySpeed >= 0) config_.control.replayKeyframeOnlySpeed = keyframeOnlySpeed;
+    config_.control.fileRateKbps = std::max(
+        0, jsonInt(jsonStr, "control_file_rate_kbps", config_.control.fileRateKbps));
+
+    config_.push.queueMax = std::max(
+        1, jsonInt(jsonStr, "push_queue_max", config_.push.queueMax));
+    std::string pushDropPolicy = jsonValue(jsonStr, "push_drop_policy");
+    if (!pushDropPolicy.empty()) config_.push.dropPolicy = pushDropPolicy;
+    if (jsonStr.find("\"push_destinations\"") != std::string::npos) {
+        config_.push.destinations = parsePushDestinations(jsonStr);
+    }
+    if (jsonStr.find("\"cameras\"") != std::string::npos) {
+        config_.cameras = parseCameras(jsonStr);
+    }
+
+    config_.lanFlv.enabled = jsonBool(
+        jsonStr, "lan_flv_enable", config_.lanFlv.enabled);
+    std::string lanFlvHost = jsonValue(jsonStr, "lan_flv_host");
+    if (!lanFlvHost.empty()) config_.lanFlv.host = lanFlvHost;
+    int lanFlvPort = jsonInt(jsonStr, "lan_flv_port", 0);
+    if (lanFlvPort > 0) config_.lanFlv.port = lanFlvPort;
+    config_.lanFlv.maxClients = std::max(
+        1, jsonInt(jsonStr, "lan_flv_max_clients", config_.lanFlv.maxClients));
+    config_.lanFlv.queueKb = std::max(
+        256, jsonInt(jsonStr, "lan_flv_queue_kb", config_.lanFlv.queueKb));
 
     config_.detection.enabled = jsonBool(
         jsonStr, "detect_enable", config_.detection.enabled);
@@ -274,6 +539,56 @@ bool Config::parseJson(const std::string& jsonStr) {
         const std::string labelPath = jsonValue(jsonStr, "detect_tflite_labels");
         if (!labelPath.empty()) config_.detection.tfliteLabelPath = labelPath;
     }
+    config_.detection.adaptiveEnabled = jsonBool(
+        jsonStr, "detect_adaptive_enable", config_.detection.adaptiveEnabled);
+    {
+        const std::string targetCpu = jsonValue(jsonStr, "detect_adaptive_target_cpu_pct");
+        if (!targetCpu.empty()) {
+            const double value = std::atof(targetCpu.c_str());
+            if (value >= 10.0 && value <= 98.0) {
+                config_.detection.adaptiveTargetCpuPct = value;
+            }
+        }
+    }
+    config_.detection.adaptiveMaxIntervalFrames = std::max(
+        config_.detection.intervalFrames,
+        jsonInt(jsonStr, "detect_adaptive_max_interval_frames", config_.detection.adaptiveMaxIntervalFrames));
+    config_.detection.adaptiveMinInferIntervalMs = std::max(
+        10, jsonInt(jsonStr, "detect_adaptive_min_infer_interval_ms", config_.detection.adaptiveMinInferIntervalMs));
+    config_.detection.adaptiveMaxInferIntervalMs = std::max(
+        config_.detection.adaptiveMinInferIntervalMs,
+        jsonInt(jsonStr, "detect_adaptive_max_infer_interval_ms", config_.detection.adaptiveMaxInferIntervalMs));
+    config_.detection.adaptiveMaxTiles = std::max(
+        1, std::min(4, jsonInt(jsonStr, "detect_adaptive_max_tiles", config_.detection.adaptiveMaxTiles)));
+    if (jsonStr.find("\"detect_zones\"") != std::string::npos) {
+        config_.detection.zones = parseMotionZones(jsonStr);
+    }
+
+    {
+        const std::string cameraName = jsonValue(jsonStr, "overlay_camera_name");
+        if (!cameraName.empty()) config_.overlay.cameraName = cameraName;
+    }
+    config_.overlay.scale = std::max(
+        1, std::min(4, jsonInt(jsonStr, "overlay_scale", config_.overlay.scale)));
+    config_.overlay.trackLabels = jsonBool(
+        jsonStr, "overlay_track_labels", config_.overlay.trackLabels);
+
+    config_.trace.enabled = jsonBool(jsonStr, "trace_enable", config_.trace.enabled);
+    config_.trace.bufferEvents = std::max(
+        1024, jsonInt(jsonStr, "trace_buffer_events", config_.trace.bufferEvents));
+    {
+        const std::string traceDir = jsonValue(jsonStr, "trace_output_dir");
+        if (!traceDir.empty()) config_.trace.outputDir = traceDir;
+    }
+    config_.trace.dumpSeconds = std::max(
+        0, jsonInt(jsonStr, "trace_dump_seconds", config_.trace.dumpSeconds));
+
+    config_.watchdog.cameraMs = std::max(
+        0, jsonInt(jsonStr, "watchdog_camera_ms", config_.watchdog.cameraMs));
+    config_.watchdog.encoderMs = std::max(
+        0, jsonInt(jsonStr, "watchdog_encoder_ms", config_.watchdog.encoderMs));
+    config_.watchdog.detectorMs = std::max(
+        0, jsonInt(jsonStr, "watchdog_detector_ms", config_.watchdog.detectorMs));
 
     config_.mqtt.enabled = jsonBool(jsonStr, "mqtt_enable", config_.mqtt.enabled);
     {
@@ -307,16 +622,36 @@ bool Config::parseJson(const std::string& jsonStr) {
     config_.mqtt.stateQos = std::max(
         0, std::min(2, jsonInt(jsonStr, "mqtt_state_qos", config_.mqtt.stateQos)));
     config_.mqtt.stateIntervalMs = std::max(
-        200, jsonInt(jsonStr, "mqtt_state_interval_ms", config_.mqtt.stateIntervalMs));
+        50, jsonInt(jsonStr, "mqtt_state_interval_ms", config_.mqtt.stateIntervalMs));
+    config_.mqtt.stateHeartbeatMs = std::max(
+        config_.mqtt.stateIntervalMs,
+        jsonInt(jsonStr, "mqtt_state_heartbeat_ms", config_.mqtt.stateHeartbeatMs));
+    config_.mqtt.eventQos = std::max(
+        0, std::min(2, jsonInt(jsonStr, "mqtt_event_qos", config_.mqtt.eventQos)));
+    config_.mqtt.eventQueueMax = std::max(
+        1, jsonInt(jsonStr, "mqtt_event_queue_max", config_.mqtt.eventQueueMax));
+
+    // Event clips are opened by the detect thread; without it nothing would
+    // ever be recorded.
+    if (config_.record.enabled && config_.record.mode == "event" && !config_.detection.enabled) {
+        std::cerr << "[Config] record_mode 'event' needs detect_enable, recording continuously instead"
+                  << std::endl;
+        config_.record.mode = "continuous";
+    }
 
     std::cout << "[Config] Loaded: " << config_.stream.url
               << " " << config_.camera.width << "x" << config_.camera.height
               << "@" << config_.camera.fps << "fps"
               << " bitrate=" << config_.encoder.bitrate
               << " record=" << (config_.record.enabled ? "on" : "off")
+              << " cameras=" << std::max<size_t>(1, config_.cameras.size())
+              << " push_destinations=" << config_.push.destinations.size()
               << " control=" << (config_.control.enabled ? "on" : "off")
+              << " lan_flv=" << (config_.lanFlv.enabled ? "on" : "off")
               << " mqtt=" << (config_.mqtt.enabled ? "on" : "off")
               << " detect=" << (config_.detection.enabled ? "on" : "off")
+              << (config_.detection.adaptiveEnabled ? "(adaptive)" : "")
+              << " zones=" << config_.detection.zones.size()
               << std::endl;
 
     return true;
@@ -366,6 +701,12 @@ bool Config::loadFromArgs(int argc, char* argv[]) {
             config_.control.replayRtmpBase = argv[++i];
         } else if (arg == "--audio") {
             config_.enableAudio = true;
+        } else if (arg == "--camera-backend" && i + 1 < argc) {
+            config_.camera.backend = argv[++i];
+        } else if (arg == "--camera-source" && i + 1 < argc) {
+            config_.camera.source = argv[++i];
+        } else if (arg == "--audio-backend" && i + 1 < argc) {
+            config_.audio.backend = argv[++i];
         } else if (arg == "--help") {
             std::cout << "Usage: reallive-pusher [options]\n"
                       << "  -c, --config <file>   Config file path (JSON)\n"
@@ -385,6 +726,9 @@ bool Config::loadFromArgs(int argc, char* argv[]) {
                       << "  --control-port <n>    Control HTTP listen port\n"
                       << "  --replay-rtmp-base    RTMP base for history replay output\n"
                       << "  --audio               Enable audio capture\n"
+                      << "  --camera-backend <b>  libcamera, synthetic or file (default: first built)\n"
+                      << "  --camera-source <f>   Clip for the file backend (.y4m, .nv12, .mp4)\n"
+                      << "  --audio-backend <b>   alsa, synthetic or file\n"
                       << "  --help                Show this help\n";
             return false;
         }
@@ -413,6 +757,39 @@ bool Config::loadFromArgs(int argc, char* argv[]) {
     return true;
 }
 
+std::vector<PusherConfig> Config::cameraConfigs() const {
+    if (config_.cameras.empty()) {
+        return {config_};
+    }
+    std::vector<PusherConfig> out;
+    for (size_t i = 0; i < config_.cameras.size(); i++) {
+        const CameraInstanceConfig& cam = config_.cameras[i];
+        PusherConfig c = config_;
+        c.cameras.clear();
+        c.stream.streamKey = cam.streamKey;
+        if (!cam.cameraId.empty()) {
+            c.camera.device = cam.cameraId;
+        } else if (c.camera.device.empty()) {
+            // Otherwise every entry would open the first camera.
+            c.camera.device = std::to_string(cam.index);
+        }
+        if (!cam.cameraBackend.empty()) c.camera.backend = cam.cameraBackend;
+        if (!cam.cameraSource.empty()) c.camera.source = cam.cameraSource;
+        if (!cam.url.empty()) c.stream.url = cam.url;
+        if (cam.width > 0) c.camera.width = c.encoder.width = cam.width;
+        if (cam.height > 0) c.camera.height = c.encoder.height = cam.height;
+        if (cam.fps > 0) c.camera.fps = c.encoder.fps = cam.fps;
+        if (cam.bitrate > 0) c.encoder.bitrate = cam.bitrate;
+        if (!cam.overlayCameraName.empty()) c.overlay.cameraName = cam.overlayCameraName;
+        c.lanFlv.port = cam.lanFlvPort > 0 ? cam.lanFlvPort : config_.lanFlv.port + static_cast<int>(i);
+        // Extra destinations name concrete ingest URLs; they belong to the
+        // first camera only.
+        if (i > 0) c.push.destinations.clear();
+        out.push_back(std::move(c));
+    }
+    return out;
+}
+
 const PusherConfig& Config::get() const {
     return config_;
 }
@@ -1,24 +1,35 @@
 #include "core/ControlServer.h"
+#include "core/SegmentIndex.h"
 #include "core/Pipeline.h"
+#include "core/PipelineHost.h"
+#include "core/Tracer.h"
 
 #include <algorithm>
 #include <array>
 #include <cerrno>
 #include <chrono>
-#include <csignal>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <filesystem>
+#include <iterator>
 #include <iostream>
 #include <map>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <netinet/in.h>
+#include <netinet/ip.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 
@@ -26,6 +37,23 @@ namespace reallive {
 
 namespace {
 
+constexpr size_t kMaxBitratePoints = 5000;
+constexpr int64_t kMaxExportMs = 2LL * 3600 * 1000;
+// Bounds the playlist size (~5400 segments).
+constexpr int64_t kMaxHlsRangeMs = 6LL * 3600 * 1000;
+constexpr size_t kMaxConcurrentExports = 2;
+constexpr size_t kMaxConcurrentFileStreams = 4;
+// Responses up to this size go out inline on the control thread.
+constexpr uint64_t kInlineFileBytes = 256 * 1024;
+constexpr size_t kSendfileChunkBytes = 64 * 1024;
+// A client that stops reading (or never finishes its request) gives up its
+// socket after this long instead of holding the control thread or a stream
+// slot.
+constexpr int kClientIoTimeoutSec = 10;
+// DSCP CS1 ("lower effort"): lets the qdisc and the router favour the live
+// RTMP uplink over history downloads.
+constexpr int kFileTos = 0x20;
+
 std::string trim(const std::string& s) {
     size_t b = s.find_first_not_of(" \t\r\n");
     if (b == std::string::npos) return "";
@@ -78,18 +106,22 @@ std::string urlDecode(const std::string& input) {
 std::string statusText(int code) {
     switch (code) {
     case 200: return "OK";
+    case 206: return "Partial Content";
+    case 304: return "Not Modified";
     case 400: return "Bad Request";
     case 404: return "Not Found";
     case 405: return "Method Not Allowed";
+    case 416: return "Range Not Satisfiable";
+    case 429: return "Too Many Requests";
     case 500: return "Internal Server Error";
     default: return "OK";
     }
 }
 
-std::string makeHttpJsonResponse(int statusCode, const std::string& body) {
+std::string makeHttpResponse(int statusCode, const std::string& contentType, const std::string& body) {
     std::ostringstream oss;
     oss << "HTTP/1.1 " << statusCode << " " << statusText(statusCode) << "\r\n"
-        << "Content-Type: application/json\r\n"
+        << "Content-Type: " << contentType << "\r\n"
         << "Cache-Control: no-store\r\n"
         << "Connection: close\r\n"
         << "Access-Control-Allow-Origin: *\r\n"
@@ -100,6 +132,52 @@ std::string makeHttpJsonResponse(int statusCode, const std::string& body) {
     return oss.str();
 }
 
+bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// sendfile() straight from the page cache, paced to |bytesPerSec| (0 = no
+// cap) so one history download cannot saturate the uplink.
+bool sendFileRange(int sockFd, int fileFd, uint64_t offset, uint64_t length, uint64_t bytesPerSec,
+                   const std::atomic<bool>& cancel) {
+    const auto start = std::chrono::steady_clock::now();
+    off_t off = static_cast<off_t>(offset);
+    uint64_t sent = 0;
+    while (sent < length && !cancel) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(kSendfileChunkBytes, length - sent));
+        const ssize_t n = ::sendfile(sockFd, fileFd, &off, want);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            // The player closing mid-download is a normal end, not a failure.
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                std::cerr << "[ControlServer] Client stopped reading, dropping the download" << std::endl;
+            } else if (errno != EPIPE && errno != ECONNRESET) {
+                std::cerr << "[ControlServer] sendfile failed: " << std::strerror(errno) << std::endl;
+            }
+            return false;
+        }
+        if (n == 0) return false;  // file shrank underneath us
+        sent += static_cast<uint64_t>(n);
+
+        if (bytesPerSec == 0) continue;
+        const auto due = start + std::chrono::microseconds(sent * 1000000 / bytesPerSec);
+        while (!cancel && std::chrono::steady_clock::now() < due) {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                due - std::chrono::steady_clock::now(), std::chrono::milliseconds(100)));
+        }
+    }
+    return sent == length;
+}
+
 std::string jsonString(const std::string& s) {
     std::string out;
     out.reserve(s.size() + 8);
@@ -161,10 +239,75 @@ int64_t toInt64(const std::string& s, int64_t fallback) {
     return static_cast<int64_t>(v);
 }
 
+// Case-insensitive lookup in the raw request header block.
+std::string headerValue(const std::string& headers, const std::string& name) {
+    size_t pos = 0;
+    while (pos < headers.size()) {
+        size_t end = headers.find("\r\n", pos);
+        if (end == std::string::npos) end = headers.size();
+        const size_t colon = headers.find(':', pos);
+        if (colon != std::string::npos && colon < end && colon - pos == name.size() &&
+            strncasecmp(headers.c_str() + pos, name.c_str(), name.size()) == 0) {
+            return trim(headers.substr(colon + 1, end - colon - 1));
+        }
+        pos = end + 2;
+    }
+    return "";
+}
+
+std::string httpDate(time_t t) {
+    struct tm tmv{};
+    gmtime_r(&t, &tmv);
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tmv);
+    return buf;
+}
+
+time_t parseHttpDate(const std::string& s) {
+    struct tm tmv{};
+    const char* end = ::strptime(s.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tmv);
+    return end ? ::timegm(&tmv) : static_cast<time_t>(-1);
+}
+
+// Single "bytes=" range against |size|: 1 = range set, 0 = absent or not
+// usable (serve the whole file), -1 = unsatisfiable.
+int parseRange(const std::string& value, uint64_t size, uint64_t& first, uint64_t& last) {
+    if (value.compare(0, 6, "bytes=") != 0 || value.find(',') != std::string::npos) return 0;
+    const std::string spec = trim(value.substr(6));
+    const size_t dash = spec.find('-');
+    if (dash == std::string::npos) return 0;
+    const std::string a = spec.substr(0, dash);
+    const std::string b = spec.substr(dash + 1);
+    if (a.empty()) {
+        const int64_t suffix = toInt64(b, -1);
+        if (suffix <= 0) return suffix == 0 ? -1 : 0;
+        if (size == 0) return -1;
+        first = size - std::min<uint64_t>(size, static_cast<uint64_t>(suffix));
+        last = size - 1;
+        return 1;
+    }
+    const int64_t start = toInt64(a, -1);
+    if (start < 0) return 0;
+    if (static_cast<uint64_t>(start) >= size) return -1;
+    const int64_t stop = b.empty() ? static_cast<int64_t>(size) - 1 : toInt64(b, -1);
+    if (stop < start) return 0;
+    first = static_cast<uint64_t>(start);
+    last = std::min<uint64_t>(size - 1, static_cast<uint64_t>(stop));
+    return 1;
+}
+
+const char* fileContentType(const std::string& name) {
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".mp4") == 0) return "video/mp4";
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".jpg") == 0) return "image/jpeg";
+    return "application/octet-stream";
+}
+
 } // namespace
 
-ControlServer::ControlServer(const PusherConfig& config, Pipeline* pipeline)
-    : config_(config), pipeline_(pipeline) {
+ControlServer::ControlServer(const PusherConfig& config, PipelineHost* host)
+    : config_(config),
+      host_(host),
+      hls_(config.record.outputDir.empty() ? "./recordings" : config.record.outputDir) {
 }
 
 ControlServer::~ControlServer() {
@@ -207,6 +350,7 @@ bool ControlServer::start() {
     }
 
     running_ = true;
+    streamCancel_ = false;
     serverThread_ = std::thread(&ControlServer::serveLoop, this);
     std::cout << "[Control] Listening on " << config_.control.host
               << ":" << config_.control.port << std::endl;
@@ -228,6 +372,7 @@ void ControlServer::stop() {
     }
 
     terminateAllSessions();
+    cancelAllStreams();
 }
 
 bool ControlServer::isRunning() const {
@@ -243,12 +388,17 @@ void ControlServer::serveLoop() {
             if (!running_) break;
             continue;
         }
-        handleClient(clientFd);
-        ::close(clientFd);
+        timeval timeout{};
+        timeout.tv_sec = kClientIoTimeoutSec;
+        ::setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if (!handleClient(clientFd)) {
+            ::close(clientFd);
+        }
     }
 }
 
-void ControlServer::handleClient(int clientFd) {
+bool ControlServer::handleClient(int clientFd) {
     std::string req;
     req.reserve(4096);
     std::array<char, 4096> buf{};
@@ -259,10 +409,10 @@ void ControlServer::handleClient(int clientFd) {
         if (req.find("\r\n\r\n") != std::string::npos) break;
         if (req.size() > 1024 * 1024) break;
     }
-    if (req.empty()) return;
+    if (req.empty()) return false;
 
     const size_t headerEnd = req.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) return;
+    if (headerEnd == std::string::npos) return false;
     const std::string header = req.substr(0, headerEnd);
     std::string body = req.substr(headerEnd + 4);
 
@@ -273,7 +423,7 @@ void ControlServer::handleClient(int clientFd) {
     std::string pathWithQuery;
     std::string httpVersion;
     fl >> method >> pathWithQuery >> httpVersion;
-    if (method.empty() || pathWithQuery.empty()) return;
+    if (method.empty() || pathWithQuery.empty()) return false;
 
     size_t clPos = header.find("Content-Length:");
     int contentLength = 0;
@@ -290,16 +440,27 @@ void ControlServer::handleClient(int clientFd) {
     }
 
     int statusCode = 200;
-    std::string json = handleRequest(method, pathWithQuery, body, statusCode);
-    const std::string resp = makeHttpJsonResponse(statusCode, json);
-    ::send(clientFd, resp.data(), resp.size(), 0);
+    std::string contentType = "application/json";
+    bool handedOff = false;
+    std::string respBody = handleRequest(method, pathWithQuery, header, body, statusCode, contentType,
+                                         clientFd, handedOff);
+    if (handedOff) return true;
+    // /metrics and /api/debug/trace bodies run to megabytes: loop over
+    // short writes, and a client that hung up must not raise SIGPIPE.
+    const std::string resp = makeHttpResponse(statusCode, contentType, respBody);
+    sendAll(clientFd, resp.data(), resp.size());
+    return false;
 }
 
 std::string ControlServer::handleRequest(
     const std::string& method,
     const std::string& pathWithQuery,
+    const std::string& headers,
     const std::string& body,
-    int& statusCode
+    int& statusCode,
+    std::string& contentType,
+    int clientFd,
+    bool& handedOff
 ) {
     reapExitedSessions();
 
@@ -337,6 +498,75 @@ std::string ControlServer::handleRequest(
         return handleTimeline(streamKey, startMs, endMs);
     }
 
+    if (method == "GET" && path == "/api/record/bitrate") {
+        const std::string streamKey = urlDecode(queryMap.count("stream_key") ? queryMap.at("stream_key") : "");
+        if (streamKey.empty()) {
+            statusCode = 400;
+            return "{\"error\":\"stream_key required\"}";
+        }
+        int64_t startMs = toInt64(queryMap.count("start") ? queryMap.at("start") : "", -1);
+        int64_t endMs = toInt64(queryMap.count("end") ? queryMap.at("end") : "", -1);
+        return handleBitrate(streamKey, startMs, endMs);
+    }
+
+    if ((method == "GET" || method == "HEAD") && path == "/api/record/file") {
+        const std::string streamKey = urlDecode(queryMap.count("stream_key") ? queryMap.at("stream_key") : "");
+        const std::string name = urlDecode(queryMap.count("name") ? queryMap.at("name") : "");
+        if (streamKey.empty() || name.empty()) {
+            statusCode = 400;
+            return "{\"error\":\"stream_key and name required\"}";
+        }
+        return handleFile(clientFd, method, headers, streamKey, name, statusCode, handedOff);
+    }
+
+    if (method == "GET" && path == "/api/record/export") {
+        const std::string streamKey = urlDecode(queryMap.count("stream_key") ? queryMap.at("stream_key") : "");
+        const int64_t startMs = toInt64(queryMap.count("start") ? queryMap.at("start") : "", -1);
+        const int64_t endMs = toInt64(queryMap.count("end") ? queryMap.at("end") : "", -1);
+        if (streamKey.empty() || startMs < 0 || endMs <= startMs) {
+            statusCode = 400;
+            return "{\"error\":\"stream_key, start and end (start < end) required\"}";
+        }
+        if (endMs - startMs > kMaxExportMs) {
+            statusCode = 400;
+            return "{\"error\":\"range too long\"}";
+        }
+        const std::string mode = queryMap.count("mode") ? queryMap.at("mode") : "";
+        const auto startMode = mode == "exact" ? ClipExporter::StartMode::Exact : ClipExporter::StartMode::Keyframe;
+        return handleExport(clientFd, streamKey, startMs, endMs, startMode, statusCode, handedOff);
+    }
+
+    if (method == "GET" && path == "/api/record/hls/playlist.m3u8") {
+        const std::string streamKey = urlDecode(queryMap.count("stream_key") ? queryMap.at("stream_key") : "");
+        const int64_t atMs = toInt64(queryMap.count("at") ? queryMap.at("at") : "", -1);
+        const int64_t startMs = toInt64(queryMap.count("start") ? queryMap.at("start") : "", atMs);
+        const int64_t endMs = toInt64(queryMap.count("end") ? queryMap.at("end") : "", -1);
+        if (streamKey.empty() || startMs < 0 || (endMs >= 0 && endMs <= startMs)) {
+            statusCode = 400;
+            return "{\"error\":\"stream_key and start (or at) required, start < end\"}";
+        }
+        if ((endMs >= 0 ? endMs : nowMs()) - startMs > kMaxHlsRangeMs) {
+            statusCode = 400;
+            return "{\"error\":\"range too long\"}";
+        }
+        return handleHlsPlaylist(streamKey, startMs, endMs, atMs, statusCode, contentType);
+    }
+
+    if (method == "GET" && (path == "/api/record/hls/init.mp4" || path == "/api/record/hls/frag.m4s")) {
+        const std::string streamKey = urlDecode(queryMap.count("stream_key") ? queryMap.at("stream_key") : "");
+        const int64_t recordingMs = toInt64(queryMap.count("rec") ? queryMap.at("rec") : "", -1);
+        const bool init = path == "/api/record/hls/init.mp4";
+        const int64_t firstGop = toInt64(queryMap.count("g") ? queryMap.at("g") : "", init ? 0 : -1);
+        const int64_t gopCount = toInt64(queryMap.count("n") ? queryMap.at("n") : "", init ? 0 : -1);
+        if (streamKey.empty() || recordingMs < 0 || firstGop < 0 || firstGop > UINT32_MAX ||
+            (!init && (gopCount <= 0 || gopCount > UINT32_MAX))) {
+            statusCode = 400;
+            return "{\"error\":\"stream_key, rec, g and n required\"}";
+        }
+        return handleHlsMedia(clientFd, streamKey, recordingMs, static_cast<uint32_t>(firstGop),
+                              init ? 0 : static_cast<uint32_t>(gopCount), statusCode, contentType, handedOff);
+    }
+
     if (method == "POST" && path == "/api/record/replay/start") {
         const std::string streamKey = jsonExtractRaw(body, "stream_key");
         if (streamKey.empty()) {
@@ -344,7 +574,20 @@ std::string ControlServer::handleRequest(
             return "{\"error\":\"stream_key required\"}";
         }
         int64_t tsMs = toInt64(jsonExtractRaw(body, "ts"), nowMs());
-        return handleReplayStart(streamKey, tsMs);
+        const std::string speed = jsonExtractRaw(body, "speed");
+        return handleReplayStart(streamKey, tsMs, speed.empty() ? 1.0 : std::atof(speed.c_str()));
+    }
+
+    if (method == "POST" && path == "/api/record/replay/speed") {
+        const std::string sessionId = jsonExtractRaw(body, "session_id").empty()
+            ? jsonExtractRaw(body, "sessionId")
+            : jsonExtractRaw(body, "session_id");
+        const std::string speed = jsonExtractRaw(body, "speed");
+        if (sessionId.empty() || speed.empty()) {
+            statusCode = 400;
+            return "{\"error\":\"session_id and speed required\"}";
+        }
+        return handleReplaySpeed(sessionId, std::atof(speed.c_str()), statusCode);
     }
 
     if (method == "POST" && path == "/api/record/replay/stop") {
@@ -359,8 +602,34 @@ std::string ControlServer::handleRequest(
         return handleReplayStop(streamKey, sessionId);
     }
 
+    if (method == "GET" && path == "/metrics") {
+        if (!host_) {
+            statusCode = 500;
+            return "{\"error\":\"pipeline unavailable\"}";
+        }
+        contentType = "text/plain; version=0.0.4";
+        return host_->renderMetrics();
+    }
+
+    if (method == "GET" && path == "/api/debug/trace") {
+        const int64_t seconds = toInt64(queryMap.count("seconds") ? queryMap.at("seconds") : "",
+                                        config_.trace.dumpSeconds);
+        return Tracer::instance().dumpJson(static_cast<int>(std::max<int64_t>(0, seconds)));
+    }
+
+    if (method == "POST" && path == "/api/debug/trace") {
+        const std::string enabled = jsonExtractRaw(body, "enabled");
+        if (enabled != "true" && enabled != "false") {
+            statusCode = 400;
+            return "{\"error\":\"enabled must be true or false\"}";
+        }
+        Tracer::instance().setEnabled(enabled == "true");
+        return std::string("{\"ok\":true,\"enabled\":") + enabled + "}";
+    }
+
     if (method == "GET" && path == "/api/runtime/status") {
-        return handleRuntimeStatus();
+        const std::string streamKey = urlDecode(queryMap.count("stream_key") ? queryMap.at("stream_key") : "");
+        return handleRuntimeStatus(streamKey, statusCode);
     }
 
     if (method == "POST" && path == "/api/runtime/live") {
@@ -371,33 +640,72 @@ std::string ControlServer::handleRequest(
     return "{\"error\":\"not found\"}";
 }
 
-std::string ControlServer::handleRuntimeStatus() {
-    const bool running = pipeline_ ? pipeline_->isRunning() : false;
-    const bool desiredLive = pipeline_ ? pipeline_->isLivePushEnabled() : false;
-    const bool activeLive = pipeline_ ? pipeline_->isLivePushActive() : false;
+std::string ControlServer::handleRuntimeStatus(const std::string& streamKey, int& statusCode) {
+    Pipeline* pipeline = host_ ? host_->find(streamKey) : nullptr;
+    if (host_ && !pipeline) {
+        statusCode = 404;
+        return "{\"ok\":false,\"error\":\"unknown stream_key\"}";
+    }
+    std::string resolvedKey = streamKey.empty() ? config_.stream.streamKey : streamKey;
+    if (streamKey.empty() && host_ && !host_->cameras().empty()) {
+        resolvedKey = host_->cameras().front().streamKey;
+    }
+    const bool running = pipeline ? pipeline->isRunning() : false;
+    const bool desiredLive = pipeline ? pipeline->isLivePushEnabled() : false;
+    const bool activeLive = pipeline ? pipeline->isLivePushActive() : false;
 
     std::ostringstream oss;
     oss << "{"
         << "\"ok\":true,"
-        << "\"stream_key\":" << jsonString(config_.stream.streamKey) << ","
+        << "\"stream_key\":" << jsonString(resolvedKey) << ","
         << "\"running\":" << (running ? "true" : "false") << ","
         << "\"desired_live\":" << (desiredLive ? "true" : "false") << ","
-        << "\"active_live\":" << (activeLive ? "true" : "false")
-        << "}";
+        << "\"active_live\":" << (activeLive ? "true" : "false") << ","
+        << "\"push\":[";
+    const std::vector<PushOutput::Stats> push =
+        pipeline ? pipeline->getPushStats() : std::vector<PushOutput::Stats>{};
+    for (size_t i = 0; i < push.size(); i++) {
+        const PushOutput::Stats& out = push[i];
+        oss << (i ? "," : "") << "{"
+            << "\"name\":" << jsonString(out.name) << ","
+            << "\"url\":" << jsonString(out.url) << ","
+            << "\"enabled\":" << (out.enabled ? "true" : "false") << ","
+            << "\"connected\":" << (out.connected ? "true" : "false") << ","
+            << "\"sent\":" << out.packetsSent << ","
+            << "\"bytes\":" << out.bytesSent << ","
+            << "\"dropped\":" << out.dropped << ","
+            << "\"errors\":" << out.errors << ","
+            << "\"reconnects\":" << out.reconnects << ","
+            << "\"queued\":" << out.queued << "}";
+    }
+    oss << "],\"cameras\":[";
+    if (host_) {
+        const std::vector<PipelineHost::Camera>& cameras = host_->cameras();
+        for (size_t i = 0; i < cameras.size(); i++) {
+            const Pipeline& cam = *cameras[i].pipeline;
+            oss << (i ? "," : "") << "{"
+                << "\"stream_key\":" << jsonString(cameras[i].streamKey) << ","
+                << "\"running\":" << (cam.isRunning() ? "true" : "false") << ","
+                << "\"desired_live\":" << (cam.isLivePushEnabled() ? "true" : "false") << ","
+                << "\"active_live\":" << (cam.isLivePushActive() ? "true" : "false") << "}";
+        }
+    }
+    oss << "]}";
     return oss.str();
 }
 
 std::string ControlServer::handleRuntimeLive(const std::string& body, int& statusCode) {
-    if (!pipeline_) {
+    if (!host_) {
         statusCode = 500;
         return "{\"ok\":false,\"error\":\"pipeline unavailable\"}";
     }
 
     std::string streamKey = jsonExtractRaw(body, "stream_key");
     if (streamKey.empty()) streamKey = jsonExtractRaw(body, "streamKey");
-    if (!streamKey.empty() && streamKey != config_.stream.streamKey) {
+    Pipeline* pipeline = host_->find(streamKey);
+    if (!pipeline) {
         statusCode = 400;
-        return "{\"ok\":false,\"error\":\"stream_key mismatch\"}";
+        return "{\"ok\":false,\"error\":\"unknown stream_key\"}";
     }
 
     std::string enableRaw = jsonExtractRaw(body, "enable");
@@ -412,10 +720,10 @@ std::string ControlServer::handleRuntimeLive(const std::string& body, int& statu
                    [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
     const bool enable = (val == "1" || val == "true" || val == "yes" || val == "on");
 
-    const bool ok = pipeline_->setLivePushEnabled(enable);
-    const bool running = pipeline_->isRunning();
-    const bool desiredLive = pipeline_->isLivePushEnabled();
-    const bool activeLive = pipeline_->isLivePushActive();
+    const bool ok = pipeline->setLivePushEnabled(enable);
+    const bool running = pipeline->isRunning();
+    const bool desiredLive = pipeline->isLivePushEnabled();
+    const bool activeLive = pipeline->isLivePushActive();
 
     std::ostringstream oss;
     oss << "{"
@@ -458,6 +766,10 @@ std::vector<ControlServer::Segment> ControlServer::loadSegments(const std::strin
         if (std::filesystem::exists(thumb, ec)) {
             seg.thumbnailPath = thumb;
         }
+        const std::string indexPath = SegmentIndex::pathFor(seg.filePath);
+        if (std::filesystem::exists(indexPath, ec)) {
+            seg.indexPath = indexPath;
+        }
         out.push_back(seg);
     }
 
@@ -542,6 +854,8 @@ std::string ControlServer::handleTimeline(const std::string& streamKey, int64_t
         if (i) oss << ",";
         oss << "{\"startMs\":" << ranges[i].first << ",\"endMs\":" << ranges[i].second << "}";
     }
+    // Sanitized keys are URL-safe as they are.
+    const std::string fileBase = "/api/record/file?stream_key=" + sanitizeStreamKey(streamKey) + "&name=";
     oss << "],\"thumbnails\":[],\"segments\":[";
     for (size_t i = 0; i < segments.size(); ++i) {
         if (i) oss << ",";
@@ -550,39 +864,383 @@ std::string ControlServer::handleTimeline(const std::string& streamKey, int64_t
             << "\"id\":" << jsonString(seg.fileName) << ","
             << "\"startMs\":" << seg.startMs << ","
             << "\"endMs\":" << seg.endMs << ","
-            << "\"durationMs\":" << seg.durationMs
+            << "\"durationMs\":" << seg.durationMs << ","
+            << "\"url\":" << jsonString(fileBase + seg.fileName) << ","
+            << "\"thumbnailUrl\":";
+        if (seg.thumbnailPath.empty()) {
+            oss << "null";
+        } else {
+            oss << jsonString(fileBase + std::filesystem::path(seg.thumbnailPath).filename().string());
+        }
+        oss << ","
+            << "\"indexed\":" << (seg.indexPath.empty() ? "false" : "true")
             << "}";
     }
     oss << "],\"nowMs\":" << nowMs() << "}";
     return oss.str();
 }
 
-std::string ControlServer::handleReplayStart(const std::string& streamKey, int64_t tsMs) {
+std::string ControlServer::handleBitrate(const std::string& streamKey, int64_t startMs, int64_t endMs) {
+    const auto all = loadSegments(streamKey);
+    if (startMs < 0 && !all.empty()) startMs = all.front().startMs;
+    if (endMs < 0 && !all.empty()) endMs = all.back().endMs;
+
+    // One point per GOP straight from the sidecar indexes; segments recorded
+    // before indexes existed are simply absent.
+    std::ostringstream oss;
+    oss << "{\"startMs\":" << startMs << ",\"endMs\":" << endMs << ",\"points\":[";
+    size_t points = 0;
+    SegmentIndex index;
+    for (const auto& seg : all) {
+        if (points >= kMaxBitratePoints) break;
+        if (seg.indexPath.empty() || seg.endMs < startMs || seg.startMs > endMs) continue;
+        if (!index.load(seg.indexPath)) continue;
+        for (const auto& gop : index.gops()) {
+            const int64_t ts = seg.startMs + gop.ptsMs;
+            if (ts < startMs || ts > endMs || gop.durationMs == 0) continue;
+            if (points++) oss << ",";
+            oss << "{\"ts\":" << ts
+                << ",\"durationMs\":" << gop.durationMs
+                << ",\"bytes\":" << gop.bytes
+                << ",\"kbps\":" << (static_cast<uint64_t>(gop.bytes) * 8 / gop.durationMs)
+                << "}";
+            if (points >= kMaxBitratePoints) break;
+        }
+    }
+    oss << "],\"nowMs\":" << nowMs() << "}";
+    return oss.str();
+}
+
+std::string ControlServer::handleFile(int clientFd, const std::string& method, const std::string& headers,
+                                      const std::string& streamKey, const std::string& name,
+                                      int& statusCode, bool& handedOff) {
+    static const std::regex allowed(R"(^segment_\d+_\d+\.(mp4|jpg|idx)$)");
+    if (!std::regex_match(name, allowed)) {
+        statusCode = 400;
+        return "{\"error\":\"invalid file name\"}";
+    }
+    const std::filesystem::path root(config_.record.outputDir.empty() ? "./recordings" : config_.record.outputDir);
+    const std::string path = (root / sanitizeStreamKey(streamKey) / name).string();
+
+    const int fileFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (fileFd < 0 || ::fstat(fileFd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        if (fileFd >= 0) ::close(fileFd);
+        statusCode = 404;
+        return "{\"error\":\"not found\"}";
+    }
+
+    const uint64_t size = static_cast<uint64_t>(st.st_size);
+    char etagBuf[64];
+    std::snprintf(etagBuf, sizeof(etagBuf), "\"%llx-%llx\"", static_cast<unsigned long long>(size),
+                  static_cast<unsigned long long>(st.st_mtim.tv_sec) * 1000000000ULL +
+                      static_cast<unsigned long long>(st.st_mtim.tv_nsec));
+    const std::string etag = etagBuf;
+    const std::string lastModified = httpDate(st.st_mtim.tv_sec);
+
+    // If-None-Match wins over If-Modified-Since (RFC 9110 13.2.2).
+    bool notModified = false;
+    const std::string inm = headerValue(headers, "If-None-Match");
+    if (!inm.empty()) {
+        notModified = inm == "*" || inm.find(etag) != std::string::npos;
+    } else {
+        const time_t ims = parseHttpDate(headerValue(headers, "If-Modified-Since"));
+        notModified = ims != static_cast<time_t>(-1) && st.st_mtim.tv_sec <= ims;
+    }
+
+    uint64_t first = 0;
+    uint64_t last = size > 0 ? size - 1 : 0;
+    int range = notModified ? 0 : parseRange(headerValue(headers, "Range"), size, first, last);
+    const std::string ifRange = headerValue(headers, "If-Range");
+    if (range != 0 && !ifRange.empty() && ifRange != etag && ifRange != lastModified) {
+        range = 0;  // representation changed: send it whole
+        first = 0;
+        last = size > 0 ? size - 1 : 0;
+    }
+
+    int status = notModified ? 304 : range > 0 ? 206 : range < 0 ? 416 : 200;
+    const uint64_t length = (status == 200 || status == 206) && size > 0 ? last - first + 1 : 0;
+
+    std::ostringstream oss;
+    oss << "HTTP/1.1 " << status << " " << statusText(status) << "\r\n"
+        << "Content-Type: " << fileContentType(name) << "\r\n"
+        << "Accept-Ranges: bytes\r\n"
+        << "ETag: " << etag << "\r\n"
+        << "Last-Modified: " << lastModified << "\r\n"
+        << "Cache-Control: no-cache\r\n"
+        << "Connection: close\r\n"
+        << "Access-Control-Allow-Origin: *\r\n"
+        << "Access-Control-Expose-Headers: Content-Range, Content-Length, ETag\r\n";
+    if (status == 206) oss << "Content-Range: bytes " << first << "-" << last << "/" << size << "\r\n";
+    if (status == 416) oss << "Content-Range: bytes */" << size << "\r\n";
+    oss << "Content-Length: " << length << "\r\n\r\n";
+    const std::string responseHeaders = oss.str();
+
+    const uint64_t bytesPerSec = static_cast<uint64_t>(std::max(0, config_.control.fileRateKbps)) * 1000 / 8;
+    const bool sendBody = method != "HEAD" && length > 0;
+    int tos = kFileTos;
+    ::setsockopt(clientFd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+
+    if (!sendBody || length <= kInlineFileBytes) {
+        if (sendAll(clientFd, responseHeaders.data(), responseHeaders.size()) && sendBody) {
+            sendFileRange(clientFd, fileFd, first, length, 0, streamCancel_);
+        }
+        ::close(fileFd);
+        ::close(clientFd);
+        handedOff = true;
+        return "";
+    }
+
+    const bool started = spawnStream(StreamJob::Kind::File, clientFd,
+        [this, clientFd, fileFd, responseHeaders, first, length, bytesPerSec]() {
+            if (sendAll(clientFd, responseHeaders.data(), responseHeaders.size())) {
+                sendFileRange(clientFd, fileFd, first, length, bytesPerSec, streamCancel_);
+            }
+            ::close(fileFd);
+        });
+    if (!started) {
+        ::close(fileFd);
+        statusCode = 429;
+        return "{\"error\":\"too many downloads in progress\"}";
+    }
+    handedOff = true;
+    return "";
+}
+
+std::string ControlServer::handleExport(int clientFd, const std::string& streamKey, int64_t startMs,
+                                        int64_t endMs, ClipExporter::StartMode startMode,
+                                        int& statusCode, bool& handedOff) {
+    ClipExporter::Options options;
+    options.startMs = startMs;
+    options.endMs = endMs;
+    options.startMode = startMode;
+    for (const auto& seg : loadSegments(streamKey)) {
+        if (seg.endMs < startMs || seg.startMs > endMs) continue;
+        options.segments.push_back({seg.filePath, seg.indexPath, seg.startMs});
+    }
+    if (options.segments.empty()) {
+        statusCode = 404;
+        return "{\"error\":\"no recording in range\"}";
+    }
+
+    const std::string fileName = sanitizeStreamKey(streamKey) + "_" + std::to_string(startMs) + "_" +
+                                 std::to_string(endMs) + ".mp4";
+    const bool started = spawnStream(StreamJob::Kind::Export, clientFd,
+        [this, clientFd, options = std::move(options), fileName]() { runExport(clientFd, options, fileName); });
+    if (!started) {
+        statusCode = 429;
+        return "{\"error\":\"too many exports in progress\"}";
+    }
+    handedOff = true;
+    return "";
+}
+
+void ControlServer::runExport(int clientFd, const ClipExporter::Options& options, const std::string& fileName) {
+    // Headers go out with the first muxed bytes, so an export that fails
+    // before producing anything can still answer with a proper error.
+    bool headersSent = false;
+    bool clientOk = true;
+    const auto sink = [&](const uint8_t* data, size_t size) {
+        if (!headersSent) {
+            std::ostringstream oss;
+            oss << "HTTP/1.1 200 OK\r\n"
+                << "Content-Type: video/mp4\r\n"
+                << "Content-Disposition: attachment; filename=\"" << fileName << "\"\r\n"
+                << "Cache-Control: no-store\r\n"
+                << "Connection: close\r\n"
+                << "Access-Control-Allow-Origin: *\r\n"
+                << "Transfer-Encoding: chunked\r\n\r\n";
+            const std::string headers = oss.str();
+            headersSent = true;
+            clientOk = sendAll(clientFd, headers.data(), headers.size());
+        }
+        char chunkHeader[32];
+        const int len = std::snprintf(chunkHeader, sizeof(chunkHeader), "%zx\r\n", size);
+        clientOk = clientOk &&
+                   sendAll(clientFd, chunkHeader, static_cast<size_t>(len)) &&
+                   sendAll(clientFd, reinterpret_cast<const char*>(data), size) &&
+                   sendAll(clientFd, "\r\n", 2);
+        return clientOk;
+    };
+
+    const ClipExporter::Result result = ClipExporter::run(options, sink, streamCancel_);
+    if (headersSent) {
+        // A missing terminal chunk tells the client the file is incomplete.
+        if (clientOk && result.ok) sendAll(clientFd, "0\r\n\r\n", 5);
+    } else {
+        const std::string resp = makeHttpResponse(500, "application/json", "{\"error\":\"export failed\"}");
+        sendAll(clientFd, resp.data(), resp.size());
+    }
+    std::cout << "[Control] Export " << fileName << (result.ok ? " done: " : " aborted: ")
+              << result.packets << " packet(s), " << result.bytes << " bytes, "
+              << result.durationMs << " ms" << std::endl;
+}
+
+HlsPackager::LiveSource ControlServer::liveRecording(const std::string& streamKey) {
+    // Each pipeline records only its own stream.
+    if (!host_) return nullptr;
+    Pipeline* pipeline = nullptr;
+    for (const PipelineHost::Camera& cam : host_->cameras()) {
+        if (sanitizeStreamKey(streamKey) == sanitizeStreamKey(cam.streamKey)) {
+            pipeline = cam.pipeline.get();
+            break;
+        }
+    }
+    if (!pipeline) return nullptr;
+    return [pipeline](LocalRecorder::LiveSegment& out) { return pipeline->getLiveRecording(out); };
+}
+
+std::string ControlServer::handleHlsPlaylist(const std::string& streamKey, int64_t startMs, int64_t endMs,
+                                             int64_t atMs, int& statusCode, std::string& contentType) {
+    const std::string body = hls_.playlist(sanitizeStreamKey(streamKey), startMs, endMs, atMs,
+                                           endMs < 0 ? liveRecording(streamKey) : nullptr);
+    if (body.empty()) {
+        statusCode = 404;
+        return "{\"error\":\"no recording in range\"}";
+    }
+    contentType = "application/vnd.apple.mpegurl";
+    return body;
+}
+
+std::string ControlServer::handleHlsMedia(int clientFd, const std::string& streamKey, int64_t recordingMs,
+                                          uint32_t firstGop, uint32_t gopCount, int& statusCode,
+                                          std::string& contentType, bool& handedOff) {
+    const std::string key = sanitizeStreamKey(streamKey);
+    const HlsPackager::LiveSource live = liveRecording(streamKey);
+    if (gopCount == 0) {
+        std::string init;
+        if (!hls_.initSegment(key, recordingMs, live, init)) {
+            statusCode = 404;
+            return "{\"error\":\"recording not found\"}";
+        }
+        contentType = "video/mp4";
+        return init;
+    }
+
+    // A fragment is a few MB of pread() and muxing: keep it off the control thread.
+    const bool started = spawnStream(StreamJob::Kind::File, clientFd,
+        [this, clientFd, key, recordingMs, firstGop, gopCount, live]() {
+            std::string bytes;
+            const std::string resp = hls_.fragment(key, recordingMs, firstGop, gopCount, live, bytes)
+                ? makeHttpResponse(200, "video/iso.segment", bytes)
+                : makeHttpResponse(404, "application/json", "{\"error\":\"fragment not found\"}");
+            sendAll(clientFd, resp.data(), resp.size());
+        });
+    if (!started) {
+        statusCode = 429;
+        return "{\"error\":\"too many downloads in progress\"}";
+    }
+    handedOff = true;
+    return "";
+}
+
+bool ControlServer::spawnStream(StreamJob::Kind kind, int clientFd, std::function<void()> work) {
+    reapFinishedStreams();
+    const size_t limit = kind == StreamJob::Kind::Export ? kMaxConcurrentExports : kMaxConcurrentFileStreams;
+
+    std::lock_guard<std::mutex> lock(streamMutex_);
+    size_t active = 0;
+    for (const auto& job : streams_) {
+        if (job.kind == kind) active++;
+    }
+    if (active >= limit) return false;
+
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    StreamJob job;
+    job.kind = kind;
+    job.fd = clientFd;
+    job.done = done;
+    // The worker closes the socket under streamMutex_ so cancelAllStreams()
+    // never shuts down a descriptor number that has been reused.
+    job.thread = std::thread([this, clientFd, done, work = std::move(work)]() {
+        work();
+        {
+            std::lock_guard<std::mutex> lock(streamMutex_);
+            ::close(clientFd);
+            for (auto& j : streams_) {
+                if (j.done == done) j.fd = -1;
+            }
+        }
+        done->store(true);
+    });
+    streams_.push_back(std::move(job));
+    return true;
+}
+
+void ControlServer::reapFinishedStreams() {
+    std::list<StreamJob> finished;
+    {
+        std::lock_guard<std::mutex> lock(streamMutex_);
+        for (auto it = streams_.begin(); it != streams_.end();) {
+            auto next = std::next(it);
+            if (it->done->load()) finished.splice(finished.end(), streams_, it);
+            it = next;
+        }
+    }
+    for (auto& job : finished) {
+        if (job.thread.joinable()) job.thread.join();
+    }
+}
+
+void ControlServer::cancelAllStreams() {
+    streamCancel_ = true;
+    std::list<StreamJob> jobs;
+    {
+        std::lock_guard<std::mutex> lock(streamMutex_);
+        for (auto& job : streams_) {
+            if (job.fd >= 0) ::shutdown(job.fd, SHUT_RDWR);
+        }
+        jobs.swap(streams_);
+    }
+    for (auto& job : jobs) {
+        if (job.thread.joinable()) job.thread.join();
+    }
+}
+
+std::string ControlServer::handleReplayStart(const std::string& streamKey, int64_t tsMs, double speed) {
     const auto segments = loadSegments(streamKey);
     if (segments.empty()) {
         return "{\"mode\":\"live\",\"playbackUrl\":null,\"offsetSec\":0}";
     }
 
-    Segment target = segments.front();
+    size_t targetIdx = 0;
     bool found = false;
-    for (const auto& seg : segments) {
-        if (tsMs >= seg.startMs && tsMs <= seg.endMs) {
-            target = seg;
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (tsMs >= segments[i].startMs && tsMs <= segments[i].endMs) {
+            targetIdx = i;
             found = true;
             break;
         }
     }
     if (!found) {
-        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
-            if (it->startMs <= tsMs) {
-                target = *it;
+        for (size_t i = segments.size(); i-- > 0;) {
+            if (segments[i].startMs <= tsMs) {
+                targetIdx = i;
                 found = true;
                 break;
             }
         }
     }
-
-    const int offsetSec = static_cast<int>(std::max<int64_t>(0, (tsMs - target.startMs) / 1000));
+    const Segment& target = segments[targetIdx];
+
+    // ReplayStreamer starts the first segment at the keyframe at or before
+    // startOffsetMs (SegmentReader::seekKeyframe, from the .idx when there
+    // is one). Look that keyframe up here as well so the offset reported to
+    // the client is where playback really begins; without an index the
+    // reader seeks through the demuxer and the reply rounds to whole seconds.
+    int64_t offsetMs = std::max<int64_t>(0, tsMs - target.startMs);
+    int64_t keyframeOffset = -1;
+    SegmentIndex index;
+    if (!target.indexPath.empty() && index.load(target.indexPath)) {
+        if (const SegmentIndex::Frame* key = index.keyframeAtOrBefore(static_cast<uint32_t>(offsetMs))) {
+            offsetMs = key->ptsMs;
+            keyframeOffset = key->offset;
+        }
+    } else {
+        offsetMs = offsetMs / 1000 * 1000;
+    }
+    const int offsetSec = static_cast<int>(offsetMs / 1000);
+    speed = std::max(ReplayStreamer::kMinSpeed, std::min(config_.control.replayMaxSpeed, speed));
 
     static std::atomic<uint64_t> seq{1};
     const uint64_t id = seq.fetch_add(1);
@@ -591,21 +1249,19 @@ std::string ControlServer::handleReplayStart(const std::string& streamKey, int64
     const std::string rtmpUrl = config_.control.replayRtmpBase + "/" + streamName;
     const std::string playbackUrl = "/history/" + streamName + ".flv";
 
-    std::ostringstream cmd;
-    cmd << config_.control.ffmpegBin
-        << " -hide_banner -loglevel error -re -ss " << offsetSec
-        << " -i " << jsonString(target.filePath)
-        << " -c copy -f flv " << jsonString(rtmpUrl)
-        << " >/dev/null 2>&1";
-
-    pid_t pid = ::fork();
-    if (pid == 0) {
-        ::execl("/bin/sh", "sh", "-lc", cmd.str().c_str(), static_cast<char*>(nullptr));
-        std::_Exit(127);
+    // Play on through every later segment so scrubbing at speed crosses
+    // boundaries without the client restarting the session.
+    ReplayStreamer::Options options;
+    for (size_t i = targetIdx; i < segments.size(); i++) {
+        options.segments.push_back({segments[i].filePath, segments[i].indexPath});
     }
-
-    if (pid < 0) {
-        return "{\"mode\":\"live\",\"playbackUrl\":null,\"offsetSec\":0,\"error\":\"fork failed\"}";
+    options.startOffsetMs = offsetMs;
+    options.speed = speed;
+    options.keyframeOnlyAbove = config_.control.replayKeyframeOnlySpeed;
+    options.url = rtmpUrl;
+    auto streamer = std::make_shared<ReplayStreamer>();
+    if (!streamer->start(options)) {
+        return "{\"mode\":\"live\",\"playbackUrl\":null,\"offsetSec\":0,\"error\":\"replay start failed\"}";
     }
 
     ReplaySession session;
@@ -616,7 +1272,7 @@ std::string ControlServer::handleReplayStart(const std::string& streamKey, int64
     session.playbackUrl = playbackUrl;
     session.requestedTs = tsMs;
     session.offsetSec = offsetSec;
-    session.pid = static_cast<int>(pid);
+    session.streamer = streamer;
     session.startedAtMs = nowMs();
 
     {
@@ -630,7 +1286,11 @@ std::string ControlServer::handleReplayStart(const std::string& streamKey, int64
         << "\"requestedTs\":" << tsMs << ","
         << "\"playbackUrl\":" << jsonString(playbackUrl) << ","
         << "\"offsetSec\":" << offsetSec << ","
+        << "\"offsetMs\":" << offsetMs << ","
+        << "\"keyframeOffset\":" << keyframeOffset << ","
         << "\"sessionId\":" << jsonString(sessionId) << ","
+        << "\"speed\":" << streamer->speed() << ","
+        << "\"keyframeOnly\":" << (streamer->keyframeOnly() ? "true" : "false") << ","
         << "\"transport\":\"flv-live\","
         << "\"segment\":{"
             << "\"startMs\":" << target.startMs << ","
@@ -641,6 +1301,27 @@ std::string ControlServer::handleReplayStart(const std::string& streamKey, int64
     return oss.str();
 }
 
+std::string ControlServer::handleReplaySpeed(const std::string& sessionId, double speed, int& statusCode) {
+    std::shared_ptr<ReplayStreamer> streamer;
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex_);
+        auto it = sessions_.find(sessionId);
+        if (it != sessions_.end()) streamer = it->second.streamer;
+    }
+    if (!streamer || !streamer->running()) {
+        statusCode = 404;
+        return "{\"error\":\"session not found\"}";
+    }
+    streamer->setSpeed(std::min(config_.control.replayMaxSpeed, speed));
+    std::ostringstream oss;
+    oss << "{\"ok\":true,"
+        << "\"sessionId\":" << jsonString(sessionId) << ","
+        << "\"speed\":" << streamer->speed() << ","
+        << "\"keyframeOnly\":" << (streamer->keyframeOnly() ? "true" : "false")
+        << "}";
+    return oss.str();
+}
+
 std::string ControlServer::handleReplayStop(const std::string& streamKey, const std::string& sessionId) {
     if (!sessionId.empty()) {
         terminateSession(sessionId);
@@ -661,39 +1342,33 @@ std::string ControlServer::handleReplayStop(const std::string& streamKey, const
 }
 
 void ControlServer::reapExitedSessions() {
-    int status = 0;
-    while (true) {
-        pid_t pid = ::waitpid(-1, &status, WNOHANG);
-        if (pid <= 0) break;
-
+    std::vector<std::shared_ptr<ReplayStreamer>> finished;
+    {
         std::lock_guard<std::mutex> lock(sessionMutex_);
-        for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
-            if (it->second.pid == static_cast<int>(pid)) {
-                sessions_.erase(it);
-                break;
+        for (auto it = sessions_.begin(); it != sessions_.end();) {
+            if (it->second.streamer && !it->second.streamer->running()) {
+                finished.push_back(it->second.streamer);
+                it = sessions_.erase(it);
+            } else {
+                ++it;
             }
         }
     }
+    for (auto& streamer : finished) {
+        streamer->stop();
+    }
 }
 
 void ControlServer::terminateSession(const std::string& sessionId) {
-    ReplaySession session;
-    bool found = false;
+    std::shared_ptr<ReplayStreamer> streamer;
     {
         std::lock_guard<std::mutex> lock(sessionMutex_);
         auto it = sessions_.find(sessionId);
-        if (it != sessions_.end()) {
-            session = it->second;
-            sessions_.erase(it);
-            found = true;
-        }
-    }
-    if (!found) return;
-
-    if (session.pid > 0) {
-        ::kill(session.pid, SIGTERM);
-        ::waitpid(session.pid, nullptr, WNOHANG);
+        if (it == sessions_.end()) return;
+        streamer = it->second.streamer;
+        sessions_.erase(it);
     }
+    if (streamer) streamer->stop();
 }
 
 void ControlServer::terminateAllSessions() {
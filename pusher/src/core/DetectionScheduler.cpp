@@ -0,0 +1,205 @@
+#include "core/DetectionScheduler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace reallive {
+
+namespace {
+
+// Encode cost is judged against the frame interval: above kEncodeBusyRatio we
+// stop adding detector work, below kEncodeIdleRatio there is room for more.
+constexpr double kEncodeBusyRatio = 0.6;
+constexpr double kEncodeIdleRatio = 0.4;
+// CPU must sit this far under target before we spend more on detection.
+constexpr double kCpuHysteresisPct = 12.0;
+// Consecutive calm windows required before each boost step.
+constexpr int kBoostCalmWindows = 3;
+// Keep inference duty cycle of the detect thread at or below ~50%.
+constexpr double kInferDutyFactor = 2.0;
+
+} // namespace
+
+DetectionScheduler::DetectionScheduler(const DetectionConfig& config, int fps)
+    : config_(config) {
+    frameBudgetUs_ = 1000000 / std::max(1, fps);
+    config_.intervalFrames = std::max(1, config_.intervalFrames);
+    config_.adaptiveMaxIntervalFrames = std::max(config_.intervalFrames, config_.adaptiveMaxIntervalFrames);
+    config_.adaptiveMinInferIntervalMs = std::max(10, config_.adaptiveMinInferIntervalMs);
+    config_.adaptiveMaxInferIntervalMs = std::max(
+        std::max(config_.adaptiveMinInferIntervalMs, config_.inferMinIntervalMs),
+        config_.adaptiveMaxInferIntervalMs);
+    config_.adaptiveMaxTiles = std::max(1, std::min(4, config_.adaptiveMaxTiles));
+
+    intervalFrames_ = config_.intervalFrames;
+    inferIntervalMs_ = std::max(10, config_.inferMinIntervalMs);
+    inferTiles_ = 1;
+
+    last_.adaptive = config_.adaptiveEnabled;
+    last_.state = config_.adaptiveEnabled ? State::Steady : State::Fixed;
+    last_.cadence = cadence();
+}
+
+void DetectionScheduler::recordEncode(int64_t encodeUs) {
+    lastEncodeUs_ = encodeUs;
+    encodeSumUs_ += encodeUs;
+    encodeMaxUs_ = std::max(encodeMaxUs_, encodeUs);
+    encodeCount_++;
+}
+
+bool DetectionScheduler::shouldOfferFrame() const {
+    if (!config_.adaptiveEnabled) return true;
+    return lastEncodeUs_ <= frameBudgetUs_;
+}
+
+void DetectionScheduler::noteSkippedFrame() {
+    skippedFrames_++;
+}
+
+void DetectionScheduler::recordDetect(int64_t detectUs, int64_t inferUs) {
+    detectSumUs_ += detectUs;
+    detectCount_++;
+    if (inferUs > 0) {
+        inferSumUs_ += inferUs;
+        inferCount_++;
+    }
+}
+
+DetectionCadence DetectionScheduler::cadence() const {
+    DetectionCadence c;
+    c.intervalFrames = intervalFrames_.load();
+    c.inferMinIntervalMs = inferIntervalMs_.load();
+    c.inferTiles = inferTiles_.load();
+    return c;
+}
+
+DetectionScheduler::Snapshot DetectionScheduler::snapshot() const {
+    Snapshot s = last_;
+    s.cadence = cadence();
+    s.skippedFrames = skippedFrames_;
+    return s;
+}
+
+const char* DetectionScheduler::stateName(State state) {
+    switch (state) {
+        case State::Fixed: return "fixed";
+        case State::Steady: return "steady";
+        case State::Backoff: return "backoff";
+        case State::Boost: return "boost";
+        case State::Overload: return "overload";
+    }
+    return "unknown";
+}
+
+void DetectionScheduler::update(double cpuPct) {
+    const int64_t encodeAvgUs = encodeCount_ > 0 ? encodeSumUs_ / encodeCount_ : 0;
+    const int64_t encodeMaxUs = encodeMaxUs_;
+    encodeSumUs_ = 0;
+    encodeMaxUs_ = 0;
+    encodeCount_ = 0;
+
+    const int detectCount = detectCount_.exchange(0);
+    const int64_t detectSumUs = detectSumUs_.exchange(0);
+    const int inferCount = inferCount_.exchange(0);
+    const int64_t inferSumUs = inferSumUs_.exchange(0);
+    if (inferCount > 0) {
+        const int64_t avg = inferSumUs / inferCount;
+        inferEstimateUs_ = inferEstimateUs_ > 0 ? (inferEstimateUs_ * 3 + avg) / 4 : avg;
+    }
+
+    last_.cpuPct = cpuPct;
+    last_.encodeAvgMs = static_cast<double>(encodeAvgUs) / 1000.0;
+    last_.encodeMaxMs = static_cast<double>(encodeMaxUs) / 1000.0;
+    last_.detectAvgMs = detectCount > 0 ? static_cast<double>(detectSumUs / detectCount) / 1000.0 : 0.0;
+    last_.inferAvgMs = static_cast<double>(inferEstimateUs_) / 1000.0;
+
+    if (!config_.adaptiveEnabled) return;
+
+    DetectionCadence next = cadence();
+    const int tiles = std::max(1, next.inferTiles);
+    // Inference may not run more often than its own cost allows.
+    const int inferFloorMs = std::max<int>(
+        config_.adaptiveMinInferIntervalMs,
+        static_cast<int>(static_cast<double>(inferEstimateUs_) * kInferDutyFactor / 1000.0));
+
+    const bool overload = encodeMaxUs > frameBudgetUs_;
+    const bool busy = cpuPct > config_.adaptiveTargetCpuPct ||
+                      encodeAvgUs > static_cast<int64_t>(frameBudgetUs_ * kEncodeBusyRatio);
+    const bool idle = cpuPct < config_.adaptiveTargetCpuPct - kCpuHysteresisPct &&
+                      encodeMaxUs < static_cast<int64_t>(frameBudgetUs_ * kEncodeIdleRatio);
+
+    if (overload) {
+        calmWindows_ = 0;
+        next.inferTiles = 1;
+        next.inferMinIntervalMs = std::min(config_.adaptiveMaxInferIntervalMs, next.inferMinIntervalMs * 2);
+        next.intervalFrames = std::min(config_.adaptiveMaxIntervalFrames, next.intervalFrames * 2);
+        apply(State::Overload, next);
+        return;
+    }
+
+    if (busy) {
+        // Shed the most expensive work first: tiles, then inference rate,
+        // then the motion pass itself.
+        calmWindows_ = 0;
+        if (next.inferTiles > 1) {
+            next.inferTiles--;
+        } else if (next.inferMinIntervalMs < config_.adaptiveMaxInferIntervalMs) {
+            next.inferMinIntervalMs = std::min(
+                config_.adaptiveMaxInferIntervalMs, next.inferMinIntervalMs + next.inferMinIntervalMs / 4 + 10);
+        } else if (next.intervalFrames < config_.adaptiveMaxIntervalFrames) {
+            next.intervalFrames++;
+        }
+        apply(State::Backoff, next);
+        return;
+    }
+
+    if (idle && ++calmWindows_ >= kBoostCalmWindows) {
+        calmWindows_ = 0;
+        if (next.intervalFrames > 1) {
+            next.intervalFrames--;
+        } else if (next.inferMinIntervalMs > inferFloorMs) {
+            next.inferMinIntervalMs = std::max(inferFloorMs, next.inferMinIntervalMs - next.inferMinIntervalMs / 8 - 5);
+        } else if (next.inferTiles < config_.adaptiveMaxTiles && inferEstimateUs_ > 0) {
+            // Only add a tile when the projected inference cost still fits
+            // the current interval at the target duty cycle.
+            const int64_t projectedUs = inferEstimateUs_ / tiles * (tiles + 1);
+            if (static_cast<double>(projectedUs) * kInferDutyFactor <= next.inferMinIntervalMs * 1000.0) {
+                next.inferTiles++;
+            }
+        }
+        apply(State::Boost, next);
+        return;
+    }
+
+    if (!idle) calmWindows_ = 0;
+    apply(State::Steady, next);
+}
+
+void DetectionScheduler::apply(State state, const DetectionCadence& next) {
+    const DetectionCadence prev = cadence();
+    last_.state = state;
+    if (prev.intervalFrames == next.intervalFrames &&
+        prev.inferMinIntervalMs == next.inferMinIntervalMs &&
+        prev.inferTiles == next.inferTiles) {
+        return;
+    }
+
+    intervalFrames_ = next.intervalFrames;
+    inferIntervalMs_ = next.inferMinIntervalMs;
+    inferTiles_ = next.inferTiles;
+
+    // Formatted apart so the fixed/precision flags stay off std::cout.
+    std::ostringstream line;
+    line << "[DetectSched] " << stateName(state)
+         << " interval_frames=" << next.intervalFrames
+         << " infer_interval=" << next.inferMinIntervalMs << "ms"
+         << " tiles=" << next.inferTiles
+         << " (cpu=" << std::fixed << std::setprecision(1) << last_.cpuPct << "%"
+         << " encode_max=" << last_.encodeMaxMs << "ms"
+         << " infer=" << last_.inferAvgMs << "ms)";
+    std::cout << line.str() << std::endl;
+}
+
+} // namespace reallive
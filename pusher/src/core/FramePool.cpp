@@ -0,0 +1,50 @@
+#include "core/FramePool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace reallive {
+
+FramePool& FramePool::instance() {
+    static FramePool pool;
+    return pool;
+}
+
+std::vector<uint8_t> FramePool::acquire(size_t size) {
+    std::vector<uint8_t> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Same size first (nothing to initialize), then any that fits.
+        auto it = std::find_if(free_.begin(), free_.end(),
+                               [size](const std::vector<uint8_t>& b) { return b.size() == size; });
+        if (it == free_.end()) {
+            it = std::find_if(free_.begin(), free_.end(),
+                              [size](const std::vector<uint8_t>& b) { return b.capacity() >= size; });
+        }
+        if (it != free_.end()) {
+            std::iter_swap(it, free_.end() - 1);
+            buffer = std::move(free_.back());
+            free_.pop_back();
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void FramePool::release(std::vector<uint8_t>&& buffer) {
+    if (buffer.capacity() == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < capacity_) {
+        free_.push_back(std::move(buffer));
+    }
+}
+
+void FramePool::setCapacity(size_t buffers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = buffers;
+    if (free_.size() > capacity_) {
+        free_.resize(capacity_);
+    }
+}
+
+} // namespace reallive
@@ -0,0 +1,475 @@
+#include "core/HlsPackager.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace reallive {
+
+namespace {
+
+constexpr int kAvioBufferBytes = 64 * 1024;
+constexpr uint32_t kDefaultFrameStepMs = 33;
+// Parts stay listed for this many target durations behind the live edge.
+constexpr uint32_t kPartWindowSegments = 3;
+constexpr AVRational kMillis = {1, 1000};
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+using WriteBuf = const uint8_t*;
+#else
+using WriteBuf = uint8_t*;
+#endif
+
+int appendPacket(void* opaque, WriteBuf buf, int size) {
+    static_cast<std::string*>(opaque)->append(reinterpret_cast<const char*>(buf), static_cast<size_t>(size));
+    return size;
+}
+
+std::string ffErr(int code) {
+    char buf[256];
+    av_strerror(code, buf, sizeof(buf));
+    return std::string(buf);
+}
+
+void closeMuxer(AVFormatContext* ctx) {
+    if (!ctx) return;
+    if (ctx->pb) {
+        av_freep(&ctx->pb->buffer);
+        avio_context_free(&ctx->pb);
+    }
+    avformat_free_context(ctx);
+}
+
+// fMP4 muxer appending to |out|; on return |out| holds the init segment.
+// Fragments are flushed by hand, and frag_discont with no edit list and no
+// timestamp shifting makes each fragment's tfdt its own (recording-relative)
+// decode time, however many fragments this muxer has produced before.
+AVFormatContext* openMuxer(const AVCodecParameters* codecpar, std::string* out, uint32_t fragmentIndex) {
+    AVFormatContext* ctx = nullptr;
+    int ret = avformat_alloc_output_context2(&ctx, nullptr, "mp4", nullptr);
+    if (ret < 0 || !ctx) {
+        std::cerr << "[HLS] Failed to allocate output context: " << ffErr(ret) << std::endl;
+        return nullptr;
+    }
+    AVStream* stream = avformat_new_stream(ctx, nullptr);
+    auto* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferBytes));
+    if (!stream || !buffer || avcodec_parameters_copy(stream->codecpar, codecpar) < 0) {
+        av_free(buffer);
+        avformat_free_context(ctx);
+        return nullptr;
+    }
+    stream->codecpar->codec_tag = 0;
+    stream->time_base = {1, 90000};
+    ctx->pb = avio_alloc_context(buffer, kAvioBufferBytes, 1, out, nullptr, &appendPacket, nullptr);
+    if (!ctx->pb) {
+        av_free(buffer);
+        avformat_free_context(ctx);
+        return nullptr;
+    }
+    ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    ctx->avoid_negative_ts = AVFMT_AVOID_NEG_TS_DISABLED;
+
+    AVDictionary* opts = nullptr;
+    av_dict_set(&opts, "movflags", "frag_custom+empty_moov+default_base_moof+frag_discont", 0);
+    av_dict_set(&opts, "use_editlist", "0", 0);
+    av_dict_set_int(&opts, "fragment_index", std::max<uint32_t>(1, fragmentIndex), 0);
+    ret = avformat_write_header(ctx, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        std::cerr << "[HLS] Failed to write header: " << ffErr(ret) << std::endl;
+        closeMuxer(ctx);
+        return nullptr;
+    }
+    avio_flush(ctx->pb);
+    return ctx;
+}
+
+std::shared_ptr<AVCodecParameters> makeCodecpar() {
+    return std::shared_ptr<AVCodecParameters>(avcodec_parameters_alloc(), [](AVCodecParameters* p) {
+        avcodec_parameters_free(&p);
+    });
+}
+
+// Codec parameters of a finalized recording, from its moov.
+std::shared_ptr<AVCodecParameters> readCodecpar(const std::string& path) {
+    AVFormatContext* in = nullptr;
+    int ret = avformat_open_input(&in, path.c_str(), nullptr, nullptr);
+    if (ret < 0) {
+        std::cerr << "[HLS] open " << path << " failed: " << ffErr(ret) << std::endl;
+        return nullptr;
+    }
+    std::shared_ptr<AVCodecParameters> out;
+    const int idx = av_find_best_stream(in, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (idx >= 0) {
+        out = makeCodecpar();
+        if (!out || avcodec_parameters_copy(out.get(), in->streams[idx]->codecpar) < 0) out.reset();
+    }
+    avformat_close_input(&in);
+    return out;
+}
+
+std::string isoTime(int64_t ms) {
+    const time_t sec = static_cast<time_t>(ms / 1000);
+    struct tm tmv{};
+    gmtime_r(&sec, &tmv);
+    char buf[64];
+    const size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tmv);
+    std::snprintf(buf + n, sizeof(buf) - n, ".%03dZ", static_cast<int>(ms % 1000));
+    return buf;
+}
+
+std::string seconds(uint32_t ms) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", ms / 1000.0);
+    return buf;
+}
+
+std::string initUri(const std::string& streamKey, int64_t recordingMs) {
+    return "init.mp4?stream_key=" + streamKey + "&rec=" + std::to_string(recordingMs);
+}
+
+} // namespace
+
+HlsPackager::HlsPackager(std::string recordRoot) : root_(std::move(recordRoot)) {
+}
+
+HlsPackager::~HlsPackager() = default;
+
+std::string HlsPackager::chunkUri(const std::string& streamKey, int64_t recordingMs, uint32_t firstGop,
+                                  uint32_t gopCount) {
+    return "frag.m4s?stream_key=" + streamKey + "&rec=" + std::to_string(recordingMs) +
+           "&g=" + std::to_string(firstGop) + "&n=" + std::to_string(gopCount);
+}
+
+HlsPackager::RecordingPtr HlsPackager::fromIndex(const SegmentIndex& index, uint32_t endPtsMs, bool closed) {
+    auto rec = std::make_shared<Recording>();
+    const auto& gops = index.gops();
+    rec->gopDurationsMs.reserve(gops.size());
+    for (size_t g = 0; g < gops.size(); g++) {
+        const uint32_t next = g + 1 < gops.size() ? gops[g + 1].ptsMs : endPtsMs;
+        rec->gopDurationsMs.push_back(next > gops[g].ptsMs ? next - gops[g].ptsMs : gops[g].durationMs);
+    }
+
+    // Whole GOPs per segment, closed once they reach the target. A live
+    // recording keeps its unfinished tail as parts only, so a segment is
+    // never listed before it is final and its boundaries never move.
+    Chunk chunk;
+    for (uint32_t g = 0; g < gops.size(); g++) {
+        if (chunk.gopCount == 0) {
+            chunk.firstGop = g;
+            chunk.ptsMs = gops[g].ptsMs;
+        }
+        chunk.gopCount++;
+        chunk.durationMs += rec->gopDurationsMs[g];
+        if (chunk.durationMs >= kTargetSegmentMs) {
+            rec->chunks.push_back(chunk);
+            chunk = Chunk();
+        }
+    }
+    if (closed && chunk.gopCount > 0) rec->chunks.push_back(chunk);
+    return rec;
+}
+
+HlsPackager::RecordingPtr HlsPackager::fromLive(const LocalRecorder::LiveSegment& live) {
+    RecordingPtr rec = fromIndex(live.index, live.endPtsMs, false);
+    rec->path = live.path;
+    rec->startMs = live.startMs;
+    rec->codecpar = makeCodecpar();
+    if (!rec->codecpar) return nullptr;
+    AVCodecParameters* par = rec->codecpar.get();
+    par->codec_type = AVMEDIA_TYPE_VIDEO;
+    par->codec_id = AV_CODEC_ID_H264;
+    par->width = live.width;
+    par->height = live.height;
+    // Without the avcC the muxer would take the length-prefixed samples for
+    // Annex-B and mangle them.
+    if (live.avcc.empty()) return nullptr;
+    par->extradata = static_cast<uint8_t*>(av_mallocz(live.avcc.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+    if (!par->extradata) return nullptr;
+    std::memcpy(par->extradata, live.avcc.data(), live.avcc.size());
+    par->extradata_size = static_cast<int>(live.avcc.size());
+    return rec;
+}
+
+bool HlsPackager::ensureInit(Recording& rec) {
+    if (!rec.init.empty()) return true;
+    if (!rec.codecpar) rec.codecpar = readCodecpar(rec.path);
+    if (!rec.codecpar) return false;
+    std::string init;
+    AVFormatContext* ctx = openMuxer(rec.codecpar.get(), &init, 1);
+    if (!ctx) return false;
+    closeMuxer(ctx);
+    rec.init = std::move(init);
+    return true;
+}
+
+void HlsPackager::refresh(const std::string& streamKey, StreamCache& cache) {
+    const std::filesystem::path dir = std::filesystem::path(root_) / streamKey;
+    struct stat st{};
+    if (::stat(dir.c_str(), &st) != 0) {
+        cache.recordings.clear();
+        cache.scanned = false;
+        return;
+    }
+    // Finalize (rename), new segments and retention all touch the directory.
+    if (cache.scanned && st.st_mtim.tv_sec == cache.dirMtime.tv_sec &&
+        st.st_mtim.tv_nsec == cache.dirMtime.tv_nsec) {
+        return;
+    }
+    cache.scanned = true;
+    cache.dirMtime = st.st_mtim;
+
+    static const std::regex pattern(R"(^segment_(\d+)_(\d+)\.mp4$)");
+    std::map<int64_t, RecordingPtr> next;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        const std::string fn = entry.path().filename().string();
+        std::smatch m;
+        if (!std::regex_match(fn, m, pattern)) continue;
+        const int64_t startMs = std::atoll(m[1].str().c_str());
+        auto it = cache.recordings.find(startMs);
+        if (it != cache.recordings.end() && it->second->path == entry.path().string()) {
+            next.emplace(startMs, it->second);
+            continue;
+        }
+
+        // Recordings from before the .idx sidecar cannot be packaged.
+        const std::string indexPath = SegmentIndex::pathFor(entry.path().string());
+        SegmentIndex index;
+        if (!index.load(indexPath) || index.gops().empty()) continue;
+        const auto& frames = index.frames();
+        const uint32_t step = frames.size() > 1 && frames.back().ptsMs > frames[frames.size() - 2].ptsMs
+            ? frames.back().ptsMs - frames[frames.size() - 2].ptsMs
+            : kDefaultFrameStepMs;
+        RecordingPtr rec = fromIndex(index, frames.back().ptsMs + step, true);
+        rec->path = entry.path().string();
+        rec->indexPath = indexPath;
+        rec->startMs = startMs;
+        for (const Chunk& c : rec->chunks) {
+            rec->lines += "#EXTINF:" + seconds(c.durationMs) + ",\n" +
+                          chunkUri(streamKey, startMs, c.firstGop, c.gopCount) + "\n";
+        }
+        next.emplace(startMs, std::move(rec));
+    }
+    cache.recordings.swap(next);
+}
+
+HlsPackager::RecordingPtr HlsPackager::findFinalized(const std::string& streamKey, int64_t recordingMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StreamCache& cache = streams_[streamKey];
+    refresh(streamKey, cache);
+    auto it = cache.recordings.find(recordingMs);
+    if (it == cache.recordings.end()) return nullptr;
+    if (!ensureInit(*it->second)) return nullptr;
+    return it->second;
+}
+
+std::string HlsPackager::playlist(const std::string& streamKey, int64_t startMs, int64_t endMs, int64_t atMs,
+                                  const LiveSource& live) {
+    std::vector<RecordingPtr> recordings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        StreamCache& cache = streams_[streamKey];
+        refresh(streamKey, cache);
+        for (const auto& entry : cache.recordings) {
+            const RecordingPtr& rec = entry.second;
+            const Chunk& last = rec->chunks.back();
+            if (rec->startMs + last.ptsMs + last.durationMs <= startMs) continue;
+            if (endMs >= 0 && rec->startMs > endMs) break;
+            recordings.push_back(rec);
+        }
+    }
+
+    RecordingPtr liveRec;
+    if (endMs < 0 && live) {
+        // An open segment is never also in the finalized set; the start
+        // check covers a snapshot taken just before a rescan.
+        LocalRecorder::LiveSegment snapshot;
+        if (live(snapshot) && !snapshot.index.empty() &&
+            (recordings.empty() || snapshot.startMs > recordings.back()->startMs)) {
+            liveRec = fromLive(snapshot);
+            if (liveRec) recordings.push_back(liveRec);
+        }
+    }
+
+    std::ostringstream body;
+    uint32_t listedMs = 0;
+    uint32_t maxChunkMs = kTargetSegmentMs;
+    uint32_t partTargetMs = 0;
+    int64_t startOffsetMs = -1;
+    bool first = true;
+
+    for (const RecordingPtr& rec : recordings) {
+        const bool isLive = rec == liveRec;
+        const auto inRange = [&](uint32_t ptsMs, uint32_t durationMs) {
+            const int64_t wallStart = rec->startMs + ptsMs;
+            return wallStart + durationMs > startMs && (endMs < 0 || wallStart <= endMs);
+        };
+        size_t c0 = 0;
+        while (c0 < rec->chunks.size() && !inRange(rec->chunks[c0].ptsMs, rec->chunks[c0].durationMs)) c0++;
+        size_t c1 = c0;
+        while (c1 < rec->chunks.size() && inRange(rec->chunks[c1].ptsMs, rec->chunks[c1].durationMs)) c1++;
+        // The live tail: closed GOPs not yet making up a whole segment.
+        const uint32_t tailGop = rec->chunks.empty() ? 0 : rec->chunks.back().firstGop + rec->chunks.back().gopCount;
+        const size_t gopCount = rec->gopDurationsMs.size();
+        if (c0 == c1 && !(isLive && tailGop < gopCount)) continue;
+
+        if (!first) body << "#EXT-X-DISCONTINUITY\n";
+        first = false;
+        body << "#EXT-X-MAP:URI=\"" << initUri(streamKey, rec->startMs) << "\"\n";
+        const uint32_t firstPts = c0 < c1 ? rec->chunks[c0].ptsMs : 0;
+        body << "#EXT-X-PROGRAM-DATE-TIME:" << isoTime(rec->startMs + firstPts) << "\n";
+
+        for (size_t c = c0; c < c1; c++) {
+            const Chunk& chunk = rec->chunks[c];
+            maxChunkMs = std::max(maxChunkMs, chunk.durationMs);
+            const int64_t wallStart = rec->startMs + chunk.ptsMs;
+            if (atMs >= 0 && startOffsetMs < 0 && atMs < wallStart + chunk.durationMs) {
+                startOffsetMs = listedMs + std::max<int64_t>(0, atMs - wallStart);
+            }
+            listedMs += chunk.durationMs;
+        }
+        if (!isLive && c0 == 0 && c1 == rec->chunks.size()) {
+            body << rec->lines;
+            continue;
+        }
+
+        // Parts only near the live edge, as LL-HLS asks.
+        uint32_t recentMs = 0;
+        size_t partsFrom = rec->chunks.size();
+        if (isLive) {
+            while (partsFrom > c0 && recentMs < kPartWindowSegments * kTargetSegmentMs) {
+                recentMs += rec->chunks[--partsFrom].durationMs;
+            }
+        }
+        const auto writeParts = [&](uint32_t g0, uint32_t g1) {
+            for (uint32_t g = g0; g < g1; g++) {
+                partTargetMs = std::max(partTargetMs, rec->gopDurationsMs[g]);
+                body << "#EXT-X-PART:DURATION=" << seconds(rec->gopDurationsMs[g])
+                     << ",URI=\"" << chunkUri(streamKey, rec->startMs, g, 1) << "\",INDEPENDENT=YES\n";
+            }
+        };
+        for (size_t c = c0; c < c1; c++) {
+            const Chunk& chunk = rec->chunks[c];
+            if (c >= partsFrom) writeParts(chunk.firstGop, chunk.firstGop + chunk.gopCount);
+            body << "#EXTINF:" << seconds(chunk.durationMs) << ",\n"
+                 << chunkUri(streamKey, rec->startMs, chunk.firstGop, chunk.gopCount) << "\n";
+        }
+        if (isLive) writeParts(tailGop, static_cast<uint32_t>(gopCount));
+    }
+    if (first) return "";
+
+    std::ostringstream out;
+    out << "#EXTM3U\n"
+        << "#EXT-X-VERSION:7\n"
+        << "#EXT-X-TARGETDURATION:" << (maxChunkMs + 999) / 1000 << "\n"
+        << "#EXT-X-MEDIA-SEQUENCE:0\n"
+        << "#EXT-X-INDEPENDENT-SEGMENTS\n"
+        << "#EXT-X-PLAYLIST-TYPE:" << (endMs < 0 ? "EVENT" : "VOD") << "\n";
+    if (partTargetMs > 0) {
+        out << "#EXT-X-PART-INF:PART-TARGET=" << seconds(partTargetMs) << "\n"
+            << "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=" << seconds(partTargetMs * 3) << "\n";
+    }
+    if (startOffsetMs >= 0) {
+        out << "#EXT-X-START:TIME-OFFSET=" << seconds(static_cast<uint32_t>(startOffsetMs)) << ",PRECISE=YES\n";
+    }
+    out << body.str();
+    if (endMs >= 0) out << "#EXT-X-ENDLIST\n";
+    return out.str();
+}
+
+bool HlsPackager::initSegment(const std::string& streamKey, int64_t recordingMs, const LiveSource& live,
+                              std::string& out) {
+    if (RecordingPtr rec = findFinalized(streamKey, recordingMs)) {
+        out = rec->init;
+        return true;
+    }
+    LocalRecorder::LiveSegment snapshot;
+    if (!live || !live(snapshot) || snapshot.startMs != recordingMs) return false;
+    RecordingPtr rec = fromLive(snapshot);
+    if (!rec || !ensureInit(*rec)) return false;
+    out = std::move(rec->init);
+    return true;
+}
+
+bool HlsPackager::fragment(const std::string& streamKey, int64_t recordingMs, uint32_t firstGop,
+                           uint32_t gopCount, const LiveSource& live, std::string& out) {
+    SegmentIndex index;
+    RecordingPtr rec = findFinalized(streamKey, recordingMs);
+    if (rec) {
+        if (!index.load(rec->indexPath)) return false;
+    } else {
+        LocalRecorder::LiveSegment snapshot;
+        if (!live || !live(snapshot) || snapshot.startMs != recordingMs) return false;
+        rec = fromLive(snapshot);
+        index = std::move(snapshot.index);
+    }
+    if (!rec || !rec->codecpar) return false;
+
+    const auto& frames = index.frames();
+    const auto& gops = index.gops();
+    if (gopCount == 0 || firstGop >= gops.size() || gopCount > gops.size() - firstGop ||
+        rec->gopDurationsMs.size() != gops.size()) {
+        return false;
+    }
+    const uint32_t lastGop = firstGop + gopCount - 1;
+    const size_t begin = gops[firstGop].firstFrame;
+    const size_t end = lastGop + 1 < gops.size() ? gops[lastGop + 1].firstFrame : frames.size();
+    const uint32_t endPtsMs = gops[lastGop].ptsMs + rec->gopDurationsMs[lastGop];
+
+    const int fd = ::open(rec->path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    std::string bytes;
+    AVFormatContext* ctx = openMuxer(rec->codecpar.get(), &bytes, firstGop + 1);
+    AVPacket* pkt = av_packet_alloc();
+    bool ok = ctx && pkt;
+    const size_t initBytes = bytes.size();
+    const AVRational tb = ctx ? ctx->streams[0]->time_base : AVRational{1, 90000};
+    for (size_t i = begin; ok && i < end; i++) {
+        const SegmentIndex::Frame& frame = frames[i];
+        const uint32_t nextPts = i + 1 < end ? frames[i + 1].ptsMs : endPtsMs;
+        if (av_new_packet(pkt, static_cast<int>(frame.size)) < 0 ||
+            ::pread(fd, pkt->data, frame.size, frame.offset) != static_cast<ssize_t>(frame.size)) {
+            std::cerr << "[HLS] short read in " << rec->path << " at " << frame.offset << std::endl;
+            av_packet_unref(pkt);
+            ok = false;
+            break;
+        }
+        pkt->pts = pkt->dts = av_rescale_q(frame.ptsMs, kMillis, tb);
+        pkt->duration = av_rescale_q(nextPts > frame.ptsMs ? nextPts - frame.ptsMs : kDefaultFrameStepMs,
+                                     kMillis, tb);
+        if (frame.keyframe) pkt->flags |= AV_PKT_FLAG_KEY;
+        const int ret = av_write_frame(ctx, pkt);
+        av_packet_unref(pkt);
+        if (ret < 0) {
+            std::cerr << "[HLS] write frame failed: " << ffErr(ret) << std::endl;
+            ok = false;
+        }
+    }
+    ::close(fd);
+    // A null packet flushes the fragment; no trailer, nothing follows it.
+    ok = ok && av_write_frame(ctx, nullptr) >= 0;
+    if (ctx) avio_flush(ctx->pb);
+    av_packet_free(&pkt);
+    closeMuxer(ctx);
+    if (!ok || bytes.size() <= initBytes) return false;
+    out.assign(bytes, initBytes, std::string::npos);
+    return true;
+}
+
+} // namespace reallive
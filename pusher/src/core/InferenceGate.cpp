@@ -0,0 +1,36 @@
+#include "core/InferenceGate.h"
+
+namespace reallive {
+
+InferenceGate& InferenceGate::instance() {
+    static InferenceGate gate;
+    return gate;
+}
+
+InferenceGate::Turn::Turn(InferenceGate& gate) : gate_(gate) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    std::unique_lock<std::mutex> lock(gate_.mutex_);
+    ticket_ = gate_.nextTicket_++;
+    while (gate_.serving_ != ticket_) {
+        gate_.cv_.wait_for(lock, std::chrono::milliseconds(100));
+        const bool nextInLine = gate_.serving_ + 1 == ticket_;
+        if (nextInLine && Clock::now() - gate_.turnStarted_ > std::chrono::milliseconds(kStuckMs)) {
+            gate_.serving_ = ticket_;  // the holder's release becomes a no-op
+        }
+    }
+    gate_.turnStarted_ = Clock::now();
+    waitedUs_ = std::chrono::duration_cast<std::chrono::microseconds>(gate_.turnStarted_ - start).count();
+}
+
+InferenceGate::Turn::~Turn() {
+    {
+        std::lock_guard<std::mutex> lock(gate_.mutex_);
+        if (gate_.serving_ != ticket_) return;  // skipped as stuck
+        gate_.serving_++;
+        gate_.turnStarted_ = std::chrono::steady_clock::now();
+    }
+    gate_.cv_.notify_all();
+}
+
+} // namespace reallive
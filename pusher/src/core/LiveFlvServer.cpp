@@ -0,0 +1,678 @@
+#include "core/LiveFlvServer.h"
+#include "core/Metrics.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/base64.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+#include <libavutil/sha.h>
+}
+
+namespace reallive {
+
+namespace {
+
+constexpr int kAvioBufferBytes = 256 * 1024;
+constexpr size_t kMaxRequestBytes = 8 * 1024;
+constexpr int64_t kRequestTimeoutMs = 5000;
+// Beyond this (or the per-viewer queue limit, if lower) the cache stops
+// growing and new viewers wait for the next keyframe instead.
+constexpr size_t kMaxGopCacheBytes = 8 * 1024 * 1024;
+constexpr int kMaxEvents = 64;
+constexpr int kMaxIov = 64;
+constexpr const char* kWebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+using WriteBuf = const uint8_t*;
+#else
+using WriteBuf = uint8_t*;
+#endif
+
+int appendPacket(void* opaque, WriteBuf buf, int size) {
+    static_cast<std::string*>(opaque)->append(reinterpret_cast<const char*>(buf), static_cast<size_t>(size));
+    return size;
+}
+
+std::string ffErr(int code) {
+    char buf[256];
+    av_strerror(code, buf, sizeof(buf));
+    return std::string(buf);
+}
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+std::string headerValue(const std::string& headers, const std::string& name) {
+    size_t pos = 0;
+    while (pos < headers.size()) {
+        size_t end = headers.find("\r\n", pos);
+        if (end == std::string::npos) end = headers.size();
+        const size_t colon = headers.find(':', pos);
+        if (colon != std::string::npos && colon < end && colon - pos == name.size() &&
+            strncasecmp(headers.c_str() + pos, name.c_str(), name.size()) == 0) {
+            return trim(headers.substr(colon + 1, end - colon - 1));
+        }
+        pos = end + 2;
+    }
+    return "";
+}
+
+// Sec-WebSocket-Accept (RFC 6455 4.2.2).
+std::string webSocketAccept(const std::string& key) {
+    const std::string input = key + kWebSocketGuid;
+    uint8_t digest[20];
+    struct AVSHA* sha = av_sha_alloc();
+    if (!sha) return "";
+    av_sha_init(sha, 160);
+    av_sha_update(sha, reinterpret_cast<const uint8_t*>(input.data()), static_cast<unsigned int>(input.size()));
+    av_sha_final(sha, digest);
+    av_free(sha);
+    char out[AV_BASE64_SIZE(20)];
+    return av_base64_encode(out, sizeof(out), digest, sizeof(digest)) ? std::string(out) : "";
+}
+
+std::string webSocketFrameHeader(size_t size) {
+    std::string h;
+    h.push_back(static_cast<char>(0x82));  // FIN + binary
+    if (size < 126) {
+        h.push_back(static_cast<char>(size));
+    } else if (size <= 0xFFFF) {
+        h.push_back(126);
+        h.push_back(static_cast<char>(size >> 8));
+        h.push_back(static_cast<char>(size));
+    } else {
+        h.push_back(127);
+        for (int shift = 56; shift >= 0; shift -= 8) h.push_back(static_cast<char>(static_cast<uint64_t>(size) >> shift));
+    }
+    return h;
+}
+
+// True once a complete client frame with the close opcode has arrived;
+// everything else the client sends is consumed and ignored.
+bool consumeWebSocketFrames(std::string& buf) {
+    while (buf.size() >= 2) {
+        const auto* p = reinterpret_cast<const uint8_t*>(buf.data());
+        const int opcode = p[0] & 0x0F;
+        const bool masked = (p[1] & 0x80) != 0;
+        uint64_t len = p[1] & 0x7F;
+        size_t pos = 2;
+        if (len == 126) {
+            if (buf.size() < 4) return false;
+            len = (static_cast<uint64_t>(p[2]) << 8) | p[3];
+            pos = 4;
+        } else if (len == 127) {
+            if (buf.size() < 10) return false;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = (len << 8) | p[2 + i];
+            pos = 10;
+        }
+        if (masked) pos += 4;
+        if (opcode == 0x8) return true;
+        if (len > kMaxRequestBytes) return true;  // viewers have nothing large to say
+        if (buf.size() < pos + len) return false;
+        buf.erase(0, pos + static_cast<size_t>(len));
+    }
+    return false;
+}
+
+} // namespace
+
+LiveFlvServer::~LiveFlvServer() {
+    stop();
+}
+
+bool LiveFlvServer::start(const Options& options) {
+    stop();
+    options_ = options;
+    if (options_.metrics) {
+        subscribersGauge_ = &options_.metrics->gauge(
+            "reallive_lan_flv_subscribers", "Viewers attached to the LAN HTTP/WebSocket-FLV server");
+        evictions_ = &options_.metrics->counter(
+            "reallive_lan_flv_evictions_total", "LAN FLV viewers disconnected for falling behind");
+        bytesOut_ = &options_.metrics->counter(
+            "reallive_lan_flv_bytes_total", "Bytes written to LAN FLV viewers");
+    }
+    if (!openMuxer()) return false;
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "[LanFlv] socket() failed: " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    int opt = 1;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (options_.host.empty() || options_.host == "0.0.0.0" ||
+        ::inet_pton(AF_INET, options_.host.c_str(), &addr.sin_addr) <= 0) {
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    }
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listenFd_, 32) < 0) {
+        std::cerr << "[LanFlv] bind/listen on port " << options_.port << " failed: "
+                  << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        stop();
+        return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd_;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev);
+    ev.data.fd = wakeFd_;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    running_ = true;
+    thread_ = std::thread(&LiveFlvServer::run, this);
+    std::cout << "[LanFlv] Serving /live/" << options_.streamKey << ".flv on "
+              << options_.host << ":" << options_.port << std::endl;
+    return true;
+}
+
+void LiveFlvServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        wake();
+        thread_.join();
+    }
+    for (auto& entry : clients_) ::close(entry.first);
+    clients_.clear();
+    streaming_ = 0;
+    gop_.clear();
+    gopBytes_ = 0;
+    gopComplete_ = false;
+    if (subscribersGauge_) subscribersGauge_->set(0);
+    for (int* fd : {&listenFd_, &epollFd_, &wakeFd_}) {
+        if (*fd >= 0) ::close(*fd);
+        *fd = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.clear();
+    }
+    closeMuxer();
+}
+
+bool LiveFlvServer::openMuxer() {
+    std::lock_guard<std::mutex> lock(muxMutex_);
+    int ret = avformat_alloc_output_context2(&mux_, nullptr, "flv", nullptr);
+    if (ret < 0 || !mux_) {
+        std::cerr << "[LanFlv] alloc flv muxer failed: " << ffErr(ret) << std::endl;
+        mux_ = nullptr;
+        return false;
+    }
+    AVStream* vs = avformat_new_stream(mux_, nullptr);
+    auto* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferBytes));
+    if (!vs || !buffer) {
+        av_free(buffer);
+        avformat_free_context(mux_);
+        mux_ = nullptr;
+        return false;
+    }
+    vs->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    vs->codecpar->codec_id = AV_CODEC_ID_H264;
+    vs->codecpar->width = options_.width;
+    vs->codecpar->height = options_.height;
+    vs->time_base = {1, 1000};
+    if (!options_.extraData.empty()) {
+        vs->codecpar->extradata = static_cast<uint8_t*>(
+            av_mallocz(options_.extraData.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (vs->codecpar->extradata) {
+            std::memcpy(vs->codecpar->extradata, options_.extraData.data(), options_.extraData.size());
+            vs->codecpar->extradata_size = static_cast<int>(options_.extraData.size());
+        }
+    }
+
+    muxOut_.clear();
+    mux_->pb = avio_alloc_context(buffer, kAvioBufferBytes, 1, &muxOut_, nullptr, &appendPacket, nullptr);
+    if (!mux_->pb) {
+        av_free(buffer);
+        avformat_free_context(mux_);
+        mux_ = nullptr;
+        return false;
+    }
+    mux_->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    AVDictionary* opts = nullptr;
+    av_dict_set(&opts, "flvflags", "no_duration_filesize", 0);
+    ret = avformat_write_header(mux_, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        std::cerr << "[LanFlv] write header failed: " << ffErr(ret) << std::endl;
+        av_freep(&mux_->pb->buffer);
+        avio_context_free(&mux_->pb);
+        avformat_free_context(mux_);
+        mux_ = nullptr;
+        return false;
+    }
+    // FLV header, metadata and the AVC sequence header: sent to every viewer first.
+    avio_flush(mux_->pb);
+    header_ = makeChunk(std::move(muxOut_), true);
+    muxOut_.clear();
+    firstDtsUs_ = -1;
+    lastDtsMs_ = 0;
+    return true;
+}
+
+void LiveFlvServer::closeMuxer() {
+    std::lock_guard<std::mutex> lock(muxMutex_);
+    if (!mux_) return;
+    av_freep(&mux_->pb->buffer);
+    avio_context_free(&mux_->pb);
+    avformat_free_context(mux_);
+    mux_ = nullptr;
+    header_.reset();
+}
+
+LiveFlvServer::ChunkPtr LiveFlvServer::makeChunk(std::string data, bool websocketFramed) {
+    auto chunk = std::make_shared<Chunk>();
+    if (websocketFramed) chunk->wsHeader = webSocketFrameHeader(data.size());
+    chunk->data = std::move(data);
+    return chunk;
+}
+
+void LiveFlvServer::publish(const EncodedPacket& packet) {
+    if (!running_ || packet.empty()) return;
+
+    ChunkPtr chunk;
+    {
+        std::lock_guard<std::mutex> lock(muxMutex_);
+        if (!mux_) return;
+        AVPacket* avpkt = av_packet_alloc();
+        if (!avpkt) return;
+        avpkt->data = const_cast<uint8_t*>(packet.bytes());
+        avpkt->size = static_cast<int>(packet.size());
+        avpkt->stream_index = 0;
+        if (firstDtsUs_ < 0) firstDtsUs_ = packet.dts;
+        const int64_t dtsMs = std::max(lastDtsMs_, (packet.dts - firstDtsUs_) / 1000);
+        lastDtsMs_ = dtsMs;
+        avpkt->dts = dtsMs;
+        avpkt->pts = std::max(dtsMs, (packet.pts - firstDtsUs_) / 1000);
+        if (packet.isKeyframe) avpkt->flags |= AV_PKT_FLAG_KEY;
+        const int ret = av_write_frame(mux_, avpkt);
+        av_packet_free(&avpkt);
+        if (ret < 0) {
+            std::cerr << "[LanFlv] mux failed: " << ffErr(ret) << std::endl;
+            muxOut_.clear();
+            return;
+        }
+        avio_flush(mux_->pb);
+        chunk = makeChunk(std::move(muxOut_), true);
+        muxOut_.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.push_back({std::move(chunk), packet.isKeyframe});
+    }
+    wake();
+}
+
+void LiveFlvServer::wake() {
+    if (wakeFd_ < 0) return;
+    const uint64_t one = 1;
+    (void)::write(wakeFd_, &one, sizeof(one));
+}
+
+void LiveFlvServer::run() {
+    epoll_event events[kMaxEvents];
+    while (running_) {
+        const int n = ::epoll_wait(epollFd_, events, kMaxEvents, 1000);
+        if (n < 0 && errno != EINTR) {
+            std::cerr << "[LanFlv] epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < n && running_; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd_) {
+                acceptClients();
+                continue;
+            }
+            if (fd == wakeFd_) {
+                uint64_t count = 0;
+                while (::read(wakeFd_, &count, sizeof(count)) > 0) {
+                }
+                drainPublished();
+                continue;
+            }
+            auto it = clients_.find(fd);
+            if (it == clients_.end()) continue;
+            Subscriber& sub = it->second;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeClient(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                if (!flush(sub)) {
+                    closeClient(fd);
+                    continue;
+                }
+            }
+            if (events[i].events & EPOLLIN) onReadable(sub);
+        }
+
+        // Connections that never finish their request.
+        const int64_t now = nowMs();
+        std::vector<int> expired;
+        for (const auto& entry : clients_) {
+            if (entry.second.state == Subscriber::State::Request &&
+                now - entry.second.acceptedMs > kRequestTimeoutMs) {
+                expired.push_back(entry.first);
+            }
+        }
+        for (int fd : expired) closeClient(fd);
+    }
+}
+
+void LiveFlvServer::acceptClients() {
+    while (true) {
+        const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // EAGAIN: backlog drained
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        Subscriber sub;
+        sub.fd = fd;
+        sub.acceptedMs = nowMs();
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            ::close(fd);
+            continue;
+        }
+        clients_.emplace(fd, std::move(sub));
+    }
+}
+
+void LiveFlvServer::onReadable(Subscriber& sub) {
+    char buf[4096];
+    while (true) {
+        const ssize_t n = ::recv(sub.fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            closeClient(sub.fd);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                closeClient(sub.fd);
+                return;
+            }
+            break;
+        }
+        if (sub.state == Subscriber::State::Streaming && !sub.websocket) continue;  // nothing to read
+        sub.inbuf.append(buf, static_cast<size_t>(n));
+        if (sub.inbuf.size() > kMaxRequestBytes * 2) {
+            closeClient(sub.fd);
+            return;
+        }
+    }
+
+    if (sub.state == Subscriber::State::Request) {
+        if (sub.inbuf.find("\r\n\r\n") != std::string::npos) {
+            handleRequest(sub);
+        } else if (sub.inbuf.size() > kMaxRequestBytes) {
+            rejectAndClose(sub, 400, "Bad Request");
+        }
+    } else if (sub.websocket && consumeWebSocketFrames(sub.inbuf)) {
+        closeClient(sub.fd);
+    }
+}
+
+void LiveFlvServer::handleRequest(Subscriber& sub) {
+    const size_t headerEnd = sub.inbuf.find("\r\n\r\n");
+    const std::string headers = sub.inbuf.substr(0, headerEnd);
+    sub.inbuf.erase(0, headerEnd + 4);
+
+    std::istringstream firstLine(headers.substr(0, headers.find("\r\n")));
+    std::string method;
+    std::string target;
+    firstLine >> method >> target;
+    const std::string path = target.substr(0, target.find('?'));
+    if (method != "GET") {
+        rejectAndClose(sub, 405, "Method Not Allowed");
+        return;
+    }
+    const std::string file = "/" + options_.streamKey + ".flv";
+    if (path != file && path != "/live" + file) {
+        rejectAndClose(sub, 404, "Not Found");
+        return;
+    }
+    if (streaming_ >= options_.maxSubscribers) {
+        rejectAndClose(sub, 503, "Service Unavailable");
+        return;
+    }
+
+    std::ostringstream resp;
+    const std::string upgrade = headerValue(headers, "Upgrade");
+    if (strcasecmp(upgrade.c_str(), "websocket") == 0) {
+        const std::string accept = webSocketAccept(headerValue(headers, "Sec-WebSocket-Key"));
+        if (accept.empty()) {
+            rejectAndClose(sub, 400, "Bad Request");
+            return;
+        }
+        sub.websocket = true;
+        resp << "HTTP/1.1 101 Switching Protocols\r\n"
+             << "Upgrade: websocket\r\n"
+             << "Connection: Upgrade\r\n"
+             << "Sec-WebSocket-Accept: " << accept << "\r\n\r\n";
+    } else {
+        resp << "HTTP/1.1 200 OK\r\n"
+             << "Content-Type: video/x-flv\r\n"
+             << "Cache-Control: no-cache\r\n"
+             << "Connection: close\r\n"
+             << "Access-Control-Allow-Origin: *\r\n\r\n";
+    }
+    sub.state = Subscriber::State::Streaming;
+    streaming_++;
+    if (subscribersGauge_) subscribersGauge_->set(static_cast<double>(streaming_));
+    const int fd = sub.fd;
+    if (!enqueue(sub, makeChunk(resp.str(), false))) return;
+    if (clients_.count(fd)) join(sub);
+}
+
+void LiveFlvServer::join(Subscriber& sub) {
+    ChunkPtr header;
+    {
+        std::lock_guard<std::mutex> lock(muxMutex_);
+        header = header_;
+    }
+    if (!header || !enqueue(sub, header)) return;
+    if (!gopComplete_ || gop_.empty()) {
+        sub.wantKeyframe = true;
+        return;
+    }
+    // A GOP that would overflow the viewer's queue in one go would get it
+    // evicted as a slow viewer before it has read a byte.
+    size_t replayBytes = sub.queuedBytes;
+    for (const ChunkPtr& chunk : gop_) {
+        replayBytes += chunk->wsHeader.size() + chunk->data.size();
+    }
+    if (replayBytes > options_.queueBytes) {
+        sub.wantKeyframe = true;
+        return;
+    }
+    // Whole GOP at once: the player decodes up to live right away.
+    for (const ChunkPtr& chunk : gop_) {
+        if (!enqueue(sub, chunk)) return;
+    }
+}
+
+void LiveFlvServer::drainPublished() {
+    std::vector<Published> batch;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        batch.swap(pending_);
+    }
+    for (const Published& item : batch) {
+        const size_t size = item.chunk->data.size();
+        if (item.keyframe) {
+            gop_.clear();
+            gopBytes_ = 0;
+            gopComplete_ = true;
+        }
+        if (gopComplete_ && gopBytes_ + size <= std::min(kMaxGopCacheBytes, options_.queueBytes)) {
+            gop_.push_back(item.chunk);
+            gopBytes_ += size;
+        } else {
+            gopComplete_ = false;
+        }
+
+        std::vector<int> fds;
+        fds.reserve(clients_.size());
+        for (const auto& entry : clients_) {
+            if (entry.second.state == Subscriber::State::Streaming) fds.push_back(entry.first);
+        }
+        for (int fd : fds) {
+            Subscriber& sub = clients_.at(fd);
+            if (sub.wantKeyframe) {
+                if (!item.keyframe) continue;
+                sub.wantKeyframe = false;
+            }
+            enqueue(sub, item.chunk);
+        }
+    }
+}
+
+bool LiveFlvServer::enqueue(Subscriber& sub, const ChunkPtr& chunk) {
+    sub.queuedBytes += chunk->wsHeader.size() + chunk->data.size();
+    sub.queue.push_back(chunk);
+    if (sub.queuedBytes > options_.queueBytes) {
+        std::cout << "[LanFlv] Dropping slow viewer fd=" << sub.fd << " (" << sub.queuedBytes
+                  << " bytes behind)" << std::endl;
+        if (evictions_) evictions_->inc();
+        closeClient(sub.fd);
+        return false;
+    }
+    if (sub.writeArmed) return true;  // EPOLLOUT will pick it up
+    if (!flush(sub)) {
+        closeClient(sub.fd);
+        return false;
+    }
+    return true;
+}
+
+bool LiveFlvServer::flush(Subscriber& sub) {
+    while (!sub.queue.empty()) {
+        iovec iov[kMaxIov];
+        int count = 0;
+        size_t skip = sub.frontOffset;
+        for (const ChunkPtr& chunk : sub.queue) {
+            if (count + 2 > kMaxIov) break;
+            const std::string* parts[2] = {sub.websocket ? &chunk->wsHeader : nullptr, &chunk->data};
+            for (const std::string* part : parts) {
+                if (!part || part->empty()) continue;
+                if (skip >= part->size()) {
+                    skip -= part->size();
+                    continue;
+                }
+                iov[count].iov_base = const_cast<char*>(part->data() + skip);
+                iov[count].iov_len = part->size() - skip;
+                count++;
+                skip = 0;
+            }
+        }
+
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(count);
+        const ssize_t n = ::sendmsg(sub.fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                setWriteInterest(sub, true);
+                return true;
+            }
+            return false;
+        }
+        if (bytesOut_) bytesOut_->inc(static_cast<uint64_t>(n));
+
+        size_t done = static_cast<size_t>(n);
+        while (done > 0 && !sub.queue.empty()) {
+            const Chunk& front = *sub.queue.front();
+            const size_t total = (sub.websocket ? front.wsHeader.size() : 0) + front.data.size();
+            const size_t left = total - sub.frontOffset;
+            if (done < left) {
+                sub.frontOffset += done;
+                done = 0;
+                break;
+            }
+            done -= left;
+            sub.queuedBytes -= front.wsHeader.size() + front.data.size();
+            sub.queue.pop_front();
+            sub.frontOffset = 0;
+        }
+    }
+    setWriteInterest(sub, false);
+    return true;
+}
+
+void LiveFlvServer::setWriteInterest(Subscriber& sub, bool on) {
+    if (sub.writeArmed == on) return;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (on ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.fd = sub.fd;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, sub.fd, &ev);
+    sub.writeArmed = on;
+}
+
+void LiveFlvServer::rejectAndClose(Subscriber& sub, int status, const char* reason) {
+    std::ostringstream resp;
+    resp << "HTTP/1.1 " << status << " " << reason << "\r\n"
+         << "Content-Length: 0\r\n"
+         << "Connection: close\r\n\r\n";
+    const std::string text = resp.str();
+    (void)::send(sub.fd, text.data(), text.size(), MSG_NOSIGNAL);
+    closeClient(sub.fd);
+}
+
+void LiveFlvServer::closeClient(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) return;
+    if (it->second.state == Subscriber::State::Streaming) {
+        streaming_--;
+        if (subscribersGauge_) subscribersGauge_->set(static_cast<double>(streaming_));
+    }
+    ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    clients_.erase(it);
+}
+
+} // namespace reallive
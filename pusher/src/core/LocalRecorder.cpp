@@ -1,8 +1,10 @@
 #include "core/LocalRecorder.h"
+#include "core/Metrics.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <iostream>
@@ -17,6 +19,15 @@ namespace reallive {
 
 namespace {
 
+// Upper bound on the pre-roll ring regardless of bitrate; whole GOPs are
+// dropped from the front beyond it.
+constexpr size_t kPreRollMaxBytes = 32 * 1024 * 1024;
+constexpr size_t kMaxSpareBuffers = 64;
+constexpr uint64_t kMaxPreallocateBytes = 1024ULL * 1024 * 1024;
+// How long one liveSegment() call keeps the per-keyframe flush going; HLS
+// clients reload the playlist well within it.
+constexpr int64_t kLiveReaderHoldMs = 10000;
+
 int64_t nowWallMs() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()
@@ -29,6 +40,95 @@ std::string ffErr(int code) {
     return std::string(buf);
 }
 
+// Exp-Golomb reader over an SPS with its emulation-prevention bytes removed.
+class RbspReader {
+public:
+    RbspReader(const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            if (i >= 2 && data[i] == 3 && data[i - 1] == 0 && data[i - 2] == 0) continue;
+            bytes_.push_back(data[i]);
+        }
+    }
+    uint32_t bit() {
+        if (pos_ >= bytes_.size() * 8) return 0;
+        const uint32_t b = (bytes_[pos_ / 8] >> (7 - pos_ % 8)) & 1;
+        pos_++;
+        return b;
+    }
+    uint32_t ue() {
+        int zeros = 0;
+        while (bit() == 0 && zeros < 31) zeros++;
+        uint32_t value = 0;
+        for (int i = 0; i < zeros; i++) value = (value << 1) | bit();
+        return (1u << zeros) - 1 + value;
+    }
+    void skip(size_t bits) { pos_ += bits; }
+
+private:
+    std::vector<uint8_t> bytes_;
+    size_t pos_ = 0;
+};
+
+// The mp4 muxer converts Annex-B extradata to an avcC record for the moov
+// and writes every sample length-prefixed. Readers of the still-open file
+// get the samples but not the moov, so they need the same record; this
+// builds it the way libavformat does. Empty if there is no SPS/PPS.
+std::vector<uint8_t> avccFromAnnexB(const std::vector<uint8_t>& extra) {
+    if (!extra.empty() && extra[0] == 1) return extra;  // already avcC
+
+    std::vector<std::pair<size_t, size_t>> sps;  // (offset, size)
+    std::vector<std::pair<size_t, size_t>> pps;
+    size_t i = 0;
+    const size_t n = extra.size();
+    while (i + 3 <= n) {
+        if (extra[i] != 0 || extra[i + 1] != 0 || extra[i + 2] != 1) {
+            i++;
+            continue;
+        }
+        const size_t begin = i + 3;
+        size_t end = begin;
+        while (end + 3 <= n && !(extra[end] == 0 && extra[end + 1] == 0 && extra[end + 2] == 1)) end++;
+        if (end + 3 > n) end = n;
+        size_t trimmed = end;
+        while (trimmed > begin && extra[trimmed - 1] == 0) trimmed--;  // 4-byte start code / trailing zeros
+        if (trimmed > begin && trimmed - begin <= 0xFFFF) {
+            const uint8_t type = extra[begin] & 0x1F;
+            if (type == 7) sps.emplace_back(begin, trimmed - begin);
+            if (type == 8) pps.emplace_back(begin, trimmed - begin);
+        }
+        i = end;
+    }
+    if (sps.empty() || pps.empty() || sps[0].second < 4 || sps.size() > 31 || pps.size() > 255) return {};
+
+    const uint8_t* first = extra.data() + sps[0].first;
+    std::vector<uint8_t> out = {1, first[1], first[2], first[3], 0xFF,
+                                static_cast<uint8_t>(0xE0 | sps.size())};
+    const auto append = [&](const std::pair<size_t, size_t>& nal) {
+        out.push_back(static_cast<uint8_t>(nal.second >> 8));
+        out.push_back(static_cast<uint8_t>(nal.second & 0xFF));
+        out.insert(out.end(), extra.begin() + nal.first, extra.begin() + nal.first + nal.second);
+    };
+    for (const auto& nal : sps) append(nal);
+    out.push_back(static_cast<uint8_t>(pps.size()));
+    for (const auto& nal : pps) append(nal);
+
+    // High profiles carry chroma format and bit depth as well (ISO 14496-15).
+    const uint8_t profile = first[1];
+    if (profile == 100 || profile == 110 || profile == 122 || profile == 144) {
+        RbspReader sp(first + 4, sps[0].second - 4);
+        sp.ue();  // seq_parameter_set_id
+        const uint32_t chromaFormat = sp.ue();
+        if (chromaFormat == 3) sp.skip(1);  // separate_colour_plane_flag
+        const uint32_t lumaDepth = sp.ue();
+        const uint32_t chromaDepth = sp.ue();
+        out.push_back(static_cast<uint8_t>(0xFC | (chromaFormat & 3)));
+        out.push_back(static_cast<uint8_t>(0xF8 | (lumaDepth & 7)));
+        out.push_back(static_cast<uint8_t>(0xF8 | (chromaDepth & 7)));
+        out.push_back(0);  // no SPS extensions
+    }
+    return out;
+}
+
 double thumbnailSeekSeconds(const std::string& mp4Path) {
     std::smatch m;
     const std::regex pattern(R"(segment_(\d+)_(\d+)\.mp4$)");
@@ -61,7 +161,9 @@ bool LocalRecorder::init(
     const uint8_t* videoExtraData,
     int videoExtraDataSize,
     int width,
-    int height
+    int height,
+    int bitrate,
+    MetricsRegistry* metrics
 ) {
     close();
 
@@ -86,12 +188,24 @@ bool LocalRecorder::init(
     streamKey_ = sanitizeStreamKey(streamKey.empty() ? "default" : streamKey);
     width_ = width;
     height_ = height;
+    bitrate_ = bitrate;
+    if (metrics) {
+        writeHist_ = &metrics->histogram(
+            "reallive_record_write_seconds", "Recorder pwrite() latency per AVIO buffer flush");
+        syncHist_ = &metrics->histogram(
+            "reallive_record_fsync_seconds", "Recorder blocking writeback waits and segment fdatasync");
+    }
 
     if (videoExtraData && videoExtraDataSize > 0) {
         videoExtraData_.assign(videoExtraData, videoExtraData + videoExtraDataSize);
     } else {
         videoExtraData_.clear();
     }
+    liveAvcc_ = avccFromAnnexB(videoExtraData_);
+    if (!videoExtraData_.empty() && liveAvcc_.empty()) {
+        std::cerr << "[LocalRecorder] No SPS/PPS in the encoder extradata; live HLS parts are unavailable"
+                  << std::endl;
+    }
 
     std::filesystem::path root(config_.outputDir);
     std::filesystem::path streamDir = root / streamKey_;
@@ -103,13 +217,28 @@ bool LocalRecorder::init(
         return false;
     }
     streamDir_ = streamDir.string();
+    recoverOrphanSegments();
+
+    retention_.start(streamDir_, retentionPolicy(), config_.retentionIntervalSec);
+
+    eventMode_ = config_.mode == "event";
+    eventUntilMs_ = 0;
+    if (eventMode_) {
+        initialized_ = true;
+        std::cout << "[LocalRecorder] Event mode at " << streamDir_
+                  << ", pre-roll=" << config_.preRollSec << "s"
+                  << ", post-roll=" << config_.postRollSec << "s"
+                  << ", max-clip=" << config_.segmentDurationSec << "s"
+                  << std::endl;
+        return true;
+    }
 
     initialized_ = openSegment(nowWallMs());
     if (!initialized_) {
         std::cerr << "[LocalRecorder] Failed to open first segment" << std::endl;
+        retention_.stop();
         return false;
     }
-    maybeCleanupOldSegments();
     std::cout << "[LocalRecorder] Enabled at " << streamDir_
               << ", segment=" << config_.segmentDurationSec << "s"
               << ", free-threshold=" << config_.minFreePercent << "%"
@@ -121,6 +250,17 @@ bool LocalRecorder::isEnabled() const {
     return initialized_;
 }
 
+bool LocalRecorder::isEventMode() const {
+    return eventMode_;
+}
+
+void LocalRecorder::markEvent() {
+    const int64_t until = nowWallMs() + static_cast<int64_t>(config_.postRollSec) * 1000;
+    int64_t current = eventUntilMs_.load();
+    while (current < until && !eventUntilMs_.compare_exchange_weak(current, until)) {
+    }
+}
+
 bool LocalRecorder::setCleanupPolicy(int minFreePercent, int targetFreePercent) {
     if (!initialized_) return false;
     minFreePercent = std::max(1, std::min(95, minFreePercent));
@@ -130,7 +270,7 @@ bool LocalRecorder::setCleanupPolicy(int minFreePercent, int targetFreePercent)
         config_.minFreePercent = minFreePercent;
         config_.targetFreePercent = targetFreePercent;
     }
-    maybeCleanupOldSegments();
+    retention_.setPolicy(retentionPolicy());
     return true;
 }
 
@@ -182,30 +322,44 @@ bool LocalRecorder::openSegment(int64_t startMs) {
         vs->codecpar->extradata_size = static_cast<int>(videoExtraData_.size());
     }
 
-    if (!(formatCtx_->oformat->flags & AVFMT_NOFILE)) {
-        ret = avio_open(&formatCtx_->pb, currentTempPath_.c_str(), AVIO_FLAG_WRITE);
-        if (ret < 0) {
-            std::cerr << "[LocalRecorder] open temp file failed: " << ffErr(ret) << std::endl;
-            avformat_free_context(formatCtx_);
-            formatCtx_ = nullptr;
-            return false;
-        }
+    RecordFileWriter::Options fileOptions;
+    fileOptions.bufferBytes = static_cast<size_t>(config_.writeBufferKb) * 1024;
+    fileOptions.syncChunkBytes = static_cast<uint64_t>(config_.syncChunkKb) * 1024;
+    fileOptions.writeHist = writeHist_;
+    fileOptions.syncHist = syncHist_;
+    if (config_.preallocate && bitrate_ > 0) {
+        // Expected size plus 25% for bitrate overshoot; trimmed on close.
+        const uint64_t expected = static_cast<uint64_t>(bitrate_) / 8 *
+                                  static_cast<uint64_t>(config_.segmentDurationSec);
+        fileOptions.preallocateBytes = std::min<uint64_t>(expected + expected / 4, kMaxPreallocateBytes);
     }
+    if (!file_.open(currentTempPath_, fileOptions)) {
+        std::cerr << "[LocalRecorder] open temp file failed: " << currentTempPath_ << std::endl;
+        avformat_free_context(formatCtx_);
+        formatCtx_ = nullptr;
+        return false;
+    }
+    formatCtx_->pb = file_.avio();
+    formatCtx_->flags |= AVFMT_FLAG_CUSTOM_IO;
 
     ret = avformat_write_header(formatCtx_, nullptr);
     if (ret < 0) {
         std::cerr << "[LocalRecorder] write header failed: " << ffErr(ret) << std::endl;
-        if (!(formatCtx_->oformat->flags & AVFMT_NOFILE)) {
-            avio_closep(&formatCtx_->pb);
-        }
+        formatCtx_->pb = nullptr;
+        file_.close();
         avformat_free_context(formatCtx_);
         formatCtx_ = nullptr;
         return false;
     }
 
     headerWritten_ = true;
-    segmentStartWallMs_ = startMs;
     segmentStartPtsUs_ = -1;
+    {
+        std::lock_guard<std::mutex> lock(liveMutex_);
+        segmentStartWallMs_ = startMs;
+        index_.clear();
+        liveOpen_ = true;
+    }
     return true;
 }
 
@@ -213,20 +367,31 @@ bool LocalRecorder::finalizeCurrentSegment(int64_t endMs) {
     if (!formatCtx_) {
         return true;
     }
+    {
+        std::lock_guard<std::mutex> lock(liveMutex_);
+        liveOpen_ = false;
+    }
 
     if (headerWritten_) {
         av_write_trailer(formatCtx_);
     }
 
-    if (!(formatCtx_->oformat->flags & AVFMT_NOFILE)) {
-        avio_closep(&formatCtx_->pb);
-    }
+    formatCtx_->pb = nullptr;
+    const bool fileOk = file_.close();
     avformat_free_context(formatCtx_);
     formatCtx_ = nullptr;
     headerWritten_ = false;
     videoStreamIdx_ = -1;
 
+    if (!fileOk) {
+        std::cerr << "[LocalRecorder] segment write incomplete: " << currentTempPath_ << std::endl;
+    }
+
     const std::string finalPath = makeFinalPath(segmentStartWallMs_, endMs);
+    // The index goes first so a visible mp4 always has its sidecar.
+    if (fileOk && !index_.empty() && !index_.save(SegmentIndex::pathFor(finalPath))) {
+        std::cerr << "[LocalRecorder] write index failed for " << finalPath << std::endl;
+    }
     std::error_code ec;
     std::filesystem::rename(currentTempPath_, finalPath, ec);
     if (ec) {
@@ -240,7 +405,7 @@ bool LocalRecorder::finalizeCurrentSegment(int64_t endMs) {
         generateThumbnail(finalPath);
     }
 
-    maybeCleanupOldSegments();
+    retention_.requestPass();
     currentTempPath_.clear();
     return true;
 }
@@ -265,14 +430,110 @@ bool LocalRecorder::rotateIfNeeded(const EncodedPacket& packet, int64_t nowMs) {
     return openSegment(nowMs);
 }
 
+bool LocalRecorder::startsSegment(const EncodedPacket& packet) const {
+    if (!initialized_ || !packet.isKeyframe) return false;
+    if (eventMode_ || !formatCtx_) return true;
+    const int64_t durationMs = static_cast<int64_t>(config_.segmentDurationSec) * 1000;
+    return nowWallMs() - segmentStartWallMs_ >= durationMs;
+}
+
 bool LocalRecorder::writeVideoPacket(const EncodedPacket& packet) {
     if (!initialized_) return true;
     if (packet.empty()) return true;
 
     const int64_t nowMs = nowWallMs();
+    if (eventMode_) {
+        return writeEventPacket(packet, nowMs);
+    }
     if (!rotateIfNeeded(packet, nowMs)) {
         return false;
     }
+    return writeRaw(packet.bytes(), packet.size(), packet.pts, packet.dts, packet.isKeyframe);
+}
+
+bool LocalRecorder::writeEventPacket(const EncodedPacket& packet, int64_t nowMs) {
+    const bool active = nowMs < eventUntilMs_.load();
+
+    if (!formatCtx_) {
+        if (!active) {
+            bufferPreRoll(packet, nowMs);
+            return true;
+        }
+        // Clips start on a keyframe: the ring always begins with one, and
+        // with an empty ring we wait for the next.
+        if (preRoll_.empty() && !packet.isKeyframe) {
+            return true;
+        }
+        const int64_t startMs = preRoll_.empty() ? nowMs : preRoll_.front().wallMs;
+        if (!openSegment(startMs)) {
+            return false;
+        }
+        std::cout << "[LocalRecorder] Event clip started, pre-roll="
+                  << (nowMs - startMs) << "ms" << std::endl;
+        bool ok = true;
+        for (const BufferedPacket& b : preRoll_) {
+            ok = writeRaw(b.data.data(), b.data.size(), b.pts, b.dts, b.isKeyframe) && ok;
+        }
+        dropPreRollFront(preRoll_.size());
+        return writeRaw(packet.bytes(), packet.size(), packet.pts, packet.dts, packet.isKeyframe) && ok;
+    }
+
+    if (!active) {
+        // Post-roll elapsed; the ring refills from the next keyframe.
+        const bool ok = finalizeCurrentSegment(nowMs);
+        bufferPreRoll(packet, nowMs);
+        return ok;
+    }
+
+    // Long events are split like continuous segments.
+    if (!rotateIfNeeded(packet, nowMs)) {
+        return false;
+    }
+    return writeRaw(packet.bytes(), packet.size(), packet.pts, packet.dts, packet.isKeyframe);
+}
+
+void LocalRecorder::bufferPreRoll(const EncodedPacket& packet, int64_t nowMs) {
+    if (config_.preRollSec <= 0) return;
+    if (preRoll_.empty() && !packet.isKeyframe) return;
+
+    BufferedPacket b;
+    if (!spareBuffers_.empty()) {
+        b.data = std::move(spareBuffers_.back());
+        spareBuffers_.pop_back();
+    }
+    b.data.assign(packet.bytes(), packet.bytes() + packet.size());
+    b.pts = packet.pts;
+    b.dts = packet.dts;
+    b.wallMs = nowMs;
+    b.isKeyframe = packet.isKeyframe;
+    preRollBytes_ += b.data.size();
+    preRoll_.push_back(std::move(b));
+
+    // Drop the oldest GOP while the rest still covers the pre-roll window
+    // (or the ring is over its byte budget).
+    const int64_t windowStartMs = nowMs - static_cast<int64_t>(config_.preRollSec) * 1000;
+    while (true) {
+        size_t nextGop = 1;
+        while (nextGop < preRoll_.size() && !preRoll_[nextGop].isKeyframe) nextGop++;
+        if (nextGop >= preRoll_.size()) break;
+        if (preRoll_[nextGop].wallMs > windowStartMs && preRollBytes_ <= kPreRollMaxBytes) break;
+        dropPreRollFront(nextGop);
+    }
+}
+
+void LocalRecorder::dropPreRollFront(size_t count) {
+    for (size_t i = 0; i < count && !preRoll_.empty(); i++) {
+        BufferedPacket& b = preRoll_.front();
+        preRollBytes_ -= b.data.size();
+        if (spareBuffers_.size() < kMaxSpareBuffers) {
+            b.data.clear();
+            spareBuffers_.push_back(std::move(b.data));
+        }
+        preRoll_.pop_front();
+    }
+}
+
+bool LocalRecorder::writeRaw(const uint8_t* data, size_t size, int64_t ptsUs, int64_t dtsUs, bool isKeyframe) {
     if (!formatCtx_) {
         return false;
     }
@@ -280,12 +541,10 @@ bool LocalRecorder::writeVideoPacket(const EncodedPacket& packet) {
     AVPacket* avpkt = av_packet_alloc();
     if (!avpkt) return false;
 
-    avpkt->data = const_cast<uint8_t*>(packet.data.data());
-    avpkt->size = static_cast<int>(packet.data.size());
+    avpkt->data = const_cast<uint8_t*>(data);
+    avpkt->size = static_cast<int>(size);
     avpkt->stream_index = videoStreamIdx_;
 
-    int64_t ptsUs = packet.pts;
-    int64_t dtsUs = packet.dts;
     if (segmentStartPtsUs_ < 0) {
         segmentStartPtsUs_ = std::max<int64_t>(0, ptsUs);
     }
@@ -298,19 +557,130 @@ bool LocalRecorder::writeVideoPacket(const EncodedPacket& packet) {
     avpkt->pts = av_rescale_q(ptsUs, {1, 1000000}, stream->time_base);
     avpkt->dts = av_rescale_q(dtsUs, {1, 1000000}, stream->time_base);
     avpkt->duration = 0;
-    if (packet.isKeyframe) {
+    if (isKeyframe) {
         avpkt->flags |= AV_PKT_FLAG_KEY;
     }
 
-    const int ret = av_interleaved_write_frame(formatCtx_, avpkt);
+    // Someone follows this segment over HLS: put the GOP that just closed
+    // on disk now instead of whenever the write buffer fills.
+    if (isKeyframe && nowWallMs() < liveReadersUntilMs_.load()) {
+        avio_flush(formatCtx_->pb);
+    }
+
+    // Single stream, so no interleaving is needed and the sample lands in
+    // the file right away; the AVIO position brackets its bytes for the index.
+    const int64_t offset = avio_tell(formatCtx_->pb);
+    const int ret = av_write_frame(formatCtx_, avpkt);
     av_packet_free(&avpkt);
     if (ret < 0) {
         std::cerr << "[LocalRecorder] write frame failed: " << ffErr(ret) << std::endl;
         return false;
     }
+    const int64_t written = avio_tell(formatCtx_->pb) - offset;
+    if (offset >= 0 && written > 0) {
+        std::lock_guard<std::mutex> lock(liveMutex_);
+        index_.addFrame(static_cast<uint32_t>(ptsUs / 1000), static_cast<uint64_t>(offset),
+                        static_cast<uint32_t>(written), isKeyframe);
+    }
     return true;
 }
 
+bool LocalRecorder::liveSegment(LiveSegment& out) {
+    liveReadersUntilMs_ = nowWallMs() + kLiveReaderHoldMs;
+    const uint64_t onDisk = file_.bytesWritten();
+
+    std::lock_guard<std::mutex> lock(liveMutex_);
+    if (!liveOpen_) return false;
+    const auto& frames = index_.frames();
+    const auto& gops = index_.gops();
+
+    // The last GOP is still growing; of the closed ones, keep those whose
+    // bytes have left the write buffer.
+    size_t endFrame = 0;
+    for (size_t g = 1; g < gops.size(); g++) {
+        const SegmentIndex::Frame& last = frames[gops[g].firstFrame - 1];
+        if (last.offset + last.size > onDisk) break;
+        endFrame = gops[g].firstFrame;
+    }
+
+    out.path = currentTempPath_;
+    out.startMs = segmentStartWallMs_;
+    out.index.clear();
+    for (size_t i = 0; i < endFrame; i++) {
+        const SegmentIndex::Frame& f = frames[i];
+        out.index.addFrame(f.ptsMs, f.offset, f.size, f.keyframe);
+    }
+    out.endPtsMs = endFrame > 0 ? frames[endFrame].ptsMs : 0;
+    out.avcc = liveAvcc_;
+    out.width = width_;
+    out.height = height_;
+    return true;
+}
+
+// Temp files left behind by a crash or power loss. One whose trailer made it
+// to disk (the rename was all that failed) demuxes and is finalized under
+// its real duration; anything else has no moov and is deleted.
+void LocalRecorder::recoverOrphanSegments() {
+    namespace fs = std::filesystem;
+    std::vector<std::pair<fs::path, int64_t>> orphans;
+    std::vector<std::string> indexNames;
+    std::error_code ec;
+    for (fs::directory_iterator it(streamDir_, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        long long startMs = 0;
+        int consumed = 0;
+        if (std::sscanf(name.c_str(), "segment_%lld_open.writing%n", &startMs, &consumed) == 1 &&
+            static_cast<size_t>(consumed) == name.size()) {
+            orphans.emplace_back(it->path(), startMs);
+        } else if (it->path().extension() == ".idx") {
+            indexNames.push_back(name);
+        }
+    }
+
+    for (const auto& orphan : orphans) {
+        const std::string tempPath = orphan.first.string();
+        const int64_t startMs = orphan.second;
+        int64_t durationMs = -1;
+        AVFormatContext* in = nullptr;
+        if (avformat_open_input(&in, tempPath.c_str(), nullptr, nullptr) == 0) {
+            // The moov alone carries the duration; nothing needs decoding.
+            if (in->nb_streams > 0 && in->streams[0]->duration > 0) {
+                const AVStream* st = in->streams[0];
+                durationMs = av_rescale_q(st->duration, st->time_base, {1, 1000});
+            }
+            avformat_close_input(&in);
+        }
+        if (durationMs < 0) {
+            fs::remove(orphan.first, ec);
+            std::cerr << "[LocalRecorder] Dropped unfinished segment " << tempPath << std::endl;
+            continue;
+        }
+
+        // The index is saved before the rename, under the end time the
+        // recorder picked; reuse it so the sidecar still matches.
+        int64_t endMs = startMs + durationMs;
+        const std::string indexPrefix = "segment_" + std::to_string(startMs) + "_";
+        for (const std::string& name : indexNames) {
+            if (name.compare(0, indexPrefix.size(), indexPrefix) == 0) {
+                endMs = std::max<int64_t>(startMs, std::atoll(name.c_str() + indexPrefix.size()));
+                break;
+            }
+        }
+        const std::string finalPath = makeFinalPath(startMs, endMs);
+        fs::rename(orphan.first, finalPath, ec);
+        if (ec) {
+            std::cerr << "[LocalRecorder] recover segment failed: " << ec.message()
+                      << ", from=" << tempPath << std::endl;
+            ec.clear();
+            continue;
+        }
+        std::cout << "[LocalRecorder] Recovered unfinished segment " << finalPath << std::endl;
+        if (config_.generateThumbnails) {
+            generateThumbnail(finalPath);
+        }
+    }
+}
+
 void LocalRecorder::close() {
     if (formatCtx_) {
         const int64_t endMs = nowWallMs();
@@ -321,6 +691,9 @@ void LocalRecorder::close() {
     videoStreamIdx_ = -1;
     formatCtx_ = nullptr;
     currentTempPath_.clear();
+    dropPreRollFront(preRoll_.size());
+    eventUntilMs_ = 0;
+    retention_.stop();
 }
 
 std::string LocalRecorder::sanitizeStreamKey(const std::string& raw) const {
@@ -346,92 +719,15 @@ std::string LocalRecorder::makeFinalPath(int64_t startMs, int64_t endMs) const {
     return streamDir_ + "/segment_" + std::to_string(startMs) + "_" + std::to_string(endMs) + ".mp4";
 }
 
-std::vector<std::string> LocalRecorder::listSegmentsOldestFirst() const {
-    std::vector<std::pair<int64_t, std::string>> items;
-    std::regex pattern(R"(segment_(\d+)_([\d]+)\.mp4$)");
-
-    std::error_code ec;
-    if (!std::filesystem::exists(streamDir_, ec)) {
-        return {};
-    }
-
-    for (const auto& entry : std::filesystem::directory_iterator(streamDir_, ec)) {
-        if (ec || !entry.is_regular_file()) continue;
-        const std::string filename = entry.path().filename().string();
-        if (filename.size() < 4 || filename.substr(filename.size() - 4) != ".mp4") continue;
-
-        int64_t sortKey = 0;
-        std::smatch m;
-        if (std::regex_search(filename, m, pattern)) {
-            sortKey = std::atoll(m[1].str().c_str());
-        } else {
-            sortKey = static_cast<int64_t>(entry.last_write_time().time_since_epoch().count());
-        }
-        items.push_back({sortKey, entry.path().string()});
-    }
-
-    std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
-        return a.first < b.first;
-    });
-
-    std::vector<std::string> out;
-    out.reserve(items.size());
-    for (const auto& item : items) {
-        out.push_back(item.second);
-    }
-    return out;
-}
-
-void LocalRecorder::maybeCleanupOldSegments() {
-    if (streamDir_.empty()) return;
-    int minFreePercent = 15;
-    int targetFreePercent = 20;
-    std::string outputDir;
-    {
-        std::lock_guard<std::mutex> lock(policyMutex_);
-        minFreePercent = config_.minFreePercent;
-        targetFreePercent = config_.targetFreePercent;
-        outputDir = config_.outputDir;
-    }
-
-    auto getFreePct = [&]() -> double {
-        std::error_code ec;
-        auto space = std::filesystem::space(outputDir, ec);
-        if (ec || space.capacity == 0) return 100.0;
-        return static_cast<double>(space.available) * 100.0 / static_cast<double>(space.capacity);
-    };
-
-    double freePct = getFreePct();
-    if (freePct >= static_cast<double>(minFreePercent)) {
-        return;
-    }
-
-    auto files = listSegmentsOldestFirst();
-    size_t deleted = 0;
-    for (size_t i = 0; i < files.size() && files.size() - deleted > 1; i++) {
-        if (freePct >= static_cast<double>(targetFreePercent)) {
-            break;
-        }
-
-        const std::string& mp4Path = files[i];
-        std::error_code ec;
-        std::filesystem::remove(mp4Path, ec);
-        if (ec) {
-            continue;
-        }
-        deleted++;
-
-        std::string jpgPath = mp4Path;
-        const size_t pos = jpgPath.rfind(".mp4");
-        if (pos != std::string::npos) {
-            jpgPath.replace(pos, 4, ".jpg");
-            std::filesystem::remove(jpgPath, ec);
-        }
-
-        freePct = getFreePct();
-        std::cout << "[LocalRecorder] Deleted old segment due to low storage, free="
-                  << freePct << "%" << std::endl;
-    }
+RetentionEngine::Policy LocalRecorder::retentionPolicy() const {
+    std::lock_guard<std::mutex> lock(policyMutex_);
+    RetentionEngine::Policy policy;
+    policy.quotaBytes = static_cast<uint64_t>(config_.quotaMb) * 1024 * 1024;
+    policy.maxAgeHours = config_.maxAgeHours;
+    policy.eventMaxAgeHours = config_.eventMaxAgeHours;
+    policy.minFreePercent = config_.minFreePercent;
+    policy.targetFreePercent = config_.targetFreePercent;
+    return policy;
 }
 
 void LocalRecorder::generateThumbnail(const std::string& mp4Path) const {
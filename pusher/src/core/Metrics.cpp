@@ -0,0 +1,184 @@
+#include "core/Metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+namespace reallive {
+
+namespace {
+
+// Exported Prometheus buckets: powers of two from 64 us to ~33 s. They line
+// up with fine bucket boundaries, so the cumulative counts are exact.
+constexpr int kExportMinExp = 6;
+constexpr int kExportMaxExp = 25;
+
+std::string formatDouble(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    return buf;
+}
+
+} // namespace
+
+size_t Histogram::bucketIndex(uint64_t us) {
+    if (us < static_cast<uint64_t>(kSubBuckets)) return static_cast<size_t>(us);
+    const int exp = 63 - __builtin_clzll(us);
+    if (exp > kMaxExponent) return kBuckets - 1;
+    const size_t sub = static_cast<size_t>((us >> (exp - kSubBits)) & (kSubBuckets - 1));
+    return kSubBuckets + static_cast<size_t>(exp - kSubBits) * kSubBuckets + sub;
+}
+
+uint64_t Histogram::bucketUpperUs(size_t index) {
+    if (index < static_cast<size_t>(kSubBuckets)) return index + 1;
+    const size_t rel = index - kSubBuckets;
+    const int exp = static_cast<int>(rel / kSubBuckets) + kSubBits;
+    const uint64_t sub = rel % kSubBuckets;
+    return (static_cast<uint64_t>(kSubBuckets) + sub + 1) << (exp - kSubBits);
+}
+
+void Histogram::observe(int64_t us) {
+    const uint64_t v = us > 0 ? static_cast<uint64_t>(us) : 0;
+    // Shifted by one so each bucket is (lower, upper]: a sample equal to a
+    // Prometheus le bound counts into that bound, as le is inclusive.
+    counts_[bucketIndex(v > 0 ? v - 1 : 0)].fetch_add(1, std::memory_order_relaxed);
+    sumUs_.fetch_add(v, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot s;
+    for (size_t i = 0; i < kBuckets; i++) {
+        s.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        s.count += s.counts[i];
+    }
+    s.sumUs = sumUs_.load(std::memory_order_relaxed);
+    return s;
+}
+
+Histogram::Snapshot Histogram::Snapshot::since(const Snapshot& earlier) const {
+    Snapshot d;
+    for (size_t i = 0; i < kBuckets; i++) {
+        d.counts[i] = counts[i] >= earlier.counts[i] ? counts[i] - earlier.counts[i] : 0;
+        d.count += d.counts[i];
+    }
+    d.sumUs = sumUs >= earlier.sumUs ? sumUs - earlier.sumUs : 0;
+    return d;
+}
+
+double Histogram::Snapshot::meanUs() const {
+    return count > 0 ? static_cast<double>(sumUs) / static_cast<double>(count) : 0.0;
+}
+
+uint64_t Histogram::Snapshot::quantileUs(double q) const {
+    if (count == 0) return 0;
+    q = std::max(0.0, std::min(1.0, q));
+    const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        seen += counts[i];
+        if (seen >= rank) return bucketUpperUs(i);
+    }
+    return bucketUpperUs(kBuckets - 1);
+}
+
+const char* MetricsRegistry::typeName(Kind kind) {
+    switch (kind) {
+        case Kind::Counter:
+        case Kind::CounterFn: return "counter";
+        case Kind::Gauge:
+        case Kind::GaugeFn: return "gauge";
+        case Kind::Histogram: return "histogram";
+    }
+    return "untyped";
+}
+
+MetricsRegistry::Entry& MetricsRegistry::entry(const std::string& name, const std::string& help, Kind kind) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& e : entries_) {
+        if (e.name != name) continue;
+        if (e.kind != kind) {
+            std::cerr << "[Metrics] " << name << " re-registered with a different type" << std::endl;
+        }
+        return e;
+    }
+    entries_.emplace_back();
+    Entry& e = entries_.back();
+    e.name = name;
+    e.help = help;
+    e.kind = kind;
+    if (kind == Kind::Histogram) e.histogram = std::make_shared<Histogram>();
+    return e;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    return entry(name, help, Kind::Counter).counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    return entry(name, help, Kind::Gauge).gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help) {
+    return *sharedHistogram(name, help);
+}
+
+std::shared_ptr<Histogram> MetricsRegistry::sharedHistogram(const std::string& name, const std::string& help) {
+    Entry& e = entry(name, help, Kind::Histogram);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!e.histogram) e.histogram = std::make_shared<Histogram>();
+    return e.histogram;
+}
+
+void MetricsRegistry::counterFn(const std::string& name, const std::string& help, std::function<double()> fn) {
+    Entry& e = entry(name, help, Kind::CounterFn);
+    std::lock_guard<std::mutex> lock(mutex_);
+    e.fn = std::move(fn);
+}
+
+void MetricsRegistry::gaugeFn(const std::string& name, const std::string& help, std::function<double()> fn) {
+    Entry& e = entry(name, help, Kind::GaugeFn);
+    std::lock_guard<std::mutex> lock(mutex_);
+    e.fn = std::move(fn);
+}
+
+std::string MetricsRegistry::renderPrometheus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream oss;
+    for (const auto& e : entries_) {
+        oss << "# HELP " << e.name << " " << e.help << "\n"
+            << "# TYPE " << e.name << " " << typeName(e.kind) << "\n";
+        switch (e.kind) {
+            case Kind::Counter:
+                oss << e.name << " " << e.counter.value() << "\n";
+                break;
+            case Kind::Gauge:
+                oss << e.name << " " << formatDouble(e.gauge.value()) << "\n";
+                break;
+            case Kind::CounterFn:
+            case Kind::GaugeFn:
+                oss << e.name << " " << formatDouble(e.fn ? e.fn() : 0.0) << "\n";
+                break;
+            case Kind::Histogram: {
+                const Histogram::Snapshot s = e.histogram ? e.histogram->snapshot() : Histogram::Snapshot{};
+                uint64_t cumulative = 0;
+                size_t bucket = 0;
+                for (int exp = kExportMinExp; exp <= kExportMaxExp; exp++) {
+                    const uint64_t le = uint64_t{1} << exp;
+                    while (bucket < Histogram::kBuckets && Histogram::bucketUpperUs(bucket) <= le) {
+                        cumulative += s.counts[bucket++];
+                    }
+                    oss << e.name << "_bucket{le=\"" << formatDouble(static_cast<double>(le) / 1e6) << "\"} "
+                        << cumulative << "\n";
+                }
+                oss << e.name << "_bucket{le=\"+Inf\"} " << s.count << "\n"
+                    << e.name << "_sum " << formatDouble(static_cast<double>(s.sumUs) / 1e6) << "\n"
+                    << e.name << "_count " << s.count << "\n";
+                break;
+            }
+        }
+    }
+    return oss.str();
+}
+
+} // namespace reallive
@@ -0,0 +1,232 @@
+#include "core/MotionZones.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace reallive {
+
+namespace {
+
+// Packs 16 bytes of 0x00/0xFF into a 16-bit mask, bit i = byte i.
+inline uint32_t packMask16(const uint8_t* p) {
+#if defined(__aarch64__)
+    static const uint8_t kBitWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(vld1q_u8(p), vld1q_u8(kBitWeights));
+    return static_cast<uint32_t>(vaddv_u8(vget_low_u8(bits))) |
+           (static_cast<uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+#elif defined(__SSE2__)
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+#else
+    uint32_t m = 0;
+    for (int i = 0; i < 16; i++) {
+        if (p[i]) m |= (1u << i);
+    }
+    return m;
+#endif
+}
+
+inline int popcount64(uint64_t v) {
+    return __builtin_popcountll(v);
+}
+
+} // namespace
+
+void MotionZones::configure(const std::vector<MotionZoneConfig>& zones, int diffThreshold, double motionRatio) {
+    zones_ = zones;
+    diffThreshold_ = std::max(1, std::min(255, diffThreshold));
+    motionRatio_ = motionRatio;
+    gridW_ = 0;
+    gridH_ = 0;
+}
+
+void MotionZones::prepare(int gridW, int gridH) {
+    if (gridW <= 0 || gridH <= 0) return;
+    if (gridW == gridW_ && gridH == gridH_) return;
+    gridW_ = gridW;
+    gridH_ = gridH;
+    rasterize();
+}
+
+bool MotionZones::insidePolygon(const std::vector<std::pair<double, double>>& poly, double x, double y) {
+    bool inside = false;
+    for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+        const double xi = poly[i].first;
+        const double yi = poly[i].second;
+        const double xj = poly[j].first;
+        const double yj = poly[j].second;
+        if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+void MotionZones::rasterize() {
+    const size_t cells = static_cast<size_t>(gridW_) * static_cast<size_t>(gridH_);
+    wordsPerRow_ = (static_cast<size_t>(gridW_) + 63) / 64;
+    const size_t words = wordsPerRow_ * static_cast<size_t>(gridH_);
+
+    bool anyInclude = false;
+    for (const auto& zone : zones_) {
+        if (!zone.exclude) anyInclude = true;
+    }
+
+    // Without include zones the whole frame (minus exclusions) is one region
+    // judged by the global ratio.
+    thresholds_.assign(cells, static_cast<uint8_t>(diffThreshold_));
+    activeBytes_.assign(cells, anyInclude ? 0x00 : 0xFF);
+    activeMask_.assign(words, 0);
+    regions_.clear();
+    if (!anyInclude) {
+        Region whole;
+        whole.mask.assign(words, 0);
+        whole.motionRatio = motionRatio_;
+        regions_.push_back(std::move(whole));
+    }
+
+    std::vector<size_t> includeRegion(zones_.size(), 0);
+    for (size_t z = 0; z < zones_.size(); z++) {
+        if (zones_[z].exclude) continue;
+        Region region;
+        region.mask.assign(words, 0);
+        region.motionRatio = zones_[z].motionRatio > 0.0 ? zones_[z].motionRatio : motionRatio_;
+        includeRegion[z] = regions_.size();
+        regions_.push_back(std::move(region));
+    }
+
+    for (int y = 0; y < gridH_; y++) {
+        const double ny = (static_cast<double>(y) + 0.5) / static_cast<double>(gridH_);
+        for (int x = 0; x < gridW_; x++) {
+            const double nx = (static_cast<double>(x) + 0.5) / static_cast<double>(gridW_);
+            const size_t cell = static_cast<size_t>(y) * static_cast<size_t>(gridW_) + static_cast<size_t>(x);
+            bool excluded = false;
+            int includeZone = -1;
+            // Later zones take precedence, so a small exclude can punch a
+            // hole in a larger include.
+            for (size_t z = 0; z < zones_.size(); z++) {
+                if (!insidePolygon(zones_[z].points, nx, ny)) continue;
+                if (zones_[z].exclude) {
+                    excluded = true;
+                    includeZone = -1;
+                } else {
+                    excluded = false;
+                    includeZone = static_cast<int>(z);
+                }
+            }
+            if (excluded) {
+                activeBytes_[cell] = 0x00;
+                continue;
+            }
+            if (anyInclude && includeZone < 0) continue;
+
+            activeBytes_[cell] = 0xFF;
+            const size_t word = static_cast<size_t>(y) * wordsPerRow_ + static_cast<size_t>(x) / 64;
+            const uint64_t bit = uint64_t{1} << (x % 64);
+            activeMask_[word] |= bit;
+            Region& region = anyInclude ? regions_[includeRegion[static_cast<size_t>(includeZone)]] : regions_[0];
+            region.mask[word] |= bit;
+            region.cellCount++;
+            if (includeZone >= 0 && zones_[static_cast<size_t>(includeZone)].diffThreshold > 0) {
+                thresholds_[cell] = static_cast<uint8_t>(zones_[static_cast<size_t>(includeZone)].diffThreshold);
+            }
+        }
+    }
+    changedBits_.assign(words, 0);
+
+    if (!zones_.empty()) {
+        int active = 0;
+        for (uint64_t w : activeMask_) active += popcount64(w);
+        std::cout << "[MotionZones] " << zones_.size() << " zone(s) rasterized to "
+                  << gridW_ << "x" << gridH_ << ", active cells " << active
+                  << "/" << cells << std::endl;
+    }
+}
+
+void MotionZones::thresholdDiff(const uint8_t* cur, const uint8_t* prev, uint8_t* out) const {
+    const size_t cells = thresholds_.size();
+    const uint8_t* thr = thresholds_.data();
+    const uint8_t* active = activeBytes_.data();
+    size_t i = 0;
+#if defined(__aarch64__)
+    for (; i + 16 <= cells; i += 16) {
+        const uint8x16_t diff = vabdq_u8(vld1q_u8(cur + i), vld1q_u8(prev + i));
+        const uint8x16_t hit = vcgtq_u8(diff, vld1q_u8(thr + i));
+        vst1q_u8(out + i, vandq_u8(hit, vld1q_u8(active + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= cells; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+        const __m128i diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+        const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(thr + i));
+        // diff > t exactly where the saturating diff - t is non-zero.
+        const __m128i miss = _mm_cmpeq_epi8(_mm_subs_epu8(diff, t), _mm_setzero_si128());
+        const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(active + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_andnot_si128(miss, mask));
+    }
+#endif
+    for (; i < cells; i++) {
+        const int diff = std::abs(static_cast<int>(cur[i]) - static_cast<int>(prev[i]));
+        out[i] = (diff > thr[i]) ? active[i] : 0;
+    }
+}
+
+MotionZones::Result MotionZones::score(const uint8_t* cells) {
+    Result result;
+    if (gridW_ <= 0 || gridH_ <= 0 || !cells) return result;
+
+    result.minX = gridW_;
+    result.minY = gridH_;
+    for (int y = 0; y < gridH_; y++) {
+        const uint8_t* row = cells + static_cast<size_t>(y) * static_cast<size_t>(gridW_);
+        uint64_t* bits = changedBits_.data() + static_cast<size_t>(y) * wordsPerRow_;
+        const uint64_t* active = activeMask_.data() + static_cast<size_t>(y) * wordsPerRow_;
+        for (size_t w = 0; w < wordsPerRow_; w++) {
+            const int x0 = static_cast<int>(w * 64);
+            const int n = std::min(64, gridW_ - x0);
+            uint64_t word = 0;
+            int x = 0;
+            for (; x + 16 <= n; x += 16) {
+                word |= static_cast<uint64_t>(packMask16(row + x0 + x)) << x;
+            }
+            for (; x < n; x++) {
+                if (row[x0 + x]) word |= uint64_t{1} << x;
+            }
+            word &= active[w];
+            bits[w] = word;
+            if (!word) continue;
+
+            result.changedCells += popcount64(word);
+            result.minY = std::min(result.minY, y);
+            result.maxY = y;
+            result.minX = std::min(result.minX, x0 + __builtin_ctzll(word));
+            result.maxX = std::max(result.maxX, x0 + 63 - __builtin_clzll(word));
+        }
+    }
+    if (result.changedCells == 0) {
+        result.minX = 0;
+        result.minY = 0;
+        return result;
+    }
+
+    for (const Region& region : regions_) {
+        if (region.cellCount <= 0) continue;
+        int changed = 0;
+        for (size_t w = 0; w < changedBits_.size(); w++) {
+            changed += popcount64(changedBits_[w] & region.mask[w]);
+        }
+        const double ratio = static_cast<double>(changed) / static_cast<double>(region.cellCount);
+        result.ratio = std::max(result.ratio, ratio);
+        if (ratio >= region.motionRatio) result.triggered = true;
+    }
+    return result;
+}
+
+} // namespace reallive
@@ -1,15 +1,18 @@
 #include "core/MqttRuntimeClient.h"
 #include "core/Pipeline.h"
+#include "core/PipelineHost.h"
+#include "core/SystemSampler.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cctype>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
-#include <filesystem>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 
 #ifdef REALLIVE_HAS_MQTT
@@ -35,8 +38,26 @@ std::string formatNumber(double value, int precision = 1) {
 
 } // namespace
 
-MqttRuntimeClient::MqttRuntimeClient(const PusherConfig& config, Pipeline* pipeline)
-    : config_(config), pipeline_(pipeline) {
+MqttRuntimeClient::MqttRuntimeClient(const PusherConfig& config, PipelineHost* host)
+    : config_(config) {
+    if (!host) return;
+    std::string prefix = trim(config_.mqtt.topicPrefix);
+    if (prefix.empty()) prefix = "reallive/device";
+    while (!prefix.empty() && prefix.back() == '/') {
+        prefix.pop_back();
+    }
+    // One session for the process; each camera gets its own topics. Fixed
+    // from here on, so detect threads can look routes up without a lock.
+    for (const PipelineHost::Camera& cam : host->cameras()) {
+        const std::string streamKey = sanitizeToken(cam.streamKey);
+        Route route;
+        route.streamKey = cam.streamKey;
+        route.pipeline = cam.pipeline.get();
+        route.commandTopic = prefix + "/" + streamKey + "/command";
+        route.stateTopic = prefix + "/" + streamKey + "/state";
+        route.eventTopic = prefix + "/" + streamKey + "/event";
+        routes_.push_back(std::move(route));
+    }
 }
 
 MqttRuntimeClient::~MqttRuntimeClient() {
@@ -51,28 +72,20 @@ bool MqttRuntimeClient::start() {
     std::cerr << "[MQTT] Enabled in config, but libmosquitto not linked at build time" << std::endl;
     return false;
 #else
-    if (!pipeline_) {
+    if (routes_.empty()) {
         std::cerr << "[MQTT] Pipeline unavailable" << std::endl;
         return false;
     }
-
-    const std::string streamKey = sanitizeToken(config_.stream.streamKey);
-    if (streamKey.empty()) {
-        std::cerr << "[MQTT] stream_key is required for MQTT runtime control" << std::endl;
-        return false;
-    }
-
-    std::string prefix = trim(config_.mqtt.topicPrefix);
-    if (prefix.empty()) prefix = "reallive/device";
-    while (!prefix.empty() && prefix.back() == '/') {
-        prefix.pop_back();
+    for (const Route& route : routes_) {
+        if (sanitizeToken(route.streamKey).empty()) {
+            std::cerr << "[MQTT] stream_key is required for MQTT runtime control" << std::endl;
+            return false;
+        }
     }
-    commandTopic_ = prefix + "/" + streamKey + "/command";
-    stateTopic_ = prefix + "/" + streamKey + "/state";
 
     clientId_ = trim(config_.mqtt.clientId);
     if (clientId_.empty()) {
-        clientId_ = "reallive-pusher-" + streamKey;
+        clientId_ = "reallive-pusher-" + sanitizeToken(routes_.front().streamKey);
     }
 
     mosquitto_lib_init();
@@ -126,8 +139,11 @@ bool MqttRuntimeClient::start() {
     }
 
     running_ = true;
+    SystemSampler::instance().start();
     stateThread_ = std::thread(&MqttRuntimeClient::stateLoop, this);
-    std::cout << "[MQTT] Runtime control started, command_topic=" << commandTopic_ << std::endl;
+    std::cout << "[MQTT] Runtime control started, command_topic=" << routes_.front().commandTopic;
+    if (routes_.size() > 1) std::cout << " (+" << routes_.size() - 1 << " camera(s))";
+    std::cout << std::endl;
     return true;
 #endif
 }
@@ -135,6 +151,7 @@ bool MqttRuntimeClient::start() {
 void MqttRuntimeClient::stop() {
     if (!running_) return;
     running_ = false;
+    wakeEventPublisher();
 
 #ifdef REALLIVE_HAS_MQTT
     if (stateThread_.joinable()) {
@@ -150,6 +167,7 @@ void MqttRuntimeClient::stop() {
     }
     connected_ = false;
     mosquitto_lib_cleanup();
+    SystemSampler::instance().stop();
 #endif
 }
 
@@ -226,41 +244,167 @@ std::string MqttRuntimeClient::jsonValue(const std::string& body, const std::str
     return trim(body.substr(p, e - p));
 }
 
-void MqttRuntimeClient::publishState(const char* reason, int64_t commandSeq) {
+MqttRuntimeClient::Route* MqttRuntimeClient::findRoute(const std::string& streamKey) {
+    for (Route& route : routes_) {
+        if (route.streamKey == streamKey) return &route;
+    }
+    return nullptr;
+}
+
+void MqttRuntimeClient::publishDetectionEvent(const std::string& streamKey, const DetectionEvent& event) {
+    if (!config_.mqtt.enabled) return;
+    const Route* route = findRoute(streamKey);
+    if (!route) return;
+
+    std::ostringstream oss;
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        oss << "{"
+            << "\"v\":1,"
+            << "\"type\":\"person_detected\","
+            << "\"stream_key\":\"" << route->streamKey << "\","
+            << "\"seq\":" << ++eventSeq_ << ","
+            << "\"ts\":" << event.tsMs << ","
+            << "\"sent_ts\":" << nowMs() << ","
+            << "\"score\":" << formatNumber(event.score, 3) << ","
+            << "\"track_id\":" << event.trackId << ","
+            << "\"bbox\":{"
+                << "\"x\":" << event.x << ","
+                << "\"y\":" << event.y << ","
+                << "\"w\":" << event.w << ","
+                << "\"h\":" << event.h
+            << "}"
+            << "}";
+        if (eventQueue_.size() >= static_cast<size_t>(config_.mqtt.eventQueueMax)) {
+            eventQueue_.pop_front();
+            if (eventsDropped_++ % 50 == 0) {
+                std::cerr << "[MQTT] Event queue full, dropped " << eventsDropped_ << " event(s)" << std::endl;
+            }
+        }
+        eventQueue_.push_back(QueuedEvent{route->eventTopic, oss.str()});
+        eventWake_ = true;
+    }
+    eventCv_.notify_one();
+}
+
+void MqttRuntimeClient::wakeEventPublisher() {
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        eventWake_ = true;
+    }
+    eventCv_.notify_one();
+}
+
+// State thread only. The queue is taken out first so publishDetectionEvent
+// never waits behind mosquitto_publish.
+void MqttRuntimeClient::flushEventQueue() {
 #ifdef REALLIVE_HAS_MQTT
-    std::lock_guard<std::mutex> lock(mqttMutex_);
-    if (!mosq_) return;
-    int minFreePercent = 0;
-    if (pipeline_) {
+    std::deque<QueuedEvent> pending;
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        pending.swap(eventQueue_);
+    }
+    while (!pending.empty()) {
+        const std::string& topic = pending.front().topic;
+        const std::string& payload = pending.front().payload;
+        int rc = MOSQ_ERR_NO_CONN;
+        {
+            std::lock_guard<std::mutex> mqttLock(mqttMutex_);
+            if (mosq_) {
+                rc = mosquitto_publish(
+                    mosq_,
+                    nullptr,
+                    topic.c_str(),
+                    static_cast<int>(payload.size()),
+                    payload.data(),
+                    config_.mqtt.eventQos,
+                    false
+                );
+            }
+        }
+        if (rc != MOSQ_ERR_SUCCESS) break;
+        pending.pop_front();
+    }
+    if (pending.empty()) return;
+
+    // Keep the rest queued ahead of anything newer; the state loop and the
+    // next connect retry.
+    std::lock_guard<std::mutex> lock(eventMutex_);
+    pending.insert(pending.end(), std::make_move_iterator(eventQueue_.begin()),
+                   std::make_move_iterator(eventQueue_.end()));
+    while (pending.size() > static_cast<size_t>(config_.mqtt.eventQueueMax)) {
+        pending.pop_front();
+        eventsDropped_++;
+    }
+    eventQueue_.swap(pending);
+#endif
+}
+
+MqttRuntimeClient::RuntimeState MqttRuntimeClient::collectState(const Route& route) const {
+    RuntimeState state;
+    if (route.pipeline) {
         int ignoredTarget = 0;
-        pipeline_->getRecordCleanupPolicy(minFreePercent, ignoredTarget);
-    }
-    double storagePct = 0.0;
-    double storageUsedGb = 0.0;
-    double storageTotalGb = 0.0;
-    try {
-        const auto space = std::filesystem::space("/");
-        if (space.capacity > 0) {
-            const uint64_t used = space.capacity > space.available ? (space.capacity - space.available) : 0;
-            storageTotalGb = static_cast<double>(space.capacity) / (1024.0 * 1024.0 * 1024.0);
-            storageUsedGb = static_cast<double>(used) / (1024.0 * 1024.0 * 1024.0);
-            storagePct = std::max(0.0, std::min(100.0, static_cast<double>(used) * 100.0 / static_cast<double>(space.capacity)));
+        route.pipeline->getRecordCleanupPolicy(state.minFreePercent, ignoredTarget);
+        state.running = route.pipeline->isRunning();
+        state.desiredLive = route.pipeline->isLivePushEnabled();
+        state.activeLive = route.pipeline->isLivePushActive();
+        state.push = route.pipeline->getPushStats();
+    }
+    const SystemTelemetry telemetry = SystemSampler::instance().latest();
+    state.storagePct = telemetry.storagePct;
+    state.storageUsedGb = telemetry.storageUsedGb;
+    state.storageTotalGb = telemetry.storageTotalGb;
+    return state;
+}
+
+bool MqttRuntimeClient::sameState(const RuntimeState& a, const RuntimeState& b) {
+    // Storage creeps up while recording; whole percents are enough to count
+    // as a change, the exact figures ride along with every publish anyway.
+    // Push outputs count as changed when one comes, goes or (dis)connects.
+    if (a.push.size() != b.push.size()) return false;
+    for (size_t i = 0; i < a.push.size(); i++) {
+        if (a.push[i].name != b.push[i].name || a.push[i].enabled != b.push[i].enabled ||
+            a.push[i].connected != b.push[i].connected) {
+            return false;
         }
-    } catch (...) {
     }
+    return a.running == b.running &&
+           a.desiredLive == b.desiredLive &&
+           a.activeLive == b.activeLive &&
+           a.minFreePercent == b.minFreePercent &&
+           std::lround(a.storagePct) == std::lround(b.storagePct);
+}
+
+void MqttRuntimeClient::publishState(Route& route, const char* reason, int64_t commandSeq) {
+#ifdef REALLIVE_HAS_MQTT
+    const RuntimeState state = collectState(route);
+    const int64_t now = nowMs();
 
     std::ostringstream oss;
     oss << "{"
         << "\"v\":1,"
-        << "\"ts\":" << nowMs() << ","
-        << "\"stream_key\":\"" << config_.stream.streamKey << "\","
-        << "\"running\":" << (pipeline_ && pipeline_->isRunning() ? "true" : "false") << ","
-        << "\"desired_live\":" << (pipeline_ && pipeline_->isLivePushEnabled() ? "true" : "false") << ","
-        << "\"active_live\":" << (pipeline_ && pipeline_->isLivePushActive() ? "true" : "false") << ","
-        << "\"record_min_free_percent\":" << minFreePercent << ","
-        << "\"storage_pct\":" << formatNumber(storagePct) << ","
-        << "\"storage_used_gb\":" << formatNumber(storageUsedGb, 2) << ","
-        << "\"storage_total_gb\":" << formatNumber(storageTotalGb, 2);
+        << "\"ts\":" << now << ","
+        << "\"stream_key\":\"" << route.streamKey << "\","
+        << "\"running\":" << (state.running ? "true" : "false") << ","
+        << "\"desired_live\":" << (state.desiredLive ? "true" : "false") << ","
+        << "\"active_live\":" << (state.activeLive ? "true" : "false") << ","
+        << "\"record_min_free_percent\":" << state.minFreePercent << ","
+        << "\"storage_pct\":" << formatNumber(state.storagePct) << ","
+        << "\"storage_used_gb\":" << formatNumber(state.storageUsedGb, 2) << ","
+        << "\"storage_total_gb\":" << formatNumber(state.storageTotalGb, 2) << ","
+        << "\"push\":[";
+    for (size_t i = 0; i < state.push.size(); i++) {
+        const PushOutput::Stats& out = state.push[i];
+        oss << (i ? "," : "") << "{"
+            << "\"name\":\"" << out.name << "\","
+            << "\"enabled\":" << (out.enabled ? "true" : "false") << ","
+            << "\"connected\":" << (out.connected ? "true" : "false") << ","
+            << "\"sent\":" << out.packetsSent << ","
+            << "\"dropped\":" << out.dropped << ","
+            << "\"errors\":" << out.errors << ","
+            << "\"reconnects\":" << out.reconnects << "}";
+    }
+    oss << "]";
     if (reason && std::strlen(reason) > 0) {
         oss << ",\"reason\":\"" << reason << "\"";
     }
@@ -270,25 +414,69 @@ void MqttRuntimeClient::publishState(const char* reason, int64_t commandSeq) {
     oss << "}";
 
     const std::string payload = oss.str();
-    mosquitto_publish(
-        mosq_,
-        nullptr,
-        stateTopic_.c_str(),
-        static_cast<int>(payload.size()),
-        payload.data(),
-        config_.mqtt.stateQos,
-        true
-    );
+    int rc = MOSQ_ERR_NO_CONN;
+    {
+        std::lock_guard<std::mutex> lock(mqttMutex_);
+        if (!mosq_) return;
+        rc = mosquitto_publish(
+            mosq_,
+            nullptr,
+            route.stateTopic.c_str(),
+            static_cast<int>(payload.size()),
+            payload.data(),
+            config_.mqtt.stateQos,
+            true
+        );
+    }
+    if (rc == MOSQ_ERR_SUCCESS) {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        route.lastState = state;
+        route.lastStatePublishMs = now;
+        route.statePublished = true;
+    }
 #else
+    (void)route;
     (void)reason;
     (void)commandSeq;
 #endif
 }
 
 void MqttRuntimeClient::stateLoop() {
+    // Polling every stateIntervalMs doubles as the coalescing window: any
+    // number of transitions inside it go out as one "changed" message. With
+    // nothing changing, a heartbeat keeps the retained state fresh for the
+    // server's staleness check. Detection events are published here too, as
+    // soon as publishDetectionEvent() or a reconnect wakes the loop.
+    const auto interval = std::chrono::milliseconds(config_.mqtt.stateIntervalMs);
+    auto nextStateAt = std::chrono::steady_clock::now() + interval;
     while (running_) {
-        publishState("heartbeat");
-        std::this_thread::sleep_for(std::chrono::milliseconds(config_.mqtt.stateIntervalMs));
+        {
+            std::unique_lock<std::mutex> lock(eventMutex_);
+            eventCv_.wait_until(lock, nextStateAt, [this]() { return !running_ || eventWake_; });
+            eventWake_ = false;
+        }
+        if (!running_) break;
+        if (connected_) flushEventQueue();
+        if (std::chrono::steady_clock::now() < nextStateAt) continue;
+        nextStateAt = std::chrono::steady_clock::now() + interval;
+        if (!connected_) continue;
+
+        for (Route& route : routes_) {
+            const RuntimeState state = collectState(route);
+            const int64_t now = nowMs();
+            bool changed = false;
+            bool heartbeatDue = false;
+            {
+                std::lock_guard<std::mutex> lock(stateMutex_);
+                changed = !route.statePublished || !sameState(state, route.lastState);
+                heartbeatDue = now - route.lastStatePublishMs >= config_.mqtt.stateHeartbeatMs;
+            }
+            if (changed) {
+                publishState(route, "changed");
+            } else if (heartbeatDue) {
+                publishState(route, "heartbeat");
+            }
+        }
     }
 }
 
@@ -303,11 +491,18 @@ void MqttRuntimeClient::onConnect(int rc) {
     {
         std::lock_guard<std::mutex> lock(mqttMutex_);
         if (mosq_) {
-            mosquitto_subscribe(mosq_, nullptr, commandTopic_.c_str(), config_.mqtt.commandQos);
+            for (const Route& route : routes_) {
+                mosquitto_subscribe(mosq_, nullptr, route.commandTopic.c_str(), config_.mqtt.commandQos);
+            }
         }
     }
-    std::cout << "[MQTT] Connected, subscribed to " << commandTopic_ << std::endl;
-    publishState("connected");
+    std::cout << "[MQTT] Connected, subscribed to " << routes_.front().commandTopic;
+    if (routes_.size() > 1) std::cout << " and " << routes_.size() - 1 << " more";
+    std::cout << std::endl;
+    for (Route& route : routes_) {
+        publishState(route, "connected");
+    }
+    wakeEventPublisher();
 #else
     (void)rc;
 #endif
@@ -319,10 +514,14 @@ void MqttRuntimeClient::onDisconnect(int rc) {
 }
 
 void MqttRuntimeClient::onMessage(const std::string& topic, const std::string& payload) {
-    if (topic != commandTopic_ || !pipeline_) return;
+    auto routeIt = std::find_if(routes_.begin(), routes_.end(),
+                                [&topic](const Route& r) { return r.commandTopic == topic; });
+    if (routeIt == routes_.end() || !routeIt->pipeline) return;
+    Route& route = *routeIt;
+    Pipeline* pipeline = route.pipeline;
 
     const std::string streamKey = jsonValue(payload, "stream_key");
-    if (!streamKey.empty() && streamKey != config_.stream.streamKey) {
+    if (!streamKey.empty() && streamKey != route.streamKey) {
         return;
     }
 
@@ -340,42 +539,76 @@ void MqttRuntimeClient::onMessage(const std::string& topic, const std::string& p
         }
     }
     if (seq >= 0) {
-        const int64_t prev = commandSeq_.load();
-        if (seq <= prev) {
-            publishState("ignored-old-seq", seq);
+        if (seq <= route.commandSeq) {
+            publishState(route, "ignored-old-seq", seq);
             return;
         }
-        commandSeq_ = seq;
+        route.commandSeq = seq;
     }
 
     if (type == "record_policy" || type == "record") {
         std::string minRaw = jsonValue(payload, "min_free_percent");
         if (minRaw.empty()) minRaw = jsonValue(payload, "record_min_free_percent");
         if (minRaw.empty()) {
-            publishState("invalid-record-policy", seq);
+            publishState(route, "invalid-record-policy", seq);
             return;
         }
         const int minFreePercent = std::max(1, std::atoi(minRaw.c_str()));
         int currentMin = 15;
         int currentTarget = 20;
-        pipeline_->getRecordCleanupPolicy(currentMin, currentTarget);
+        pipeline->getRecordCleanupPolicy(currentMin, currentTarget);
         const int targetFreePercent = std::max(minFreePercent + 1, std::max(currentTarget, minFreePercent + 5));
-        const bool ok = pipeline_->setRecordCleanupPolicy(minFreePercent, targetFreePercent);
+        const bool ok = pipeline->setRecordCleanupPolicy(minFreePercent, targetFreePercent);
         if (ok) {
             std::cout << "[MQTT] Record policy applied: min_free=" << minFreePercent
                       << "% target_free=" << targetFreePercent
                       << (seq >= 0 ? (", seq=" + std::to_string(seq)) : "") << std::endl;
-            publishState("record-policy-applied", seq);
+            publishState(route, "record-policy-applied", seq);
             return;
         }
         std::cerr << "[MQTT] Failed to apply record policy: min_free=" << minFreePercent
                   << " target_free=" << targetFreePercent << std::endl;
-        publishState("record-policy-failed", seq);
+        publishState(route, "record-policy-failed", seq);
+        return;
+    }
+
+    if (type == "push_add") {
+        // The url carries the destination's stream key: a "stream_key" field
+        // already addresses this device.
+        PushDestinationConfig dest;
+        dest.name = trim(jsonValue(payload, "name"));
+        dest.url = trim(jsonValue(payload, "url"));
+        const std::string policy = lower(trim(jsonValue(payload, "drop_policy")));
+        if (!policy.empty()) dest.dropPolicy = policy;
+        const std::string queueMax = jsonValue(payload, "queue_max");
+        if (!queueMax.empty()) dest.queueMax = std::max(1, std::min(256, std::atoi(queueMax.c_str())));
+        std::string error;
+        if (pipeline->addPushDestination(dest, error)) {
+            std::cout << "[MQTT] Push destination added: " << dest.name
+                      << (seq >= 0 ? (", seq=" + std::to_string(seq)) : "") << std::endl;
+            publishState(route, "push-added", seq);
+            return;
+        }
+        std::cerr << "[MQTT] Failed to add push destination '" << dest.name << "': " << error << std::endl;
+        publishState(route, "push-add-failed", seq);
+        return;
+    }
+
+    if (type == "push_remove") {
+        const std::string name = trim(jsonValue(payload, "name"));
+        if (pipeline->removePushDestination(name)) {
+            std::cout << "[MQTT] Push destination removed: " << name
+                      << (seq >= 0 ? (", seq=" + std::to_string(seq)) : "") << std::endl;
+            publishState(route, "push-removed", seq);
+            return;
+        }
+        std::cerr << "[MQTT] No push destination named '" << name << "'" << std::endl;
+        publishState(route, "push-remove-failed", seq);
         return;
     }
 
     if (type == "storage_query" || type == "state_query" || type == "report_state") {
-        publishState("storage-query", seq);
+        publishState(route, "storage-query", seq);
         return;
     }
 
@@ -385,16 +618,16 @@ void MqttRuntimeClient::onMessage(const std::string& topic, const std::string& p
     const std::string enableNorm = lower(trim(enableRaw));
     const bool enable = (enableNorm == "1" || enableNorm == "true" ||
                          enableNorm == "on" || enableNorm == "yes");
-    const bool ok = pipeline_->setLivePushEnabled(enable);
+    const bool ok = pipeline->setLivePushEnabled(enable);
     if (ok) {
         std::cout << "[MQTT] Live push command applied: " << (enable ? "on" : "off")
                   << (seq >= 0 ? (", seq=" + std::to_string(seq)) : "") << std::endl;
-        publishState("applied", seq);
+        publishState(route, "applied", seq);
         return;
     }
 
     std::cerr << "[MQTT] Failed to apply live command: " << (enable ? "on" : "off") << std::endl;
-    publishState("apply-failed", seq);
+    publishState(route, "apply-failed", seq);
 }
 
 void MqttRuntimeClient::handleConnect(::mosquitto* mosq, void* obj, int rc) {
@@ -0,0 +1,709 @@
+#include "core/OverlayCompositor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace reallive {
+
+namespace {
+
+constexpr int kGlyphW = 8;
+constexpr int kGlyphH = 16;
+constexpr int kFirstGlyph = 0x20;
+constexpr int kGlyphCount = 0x7F - kFirstGlyph;
+
+constexpr uint8_t kTextY = 235;   // white (video range)
+constexpr uint8_t kRectY = 96;
+constexpr uint8_t kRectU = 84;
+constexpr uint8_t kRectV = 255;
+constexpr uint8_t kChromaDarkBias = 96;  // (uv >> 2) + 96 == (uv + 3 * 128) / 4
+
+// 8x16 bitmap font for printable ASCII (0x20-0x7E).
+// Standard VGA/CP437 ROM font glyphs (public domain)
+constexpr uint8_t FONT[kGlyphCount][kGlyphH] = {
+    // 0x20 ' '
+    {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x21 '!'
+    {0x00,0x00,0x18,0x3C,0x3C,0x3C,0x18,0x18,
+     0x18,0x00,0x18,0x18,0x00,0x00,0x00,0x00},
+    // 0x22 '"'
+    {0x00,0x66,0x66,0x66,0x24,0x00,0x00,0x00,
+     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x23 '#'
+    {0x00,0x00,0x00,0x6C,0x6C,0xFE,0x6C,0x6C,
+     0x6C,0xFE,0x6C,0x6C,0x00,0x00,0x00,0x00},
+    // 0x24 '$'
+    {0x18,0x18,0x7C,0xC6,0xC2,0xC0,0x7C,0x06,
+     0x06,0x86,0xC6,0x7C,0x18,0x18,0x00,0x00},
+    // 0x25 '%'
+    {0x00,0x00,0x00,0x00,0xC2,0xC6,0x0C,0x18,
+     0x30,0x60,0xC6,0x86,0x00,0x00,0x00,0x00},
+    // 0x26 '&'
+    {0x00,0x00,0x38,0x6C,0x6C,0x38,0x76,0xDC,
+     0xCC,0xCC,0xCC,0x76,0x00,0x00,0x00,0x00},
+    // 0x27 "'"
+    {0x00,0x30,0x30,0x30,0x60,0x00,0x00,0x00,
+     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x28 '('
+    {0x00,0x00,0x0C,0x18,0x30,0x30,0x30,0x30,
+     0x30,0x30,0x18,0x0C,0x00,0x00,0x00,0x00},
+    // 0x29 ')'
+    {0x00,0x00,0x30,0x18,0x0C,0x0C,0x0C,0x0C,
+     0x0C,0x0C,0x18,0x30,0x00,0x00,0x00,0x00},
+    // 0x2A '*'
+    {0x00,0x00,0x00,0x00,0x00,0x66,0x3C,0xFF,
+     0x3C,0x66,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x2B '+'
+    {0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x7E,
+     0x18,0x18,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x2C ','
+    {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+     0x00,0x18,0x18,0x18,0x30,0x00,0x00,0x00},
+    // 0x2D '-'
+    {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x7E,
+     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x2E '.'
+    {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+     0x00,0x00,0x18,0x18,0x00,0x00,0x00,0x00},
+    // 0x2F '/'
+    {0x00,0x00,0x00,0x00,0x02,0x06,0x0C,0x18,
+     0x30,0x60,0xC0,0x80,0x00,0x00,0x00,0x00},
+    // 0x30 '0'
+    {0x00,0x00,0x7C,0xC6,0xCE,0xDE,0xF6,0xE6,
+     0xC6,0xC6,0x7C,0x00,0x00,0x00,0x00,0x00},
+    // 0x31 '1'
+    {0x00,0x00,0x18,0x38,0x78,0x18,0x18,0x18,
+     0x18,0x18,0x7E,0x00,0x00,0x00,0x00,0x00},
+    // 0x32 '2'
+    {0x00,0x00,0x7C,0xC6,0x06,0x0C,0x18,0x30,
+     0x60,0xC6,0xFE,0x00,0x00,0x00,0x00,0x00},
+    // 0x33 '3'
+    {0x00,0x00,0x7C,0xC6,0x06,0x06,0x3C,0x06,
+     0x06,0xC6,0x7C,0x00,0x00,0x00,0x00,0x00},
+    // 0x34 '4'
+    {0x00,0x00,0x0C,0x1C,0x3C,0x6C,0xCC,0xFE,
+     0x0C,0x0C,0x1E,0x00,0x00,0x00,0x00,0x00},
+    // 0x35 '5'
+    {0x00,0x00,0xFE,0xC0,0xC0,0xFC,0x06,0x06,
+     0x06,0xC6,0x7C,0x00,0x00,0x00,0x00,0x00},
+    // 0x36 '6'
+    {0x00,0x00,0x38,0x60,0xC0,0xFC,0xC6,0xC6,
+     0xC6,0xC6,0x7C,0x00,0x00,0x00,0x00,0x00},
+    // 0x37 '7'
+    {0x00,0x00,0xFE,0xC6,0x06,0x0C,0x18,0x30,
+     0x30,0x30,0x30,0x00,0x00,0x00,0x00,0x00},
+    // 0x38 '8'
+    {0x00,0x00,0x7C,0xC6,0xC6,0xC6,0x7C,0xC6,
+     0xC6,0xC6,0x7C,0x00,0x00,0x00,0x00,0x00},
+    // 0x39 '9'
+    {0x00,0x00,0x7C,0xC6,0xC6,0xC6,0x7E,0x06,
+     0x06,0x0C,0x78,0x00,0x00,0x00,0x00,0x00},
+    // 0x3A ':'
+    {0x00,0x00,0x00,0x00,0x18,0x18,0x00,0x00,
+     0x18,0x18,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x3B ';'
+    {0x00,0x00,0x00,0x00,0x18,0x18,0x00,0x00,
+     0x00,0x18,0x18,0x30,0x00,0x00,0x00,0x00},
+    // 0x3C '<'
+    {0x00,0x00,0x00,0x06,0x0C,0x18,0x30,0x60,
+     0x30,0x18,0x0C,0x06,0x00,0x00,0x00,0x00},
+    // 0x3D '='
+    {0x00,0x00,0x00,0x00,0x00,0x7E,0x00,0x00,
+     0x7E,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x3E '>'
+    {0x00,0x00,0x00,0x60,0x30,0x18,0x0C,0x06,
+     0x0C,0x18,0x30,0x60,0x00,0x00,0x00,0x00},
+    // 0x3F '?'
+    {0x00,0x00,0x7C,0xC6,0xC6,0x0C,0x18,0x18,
+     0x18,0x00,0x18,0x18,0x00,0x00,0x00,0x00},
+    // 0x40 '@'
+    {0x00,0x00,0x00,0x7C,0xC6,0xC6,0xDE,0xDE,
+     0xDE,0xDC,0xC0,0x7C,0x00,0x00,0x00,0x00},
+    // 0x41 'A'
+    {0x00,0x00,0x10,0x38,0x6C,0xC6,0xC6,0xFE,
+     0xC6,0xC6,0xC6,0xC6,0x00,0x00,0x00,0x00},
+    // 0x42 'B'
+    {0x00,0x00,0xFC,0x66,0x66,0x66,0x7C,0x66,
+     0x66,0x66,0x66,0xFC,0x00,0x00,0x00,0x00},
+    // 0x43 'C'
+    {0x00,0x00,0x3C,0x66,0xC2,0xC0,0xC0,0xC0,
+     0xC0,0xC2,0x66,0x3C,0x00,0x00,0x00,0x00},
+    // 0x44 'D'
+    {0x00,0x00,0xF8,0x6C,0x66,0x66,0x66,0x66,
+     0x66,0x66,0x6C,0xF8,0x00,0x00,0x00,0x00},
+    // 0x45 'E'
+    {0x00,0x00,0xFE,0x66,0x62,0x68,0x78,0x68,
+     0x60,0x62,0x66,0xFE,0x00,0x00,0x00,0x00},
+    // 0x46 'F'
+    {0x00,0x00,0xFE,0x66,0x62,0x68,0x78,0x68,
+     0x60,0x60,0x60,0xF0,0x00,0x00,0x00,0x00},
+    // 0x47 'G'
+    {0x00,0x00,0x3C,0x66,0xC2,0xC0,0xC0,0xDE,
+     0xC6,0xC6,0x66,0x3A,0x00,0x00,0x00,0x00},
+    // 0x48 'H'
+    {0x00,0x00,0xC6,0xC6,0xC6,0xC6,0xFE,0xC6,
+     0xC6,0xC6,0xC6,0xC6,0x00,0x00,0x00,0x00},
+    // 0x49 'I'
+    {0x00,0x00,0x3C,0x18,0x18,0x18,0x18,0x18,
+     0x18,0x18,0x18,0x3C,0x00,0x00,0x00,0x00},
+    // 0x4A 'J'
+    {0x00,0x00,0x1E,0x0C,0x0C,0x0C,0x0C,0x0C,
+     0xCC,0xCC,0xCC,0x78,0x00,0x00,0x00,0x00},
+    // 0x4B 'K'
+    {0x00,0x00,0xE6,0x66,0x66,0x6C,0x78,0x78,
+     0x6C,0x66,0x66,0xE6,0x00,0x00,0x00,0x00},
+    // 0x4C 'L'
+    {0x00,0x00,0xF0,0x60,0x60,0x60,0x60,0x60,
+     0x60,0x62,0x66,0xFE,0x00,0x00,0x00,0x00},
+    // 0x4D 'M'
+    {0x00,0x00,0xC3,0xE7,0xFF,0xFF,0xDB,0xC3,
+     0xC3,0xC3,0xC3,0xC3,0x00,0x00,0x00,0x00},
+    // 0x4E 'N'
+    {0x00,0x00,0xC6,0xE6,0xF6,0xFE,0xDE,0xCE,
+     0xC6,0xC6,0xC6,0xC6,0x00,0x00,0x00,0x00},
+    // 0x4F 'O'
+    {0x00,0x00,0x7C,0xC6,0xC6,0xC6,0xC6,0xC6,
+     0xC6,0xC6,0xC6,0x7C,0x00,0x00,0x00,0x00},
+    // 0x50 'P'
+    {0x00,0x00,0xFC,0x66,0x66,0x66,0x7C,0x60,
+     0x60,0x60,0x60,0xF0,0x00,0x00,0x00,0x00},
+    // 0x51 'Q'
+    {0x00,0x00,0x7C,0xC6,0xC6,0xC6,0xC6,0xC6,
+     0xC6,0xD6,0xDE,0x7C,0x0C,0x0E,0x00,0x00},
+    // 0x52 'R'
+    {0x00,0x00,0xFC,0x66,0x66,0x66,0x7C,0x6C,
+     0x66,0x66,0x66,0xE6,0x00,0x00,0x00,0x00},
+    // 0x53 'S'
+    {0x00,0x00,0x7C,0xC6,0xC6,0x60,0x38,0x0C,
+     0x06,0xC6,0xC6,0x7C,0x00,0x00,0x00,0x00},
+    // 0x54 'T'
+    {0x00,0x00,0xFF,0xDB,0x99,0x18,0x18,0x18,
+     0x18,0x18,0x18,0x3C,0x00,0x00,0x00,0x00},
+    // 0x55 'U'
+    {0x00,0x00,0xC6,0xC6,0xC6,0xC6,0xC6,0xC6,
+     0xC6,0xC6,0xC6,0x7C,0x00,0x00,0x00,0x00},
+    // 0x56 'V'
+    {0x00,0x00,0xC3,0xC3,0xC3,0xC3,0xC3,0xC3,
+     0xC3,0x66,0x3C,0x18,0x00,0x00,0x00,0x00},
+    // 0x57 'W'
+    {0x00,0x00,0xC3,0xC3,0xC3,0xC3,0xC3,0xDB,
+     0xDB,0xFF,0x66,0x66,0x00,0x00,0x00,0x00},
+    // 0x58 'X'
+    {0x00,0x00,0xC3,0xC3,0x66,0x3C,0x18,0x18,
+     0x3C,0x66,0xC3,0xC3,0x00,0x00,0x00,0x00},
+    // 0x59 'Y'
+    {0x00,0x00,0xC3,0xC3,0xC3,0x66,0x3C,0x18,
+     0x18,0x18,0x18,0x3C,0x00,0x00,0x00,0x00},
+    // 0x5A 'Z'
+    {0x00,0x00,0xFF,0xC3,0x86,0x0C,0x18,0x30,
+     0x60,0xC1,0xC3,0xFF,0x00,0x00,0x00,0x00},
+    // 0x5B '['
+    {0x00,0x00,0x3C,0x30,0x30,0x30,0x30,0x30,
+     0x30,0x30,0x30,0x3C,0x00,0x00,0x00,0x00},
+    // 0x5C '\\'
+    {0x00,0x00,0x00,0x80,0xC0,0xE0,0x70,0x38,
+     0x1C,0x0E,0x06,0x02,0x00,0x00,0x00,0x00},
+    // 0x5D ']'
+    {0x00,0x00,0x3C,0x0C,0x0C,0x0C,0x0C,0x0C,
+     0x0C,0x0C,0x0C,0x3C,0x00,0x00,0x00,0x00},
+    // 0x5E '^'
+    {0x10,0x38,0x6C,0xC6,0x00,0x00,0x00,0x00,
+     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x5F '_'
+    {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+     0x00,0x00,0x00,0x00,0x00,0xFF,0x00,0x00},
+    // 0x60 '`'
+    {0x30,0x30,0x18,0x00,0x00,0x00,0x00,0x00,
+     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+    // 0x61 'a'
+    {0x00,0x00,0x00,0x00,0x00,0x78,0x0C,0x7C,
+     0xCC,0xCC,0xCC,0x76,0x00,0x00,0x00,0x00},
+    // 0x62 'b'
+    {0x00,0x00,0xE0,0x60,0x60,0x78,0x6C,0x66,
+     0x66,0x66,0x66,0x7C,0x00,0x00,0x00,0x00},
+    // 0x63 'c'
+    {0x00,0x00,0x00,0x00,0x00,0x7C,0xC6,0xC0,
+     0xC0,0xC0,0xC6,0x7C,0x00,0x00,0x00,0x00},
+    // 0x64 'd'
+    {0x00,0x00,0x1C,0x0C,0x0C,0x3C,0x6C,0xCC,
+     0xCC,0xCC,0xCC,0x76,0x00,0x00,0x00,0x00},
+    // 0x65 'e'
+    {0x00,0x00,0x00,0x00,0x00,0x7C,0xC6,0xFE,
+     0xC0,0xC0,0xC6,0x7C,0x00,0x00,0x00,0x00},
+    // 0x66 'f'
+    {0x00,0x00,0x38,0x6C,0x64,0x60,0xF0,0x60,
+     0x60,0x60,0x60,0xF0,0x00,0x00,0x00,0x00},
+    // 0x67 'g'
+    {0x00,0x00,0x00,0x00,0x00,0x76,0xCC,0xCC,
+     0xCC,0xCC,0xCC,0x7C,0x0C,0xCC,0x78,0x00},
+    // 0x68 'h'
+    {0x00,0x00,0xE0,0x60,0x60,0x6C,0x76,0x66,
+     0x66,0x66,0x66,0xE6,0x00,0x00,0x00,0x00},
+    // 0x69 'i'
+    {0x00,0x00,0x18,0x18,0x00,0x38,0x18,0x18,
+     0x18,0x18,0x18,0x3C,0x00,0x00,0x00,0x00},
+    // 0x6A 'j'
+    {0x00,0x00,0x06,0x06,0x00,0x0E,0x06,0x06,
+     0x06,0x06,0x06,0x06,0x66,0x66,0x3C,0x00},
+    // 0x6B 'k'
+    {0x00,0x00,0xE0,0x60,0x60,0x66,0x6C,0x78,
+     0x78,0x6C,0x66,0xE6,0x00,0x00,0x00,0x00},
+    // 0x6C 'l'
+    {0x00,0x00,0x38,0x18,0x18,0x18,0x18,0x18,
+     0x18,0x18,0x18,0x3C,0x00,0x00,0x00,0x00},
+    // 0x6D 'm'
+    {0x00,0x00,0x00,0x00,0x00,0xE6,0xFF,0xDB,
+     0xDB,0xDB,0xDB,0xDB,0x00,0x00,0x00,0x00},
+    // 0x6E 'n'
+    {0x00,0x00,0x00,0x00,0x00,0xDC,0x66,0x66,
+     0x66,0x66,0x66,0x66,0x00,0x00,0x00,0x00},
+    // 0x6F 'o'
+    {0x00,0x00,0x00,0x00,0x00,0x7C,0xC6,0xC6,
+     0xC6,0xC6,0xC6,0x7C,0x00,0x00,0x00,0x00},
+    // 0x70 'p'
+    {0x00,0x00,0x00,0x00,0x00,0xDC,0x66,0x66,
+     0x66,0x66,0x66,0x7C,0x60,0x60,0xF0,0x00},
+    // 0x71 'q'
+    {0x00,0x00,0x00,0x00,0x00,0x76,0xCC,0xCC,
+     0xCC,0xCC,0xCC,0x7C,0x0C,0x0C,0x1E,0x00},
+    // 0x72 'r'
+    {0x00,0x00,0x00,0x00,0x00,0xDC,0x76,0x66,
+     0x60,0x60,0x60,0xF0,0x00,0x00,0x00,0x00},
+    // 0x73 's'
+    {0x00,0x00,0x00,0x00,0x00,0x7C,0xC6,0x60,
+     0x38,0x0C,0xC6,0x7C,0x00,0x00,0x00,0x00},
+    // 0x74 't'
+    {0x00,0x00,0x10,0x30,0x30,0xFC,0x30,0x30,
+     0x30,0x30,0x36,0x1C,0x00,0x00,0x00,0x00},
+    // 0x75 'u'
+    {0x00,0x00,0x00,0x00,0x00,0xCC,0xCC,0xCC,
+     0xCC,0xCC,0xCC,0x76,0x00,0x00,0x00,0x00},
+    // 0x76 'v'
+    {0x00,0x00,0x00,0x00,0x00,0xC3,0xC3,0xC3,
+     0xC3,0x66,0x3C,0x18,0x00,0x00,0x00,0x00},
+    // 0x77 'w'
+    {0x00,0x00,0x00,0x00,0x00,0xC3,0xC3,0xC3,
+     0xDB,0xDB,0xFF,0x66,0x00,0x00,0x00,0x00},
+    // 0x78 'x'
+    {0x00,0x00,0x00,0x00,0x00,0xC3,0x66,0x3C,
+     0x18,0x3C,0x66,0xC3,0x00,0x00,0x00,0x00},
+    // 0x79 'y'
+    {0x00,0x00,0x00,0x00,0x00,0xC6,0xC6,0xC6,
+     0xC6,0xC6,0xC6,0x7E,0x06,0x0C,0xF8,0x00},
+    // 0x7A 'z'
+    {0x00,0x00,0x00,0x00,0x00,0xFE,0xCC,0x18,
+     0x30,0x60,0xC6,0xFE,0x00,0x00,0x00,0x00},
+    // 0x7B '{'
+    {0x00,0x00,0x0E,0x18,0x18,0x18,0x70,0x18,
+     0x18,0x18,0x18,0x0E,0x00,0x00,0x00,0x00},
+    // 0x7C '|'
+    {0x00,0x00,0x18,0x18,0x18,0x18,0x00,0x18,
+     0x18,0x18,0x18,0x18,0x00,0x00,0x00,0x00},
+    // 0x7D '}'
+    {0x00,0x00,0x70,0x18,0x18,0x18,0x0E,0x18,
+     0x18,0x18,0x18,0x70,0x00,0x00,0x00,0x00},
+    // 0x7E '~'
+    {0x00,0x00,0x76,0xDC,0x00,0x00,0x00,0x00,
+     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+};
+
+int glyphIndex(char c) {
+    const int code = static_cast<unsigned char>(c);
+    if (code < kFirstGlyph || code >= kFirstGlyph + kGlyphCount) return '?' - kFirstGlyph;
+    return code - kFirstGlyph;
+}
+
+// dst = set ? val : (dark ? (dst >> 2) + bias : dst)
+void composeRow(uint8_t* dst, const uint8_t* set, const uint8_t* val, const uint8_t* dark,
+                int n, uint8_t bias) {
+    int i = 0;
+#if defined(__aarch64__)
+    const uint8x16_t b = vdupq_n_u8(bias);
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t px = vld1q_u8(dst + i);
+        const uint8x16_t dim = vaddq_u8(vshrq_n_u8(px, 2), b);
+        const uint8x16_t bg = vbslq_u8(vld1q_u8(dark + i), dim, px);
+        vst1q_u8(dst + i, vbslq_u8(vld1q_u8(set + i), vld1q_u8(val + i), bg));
+    }
+#elif defined(__SSE2__)
+    const __m128i b = _mm_set1_epi8(static_cast<char>(bias));
+    const __m128i low6 = _mm_set1_epi8(0x3F);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set + i));
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(val + i));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dark + i));
+        const __m128i dim = _mm_add_epi8(_mm_and_si128(_mm_srli_epi16(px, 2), low6), b);
+        const __m128i bg = _mm_or_si128(_mm_and_si128(d, dim), _mm_andnot_si128(d, px));
+        const __m128i out = _mm_or_si128(_mm_and_si128(s, v), _mm_andnot_si128(s, bg));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+    }
+#endif
+    for (; i < n; i++) {
+        if (set[i]) {
+            dst[i] = val[i];
+        } else if (dark[i]) {
+            dst[i] = static_cast<uint8_t>((dst[i] >> 2) + bias);
+        }
+    }
+}
+
+// Fills `pairs` interleaved U/V samples with one colour.
+void fillUvSpan(uint8_t* dst, int pairs, uint8_t u, uint8_t v) {
+    int i = 0;
+#if defined(__aarch64__)
+    uint8x16x2_t uv;
+    uv.val[0] = vdupq_n_u8(u);
+    uv.val[1] = vdupq_n_u8(v);
+    for (; i + 16 <= pairs; i += 16) {
+        vst2q_u8(dst + i * 2, uv);
+    }
+#elif defined(__SSE2__)
+    const __m128i uv = _mm_set1_epi16(static_cast<short>(u | (v << 8)));
+    for (; i + 8 <= pairs; i += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), uv);
+    }
+#endif
+    for (; i < pairs; i++) {
+        dst[i * 2] = u;
+        dst[i * 2 + 1] = v;
+    }
+}
+
+// Applies the background darkening to canvas cells: already-set cells get
+// their value darkened, the rest are flagged for darkening at composite time.
+void darkenSpan(uint8_t* set, uint8_t* val, uint8_t* dark, int n, uint8_t bias) {
+    for (int i = 0; i < n; i++) {
+        if (set[i]) {
+            val[i] = static_cast<uint8_t>((val[i] >> 2) + bias);
+        } else {
+            dark[i] = 0xFF;
+        }
+    }
+}
+
+} // namespace
+
+OverlayCompositor::OverlayCompositor(int scale)
+    : scale_(std::max(1, std::min(4, scale))) {
+    cellW_ = kGlyphW * scale_;
+    cellH_ = kGlyphH * scale_;
+    buildAtlas();
+}
+
+void OverlayCompositor::buildAtlas() {
+    const size_t cell = static_cast<size_t>(cellW_) * static_cast<size_t>(cellH_);
+    atlas_.assign(cell * kGlyphCount, 0);
+    for (int g = 0; g < kGlyphCount; g++) {
+        uint8_t* dst = atlas_.data() + cell * static_cast<size_t>(g);
+        for (int y = 0; y < cellH_; y++) {
+            const uint8_t bits = FONT[g][y / scale_];
+            for (int x = 0; x < cellW_; x++) {
+                if (bits & (0x80 >> (x / scale_))) dst[y * cellW_ + x] = 0xFF;
+            }
+        }
+    }
+}
+
+int OverlayCompositor::textBoxWidth(const std::string& text) const {
+    return static_cast<int>(text.size()) * cellW_ + 8 * scale_;
+}
+
+int OverlayCompositor::textBoxHeight() const {
+    return cellH_ + 6 * scale_;
+}
+
+void OverlayCompositor::setLayer(int id, const std::vector<OverlayText>& texts,
+                                 const std::vector<OverlayRect>& rects) {
+    auto it = std::find_if(layers_.begin(), layers_.end(), [id](const Layer& l) { return l.id == id; });
+    if (it != layers_.end()) {
+        const bool sameTexts = std::equal(
+            it->texts.begin(), it->texts.end(), texts.begin(), texts.end(),
+            [](const OverlayText& a, const OverlayText& b) {
+                return a.x == b.x && a.y == b.y && a.text == b.text;
+            });
+        const bool sameRects = std::equal(
+            it->rects.begin(), it->rects.end(), rects.begin(), rects.end(),
+            [](const OverlayRect& a, const OverlayRect& b) {
+                return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h && a.thickness == b.thickness;
+            });
+        if (sameTexts && sameRects) return;
+        markDirty(*it);
+        if (texts.empty() && rects.empty()) {
+            layers_.erase(it);
+            return;
+        }
+        it->texts = texts;
+        it->rects = rects;
+        markDirty(*it);
+        return;
+    }
+    if (texts.empty() && rects.empty()) return;
+
+    Layer layer;
+    layer.id = id;
+    layer.texts = texts;
+    layer.rects = rects;
+    markDirty(layer);
+    auto pos = std::upper_bound(layers_.begin(), layers_.end(), id,
+                                [](int v, const Layer& l) { return v < l.id; });
+    layers_.insert(pos, std::move(layer));
+}
+
+void OverlayCompositor::clearLayer(int id) {
+    setLayer(id, {}, {});
+}
+
+void OverlayCompositor::resize(int width, int height) {
+    width_ = width;
+    height_ = height;
+    const size_t lumaSize = static_cast<size_t>(width) * static_cast<size_t>(height);
+    const size_t chromaSize = static_cast<size_t>(width) * static_cast<size_t>(height / 2);
+    lumaSet_.assign(lumaSize, 0);
+    lumaVal_.assign(lumaSize, 0);
+    lumaDark_.assign(lumaSize, 0);
+    chromaSet_.assign(chromaSize, 0);
+    chromaVal_.assign(chromaSize, 0);
+    chromaDark_.assign(chromaSize, 0);
+    dirty_.clear();
+    dirty_.push_back(Rect{0, 0, width, height});
+    spansDirty_ = true;
+}
+
+namespace {
+
+bool intersect(int ax, int ay, int aw, int ah, int bx, int by, int bw, int bh,
+               int& x, int& y, int& w, int& h) {
+    const int x0 = std::max(ax, bx);
+    const int y0 = std::max(ay, by);
+    const int x1 = std::min(ax + aw, bx + bw);
+    const int y1 = std::min(ay + ah, by + bh);
+    if (x1 <= x0 || y1 <= y0) return false;
+    x = x0;
+    y = y0;
+    w = x1 - x0;
+    h = y1 - y0;
+    return true;
+}
+
+} // namespace
+
+OverlayCompositor::Rect OverlayCompositor::textBox(const OverlayText& text) const {
+    return Rect{text.x, text.y, textBoxWidth(text.text), textBoxHeight()};
+}
+
+bool OverlayCompositor::clampRect(const OverlayRect& rect, Rect& box, int& band, int& bandW) const {
+    if (rect.w <= 0 || rect.h <= 0 || width_ <= 0 || height_ <= 0) return false;
+    const int x0 = std::max(0, rect.x);
+    const int y0 = std::max(0, rect.y);
+    const int x1 = std::min(width_ - 1, rect.x + rect.w - 1);
+    const int y1 = std::min(height_ - 1, rect.y + rect.h - 1);
+    if (x1 <= x0 || y1 <= y0) return false;
+    const int thickness = std::max(1, rect.thickness);
+    box = Rect{x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+    band = std::min(thickness, box.h);
+    bandW = std::min(thickness, box.w);
+    return true;
+}
+
+void OverlayCompositor::elementRects(const Layer& layer, std::vector<Rect>& out) const {
+    for (const auto& rect : layer.rects) {
+        Rect box;
+        int band = 0;
+        int bandW = 0;
+        if (!clampRect(rect, box, band, bandW)) continue;
+        out.push_back(Rect{box.x, box.y, box.w, band});
+        out.push_back(Rect{box.x, box.y + box.h - band, box.w, band});
+        out.push_back(Rect{box.x, box.y, bandW, box.h});
+        out.push_back(Rect{box.x + box.w - bandW, box.y, bandW, box.h});
+    }
+    for (const auto& text : layer.texts) {
+        out.push_back(textBox(text));
+    }
+}
+
+void OverlayCompositor::markDirty(const Layer& layer) {
+    elementRects(layer, dirty_);
+    spansDirty_ = true;
+}
+
+void OverlayCompositor::redrawDirty() {
+    for (const Rect& raw : dirty_) {
+        // Align to 2x2 blocks so luma and the subsampled chroma are cleared
+        // and redrawn over exactly the same area.
+        Rect d;
+        const int ax = raw.x & ~1;
+        const int ay = raw.y & ~1;
+        const int aw = ((raw.x + raw.w + 1) & ~1) - ax;
+        const int ah = ((raw.y + raw.h + 1) & ~1) - ay;
+        if (!intersect(ax, ay, aw, ah, 0, 0, width_ & ~1, height_ & ~1, d.x, d.y, d.w, d.h)) continue;
+
+        for (int y = d.y; y < d.y + d.h; y++) {
+            const size_t off = static_cast<size_t>(y) * static_cast<size_t>(width_) + static_cast<size_t>(d.x);
+            std::memset(lumaSet_.data() + off, 0, static_cast<size_t>(d.w));
+            std::memset(lumaDark_.data() + off, 0, static_cast<size_t>(d.w));
+        }
+        for (int cy = d.y / 2; cy < (d.y + d.h) / 2; cy++) {
+            const size_t off = static_cast<size_t>(cy) * static_cast<size_t>(width_) + static_cast<size_t>(d.x);
+            std::memset(chromaSet_.data() + off, 0, static_cast<size_t>(d.w));
+            std::memset(chromaDark_.data() + off, 0, static_cast<size_t>(d.w));
+        }
+        for (const auto& layer : layers_) {
+            for (const auto& rect : layer.rects) rasterizeRect(rect, d);
+            for (const auto& text : layer.texts) rasterizeText(text, d);
+        }
+    }
+    dirty_.clear();
+}
+
+void OverlayCompositor::rasterizeText(const OverlayText& text, const Rect& clip) {
+    const Rect box = textBox(text);
+    Rect l;
+    if (!intersect(box.x, box.y, box.w, box.h, clip.x, clip.y, clip.w, clip.h, l.x, l.y, l.w, l.h)) return;
+
+    // Background darkens everything beneath it, including lower layers'
+    // pixels, which are pre-darkened in place.
+    for (int y = l.y; y < l.y + l.h; y++) {
+        const size_t off = static_cast<size_t>(y) * static_cast<size_t>(width_) + static_cast<size_t>(l.x);
+        darkenSpan(lumaSet_.data() + off, lumaVal_.data() + off, lumaDark_.data() + off, l.w, 0);
+    }
+    Rect c;
+    const int cx = box.x & ~1;
+    const int cyTop = box.y & ~1;
+    if (intersect(cx, cyTop, ((box.x + box.w + 1) & ~1) - cx, ((box.y + box.h + 1) & ~1) - cyTop,
+                  clip.x, clip.y, clip.w, clip.h, c.x, c.y, c.w, c.h)) {
+        for (int cy = c.y / 2; cy < (c.y + c.h) / 2; cy++) {
+            const size_t off = static_cast<size_t>(cy) * static_cast<size_t>(width_) + static_cast<size_t>(c.x);
+            darkenSpan(chromaSet_.data() + off, chromaVal_.data() + off, chromaDark_.data() + off,
+                       c.w, kChromaDarkBias);
+        }
+    }
+
+    const int padX = 4 * scale_;
+    const int padY = 3 * scale_;
+    const size_t cell = static_cast<size_t>(cellW_) * static_cast<size_t>(cellH_);
+    for (size_t i = 0; i < text.text.size(); i++) {
+        const int gx = box.x + padX + static_cast<int>(i) * cellW_;
+        const int gy = box.y + padY;
+        Rect g;
+        if (!intersect(gx, gy, cellW_, cellH_, l.x, l.y, l.w, l.h, g.x, g.y, g.w, g.h)) continue;
+        const uint8_t* glyph = atlas_.data() + cell * static_cast<size_t>(glyphIndex(text.text[i]));
+        for (int y = g.y; y < g.y + g.h; y++) {
+            const uint8_t* src = glyph + static_cast<size_t>(y - gy) * static_cast<size_t>(cellW_) + (g.x - gx);
+            const size_t off = static_cast<size_t>(y) * static_cast<size_t>(width_) + static_cast<size_t>(g.x);
+            uint8_t* set = lumaSet_.data() + off;
+            uint8_t* val = lumaVal_.data() + off;
+            for (int x = 0; x < g.w; x++) {
+                if (src[x]) {
+                    set[x] = 0xFF;
+                    val[x] = kTextY;
+                }
+            }
+        }
+    }
+}
+
+void OverlayCompositor::rasterizeRect(const OverlayRect& rect, const Rect& clip) {
+    Rect box;
+    int band = 0;
+    int bandW = 0;
+    if (!clampRect(rect, box, band, bandW)) return;
+
+    const Rect edges[4] = {
+        {box.x, box.y, box.w, band},
+        {box.x, box.y + box.h - band, box.w, band},
+        {box.x, box.y, bandW, box.h},
+        {box.x + box.w - bandW, box.y, bandW, box.h},
+    };
+    for (const Rect& e : edges) {
+        Rect l;
+        if (!intersect(e.x, e.y, e.w, e.h, clip.x, clip.y, clip.w, clip.h, l.x, l.y, l.w, l.h)) continue;
+        for (int y = l.y; y < l.y + l.h; y++) {
+            const size_t off = static_cast<size_t>(y) * static_cast<size_t>(width_) + static_cast<size_t>(l.x);
+            std::memset(lumaSet_.data() + off, 0xFF, static_cast<size_t>(l.w));
+            std::memset(lumaVal_.data() + off, kRectY, static_cast<size_t>(l.w));
+        }
+        // Chroma samples covering the edge; clip is 2x2 aligned so they stay inside it.
+        const int cx0 = l.x & ~1;
+        const int cx1 = (l.x + l.w + 1) & ~1;
+        for (int cy = l.y / 2; cy <= (l.y + l.h - 1) / 2; cy++) {
+            const size_t off = static_cast<size_t>(cy) * static_cast<size_t>(width_);
+            std::memset(chromaSet_.data() + off + cx0, 0xFF, static_cast<size_t>(cx1 - cx0));
+            fillUvSpan(chromaVal_.data() + off + cx0, (cx1 - cx0) / 2, kRectU, kRectV);
+        }
+    }
+}
+
+void OverlayCompositor::rebuildSpans() {
+    lumaSpans_.assign(static_cast<size_t>(height_), {});
+    chromaSpans_.assign(static_cast<size_t>(height_ / 2), {});
+
+    std::vector<Rect> rects;
+    for (const auto& layer : layers_) elementRects(layer, rects);
+    for (const Rect& r : rects) {
+        Rect l;
+        if (!intersect(r.x, r.y, r.w, r.h, 0, 0, width_, height_, l.x, l.y, l.w, l.h)) continue;
+        for (int y = l.y; y < l.y + l.h; y++) {
+            lumaSpans_[static_cast<size_t>(y)].push_back(Span{l.x, l.x + l.w});
+        }
+        const int cx0 = l.x & ~1;
+        const int cx1 = std::min(width_ & ~1, (l.x + l.w + 1) & ~1);
+        const int cyEnd = std::min(height_ / 2 - 1, (l.y + l.h - 1) / 2);
+        for (int cy = l.y / 2; cy <= cyEnd; cy++) {
+            chromaSpans_[static_cast<size_t>(cy)].push_back(Span{cx0, cx1});
+        }
+    }
+
+    auto merge = [](std::vector<Span>& spans) {
+        if (spans.size() < 2) return;
+        std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) { return a.x0 < b.x0; });
+        size_t out = 0;
+        for (size_t i = 1; i < spans.size(); i++) {
+            if (spans[i].x0 <= spans[out].x1) {
+                spans[out].x1 = std::max(spans[out].x1, spans[i].x1);
+            } else {
+                spans[++out] = spans[i];
+            }
+        }
+        spans.resize(out + 1);
+    };
+    for (auto& row : lumaSpans_) merge(row);
+    for (auto& row : chromaSpans_) merge(row);
+    spansDirty_ = false;
+}
+
+void OverlayCompositor::composite(uint8_t* data, int width, int height) {
+    if (!data || width <= 0 || height <= 0) return;
+    if (width != width_ || height != height_) resize(width, height);
+    if (!dirty_.empty()) redrawDirty();
+    if (spansDirty_) rebuildSpans();
+    if (layers_.empty()) return;
+
+    const size_t stride = static_cast<size_t>(width_);
+    for (int y = 0; y < height_; y++) {
+        const size_t row = static_cast<size_t>(y) * stride;
+        for (const Span& s : lumaSpans_[static_cast<size_t>(y)]) {
+            const size_t off = row + static_cast<size_t>(s.x0);
+            composeRow(data + off, lumaSet_.data() + off, lumaVal_.data() + off, lumaDark_.data() + off,
+                       s.x1 - s.x0, 0);
+        }
+    }
+    uint8_t* uvPlane = data + static_cast<size_t>(width_) * static_cast<size_t>(height_);
+    for (int cy = 0; cy < height_ / 2; cy++) {
+        const size_t row = static_cast<size_t>(cy) * stride;
+        for (const Span& s : chromaSpans_[static_cast<size_t>(cy)]) {
+            const size_t off = row + static_cast<size_t>(s.x0);
+            composeRow(uvPlane + off, chromaSet_.data() + off, chromaVal_.data() + off,
+                       chromaDark_.data() + off, s.x1 - s.x0, kChromaDarkBias);
+        }
+    }
+}
+
+} // namespace reallive
@@ -1,5 +1,15 @@
 #include "core/Pipeline.h"
-#include "core/TextOverlay.h"
+#include "core/ComponentRegistry.h"
+#include "core/DetectionScheduler.h"
+#include "core/FramePool.h"
+#include "core/InferenceGate.h"
+#include "core/MotionZones.h"
+#include "core/OverlayCompositor.h"
+#include "core/SeiTimestamp.h"
+#include "core/StageWatchdog.h"
+#include "core/SystemSampler.h"
+#include "core/TelemetrySei.h"
+#include "core/Tracer.h"
 
 #include <iostream>
 #include <chrono>
@@ -14,18 +24,24 @@
 #include <sstream>
 #include <cctype>
 #include <cstring>
+#include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <iterator>
 #include <limits>
+#include <map>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-
-// Platform-specific includes (Raspberry Pi 5)
-#include "platform/rpi5/LibcameraCapture.h"
-#include "platform/rpi5/AvcodecEncoder.h"
-#include "platform/rpi5/AlsaCapture.h"
-#include "platform/rpi5/RtmpStreamer.h"
+#include <future>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Capture and encoder backends come from ComponentRegistry; the FFmpeg
+// based encoder and streamers build on any Linux.
+#include "platform/generic/AvcodecEncoder.h"
+#include "platform/generic/RtmpStreamer.h"
+#include "platform/generic/UdpStreamer.h"
 #include "core/LocalRecorder.h"
 
 #ifdef REALLIVE_HAS_OPENCV
@@ -43,22 +59,6 @@ namespace reallive {
 
 namespace {
 
-constexpr std::array<uint8_t, 16> kTelemetrySeiUuid = {
-    0x52, 0x65, 0x61, 0x4C, 0x69, 0x76, 0x65, 0x53,
-    0x65, 0x69, 0x4D, 0x65, 0x74, 0x72, 0x69, 0x63
-};
-
-struct SystemTelemetry {
-    double cpuPct = 0.0;
-    std::vector<double> cpuCorePct;
-    double memoryPct = 0.0;
-    double memoryUsedMb = 0.0;
-    double memoryTotalMb = 0.0;
-    double storagePct = 0.0;
-    double storageUsedGb = 0.0;
-    double storageTotalGb = 0.0;
-};
-
 struct PersonBox {
     bool valid = false;
     int x = 0;
@@ -67,42 +67,9 @@ struct PersonBox {
     int h = 0;
     double score = 0.0;
     int64_t ts = 0;
+    uint32_t trackId = 0;
 };
 
-struct CpuCounters {
-    uint64_t total = 0;
-    uint64_t idle = 0;
-    bool valid = false;
-};
-
-struct CpuStatSnapshot {
-    CpuCounters total;
-    std::vector<CpuCounters> cores;
-};
-
-double clampPercent(double value) {
-    if (!std::isfinite(value)) return 0.0;
-    if (value < 0.0) return 0.0;
-    if (value > 100.0) return 100.0;
-    return value;
-}
-
-std::string jsonEscape(const std::string& input) {
-    std::string out;
-    out.reserve(input.size());
-    for (char ch : input) {
-        switch (ch) {
-        case '\\': out += "\\\\"; break;
-        case '"': out += "\\\""; break;
-        case '\n': out += "\\n"; break;
-        case '\r': out += "\\r"; break;
-        case '\t': out += "\\t"; break;
-        default: out += ch; break;
-        }
-    }
-    return out;
-}
-
 std::string formatNumber(double value, int precision = 1) {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(precision) << value;
@@ -148,6 +115,20 @@ double clamp01(double value) {
     return value;
 }
 
+#ifdef REALLIVE_HAS_TFLITE
+// The flatbuffer is read-only once built, so cameras using the same model
+// file share one copy; each detector still builds its own interpreter.
+std::shared_ptr<tflite::FlatBufferModel> sharedTfliteModel(const std::string& path) {
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<tflite::FlatBufferModel>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto model = cache[path].lock()) return model;
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(path.c_str());
+    if (model) cache[path] = model;
+    return model;
+}
+#endif
+
 class MotionPersonDetector {
 public:
     MotionPersonDetector() = default;
@@ -155,6 +136,7 @@ public:
     explicit MotionPersonDetector(const DetectionConfig& cfg)
         : cfg_(cfg) {
         normalizeConfig();
+        zones_.configure(cfg_.zones, cfg_.diffThreshold, cfg_.motionRatioThreshold);
         loadLabels();
         initTflite();
 #ifdef REALLIVE_HAS_OPENCV
@@ -166,6 +148,7 @@ public:
                   << ((hasOpenCv_ && cfg_.useOpenCvMotion) ? "opencv" : "fallback")
                   << " tflite=" << (tfliteReady_ ? "on" : "off")
                   << " infer_on_motion=" << (cfg_.inferOnMotionOnly ? "true" : "false")
+                  << " zones=" << cfg_.zones.size()
                   << std::endl;
     }
 
@@ -179,6 +162,8 @@ public:
         }
 
         frameCount_++;
+        lastInferUs_ = 0;
+        lastHadMotion_ = false;
         const bool onDetectFrame = (cfg_.intervalFrames <= 1) || ((frameCount_ % cfg_.intervalFrames) == 0);
         if (!onDetectFrame) {
             PersonBox tracked;
@@ -193,6 +178,7 @@ public:
         PersonBox motionCandidate;
         double motionRatio = 0.0;
         const bool hasMotion = detectMotion(frame, nowMs, motionCandidate, motionRatio);
+        lastHadMotion_ = hasMotion;
         const bool useModelPath = (cfg_.useTfliteSsd && tfliteReady_);
 
         if (useModelPath) {
@@ -201,7 +187,15 @@ public:
                 lastInferMs_ = nowMs;
                 PersonBox inferBox;
                 const PersonBox gateMotion = hasMotion ? motionCandidate : PersonBox{};
-                if (runTfliteInference(frame, gateMotion, nowMs, inferBox)) {
+                const auto inferStart = std::chrono::steady_clock::now();
+                bool inferred = false;
+                {
+                    TraceSpan span("inference");
+                    inferred = runTfliteInference(frame, gateMotion, nowMs, inferBox);
+                }
+                lastInferUs_ = std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - inferStart).count());
+                if (inferred) {
                     lastDetectedMs_ = nowMs;
                     lastBox_ = inferBox;
                     refreshTrackTemplate(frame, inferBox, true);
@@ -240,6 +234,17 @@ public:
         return motionCandidate;
     }
 
+    void setCadence(const DetectionCadence& cadence) {
+        cfg_.intervalFrames = std::max(1, cadence.intervalFrames);
+        cfg_.inferMinIntervalMs = std::max(10, cadence.inferMinIntervalMs);
+        inferTiles_ = std::max(1, std::min(4, cadence.inferTiles));
+    }
+
+    // Microseconds spent in inference during the last detect() call, 0 if none ran.
+    int64_t lastInferUs() const { return lastInferUs_; }
+    // Whether the last detect() call ran motion detection and found motion.
+    bool lastHadMotion() const { return lastHadMotion_; }
+
 private:
     void normalizeConfig() {
         if (cfg_.intervalFrames < 1) cfg_.intervalFrames = 1;
@@ -334,23 +339,63 @@ private:
         float scale = 1.0f;
     };
 
-    static LetterboxTransform nv12ToRgbLetterbox(const Frame& frame, int dstW, int dstH, std::vector<uint8_t>& out) {
+    struct InferTile {
+        int x = 0;
+        int y = 0;
+        int w = 0;
+        int h = 0;
+    };
+
+    // Splits the frame into overlapping inference tiles. One tile is the whole
+    // frame; more tiles run the model on sub-regions so small people keep
+    // more input pixels, at proportionally higher inference cost.
+    std::vector<InferTile> inferenceTiles(const Frame& frame) const {
+        const int tiles = std::max(1, std::min(4, inferTiles_));
+        if (tiles == 1) {
+            return {InferTile{0, 0, frame.width, frame.height}};
+        }
+        const bool wide = frame.width >= frame.height;
+        const int cols = (tiles == 4) ? 2 : (wide ? tiles : 1);
+        const int rows = (tiles == 4) ? 2 : (wide ? 1 : tiles);
+        // Neighbouring tiles overlap by ~1/8 of a tile so a person on a seam
+        // is seen whole by at least one of them.
+        const int tileW = (cols == 1) ? frame.width
+                                      : std::min(frame.width, frame.width / cols + frame.width / (cols * 8));
+        const int tileH = (rows == 1) ? frame.height
+                                      : std::min(frame.height, frame.height / rows + frame.height / (rows * 8));
+        std::vector<InferTile> out;
+        out.reserve(static_cast<size_t>(cols * rows));
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                InferTile t;
+                t.x = (cols == 1) ? 0 : (frame.width - tileW) * c / (cols - 1);
+                t.y = (rows == 1) ? 0 : (frame.height - tileH) * r / (rows - 1);
+                t.w = tileW;
+                t.h = tileH;
+                out.push_back(t);
+            }
+        }
+        return out;
+    }
+
+    static LetterboxTransform nv12ToRgbLetterbox(
+        const Frame& frame, const InferTile& roi, int dstW, int dstH, std::vector<uint8_t>& out) {
         LetterboxTransform tx;
-        tx.srcW = frame.width;
-        tx.srcH = frame.height;
+        tx.srcW = roi.w;
+        tx.srcH = roi.h;
         tx.dstW = dstW;
         tx.dstH = dstH;
 
-        if (frame.width <= 0 || frame.height <= 0 || dstW <= 0 || dstH <= 0) {
+        if (roi.w <= 0 || roi.h <= 0 || dstW <= 0 || dstH <= 0) {
             out.clear();
             return tx;
         }
 
-        const float sx = static_cast<float>(dstW) / static_cast<float>(frame.width);
-        const float sy = static_cast<float>(dstH) / static_cast<float>(frame.height);
+        const float sx = static_cast<float>(dstW) / static_cast<float>(roi.w);
+        const float sy = static_cast<float>(dstH) / static_cast<float>(roi.h);
         tx.scale = std::max(1e-6f, std::min(sx, sy));
-        tx.resizedW = std::max(1, std::min(dstW, static_cast<int>(std::round(frame.width * tx.scale))));
-        tx.resizedH = std::max(1, std::min(dstH, static_cast<int>(std::round(frame.height * tx.scale))));
+        tx.resizedW = std::max(1, std::min(dstW, static_cast<int>(std::round(roi.w * tx.scale))));
+        tx.resizedH = std::max(1, std::min(dstH, static_cast<int>(std::round(roi.h * tx.scale))));
         tx.padX = std::max(0, (dstW - tx.resizedW) / 2);
         tx.padY = std::max(0, (dstH - tx.resizedH) / 2);
 
@@ -360,10 +405,12 @@ private:
 
         const float invScale = 1.0f / tx.scale;
         for (int ry = 0; ry < tx.resizedH; ry++) {
-            const int syPx = std::max(0, std::min(frame.height - 1, static_cast<int>(std::floor(ry * invScale))));
+            const int syPx = std::max(0, std::min(frame.height - 1,
+                                                  roi.y + static_cast<int>(std::floor(ry * invScale))));
             const int dy = tx.padY + ry;
             for (int rx = 0; rx < tx.resizedW; rx++) {
-                const int sxPx = std::max(0, std::min(frame.width - 1, static_cast<int>(std::floor(rx * invScale))));
+                const int sxPx = std::max(0, std::min(frame.width - 1,
+                                                      roi.x + static_cast<int>(std::floor(rx * invScale))));
                 const int dx = tx.padX + rx;
                 const int y = static_cast<int>(yPlane[syPx * frame.width + sxPx]);
                 const int uvIndex = (syPx / 2) * frame.width + (sxPx / 2) * 2;
@@ -502,46 +549,40 @@ private:
 
         if (prevLuma_.size() != sampleSize) {
             prevLuma_.assign(sampleSize, 0);
+            curLuma_.assign(sampleSize, 0);
+            motionCells_.assign(sampleSize, 0);
             hasPrev_ = false;
         }
+        zones_.prepare(sampleW, sampleH);
 
         const uint8_t* yPlane = frame.data.data();
-        int changed = 0;
-        int minX = sampleW;
-        int minY = sampleH;
-        int maxX = -1;
-        int maxY = -1;
-
         for (int sy = 0; sy < sampleH; sy++) {
             const int srcY = std::min(frame.height - 1, (sy * frame.height) / sampleH);
+            const uint8_t* srcRow = yPlane + static_cast<size_t>(srcY) * static_cast<size_t>(frame.width);
+            uint8_t* dstRow = curLuma_.data() + static_cast<size_t>(sy) * static_cast<size_t>(sampleW);
             for (int sx = 0; sx < sampleW; sx++) {
-                const int srcX = std::min(frame.width - 1, (sx * frame.width) / sampleW);
-                const uint8_t current = yPlane[srcY * frame.width + srcX];
-                const size_t idx = static_cast<size_t>(sy) * static_cast<size_t>(sampleW) + static_cast<size_t>(sx);
-                const uint8_t prev = prevLuma_[idx];
-                prevLuma_[idx] = current;
-
-                if (!hasPrev_) continue;
-                const int diff = std::abs(static_cast<int>(current) - static_cast<int>(prev));
-                if (diff < cfg_.diffThreshold) continue;
-                changed++;
-                minX = std::min(minX, sx);
-                minY = std::min(minY, sy);
-                maxX = std::max(maxX, sx);
-                maxY = std::max(maxY, sy);
+                dstRow[sx] = srcRow[std::min(frame.width - 1, (sx * frame.width) / sampleW)];
             }
         }
-        hasPrev_ = true;
-        if (changed <= 0 || maxX < minX || maxY < minY) return false;
+        if (!hasPrev_) {
+            prevLuma_.swap(curLuma_);
+            hasPrev_ = true;
+            return false;
+        }
+
+        zones_.thresholdDiff(curLuma_.data(), prevLuma_.data(), motionCells_.data());
+        prevLuma_.swap(curLuma_);
+        const MotionZones::Result motion = zones_.score(motionCells_.data());
+        if (motion.changedCells <= 0 || motion.maxX < motion.minX || motion.maxY < motion.minY) return false;
 
-        ratio = static_cast<double>(changed) / static_cast<double>(sampleW * sampleH);
-        if (ratio < cfg_.motionRatioThreshold) return false;
+        ratio = motion.ratio;
+        if (!motion.triggered) return false;
 
         box.valid = true;
-        box.x = (minX * frame.width) / sampleW;
-        box.y = (minY * frame.height) / sampleH;
-        box.w = std::max(2, ((maxX + 1) * frame.width) / sampleW - box.x);
-        box.h = std::max(2, ((maxY + 1) * frame.height) / sampleH - box.y);
+        box.x = (motion.minX * frame.width) / sampleW;
+        box.y = (motion.minY * frame.height) / sampleH;
+        box.w = std::max(2, ((motion.maxX + 1) * frame.width) / sampleW - box.x);
+        box.h = std::max(2, ((motion.maxY + 1) * frame.height) / sampleH - box.y);
         const double areaRatio = static_cast<double>(box.w) * static_cast<double>(box.h) /
                                  static_cast<double>(frame.width * frame.height);
         if (areaRatio < cfg_.minBoxAreaRatio) return false;
@@ -566,17 +607,24 @@ private:
                 return false;
             }
 
-            cv::Mat diff;
-            cv::absdiff(small, prevSmall_, diff);
-            cv::threshold(diff, diff, cfg_.diffThreshold, 255, cv::THRESH_BINARY);
+            // Per-cell thresholds and exclusions are applied in one SIMD pass
+            // instead of absdiff + threshold.
+            zones_.prepare(procW, procH);
+            cv::Mat diff(procH, procW, CV_8UC1);
+            zones_.thresholdDiff(small.data, prevSmall_.data, diff.data);
             cv::morphologyEx(diff, diff, cv::MORPH_OPEN,
                              cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3)));
             cv::dilate(diff, diff, cv::Mat(), cv::Point(-1, -1), 2);
+            if (zones_.hasZones()) {
+                // Dilation bleeds into excluded cells; clip it back.
+                const cv::Mat active(procH, procW, CV_8UC1, const_cast<uint8_t*>(zones_.activeCells()));
+                cv::bitwise_and(diff, active, diff);
+            }
             prevSmall_ = small;
 
-            const int changed = cv::countNonZero(diff);
-            ratio = static_cast<double>(changed) / static_cast<double>(diff.rows * diff.cols);
-            if (ratio < cfg_.motionRatioThreshold) return false;
+            const MotionZones::Result motion = zones_.score(diff.data);
+            ratio = motion.ratio;
+            if (!motion.triggered) return false;
 
             std::vector<std::vector<cv::Point>> contours;
             cv::findContours(diff, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
@@ -613,7 +661,7 @@ private:
     void initTflite() {
 #ifdef REALLIVE_HAS_TFLITE
         if (!cfg_.useTfliteSsd || cfg_.tfliteModelPath.empty()) return;
-        tfliteModel_ = tflite::FlatBufferModel::BuildFromFile(cfg_.tfliteModelPath.c_str());
+        tfliteModel_ = sharedTfliteModel(cfg_.tfliteModelPath);
         if (!tfliteModel_) return;
 
         tflite::ops::builtin::BuiltinOpResolver resolver;
@@ -693,8 +741,45 @@ private:
 #else
         if (!tfliteReady_ || !tfliteInterpreter_) return false;
 
-        std::vector<uint8_t> rgb;
-        const LetterboxTransform lb = nv12ToRgbLetterbox(frame, tfliteInputW_, tfliteInputH_, rgb);
+        std::vector<PersonBox> candidates;
+        candidates.reserve(64);
+        for (const InferTile& tile : inferenceTiles(frame)) {
+            inferTile(frame, tile, motion, nowMs, candidates);
+        }
+        if (candidates.empty()) return false;
+
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const PersonBox& a, const PersonBox& b) { return a.score > b.score; });
+
+        std::vector<PersonBox> kept;
+        kept.reserve(16);
+        constexpr double kNmsIouThreshold = 0.45;
+        for (const auto& cand : candidates) {
+            bool suppressed = false;
+            for (const auto& k : kept) {
+                if (iou(cand, k) > kNmsIouThreshold) {
+                    suppressed = true;
+                    break;
+                }
+            }
+            if (!suppressed) {
+                kept.push_back(cand);
+            }
+            if (kept.size() >= 16) break;
+        }
+
+        if (kept.empty()) return false;
+        out = kept.front();
+        return true;
+#endif
+    }
+
+#ifdef REALLIVE_HAS_TFLITE
+    // Runs the model on one tile and appends person candidates in frame coordinates.
+    bool inferTile(const Frame& frame, const InferTile& tile, const PersonBox& motion, int64_t nowMs,
+                   std::vector<PersonBox>& candidates) {
+        std::vector<uint8_t>& rgb = rgbScratch_;
+        const LetterboxTransform lb = nv12ToRgbLetterbox(frame, tile, tfliteInputW_, tfliteInputH_, rgb);
         if (rgb.empty()) return false;
 
         TfLiteTensor* input = tfliteInterpreter_->tensor(tfliteInputTensor_);
@@ -723,7 +808,11 @@ private:
             return false;
         }
 
-        if (tfliteInterpreter_->Invoke() != kTfLiteOk) return false;
+        {
+            InferenceGate::Turn turn(InferenceGate::instance());
+            TraceSpan span("tfliteInvoke");
+            if (tfliteInterpreter_->Invoke() != kTfLiteOk) return false;
+        }
 
         const auto& outs = tfliteInterpreter_->outputs();
         if (outs.empty()) return false;
@@ -750,8 +839,6 @@ private:
                 return data[i * channels + c];
             };
 
-            std::vector<PersonBox> candidates;
-            candidates.reserve(64);
             for (int i = 0; i < predCount; i++) {
                 float score = valAt(4 + personCls, i);
                 if (score < 0.0f || score > 1.0f) {
@@ -787,10 +874,10 @@ private:
                     continue;
                 }
 
-                const float x1f = (x1i - static_cast<float>(lb.padX)) / lb.scale;
-                const float y1f = (y1i - static_cast<float>(lb.padY)) / lb.scale;
-                const float x2f = (x2i - static_cast<float>(lb.padX)) / lb.scale;
-                const float y2f = (y2i - static_cast<float>(lb.padY)) / lb.scale;
+                const float x1f = (x1i - static_cast<float>(lb.padX)) / lb.scale + static_cast<float>(tile.x);
+                const float y1f = (y1i - static_cast<float>(lb.padY)) / lb.scale + static_cast<float>(tile.y);
+                const float x2f = (x2i - static_cast<float>(lb.padX)) / lb.scale + static_cast<float>(tile.x);
+                const float y2f = (y2i - static_cast<float>(lb.padY)) / lb.scale + static_cast<float>(tile.y);
 
                 if (x2f <= 0.0f || y2f <= 0.0f ||
                     x1f >= static_cast<float>(frame.width) ||
@@ -825,31 +912,6 @@ private:
 
                 candidates.push_back(box);
             }
-
-            if (candidates.empty()) return false;
-
-            std::sort(candidates.begin(), candidates.end(),
-                      [](const PersonBox& a, const PersonBox& b) { return a.score > b.score; });
-
-            std::vector<PersonBox> kept;
-            kept.reserve(16);
-            constexpr double kNmsIouThreshold = 0.45;
-            for (const auto& cand : candidates) {
-                bool suppressed = false;
-                for (const auto& k : kept) {
-                    if (iou(cand, k) > kNmsIouThreshold) {
-                        suppressed = true;
-                        break;
-                    }
-                }
-                if (!suppressed) {
-                    kept.push_back(cand);
-                }
-                if (kept.size() >= 16) break;
-            }
-
-            if (kept.empty()) return false;
-            out = kept.front();
             return true;
         }
 
@@ -878,8 +940,6 @@ private:
         count = std::max(0, std::min(200, count));
         if (count <= 0) return false;
 
-        PersonBox best;
-        double bestScore = cfg_.personScoreThreshold;
         for (int i = 0; i < count; i++) {
             const double score = static_cast<double>(scores->data.f[i]);
             if (score < cfg_.personScoreThreshold) continue;
@@ -894,10 +954,12 @@ private:
 
             PersonBox candidate;
             candidate.valid = true;
-            candidate.x = std::max(0, std::min(frame.width - 1, static_cast<int>(std::floor(xMinN * frame.width))));
-            candidate.y = std::max(0, std::min(frame.height - 1, static_cast<int>(std::floor(yMinN * frame.height))));
-            const int x2 = std::max(0, std::min(frame.width, static_cast<int>(std::ceil(xMaxN * frame.width))));
-            const int y2 = std::max(0, std::min(frame.height, static_cast<int>(std::ceil(yMaxN * frame.height))));
+            candidate.x = std::max(0, std::min(frame.width - 1,
+                                               tile.x + static_cast<int>(std::floor(xMinN * tile.w))));
+            candidate.y = std::max(0, std::min(frame.height - 1,
+                                               tile.y + static_cast<int>(std::floor(yMinN * tile.h))));
+            const int x2 = std::max(0, std::min(frame.width, tile.x + static_cast<int>(std::ceil(xMaxN * tile.w))));
+            const int y2 = std::max(0, std::min(frame.height, tile.y + static_cast<int>(std::ceil(yMaxN * tile.h))));
             candidate.w = std::max(0, x2 - candidate.x);
             candidate.h = std::max(0, y2 - candidate.y);
             candidate.ts = nowMs;
@@ -907,16 +969,11 @@ private:
             if (cfg_.inferOnMotionOnly && motion.valid && iou(candidate, motion) < 0.02) {
                 continue;
             }
-            if (score > bestScore) {
-                bestScore = score;
-                best = candidate;
-            }
+            candidates.push_back(candidate);
         }
-        if (!best.valid) return false;
-        out = best;
         return true;
-#endif
     }
+#endif
 
     PersonBox heldBox(int64_t nowMs) {
         if (!lastBox_.valid) return {};
@@ -942,8 +999,14 @@ private:
     bool hasPrev_ = false;
     int64_t lastDetectedMs_ = 0;
     int64_t lastInferMs_ = std::numeric_limits<int64_t>::min() / 2;
+    int64_t lastInferUs_ = 0;
+    bool lastHadMotion_ = false;
+    int inferTiles_ = 1;
     PersonBox lastBox_;
     std::vector<uint8_t> prevLuma_;
+    std::vector<uint8_t> curLuma_;
+    std::vector<uint8_t> motionCells_;
+    MotionZones zones_;
 #ifdef REALLIVE_HAS_OPENCV
     cv::Mat prevSmall_;
     cv::Mat trackTemplate_;
@@ -960,11 +1023,12 @@ private:
     bool tfliteYoloChannelsFirst_ = true;
     int tfliteYoloPredCount_ = 0;
 #ifdef REALLIVE_HAS_TFLITE
-    std::unique_ptr<tflite::FlatBufferModel> tfliteModel_;
+    std::shared_ptr<tflite::FlatBufferModel> tfliteModel_;
     std::unique_ptr<tflite::Interpreter> tfliteInterpreter_;
     int tfliteInputTensor_ = 0;
     int tfliteInputW_ = 320;
     int tfliteInputH_ = 320;
+    std::vector<uint8_t> rgbScratch_;
 #endif
 };
 
@@ -1032,309 +1096,154 @@ private:
     std::string path_;
 };
 
-bool parseCpuCountersLine(const std::string& line, std::string& label, CpuCounters& counters) {
-    std::istringstream iss(line);
-    uint64_t user = 0;
-    uint64_t nice = 0;
-    uint64_t system = 0;
-    uint64_t idle = 0;
-    uint64_t iowait = 0;
-    uint64_t irq = 0;
-    uint64_t softirq = 0;
-    uint64_t steal = 0;
-    uint64_t guest = 0;
-    uint64_t guestNice = 0;
-    iss >> label >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal >> guest >> guestNice;
-    if (label.empty()) return false;
-    if (!iss && !iss.eof()) return false;
-    if (label.rfind("cpu", 0) != 0) return false;
-
-    counters.idle = idle + iowait;
-    counters.total = user + nice + system + idle + iowait + irq + softirq + steal + guest + guestNice;
-    counters.valid = true;
-    return true;
+TelemetryPerson toTelemetryPerson(const PersonBox& box) {
+    TelemetryPerson p;
+    p.active = box.valid;
+    p.score = box.score;
+    p.ts = box.ts;
+    p.x = box.x;
+    p.y = box.y;
+    p.w = box.w;
+    p.h = box.h;
+    return p;
 }
 
-CpuStatSnapshot readCpuStatSnapshot() {
-    std::ifstream file("/proc/stat");
-    if (!file.is_open()) return {};
-
-    CpuStatSnapshot snapshot;
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-        if (line.rfind("cpu", 0) != 0) {
-            if (snapshot.total.valid) break;
-            continue;
-        }
-
-        std::string label;
-        CpuCounters counters;
-        if (!parseCpuCountersLine(line, label, counters)) continue;
-        if (label == "cpu") {
-            snapshot.total = counters;
-            continue;
-        }
-        if (label.size() <= 3) continue;
-        const std::string suffix = label.substr(3);
-        if (suffix.empty() || !std::all_of(suffix.begin(), suffix.end(),
-                                            [](unsigned char c) { return std::isdigit(c) != 0; })) {
-            continue;
-        }
-        const size_t coreIndex = static_cast<size_t>(std::stoul(suffix));
-        if (coreIndex >= snapshot.cores.size()) {
-            snapshot.cores.resize(coreIndex + 1);
-        }
-        snapshot.cores[coreIndex] = counters;
+TelemetrySnapshot buildTelemetrySnapshot(
+    const PusherConfig& config,
+    const SystemTelemetry& telemetry,
+    int64_t nowMs,
+    const PersonBox& personState,
+    const std::vector<PersonBox>& personEvents,
+    const DetectionScheduler::Snapshot& detectSched
+) {
+    TelemetrySnapshot snap;
+    snap.tsMs = nowMs;
+    snap.streamKey = config.stream.streamKey;
+    snap.width = config.camera.width;
+    snap.height = config.camera.height;
+    snap.fps = config.camera.fps;
+    snap.bitrate = config.encoder.bitrate;
+    snap.gop = config.encoder.gopSize;
+    snap.pixelFormat = config.camera.pixelFormat;
+    snap.codec = config.encoder.codec;
+    snap.profile = config.encoder.profile;
+    snap.audioEnabled = config.enableAudio;
+    snap.tfliteEnabled = config.detection.useTfliteSsd;
+    snap.inferOnMotionOnly = config.detection.inferOnMotionOnly;
+    snap.personScoreThreshold = config.detection.personScoreThreshold;
+    snap.device = telemetry;
+    snap.detectSched = detectSched;
+    snap.person = toTelemetryPerson(personState);
+    snap.events.reserve(personEvents.size());
+    for (const auto& evt : personEvents) {
+        snap.events.push_back(toTelemetryPerson(evt));
     }
-    return snapshot;
+    return snap;
 }
 
-class SystemUsageSampler {
-public:
-    SystemTelemetry sample() {
-        SystemTelemetry telemetry;
-
-        CpuStatSnapshot current = readCpuStatSnapshot();
-        if (current.total.valid && previousTotal_.valid && current.total.total > previousTotal_.total) {
-            const double totalDelta = static_cast<double>(current.total.total - previousTotal_.total);
-            const double idleDelta = static_cast<double>(current.total.idle - previousTotal_.idle);
-            telemetry.cpuPct = clampPercent((1.0 - idleDelta / totalDelta) * 100.0);
-        } else {
-            telemetry.cpuPct = 0.0;
-        }
-        if (current.total.valid) {
-            previousTotal_ = current.total;
-        }
-
-        telemetry.cpuCorePct.assign(current.cores.size(), 0.0);
-        for (size_t i = 0; i < current.cores.size(); i++) {
-            const CpuCounters& core = current.cores[i];
-            if (!core.valid) continue;
-            if (i >= previousCores_.size()) continue;
-            const CpuCounters& prevCore = previousCores_[i];
-            if (!prevCore.valid || core.total <= prevCore.total) continue;
-            const double totalDelta = static_cast<double>(core.total - prevCore.total);
-            const double idleDelta = static_cast<double>(core.idle - prevCore.idle);
-            telemetry.cpuCorePct[i] = clampPercent((1.0 - idleDelta / totalDelta) * 100.0);
-        }
-        previousCores_ = current.cores;
-
-        std::ifstream memFile("/proc/meminfo");
-        if (memFile.is_open()) {
-            std::string key;
-            uint64_t valueKb = 0;
-            std::string unit;
-            uint64_t memTotalKb = 0;
-            uint64_t memAvailableKb = 0;
-            while (memFile >> key >> valueKb >> unit) {
-                if (key == "MemTotal:") memTotalKb = valueKb;
-                if (key == "MemAvailable:") memAvailableKb = valueKb;
-                if (memTotalKb > 0 && memAvailableKb > 0) break;
-            }
-
-            if (memTotalKb > 0) {
-                const uint64_t memUsedKb = memTotalKb > memAvailableKb ? (memTotalKb - memAvailableKb) : 0;
-                telemetry.memoryTotalMb = static_cast<double>(memTotalKb) / 1024.0;
-                telemetry.memoryUsedMb = static_cast<double>(memUsedKb) / 1024.0;
-                telemetry.memoryPct = clampPercent(static_cast<double>(memUsedKb) * 100.0 / static_cast<double>(memTotalKb));
-            }
-        }
-
-        try {
-            const auto space = std::filesystem::space("/");
-            if (space.capacity > 0) {
-                const uint64_t used = space.capacity > space.available ? (space.capacity - space.available) : 0;
-                telemetry.storageTotalGb = static_cast<double>(space.capacity) / (1024.0 * 1024.0 * 1024.0);
-                telemetry.storageUsedGb = static_cast<double>(used) / (1024.0 * 1024.0 * 1024.0);
-                telemetry.storagePct = clampPercent(static_cast<double>(used) * 100.0 / static_cast<double>(space.capacity));
-            }
-        } catch (...) {
-        }
-
-        return telemetry;
-    }
-
-private:
-    CpuCounters previousTotal_;
-    std::vector<CpuCounters> previousCores_;
-};
-
-void appendSeiField(std::vector<uint8_t>& rbsp, int value) {
-    while (value >= 0xFF) {
-        rbsp.push_back(0xFF);
-        value -= 0xFF;
-    }
-    rbsp.push_back(static_cast<uint8_t>(value));
+int64_t steadyClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
 }
 
-std::vector<uint8_t> escapeRbsp(const std::vector<uint8_t>& rbsp) {
-    std::vector<uint8_t> ebsp;
-    ebsp.reserve(rbsp.size() + 16);
-    int zeroCount = 0;
-    for (uint8_t b : rbsp) {
-        if (zeroCount >= 2 && b <= 0x03) {
-            ebsp.push_back(0x03);
-            zeroCount = 0;
-        }
-        ebsp.push_back(b);
-        zeroCount = (b == 0x00) ? (zeroCount + 1) : 0;
-    }
-    return ebsp;
+uint32_t clampStageUs(int64_t us) {
+    if (us <= 0) return 0;
+    return static_cast<uint32_t>(std::min<int64_t>(us, std::numeric_limits<uint32_t>::max()));
 }
 
-bool isAnnexBPacket(const std::vector<uint8_t>& data) {
-    if (data.size() >= 4) {
-        if (data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x01) return true;
-        if (data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x00 && data[3] == 0x01) return true;
-    }
-    const size_t limit = std::min<size_t>(data.size(), 32);
-    for (size_t i = 0; i + 3 < limit; ++i) {
-        if (data[i] == 0x00 && data[i + 1] == 0x00 &&
-            (data[i + 2] == 0x01 || (data[i + 2] == 0x00 && data[i + 3] == 0x01))) {
-            return true;
-        }
-    }
-    return false;
+// Stage times of |packet| as of now (send thread, right before sending). The
+// steady-clock sensor time is mapped onto the wall clock by its age.
+FrameTiming buildFrameTiming(const EncodedPacket& packet, int64_t lastSendUs) {
+    const int64_t steadyNow = steadyClockUs();
+    const int64_t wallNow = SeiTimestamp::nowUs();
+    const int64_t sensorSteady = packet.sensorTime > 0 ? packet.sensorTime : packet.captureTime;
+
+    FrameTiming timing;
+    timing.sensorUs = wallNow - (steadyNow - sensorSteady);
+    timing.sentUs = wallNow;
+    timing.captureUs = clampStageUs(packet.captureTime - sensorSteady);
+    timing.overlayUs = clampStageUs(packet.overlayTime);
+    timing.encodeUs = clampStageUs(packet.encodeTime);
+    timing.queueUs = clampStageUs(steadyNow - packet.queuedAt);
+    timing.sendUs = clampStageUs(lastSendUs);
+    timing.frameSeq = packet.frameSeq;
+    return timing;
 }
 
-std::string buildTelemetryPayload(
-    const PusherConfig& config,
-    const SystemTelemetry& telemetry,
-    int64_t nowMs,
-    const PersonBox& personState,
-    const std::vector<PersonBox>& personEvents
-) {
-    std::ostringstream oss;
-    oss << "{"
-        << "\"v\":1,"
-        << "\"ts\":" << nowMs << ","
-        << "\"stream_key\":\"" << jsonEscape(config.stream.streamKey) << "\","
-        << "\"device\":{"
-            << "\"cpu_pct\":" << formatNumber(telemetry.cpuPct) << ","
-            << "\"cpu_core_pct\":[";
-    for (size_t i = 0; i < telemetry.cpuCorePct.size(); i++) {
-        if (i) oss << ",";
-        oss << formatNumber(telemetry.cpuCorePct[i]);
-    }
-    oss << "],"
-            << "\"mem_pct\":" << formatNumber(telemetry.memoryPct) << ","
-            << "\"mem_used_mb\":" << formatNumber(telemetry.memoryUsedMb) << ","
-            << "\"mem_total_mb\":" << formatNumber(telemetry.memoryTotalMb) << ","
-            << "\"storage_pct\":" << formatNumber(telemetry.storagePct) << ","
-            << "\"storage_used_gb\":" << formatNumber(telemetry.storageUsedGb, 2) << ","
-            << "\"storage_total_gb\":" << formatNumber(telemetry.storageTotalGb, 2)
-        << "},"
-        << "\"camera\":{"
-            << "\"width\":" << config.camera.width << ","
-            << "\"height\":" << config.camera.height << ","
-            << "\"fps\":" << config.camera.fps << ","
-            << "\"pixel_format\":\"" << jsonEscape(config.camera.pixelFormat) << "\","
-            << "\"codec\":\"" << jsonEscape(config.encoder.codec) << "\","
-            << "\"bitrate\":" << config.encoder.bitrate << ","
-            << "\"profile\":\"" << jsonEscape(config.encoder.profile) << "\","
-            << "\"gop\":" << config.encoder.gopSize << ","
-            << "\"audio_enabled\":" << (config.enableAudio ? "true" : "false") << ","
-            << "\"detect_tflite_enabled\":" << (config.detection.useTfliteSsd ? "true" : "false") << ","
-            << "\"detect_infer_on_motion_only\":" << (config.detection.inferOnMotionOnly ? "true" : "false") << ","
-            << "\"detect_person_score_threshold\":" << formatNumber(config.detection.personScoreThreshold, 2)
-        << "},"
-        << "\"configurable\":{"
-            << "\"resolution\":["
-                << "{\"width\":640,\"height\":480},"
-                << "{\"width\":1280,\"height\":720},"
-                << "{\"width\":1920,\"height\":1080}"
-            << "],"
-            << "\"fps\":[10,15,24,25,30,50,60],"
-            << "\"profile\":[\"baseline\",\"main\",\"high\"],"
-            << "\"bitrate\":{\"min\":300000,\"max\":8000000,\"step\":100000},"
-            << "\"gop\":{\"min\":10,\"max\":120,\"step\":5},"
-            << "\"person_score_threshold\":{\"min\":0.3,\"max\":0.95,\"step\":0.01},"
-            << "\"detect_infer_interval_ms\":{\"min\":10,\"max\":1000,\"step\":10}"
-        << "},"
-        << "\"person\":{"
-            << "\"active\":" << (personState.valid ? "true" : "false") << ","
-            << "\"score\":" << formatNumber(personState.score, 3) << ","
-            << "\"ts\":" << personState.ts << ","
-            << "\"bbox\":{"
-                << "\"x\":" << personState.x << ","
-                << "\"y\":" << personState.y << ","
-                << "\"w\":" << personState.w << ","
-                << "\"h\":" << personState.h
-            << "}"
-        << "},"
-        << "\"events\":[";
-    for (size_t i = 0; i < personEvents.size(); i++) {
-        if (i) oss << ",";
-        const auto& evt = personEvents[i];
-        oss << "{"
-            << "\"type\":\"person_detected\","
-            << "\"ts\":" << evt.ts << ","
-            << "\"score\":" << formatNumber(evt.score, 3) << ","
-            << "\"bbox\":{"
-                << "\"x\":" << evt.x << ","
-                << "\"y\":" << evt.y << ","
-                << "\"w\":" << evt.w << ","
-                << "\"h\":" << evt.h
-            << "}"
-            << "}";
-    }
-    oss << "]"
-        << "}";
-    return oss.str();
+// Asks the kernel to start reading the model file so the detector's load
+// on the detect thread finds it in the page cache instead of on the SD card.
+void prefetchDetectorModel(const DetectionConfig& cfg) {
+#ifdef REALLIVE_HAS_TFLITE
+    if (!cfg.useTfliteSsd || cfg.tfliteModelPath.empty()) return;
+    const int fd = ::open(cfg.tfliteModelPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+#else
+    (void)cfg;
+#endif
 }
 
-void injectTelemetrySei(std::vector<uint8_t>& packet, const std::string& payload) {
-    if (packet.empty() || payload.empty()) return;
-
-    const int payloadSize = static_cast<int>(kTelemetrySeiUuid.size() + payload.size());
-    std::vector<uint8_t> rbsp;
-    rbsp.reserve(payload.size() + 32);
-    rbsp.push_back(0x06);
-    appendSeiField(rbsp, 5);
-    appendSeiField(rbsp, payloadSize);
-    rbsp.insert(rbsp.end(), kTelemetrySeiUuid.begin(), kTelemetrySeiUuid.end());
-    rbsp.insert(rbsp.end(), payload.begin(), payload.end());
-    rbsp.push_back(0x80);
-
-    const std::vector<uint8_t> ebsp = escapeRbsp(rbsp);
-    std::vector<uint8_t> prefix;
-    if (isAnnexBPacket(packet)) {
-        prefix.reserve(4 + ebsp.size());
-        prefix.push_back(0x00);
-        prefix.push_back(0x00);
-        prefix.push_back(0x00);
-        prefix.push_back(0x01);
-        prefix.insert(prefix.end(), ebsp.begin(), ebsp.end());
-    } else {
-        const uint32_t naluSize = static_cast<uint32_t>(ebsp.size());
-        prefix.reserve(4 + ebsp.size());
-        prefix.push_back(static_cast<uint8_t>((naluSize >> 24) & 0xFF));
-        prefix.push_back(static_cast<uint8_t>((naluSize >> 16) & 0xFF));
-        prefix.push_back(static_cast<uint8_t>((naluSize >> 8) & 0xFF));
-        prefix.push_back(static_cast<uint8_t>(naluSize & 0xFF));
-        prefix.insert(prefix.end(), ebsp.begin(), ebsp.end());
-    }
-
-    packet.insert(packet.begin(), prefix.begin(), prefix.end());
-}
+// Frame slot and results shared by the video loop and one detect thread.
+// Shared ownership lets the watchdog abandon a hung detect thread: it keeps
+// its channel alive and, should detect() ever return, sees `abandoned` and
+// exits before any side effect. The thread holds nothing of the Pipeline
+// itself, only shared or copied state, since it may outlive it.
+struct DetectChannel {
+    DetectChannel(int deadlineMs, MetricsRegistry* metrics) : watchdog("detector", deadlineMs, metrics) {}
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+    bool abandoned = false;
+    bool frameReady = false;
+    Frame frame;
+    int64_t frameTsMs = 0;
+    uint32_t frameId = 0;
+    PersonBox latestPerson;
+    std::vector<PersonBox> pendingEvents;
+    uint32_t trackSeq = 0;  // carried over to a respawned thread
+    int64_t detectorLoadUs = -1;  // set once the detector is built
+    StageWatchdog watchdog; // armed only while detect() runs
+};
 
 } // namespace
 
-Pipeline::Pipeline() = default;
+Pipeline::Pipeline() {
+    metrics_.counterFn("reallive_frames_sent_total", "Video packets sent to the streaming server",
+                       [this]() { return static_cast<double>(getFramesSent()); });
+    metrics_.counterFn("reallive_bytes_sent_total", "Video bytes sent to the streaming server",
+                       [this]() { return static_cast<double>(getBytesSent()); });
+    metrics_.gaugeFn("reallive_fps", "Video packets sent per second",
+                     [this]() { return currentFps_.load(); });
+    metrics_.gaugeFn("reallive_live_push_active", "1 while the RTMP push is connected",
+                     [this]() { return isLivePushActive() ? 1.0 : 0.0; });
+    metrics_.gaugeFn("reallive_push_destinations_connected", "Extra push destinations currently connected",
+                     [this]() {
+                         double connected = 0;
+                         for (const PushOutputPtr& output : pushOutputs()) {
+                             if (output != primary_ && output->isConnected()) connected++;
+                         }
+                         return connected;
+                     });
+}
 
 Pipeline::~Pipeline() {
     stop();
 }
 
 bool Pipeline::createComponents(const PusherConfig& config) {
-    // Create platform-specific implementations for Raspberry Pi 5
-    camera_ = std::make_unique<LibcameraCapture>();
-    encoder_ = std::make_unique<AvcodecEncoder>();
-    streamer_ = std::make_unique<RtmpStreamer>();
+    ComponentRegistry& registry = ComponentRegistry::instance();
+    camera_ = registry.createCamera(config.camera.backend);
+    encoder_ = registry.createEncoder(config.encoder.backend);
+    if (!camera_ || !encoder_) {
+        return false;
+    }
 
     if (config.enableAudio) {
-        audio_ = std::make_unique<AlsaCapture>();
+        // An unknown backend is treated like a missing device: no audio.
+        audio_ = registry.createAudio(config.audio.backend);
     }
 
     return true;
@@ -1348,23 +1257,40 @@ bool Pipeline::init(const PusherConfig& config) {
         return false;
     }
 
-    // Initialize camera
-    if (!camera_->open(config.camera)) {
+    // Camera, encoder and audio device share nothing, so they open side by
+    // side and init costs the slowest of them rather than the sum.
+    const int64_t initStartUs = steadyClockUs();
+    prefetchDetectorModel(config.detection);
+    auto cameraOpen = std::async(std::launch::async, [&]() {
+        const bool ok = camera_->open(config.camera);
+        if (ok) noteStartupPhase("camera_open", initStartUs);
+        return ok;
+    });
+    std::future<bool> audioOpen;
+    if (config.enableAudio && audio_) {
+        audioOpen = std::async(std::launch::async, [&]() {
+            const bool ok = audio_->open(config.audio);
+            if (ok) noteStartupPhase("audio_open", initStartUs);
+            return ok;
+        });
+    }
+    const bool encoderOk = encoder_->init(config.encoder);
+    if (encoderOk) noteStartupPhase("encoder_init", initStartUs);
+    const bool cameraOk = cameraOpen.get();
+    const bool audioOk = audioOpen.valid() && audioOpen.get();
+
+    if (!cameraOk) {
         std::cerr << "[Pipeline] Failed to open camera" << std::endl;
         return false;
     }
     std::cout << "[Pipeline] Camera opened: " << camera_->getName() << std::endl;
-
-    // Initialize encoder
-    if (!encoder_->init(config.encoder)) {
+    if (!encoderOk) {
         std::cerr << "[Pipeline] Failed to init encoder" << std::endl;
         return false;
     }
     std::cout << "[Pipeline] Encoder initialized: " << encoder_->getName() << std::endl;
-
-    // Initialize audio if enabled
     if (config.enableAudio && audio_) {
-        if (!audio_->open(config.audio)) {
+        if (!audioOk) {
             std::cerr << "[Pipeline] Failed to open audio (continuing without audio)" << std::endl;
             audio_.reset();
         } else {
@@ -1376,38 +1302,83 @@ bool Pipeline::init(const PusherConfig& config) {
     // Pass encoder extradata (SPS/PPS) to the streamer for FLV header
     auto* avEncoder = dynamic_cast<AvcodecEncoder*>(encoder_.get());
     if (avEncoder) {
-        config_.stream.videoExtraData = avEncoder->getExtraData();
-        config_.stream.videoExtraDataSize = avEncoder->getExtraDataSize();
+        // Own copy: the encoder's buffer goes away if the watchdog reinits it.
+        const uint8_t* extraData = avEncoder->getExtraData();
+        videoExtraData_.assign(extraData, extraData + std::max(0, avEncoder->getExtraDataSize()));
+        config_.stream.videoExtraData = videoExtraData_.data();
+        config_.stream.videoExtraDataSize = static_cast<int>(videoExtraData_.size());
         config_.stream.videoWidth = config.encoder.width;
         config_.stream.videoHeight = config.encoder.height;
+        config_.stream.videoBitrate = config.encoder.bitrate;
     }
 
-    // Connect to streaming server
-    if (!streamer_->connect(config_.stream)) {
-        std::cerr << "[Pipeline] Failed to connect to server: "
-                  << config.stream.url << std::endl;
+    // Live push connects on its own send thread, started here so the RTMP
+    // handshake overlaps the rest of init and camera start. An unreachable
+    // server only costs the live view; recording goes ahead regardless.
+    PushDestinationConfig primary;
+    primary.name = "primary";
+    primary.url = config_.stream.url;
+    primary.streamKey = config_.stream.streamKey;
+    primary.queueMax = config_.push.queueMax;
+    primary.dropPolicy = config_.push.dropPolicy;
+    std::string error;
+    primary_ = makePushOutput(primary, error);
+    if (!primary_) {
+        std::cerr << "[Pipeline] " << error << std::endl;
         return false;
     }
-    livePushDesired_ = true;
-    livePushActive_ = true;
-    std::cout << "[Pipeline] Connected to: " << config.stream.url << std::endl;
+    primary_->start();
+    std::cout << "[Pipeline] Live push connecting in background: " << config.stream.url << std::endl;
+
+    {
+        std::lock_guard<std::mutex> lock(outputsMutex_);
+        destinations_.clear();
+    }
+    for (const PushDestinationConfig& dest : config_.push.destinations) {
+        if (!addPushDestination(dest, error)) {
+            std::cerr << "[Pipeline] Push destination '" << dest.name << "' skipped: " << error << std::endl;
+        }
+    }
 
     if (config_.record.enabled) {
-        recorder_ = std::make_unique<LocalRecorder>();
+        const int64_t recorderStartUs = steadyClockUs();
+        recorder_ = std::make_shared<LocalRecorder>();
         if (!recorder_->init(
                 config_.record,
                 config_.stream.streamKey,
                 config_.stream.videoExtraData,
                 config_.stream.videoExtraDataSize,
                 config_.encoder.width,
-                config_.encoder.height)) {
+                config_.encoder.height,
+                config_.encoder.bitrate,
+                &metrics_)) {
             std::cerr << "[Pipeline] Failed to init local recorder" << std::endl;
             recorder_.reset();
+        } else {
+            noteStartupPhase("recorder_init", recorderStartUs);
         }
     } else {
         recorder_.reset();
     }
 
+    lanFlv_.reset();
+    if (config_.lanFlv.enabled) {
+        lanFlv_ = std::make_unique<LiveFlvServer>();
+        lanFlvOptions_ = LiveFlvServer::Options{};
+        lanFlvOptions_.host = config_.lanFlv.host;
+        lanFlvOptions_.port = config_.lanFlv.port;
+        lanFlvOptions_.streamKey = config_.stream.streamKey;
+        lanFlvOptions_.maxSubscribers = static_cast<size_t>(config_.lanFlv.maxClients);
+        lanFlvOptions_.queueBytes = static_cast<size_t>(config_.lanFlv.queueKb) * 1024;
+        if (config_.stream.videoExtraData && config_.stream.videoExtraDataSize > 0) {
+            lanFlvOptions_.extraData.assign(config_.stream.videoExtraData,
+                                            config_.stream.videoExtraData + config_.stream.videoExtraDataSize);
+        }
+        lanFlvOptions_.width = config_.encoder.width;
+        lanFlvOptions_.height = config_.encoder.height;
+        lanFlvOptions_.metrics = &metrics_;
+    }
+
     return true;
 }
 
@@ -1418,10 +1389,12 @@ bool Pipeline::start() {
     }
 
     // Start camera capture
+    cameraStartUs_ = steadyClockUs();
     if (!camera_->start()) {
         std::cerr << "[Pipeline] Failed to start camera" << std::endl;
         return false;
     }
+    noteStartupPhase("camera_start", cameraStartUs_);
 
     // Start audio capture
     if (audio_ && !audio_->start()) {
@@ -1429,9 +1402,16 @@ bool Pipeline::start() {
         audio_.reset();
     }
 
+    if (lanFlv_ && !lanFlv_->start(lanFlvOptions_)) {
+        std::cerr << "[Pipeline] LAN FLV server failed to start (continuing without it)" << std::endl;
+        lanFlv_.reset();
+    }
+
     running_ = true;
-    framesSent_ = 0;
-    bytesSent_ = 0;
+    for (const PushOutputPtr& output : pushOutputs()) {
+        output->start();
+    }
+    SystemSampler::instance().start();
 
     // Launch video capture/encode/stream thread
     videoThread_ = std::thread(&Pipeline::videoLoop, this);
@@ -1456,18 +1436,18 @@ void Pipeline::stop() {
     if (audioThread_.joinable()) {
         audioThread_.join();
     }
+    SystemSampler::instance().stop();
 
     // Stop components in reverse order
-    if (streamer_) {
-        std::lock_guard<std::mutex> lock(streamerMutex_);
-        if (streamer_->isConnected()) {
-            streamer_->disconnect();
-        }
-        livePushActive_ = false;
+    for (const PushOutputPtr& output : pushOutputs()) {
+        output->stop();
     }
     if (recorder_) {
         recorder_->close();
     }
+    if (lanFlv_) {
+        lanFlv_->stop();
+    }
     if (audio_ && audio_->isOpen()) {
         audio_->stop();
     }
@@ -1478,81 +1458,143 @@ void Pipeline::stop() {
         camera_->stop();
     }
 
-    std::cout << "[Pipeline] Stopped. Frames sent: " << framesSent_.load()
-              << ", Bytes sent: " << bytesSent_.load() << std::endl;
+    std::cout << "[Pipeline] Stopped. Frames sent: " << getFramesSent()
+              << ", Bytes sent: " << getBytesSent() << std::endl;
 }
 
 void Pipeline::videoLoop() {
     using Clock = std::chrono::steady_clock;
+    Tracer::instance().setThreadName("video");
     auto lastFpsTime = Clock::now();
     auto lastLogTime = Clock::now();
     auto lastSeiTime = Clock::now() - std::chrono::milliseconds(2000);
-    uint64_t droppedFrames = 0;
-    uint64_t totalProcessTime = 0;
     uint64_t maxProcessTime = 0;
-    SystemUsageSampler usageSampler;
+    SystemTelemetry lastTelemetry;
+    TelemetrySeiEncoder telemetrySei;
+    bool firstFrameNoted = false;
+
+    // Hot-path metrics (see /metrics). Registration is idempotent, so a
+    // restarted loop keeps accumulating into the same series.
+    Histogram& captureWaitHist = metrics_.histogram(
+        "reallive_capture_wait_seconds", "Time the video loop waited for a captured frame");
+    Histogram& overlayHist = metrics_.histogram(
+        "reallive_overlay_seconds", "Overlay compositing time per frame");
+    Histogram& encodeHist = metrics_.histogram(
+        "reallive_encode_seconds", "Encoder time per frame");
+    Histogram& seiHist = metrics_.histogram(
+        "reallive_sei_seconds", "Telemetry/timing SEI build and inject time");
+    Histogram& recordHist = metrics_.histogram(
+        "reallive_record_write_seconds", "Local recorder write time per packet");
+    Histogram& processHist = metrics_.histogram(
+        "reallive_frame_process_seconds", "Video loop time per frame, capture wait included");
+    // Shared: a detect thread keeps its histograms after the watchdog abandons it.
+    const auto detectHist = metrics_.sharedHistogram(
+        "reallive_detect_seconds", "Detector time per offered frame");
+    const auto inferHist = metrics_.sharedHistogram(
+        "reallive_infer_seconds", "Model inference time per detector run that invoked it");
+    Counter& slowFrames = metrics_.counter(
+        "reallive_slow_frames_total", "Frames that took over two frame intervals to process");
+    Counter& captureDropped = metrics_.counter(
+        "reallive_capture_dropped_total", "Captured frames dropped before processing");
+    Counter& sendDropped = metrics_.counter(
+        "reallive_send_dropped_total", "Encoded packets dropped before sending");
+    Counter& recordErrors = metrics_.counter(
+        "reallive_record_write_errors_total", "Packets the local recorder failed to write");
+    Counter& detectSkipped = metrics_.counter(
+        "reallive_detect_skipped_total", "Frames not offered to the detector due to encode overrun");
+    Gauge& captureQueueDepth = metrics_.gauge(
+        "reallive_capture_queue_depth", "Frames waiting in the capture queue");
+    Gauge& telemetrySeiBytes = metrics_.gauge(
+        "reallive_telemetry_sei_bytes", "Payload size of the last telemetry SEI");
 
     std::mutex captureMutex;
     std::condition_variable captureCv;
     std::deque<Frame> captureQueue;
     constexpr size_t kCaptureQueueMax = 2;
-    std::atomic<uint64_t> captureDropped{0};
-    std::atomic<uint64_t> sendDropped{0};
-
-    std::mutex sendMutex;
-    std::condition_variable sendCv;
-    std::deque<EncodedPacket> sendQueue;
-    constexpr size_t kSendQueueMax = 4;
-    bool sendStop = false;
 
-    PersonBox latestPerson;
-    std::vector<PersonBox> pendingPersonEvents;
-
-    std::mutex detectMutex;
-    std::condition_variable detectCv;
-    bool detectStop = false;
-    bool detectFrameReady = false;
-    Frame detectFrame;
-    int64_t detectFrameTsMs = 0;
+    // The scheduler outlives the loop when a hung detect thread is abandoned.
+    const auto detectScheduler = std::make_shared<DetectionScheduler>(config_.detection, config_.camera.fps);
+    std::shared_ptr<DetectChannel> detect;
     std::thread detectThread;
-    if (config_.detection.enabled) {
-        detectThread = std::thread([&]() {
-            MotionPersonDetector personDetector(config_.detection);
-            DetectionEventJournal detectionJournal;
-            detectionJournal.init(config_);
+    bool detectorLoadNoted = false;
+    auto spawnDetector = [&](uint32_t trackSeq) {
+        detect = std::make_shared<DetectChannel>(config_.watchdog.detectorMs, &metrics_);
+        detect->trackSeq = trackSeq;
+        auto journal = std::make_shared<DetectionEventJournal>();
+        journal->init(config_);
+        detectThread = std::thread([channel = detect, scheduler = detectScheduler, journal,
+                                    recorder = recorder_, sink = eventSink_,
+                                    detectHist, inferHist, detection = config_.detection,
+                                    eventOnMotion = config_.record.eventOnMotion]() {
+            Tracer::instance().setThreadName("detect");
+            const int64_t detectorLoadStartUs = steadyClockUs();
+            MotionPersonDetector personDetector(detection);
+            {
+                std::lock_guard<std::mutex> lock(channel->mutex);
+                channel->detectorLoadUs = steadyClockUs() - detectorLoadStartUs;
+            }
             bool personPresent = false;
             int64_t lastPersonGoneMs = 0;
-            const int64_t personRearmMs = std::max<int64_t>(200, config_.detection.eventMinIntervalMs);
+            const int64_t personRearmMs = std::max<int64_t>(200, detection.eventMinIntervalMs);
 
             while (true) {
                 Frame localFrame;
                 int64_t localTs = 0;
+                uint32_t localFrameId = 0;
                 {
-                    std::unique_lock<std::mutex> lock(detectMutex);
-                    detectCv.wait(lock, [&]() { return detectStop || detectFrameReady; });
-                    if (detectStop && !detectFrameReady) {
+                    std::unique_lock<std::mutex> lock(channel->mutex);
+                    channel->cv.wait(lock, [&]() { return channel->stop || channel->frameReady; });
+                    if (channel->stop && !channel->frameReady) {
                         break;
                     }
-                    localFrame = std::move(detectFrame);
-                    localTs = detectFrameTsMs;
-                    detectFrameReady = false;
+                    localFrame = std::move(channel->frame);
+                    localTs = channel->frameTsMs;
+                    localFrameId = channel->frameId;
+                    channel->frameReady = false;
                 }
+                FrameRecycler recycleLocal(localFrame);
 
                 if (localFrame.empty()) continue;
 
-                const PersonBox person = personDetector.detect(localFrame, localTs);
+                personDetector.setCadence(scheduler->cadence());
+                const auto detectStart = std::chrono::steady_clock::now();
+                PersonBox person;
+                channel->watchdog.beat();
+                {
+                    TraceSpan span("detect", localFrameId);
+                    person = personDetector.detect(localFrame, localTs);
+                }
+                channel->watchdog.idle();
+                const int64_t detectUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - detectStart).count();
+                const int64_t inferUs = personDetector.lastInferUs();
 
                 bool shouldWriteEvent = false;
                 {
-                    std::lock_guard<std::mutex> lock(detectMutex);
-                    latestPerson = person;
+                    std::lock_guard<std::mutex> lock(channel->mutex);
+                    if (channel->abandoned) {
+                        break;  // replaced by the watchdog; the result is stale
+                    }
+                    scheduler->recordDetect(detectUs, inferUs);
+                    detectHist->observe(detectUs);
+                    if (inferUs > 0) inferHist->observe(inferUs);
+                    if (recorder && recorder->isEventMode() &&
+                        (person.valid || (eventOnMotion && personDetector.lastHadMotion()))) {
+                        recorder->markEvent();
+                    }
+                    if (person.valid) {
+                        // A new track starts whenever a person appears after an absence.
+                        if (!personPresent) channel->trackSeq++;
+                        person.trackId = channel->trackSeq;
+                    }
+                    channel->latestPerson = person;
                     if (person.valid) {
                         const bool rearmed = (lastPersonGoneMs <= 0) ||
                                              (localTs - lastPersonGoneMs >= personRearmMs);
                         if (!personPresent && rearmed) {
-                            pendingPersonEvents.push_back(person);
-                            if (pendingPersonEvents.size() > 8) {
-                                pendingPersonEvents.erase(pendingPersonEvents.begin());
+                            channel->pendingEvents.push_back(person);
+                            if (channel->pendingEvents.size() > 8) {
+                                channel->pendingEvents.erase(channel->pendingEvents.begin());
                             }
                             shouldWriteEvent = true;
                         }
@@ -1565,95 +1607,86 @@ void Pipeline::videoLoop() {
                     }
                 }
                 if (shouldWriteEvent) {
-                    detectionJournal.writePersonDetected(person, localTs);
+                    journal->writePersonDetected(person, localTs);
+                    DetectionEvent event;
+                    event.tsMs = person.ts > 0 ? person.ts : localTs;
+                    event.score = person.score;
+                    event.x = person.x;
+                    event.y = person.y;
+                    event.w = person.w;
+                    event.h = person.h;
+                    event.trackId = person.trackId;
+                    std::lock_guard<std::mutex> lock(sink->mutex);
+                    if (sink->handler) sink->handler(event);
                 }
             }
         });
+    };
+    if (config_.detection.enabled) {
+        spawnDetector(0);
     }
 
+    // Camera and encoder deadlines; the detector's lives in its channel.
+    StageWatchdog cameraWatchdog("camera", config_.watchdog.cameraMs, &metrics_);
+    StageWatchdog encoderWatchdog("encoder", config_.watchdog.encoderMs, &metrics_);
+    cameraWatchdog.beat();
+    encoderWatchdog.beat();
+    int encoderMisses = 0;
+
     std::thread captureThread([&]() {
+        Tracer::instance().setThreadName("capture");
         while (running_) {
-            Frame frame = camera_->captureFrame();
+            Frame frame;
+            {
+                TraceSpan span("captureFrame");
+                frame = camera_->captureFrame();
+            }
             if (frame.empty()) {
+                // Only this thread touches the camera while running, so the
+                // reopen happens here; the video loop keeps waiting meanwhile.
+                if (cameraWatchdog.overdue()) {
+                    std::cerr << "[Pipeline] No frame from the camera for " << cameraWatchdog.stalledMs()
+                              << "ms, reopening it" << std::endl;
+                    cameraWatchdog.restarted(reopenCamera());
+                }
                 continue;
             }
+            cameraWatchdog.beat();
             {
                 std::lock_guard<std::mutex> lock(captureMutex);
                 if (captureQueue.size() >= kCaptureQueueMax) {
+                    FramePool::instance().release(std::move(captureQueue.front().data));
                     captureQueue.pop_front();
                     captureDropped++;
                 }
                 captureQueue.push_back(std::move(frame));
+                captureQueueDepth.set(static_cast<double>(captureQueue.size()));
             }
             captureCv.notify_one();
         }
         captureCv.notify_all();
     });
 
-    std::thread sendThread([&]() {
-        while (true) {
-            EncodedPacket packet;
-            {
-                std::unique_lock<std::mutex> lock(sendMutex);
-                sendCv.wait(lock, [&]() { return sendStop || !sendQueue.empty(); });
-                if (sendStop && sendQueue.empty()) {
-                    break;
-                }
-                packet = std::move(sendQueue.front());
-                sendQueue.pop_front();
-            }
-            if (packet.empty()) continue;
-
-            if (!livePushDesired_.load()) {
-                sendDropped++;
-                continue;
-            }
-
-            bool sentOk = false;
-            {
-                std::lock_guard<std::mutex> streamLock(streamerMutex_);
-                if (!livePushDesired_.load()) {
-                    sendDropped++;
-                    continue;
-                }
-                if (!streamer_->isConnected()) {
-                    if (!streamer_->connect(config_.stream)) {
-                        livePushActive_ = false;
-                        std::cerr << "[Pipeline] Failed to reconnect streamer, dropping packet" << std::endl;
-                        continue;
-                    }
-                    livePushActive_ = true;
-                    std::cout << "[Pipeline] RTMP push resumed" << std::endl;
-                }
-
-                if (!streamer_->sendVideoPacket(packet)) {
-                    std::cerr << "[Pipeline] Failed to send video packet" << std::endl;
-                    if (!streamer_->isConnected()) {
-                        livePushActive_ = false;
-                    }
-                } else {
-                    sentOk = true;
-                }
-            }
-
-            if (!sentOk) continue;
-            framesSent_++;
-            bytesSent_ += packet.data.size();
-        }
-    });
-
     const auto seiInterval = std::chrono::milliseconds(1000);
 
     const auto maxProcessThreshold = std::chrono::microseconds(1000000 / config_.camera.fps * 2); // 允许最大2倍帧间隔
-    
-    // 统计窗口
-    const int statsWindow = config_.camera.fps * 5; // 5秒统计窗口
-    std::vector<uint64_t> processTimes;
-    processTimes.reserve(statsWindow);
+
+    // 统计窗口：每次打印时与上次的直方图快照做差
+    Histogram::Snapshot lastProcessSnapshot = processHist.snapshot();
     uint64_t lastCaptureWait = 0;
     uint64_t lastFramesSentForFps = 0;
     constexpr int64_t kOverlayFreshMs = 160;
 
+    // Overlay layers, drawn bottom to top.
+    enum OverlayLayer { kOverlayTracks = 0, kOverlayCameraName = 1, kOverlayTimestamp = 2 };
+    constexpr int kOverlayMargin = 16;
+    OverlayCompositor overlay(config_.overlay.scale);
+    if (!config_.overlay.cameraName.empty()) {
+        overlay.setLayer(kOverlayCameraName, {OverlayText{kOverlayMargin, kOverlayMargin, config_.overlay.cameraName}});
+    }
+    time_t overlaySecond = -1;
+    uint32_t frameSeq = 0;
+
     while (running_) {
         auto frameStart = Clock::now();
 
@@ -1666,6 +1699,7 @@ void Pipeline::videoLoop() {
             });
             auto waitEnd = Clock::now();
             lastCaptureWait = std::chrono::duration_cast<std::chrono::microseconds>(waitEnd - waitStart).count();
+            captureWaitHist.observe(static_cast<int64_t>(lastCaptureWait));
             if (!running_ && captureQueue.empty()) {
                 break;
             }
@@ -1673,145 +1707,245 @@ void Pipeline::videoLoop() {
                 continue;
             }
             frame = std::move(captureQueue.back());
+            captureQueue.pop_back();
+            for (Frame& stale : captureQueue) {
+                FramePool::instance().release(std::move(stale.data));
+            }
             captureQueue.clear();
+            captureQueueDepth.set(0.0);
         }
         if (frame.empty()) {
             continue;
         }
+        FrameRecycler recycleFrame(frame);
 
         auto captureTime = Clock::now();
+        const uint32_t frameId = ++frameSeq;
         const int64_t frameTsMs = normalizeFrameTimestampMs(frame.pts);
 
-        if (config_.detection.enabled) {
-            Frame frameForDetect = frame;
+        if (detect && detect->watchdog.overdue()) {
+            // A thread cannot be killed; leave the hung one behind with its
+            // own channel and carry on with a fresh detector.
+            std::cerr << "[Pipeline] Detector stuck for " << detect->watchdog.stalledMs()
+                      << "ms, respawning it" << std::endl;
+            uint32_t trackSeq = 0;
             {
-                std::lock_guard<std::mutex> lock(detectMutex);
-                detectFrame = std::move(frameForDetect);
-                detectFrameTsMs = frameTsMs;
-                detectFrameReady = true;
+                std::lock_guard<std::mutex> lock(detect->mutex);
+                detect->abandoned = true;
+                detect->stop = true;
+                trackSeq = detect->trackSeq;
+            }
+            detect->cv.notify_all();
+            detect->watchdog.restarted(true);
+            detectThread.detach();
+            spawnDetector(trackSeq);
+        }
+
+        if (detect && !detectorLoadNoted) {
+            int64_t loadUs = -1;
+            {
+                std::lock_guard<std::mutex> lock(detect->mutex);
+                loadUs = detect->detectorLoadUs;
+            }
+            if (loadUs >= 0) {
+                recordStartupPhase("detector_load", loadUs);
+                detectorLoadNoted = true;
+            }
+        }
+
+        if (detect) {
+            // Encode latency has priority: while the last encode overran the
+            // frame interval, skip the copy and leave the detector idle.
+            if (detectScheduler->shouldOfferFrame()) {
+                Frame frameForDetect;
+                frameForDetect.data = FramePool::instance().acquire(frame.data.size());
+                std::memcpy(frameForDetect.data.data(), frame.data.data(), frame.data.size());
+                frameForDetect.width = frame.width;
+                frameForDetect.height = frame.height;
+                frameForDetect.stride = frame.stride;
+                frameForDetect.pts = frame.pts;
+                frameForDetect.pixelFormat = frame.pixelFormat;
+                {
+                    std::lock_guard<std::mutex> lock(detect->mutex);
+                    // Not picked up yet: the detector is busy, hand the
+                    // unconsumed copy back before replacing it.
+                    FramePool::instance().release(std::move(detect->frame.data));
+                    detect->frame = std::move(frameForDetect);
+                    detect->frameTsMs = frameTsMs;
+                    detect->frameId = frameId;
+                    detect->frameReady = true;
+                }
+                detect->cv.notify_one();
+            } else {
+                detectScheduler->noteSkippedFrame();
+                detectSkipped++;
             }
-            detectCv.notify_one();
 
             PersonBox person;
             {
-                std::lock_guard<std::mutex> lock(detectMutex);
-                person = latestPerson;
+                std::lock_guard<std::mutex> lock(detect->mutex);
+                person = detect->latestPerson;
             }
             const int64_t overlayAgeMs = std::llabs(frameTsMs - person.ts);
             if (person.valid && config_.detection.drawOverlay && overlayAgeMs <= kOverlayFreshMs) {
-                TextOverlay::drawBoundingBox(
-                    frame.data.data(),
-                    frame.width,
-                    frame.height,
-                    person.x,
-                    person.y,
-                    person.w,
-                    person.h
-                );
+                std::vector<OverlayText> labels;
+                if (config_.overlay.trackLabels) {
+                    char label[48];
+                    std::snprintf(label, sizeof(label), "#%u person %.2f", person.trackId, person.score);
+                    // Above the box, or inside its top edge when there is no room.
+                    const int labelY = person.y >= overlay.textBoxHeight() ? person.y - overlay.textBoxHeight()
+                                                                           : std::max(0, person.y);
+                    labels.push_back(OverlayText{std::max(0, person.x), labelY, label});
+                }
+                overlay.setLayer(kOverlayTracks, labels, {OverlayRect{person.x, person.y, person.w, person.h, 3}});
+            } else {
+                overlay.clearLayer(kOverlayTracks);
             }
         }
 
-        // 2. Draw timestamp overlay on frame before encoding
-        TextOverlay::drawTimestamp(frame.data.data(), frame.width, frame.height);
+        // 2. Burn in overlays (timestamp re-rendered once per second) before encoding
+        const time_t wallSecond = time(nullptr);
+        if (wallSecond != overlaySecond) {
+            struct tm lt;
+            localtime_r(&wallSecond, &lt);
+            // strftime is bounded and reports overflow (0) instead of
+            // truncating, which snprintf over int fields could not rule out.
+            char stamp[32];
+            if (std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &lt) == 0) stamp[0] = '\0';
+            overlay.setLayer(kOverlayTimestamp, {OverlayText{
+                frame.width - overlay.textBoxWidth(stamp) - kOverlayMargin,
+                frame.height - overlay.textBoxHeight() - kOverlayMargin,
+                stamp}});
+            overlaySecond = wallSecond;
+        }
+        auto overlayStart = Clock::now();
+        {
+            TraceSpan span("overlay", frameId);
+            overlay.composite(frame.data.data(), frame.width, frame.height);
+        }
+        auto overlayEnd = Clock::now();
+        overlayHist.observe(std::chrono::duration_cast<std::chrono::microseconds>(overlayEnd - overlayStart).count());
 
         // 3. Encode the frame
         auto encodeStart = Clock::now();
-        EncodedPacket packet = encoder_->encode(frame);
+        EncodedPacket packet;
+        {
+            TraceSpan span("encode", frameId);
+            packet = encoder_->encode(frame);
+        }
         auto encodeEnd = Clock::now();
-        
+        encodeHist.observe(std::chrono::duration_cast<std::chrono::microseconds>(encodeEnd - encodeStart).count());
+
         if (packet.empty()) {
+            // A frame or two of encoder delay is normal; a run of empty
+            // results past the deadline means the encoder has failed.
+            if (++encoderMisses >= config_.camera.fps && encoderWatchdog.overdue()) {
+                std::cerr << "[Pipeline] Encoder produced nothing for " << encoderWatchdog.stalledMs()
+                          << "ms, reinitializing it" << std::endl;
+                encoderWatchdog.restarted(reinitEncoder());
+                encoderMisses = 0;
+            }
             continue;
         }
+        encoderMisses = 0;
+        encoderWatchdog.beat();
 
         // Record timing information for latency tracking
         packet.captureTime = std::chrono::duration_cast<std::chrono::microseconds>(captureTime.time_since_epoch()).count();
         packet.encodeTime = std::chrono::duration_cast<std::chrono::microseconds>(encodeEnd - encodeStart).count();
+        packet.sensorTime = frame.pts;
+        packet.overlayTime = std::chrono::duration_cast<std::chrono::microseconds>(overlayEnd - overlayStart).count();
+        packet.frameSeq = frameId;
+        detectScheduler->recordEncode(packet.encodeTime);
 
         auto now = Clock::now();
-        if (now - lastSeiTime >= seiInterval) {
-            const SystemTelemetry telemetry = usageSampler.sample();
+        // Telemetry rides on one packet per second; keyframes additionally
+        // carry a key message (static fields + absolute values) every few
+        // seconds so viewers that join mid-stream can decode the deltas.
+        const bool telemetryDue = now - lastSeiTime >= seiInterval;
+        const int64_t telemetryNowMs = wallClockMs();
+        if (recorder_ && recorder_->isEnabled() && recorder_->startsSegment(packet)) {
+            telemetrySei.requestKeyMessage();
+        }
+        if (telemetryDue || telemetrySei.wantsKeyMessage(packet.isKeyframe, telemetryNowMs)) {
+            if (telemetryDue) {
+                lastTelemetry = SystemSampler::instance().latest();
+                detectScheduler->update(lastTelemetry.cpuPct);
+                lastSeiTime = now;
+            }
             PersonBox personSnapshot;
             std::vector<PersonBox> eventSnapshot;
-            if (config_.detection.enabled) {
-                std::lock_guard<std::mutex> lock(detectMutex);
-                personSnapshot = latestPerson;
-                eventSnapshot = pendingPersonEvents;
-                pendingPersonEvents.clear();
+            if (detect) {
+                std::lock_guard<std::mutex> lock(detect->mutex);
+                personSnapshot = detect->latestPerson;
+                eventSnapshot = std::move(detect->pendingEvents);
+                detect->pendingEvents.clear();
             }
-            const std::string payload = buildTelemetryPayload(
+            TraceSpan span("injectTelemetrySei", frameId);
+            const auto seiStart = Clock::now();
+            telemetrySei.inject(packet, buildTelemetrySnapshot(
                 config_,
-                telemetry,
-                wallClockMs(),
+                lastTelemetry,
+                telemetryNowMs,
                 personSnapshot,
-                eventSnapshot
-            );
-            injectTelemetrySei(packet.data, payload);
-            lastSeiTime = now;
+                eventSnapshot,
+                detectScheduler->snapshot()
+            ));
+            seiHist.observe(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - seiStart).count());
+            telemetrySeiBytes.set(static_cast<double>(telemetrySei.lastPayloadSize()));
         }
 
         if (recorder_ && recorder_->isEnabled()) {
-            if (!recorder_->writeVideoPacket(packet)) {
-                static uint64_t recorderErrCount = 0;
-                recorderErrCount++;
-                if (recorderErrCount % 30 == 1) {
-                    std::cerr << "[Pipeline] Recorder write failed (" << recorderErrCount
+            TraceSpan span("writeVideoPacket", frameId);
+            const auto recordStart = Clock::now();
+            const bool recorded = recorder_->writeVideoPacket(packet);
+            recordHist.observe(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - recordStart).count());
+            if (!recorded) {
+                recordErrors++;
+                if (recordErrors.value() % 30 == 1) {
+                    std::cerr << "[Pipeline] Recorder write failed (" << recordErrors.value()
                               << "), continuing stream" << std::endl;
                 }
             }
         }
 
-        {
-            std::lock_guard<std::mutex> lock(sendMutex);
-            if (sendQueue.size() >= kSendQueueMax) {
-                size_t dropIdx = 0;
-                bool foundNonKey = false;
-                for (size_t i = 0; i < sendQueue.size(); i++) {
-                    if (!sendQueue[i].isKeyframe) {
-                        dropIdx = i;
-                        foundNonKey = true;
-                        break;
-                    }
-                }
-                if (!foundNonKey) {
-                    dropIdx = 0;
-                }
-                auto dropIt = sendQueue.begin();
-                std::advance(dropIt, static_cast<long>(dropIdx));
-                sendQueue.erase(dropIt);
-                sendDropped++;
-            }
-            sendQueue.push_back(std::move(packet));
+        if (lanFlv_) {
+            lanFlv_->publish(packet);
+        }
+        if (!firstFrameNoted) {
+            noteStartupPhase("first_frame", cameraStartUs_);
+            firstFrameNoted = true;
+        }
+
+        // Every output queues the same packet; none of them can block this loop.
+        packet.queuedAt = steadyClockUs();
+        const auto shared = std::make_shared<const EncodedPacket>(std::move(packet));
+        for (const PushOutputPtr& output : pushOutputs()) {
+            output->pushVideo(shared);
         }
-        sendCv.notify_one();
 
         // 计算处理时间
         auto frameEnd = Clock::now();
         auto processTime = std::chrono::duration_cast<std::chrono::microseconds>(frameEnd - frameStart);
         auto encodeTime = std::chrono::duration_cast<std::chrono::microseconds>(encodeEnd - encodeStart);
-        
-        totalProcessTime += processTime.count();
+
+        processHist.observe(processTime.count());
         maxProcessTime = std::max(maxProcessTime, static_cast<uint64_t>(processTime.count()));
-        
-        // 保持统计窗口
-        processTimes.push_back(processTime.count());
-        if (processTimes.size() > static_cast<size_t>(statsWindow)) {
-            processTimes.erase(processTimes.begin());
-        }
 
         // 如果持续处理慢，记录丢帧
         if (processTime > maxProcessThreshold) {
-            droppedFrames++;
-            if (droppedFrames % 30 == 0) {
-                std::cerr << "[Pipeline] WARNING: Frame processing too slow (" 
-                          << processTime.count() / 1000 << "ms), dropped " 
-                          << droppedFrames << " frames so far" << std::endl;
+            slowFrames++;
+            if (slowFrames.value() % 30 == 0) {
+                std::cerr << "[Pipeline] WARNING: Frame processing too slow ("
+                          << processTime.count() / 1000 << "ms), dropped "
+                          << slowFrames.value() << " frames so far" << std::endl;
             }
         }
 
         // 每秒计算FPS和打印详细统计
         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastFpsTime);
         if (elapsed.count() >= 1000) {
-            const uint64_t sentNow = framesSent_.load();
+            const uint64_t sentNow = getFramesSent();
             const uint64_t sentDelta = sentNow >= lastFramesSentForFps ? (sentNow - lastFramesSentForFps) : 0;
             currentFps_ = static_cast<double>(sentDelta) * 1000.0 / elapsed.count();
             lastFramesSentForFps = sentNow;
@@ -1821,28 +1955,19 @@ void Pipeline::videoLoop() {
         // 每5秒打印详细性能统计
         auto logElapsed = std::chrono::duration_cast<std::chrono::seconds>(now - lastLogTime);
         if (logElapsed.count() >= 5) {
-            // 计算平均处理时间
-            uint64_t avgProcessTime = 0;
-            if (!processTimes.empty()) {
-                uint64_t sum = 0;
-                for (auto t : processTimes) sum += t;
-                avgProcessTime = sum / processTimes.size();
-            }
-            
-            // 计算P99延迟
-            uint64_t p99Time = 0;
-            if (!processTimes.empty()) {
-                std::vector<uint64_t> sorted = processTimes;
-                std::sort(sorted.begin(), sorted.end());
-                p99Time = sorted[static_cast<size_t>(sorted.size() * 0.99)];
-            }
+            // 平均处理时间与 P99 取自本窗口的直方图增量
+            const Histogram::Snapshot processSnapshot = processHist.snapshot();
+            const Histogram::Snapshot processWindow = processSnapshot.since(lastProcessSnapshot);
+            lastProcessSnapshot = processSnapshot;
+            const uint64_t avgProcessTime = static_cast<uint64_t>(processWindow.meanUs());
+            const uint64_t p99Time = processWindow.quantileUs(0.99);
 
             std::cout << "[Pipeline Stats] FPS: " << std::fixed << std::setprecision(1) << currentFps_
-                      << " | Frame: " << framesSent_.load()
-                      << " | Bytes: " << (bytesSent_.load() / 1024 / 1024) << " MB"
-                      << " | Dropped: " << droppedFrames
-                      << " | CaptureDrop: " << captureDropped.load()
-                      << " | SendDrop: " << sendDropped.load()
+                      << " | Frame: " << getFramesSent()
+                      << " | Bytes: " << (getBytesSent() / 1024 / 1024) << " MB"
+                      << " | Dropped: " << slowFrames.value()
+                      << " | CaptureDrop: " << captureDropped.value()
+                      << " | SendDrop: " << sendDropped.value()
                       << " | CaptureWait: " << lastCaptureWait / 1000 << "ms"
                       << " | Encode: " << encodeTime.count() / 1000 << "ms"
                       << " | AvgProcess: " << avgProcessTime / 1000 << "ms"
@@ -1850,7 +1975,6 @@ void Pipeline::videoLoop() {
                       << " | P99: " << p99Time / 1000 << "ms" << std::endl;
             
             lastLogTime = now;
-            totalProcessTime = 0;
             maxProcessTime = 0;
         }
     }
@@ -1864,22 +1988,13 @@ void Pipeline::videoLoop() {
         captureThread.join();
     }
 
-    {
-        std::lock_guard<std::mutex> lock(sendMutex);
-        sendStop = true;
-    }
-    sendCv.notify_all();
-    if (sendThread.joinable()) {
-        sendThread.join();
-    }
-
-    if (config_.detection.enabled) {
+    if (detect) {
         {
-            std::lock_guard<std::mutex> lock(detectMutex);
-            detectStop = true;
-            detectFrameReady = false;
+            std::lock_guard<std::mutex> lock(detect->mutex);
+            detect->stop = true;
+            detect->frameReady = false;
         }
-        detectCv.notify_one();
+        detect->cv.notify_one();
         if (detectThread.joinable()) {
             detectThread.join();
         }
@@ -1887,39 +2002,15 @@ void Pipeline::videoLoop() {
 }
 
 void Pipeline::audioLoop() {
+    Tracer::instance().setThreadName("audio");
     while (running_ && audio_) {
         AudioFrame audioFrame = audio_->captureFrame();
         if (audioFrame.empty()) {
             continue;
         }
-
-        if (!livePushDesired_.load()) {
-            continue;
-        }
-
-        bool sendOk = false;
-        {
-            std::lock_guard<std::mutex> streamLock(streamerMutex_);
-            if (!livePushDesired_.load()) {
-                continue;
-            }
-            if (!streamer_->isConnected()) {
-                if (streamer_->connect(config_.stream)) {
-                    livePushActive_ = true;
-                    std::cout << "[Pipeline] RTMP push resumed (audio loop)" << std::endl;
-                } else {
-                    livePushActive_ = false;
-                    continue;
-                }
-            }
-            sendOk = streamer_->sendAudioPacket(audioFrame);
-            if (!sendOk && !streamer_->isConnected()) {
-                livePushActive_ = false;
-            }
-        }
-
-        if (!sendOk) {
-            std::cerr << "[Pipeline] Failed to send audio packet" << std::endl;
+        const auto shared = std::make_shared<const AudioFrame>(std::move(audioFrame));
+        for (const PushOutputPtr& output : pushOutputs()) {
+            output->pushAudio(shared);
         }
     }
 }
@@ -1929,11 +2020,11 @@ bool Pipeline::isRunning() const {
 }
 
 uint64_t Pipeline::getFramesSent() const {
-    return framesSent_;
+    return primary_ ? primary_->packetsSent() : 0;
 }
 
 uint64_t Pipeline::getBytesSent() const {
-    return bytesSent_;
+    return primary_ ? primary_->bytesSent() : 0;
 }
 
 double Pipeline::getCurrentFps() const {
@@ -1941,38 +2032,161 @@ double Pipeline::getCurrentFps() const {
 }
 
 bool Pipeline::setLivePushEnabled(bool enabled) {
-    livePushDesired_ = enabled;
-    if (!streamer_) return false;
+    if (!primary_) return false;
+    return primary_->setEnabled(enabled);
+}
+
+bool Pipeline::isLivePushEnabled() const {
+    return primary_ ? primary_->isEnabled() : true;
+}
 
-    std::lock_guard<std::mutex> lock(streamerMutex_);
-    if (!enabled) {
-        if (streamer_->isConnected()) {
-            streamer_->disconnect();
+bool Pipeline::isLivePushActive() const {
+    return primary_ && primary_->isConnected();
+}
+
+PushOutputPtr Pipeline::makePushOutput(const PushDestinationConfig& dest, std::string& error) {
+    PushOutput::Options options;
+    options.name = dest.name;
+    options.stream = config_.stream;
+    options.stream.url = dest.url;
+    options.stream.streamKey = dest.streamKey;
+    options.queueMax = static_cast<size_t>(std::max(1, dest.queueMax));
+    options.enabled = dest.enabled;
+    if (!PushOutput::parseDropPolicy(dest.dropPolicy, options.dropPolicy)) {
+        error = "unknown drop policy '" + dest.dropPolicy + "'";
+        return nullptr;
+    }
+    options.metrics = &metrics_;
+    if (dest.name == "primary") {
+        // Keeps the series the single-output pipeline always exported.
+        options.metricPrefix = "reallive_send";
+    } else {
+        std::string id;
+        for (char c : dest.name) {
+            id.push_back(std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::tolower(c)) : '_');
         }
-        livePushActive_ = false;
-        return true;
+        options.metricPrefix = "reallive_push_" + id;
+    }
+    if (config_.stream.latencySei) {
+        Histogram* seiHist = &metrics_.histogram(
+            "reallive_sei_seconds", "Telemetry/timing SEI build and inject time");
+        options.beforeSend = [seiHist](EncodedPacket& packet, int64_t lastSendUs) {
+            TraceSpan span("injectTimingSei", packet.frameSeq);
+            const int64_t seiStartUs = steadyClockUs();
+            SeiTimestamp::inject(packet, buildFrameTiming(packet, lastSendUs));
+            seiHist->observe(steadyClockUs() - seiStartUs);
+        };
+    }
+    // udp:// and rtp:// go out as MPEG-TS / RTP for LAN walls, anything else over RTMP.
+    StreamerPtr streamer;
+    if (UdpStreamer::handlesUrl(dest.url)) {
+        streamer = std::make_unique<UdpStreamer>();
+    } else {
+        streamer = std::make_unique<RtmpStreamer>();
     }
+    return std::make_shared<PushOutput>(std::move(options), std::move(streamer));
+}
 
-    if (!running_) {
-        return true;
+std::vector<PushOutputPtr> Pipeline::pushOutputs() const {
+    std::vector<PushOutputPtr> outputs;
+    std::lock_guard<std::mutex> lock(outputsMutex_);
+    outputs.reserve(destinations_.size() + 1);
+    if (primary_) outputs.push_back(primary_);
+    outputs.insert(outputs.end(), destinations_.begin(), destinations_.end());
+    return outputs;
+}
+
+void Pipeline::noteStartupPhase(const char* phase, int64_t sinceUs) {
+    recordStartupPhase(phase, steadyClockUs() - sinceUs);
+}
+
+void Pipeline::recordStartupPhase(const char* phase, int64_t elapsedUs) {
+    metrics_.gauge(std::string("reallive_startup_") + phase + "_seconds",
+                   "Startup phase duration, from the start of init or of camera start")
+        .set(static_cast<double>(elapsedUs) / 1e6);
+    std::cout << "[Pipeline] Startup " << phase << ": " << elapsedUs / 1000 << "ms" << std::endl;
+}
+
+bool Pipeline::reopenCamera() {
+    camera_->stop();
+    camera_->close();
+    if (!camera_->open(config_.camera) || !camera_->start()) {
+        std::cerr << "[Pipeline] Camera reopen failed, retrying after the next deadline" << std::endl;
+        return false;
+    }
+    std::cout << "[Pipeline] Camera reopened: " << camera_->getName() << std::endl;
+    return true;
+}
+
+bool Pipeline::reinitEncoder() {
+    if (!encoder_->init(config_.encoder)) {
+        std::cerr << "[Pipeline] Encoder reinit failed, retrying after the next deadline" << std::endl;
+        return false;
     }
+    std::cout << "[Pipeline] Encoder reinitialized, resuming on an IDR" << std::endl;
+    return true;
+}
 
-    if (!streamer_->isConnected()) {
-        if (!streamer_->connect(config_.stream)) {
-            livePushActive_ = false;
+bool Pipeline::addPushDestination(const PushDestinationConfig& dest, std::string& error) {
+    if (dest.name.empty() || dest.url.empty()) {
+        error = "name and url are required";
+        return false;
+    }
+    if (dest.name == "primary") {
+        error = "'primary' is reserved";
+        return false;
+    }
+    for (char c : dest.name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+            error = "name may only contain letters, digits, '-' and '_'";
             return false;
         }
     }
-    livePushActive_ = streamer_->isConnected();
-    return livePushActive_;
+    PushOutputPtr output = makePushOutput(dest, error);
+    if (!output) return false;
+    {
+        std::lock_guard<std::mutex> lock(outputsMutex_);
+        for (const PushOutputPtr& existing : destinations_) {
+            if (existing->name() == dest.name) {
+                error = "destination '" + dest.name + "' already exists";
+                return false;
+            }
+        }
+        destinations_.push_back(output);
+    }
+    // Connects from its own thread on the first packet; a dead ingest never
+    // blocks the caller or the other outputs.
+    if (running_) output->start();
+    std::cout << "[Pipeline] Push destination added: " << dest.name << " -> " << dest.url << std::endl;
+    return true;
 }
 
-bool Pipeline::isLivePushEnabled() const {
-    return livePushDesired_.load();
+bool Pipeline::removePushDestination(const std::string& name) {
+    PushOutputPtr removed;
+    {
+        std::lock_guard<std::mutex> lock(outputsMutex_);
+        for (auto it = destinations_.begin(); it != destinations_.end(); ++it) {
+            if ((*it)->name() == name) {
+                removed = *it;
+                destinations_.erase(it);
+                break;
+            }
+        }
+    }
+    if (!removed) return false;
+    // The video loop may still hold a snapshot with it; stop() makes any
+    // late packets a no-op.
+    removed->stop();
+    std::cout << "[Pipeline] Push destination removed: " << name << std::endl;
+    return true;
 }
 
-bool Pipeline::isLivePushActive() const {
-    return livePushActive_.load();
+std::vector<PushOutput::Stats> Pipeline::getPushStats() const {
+    std::vector<PushOutput::Stats> stats;
+    for (const PushOutputPtr& output : pushOutputs()) {
+        stats.push_back(output->stats());
+    }
+    return stats;
 }
 
 bool Pipeline::setRecordCleanupPolicy(int minFreePercent, int targetFreePercent) {
@@ -1990,4 +2204,14 @@ bool Pipeline::getRecordCleanupPolicy(int& minFreePercent, int& targetFreePercen
     return true;
 }
 
+bool Pipeline::getLiveRecording(LocalRecorder::LiveSegment& out) {
+    if (!recorder_ || !recorder_->isEnabled()) return false;
+    return recorder_->liveSegment(out);
+}
+
+void Pipeline::setDetectionEventHandler(DetectionEventHandler handler) {
+    std::lock_guard<std::mutex> lock(eventSink_->mutex);
+    eventSink_->handler = std::move(handler);
+}
+
 } // namespace reallive
@@ -0,0 +1,183 @@
+#include "core/PipelineHost.h"
+#include "core/FramePool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace reallive {
+
+namespace {
+
+// Frames in flight per camera: capture queue, the one being encoded and the
+// detector's copy, plus one spare.
+constexpr size_t kPooledFramesPerCamera = 4;
+
+std::string labelValue(const std::string& raw) {
+    std::string out;
+    out.reserve(raw.size());
+    for (char c : raw) {
+        if (c == '\\' || c == '"') out.push_back('\\');
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out.push_back(c);
+    }
+    return out;
+}
+
+// "name{a=\"b\"} 1" -> "name{stream_key=\"k\",a=\"b\"} 1"; "name 1" -> "name{stream_key=\"k\"} 1".
+std::string withStreamKeyLabel(const std::string& sample, const std::string& label) {
+    const size_t space = sample.find(' ');
+    const size_t brace = sample.find('{');
+    if (brace != std::string::npos && (space == std::string::npos || brace < space)) {
+        return sample.substr(0, brace + 1) + label + "," + sample.substr(brace + 1);
+    }
+    if (space == std::string::npos) return sample;
+    return sample.substr(0, space) + "{" + label + "}" + sample.substr(space);
+}
+
+} // namespace
+
+PipelineHost::PipelineHost(const Config& config) {
+    std::vector<PusherConfig> configs = config.cameraConfigs();
+    const size_t count = configs.size();
+    if (count > 1) {
+        // Split the encoder threads between cameras so one busy scene
+        // cannot take every core from the others.
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        const int perCamera = std::max(1, static_cast<int>(cores / count));
+        for (PusherConfig& c : configs) {
+            if (c.encoder.threads <= 0) c.encoder.threads = perCamera;
+        }
+        FramePool::instance().setCapacity(kPooledFramesPerCamera * count);
+    }
+    for (PusherConfig& c : configs) {
+        Camera cam;
+        cam.streamKey = c.stream.streamKey;
+        cam.config = std::move(c);
+        cam.pipeline = std::make_unique<Pipeline>();
+        cameras_.push_back(std::move(cam));
+    }
+}
+
+PipelineHost::~PipelineHost() {
+    stop();
+}
+
+bool PipelineHost::init() {
+    size_t ready = 0;
+    for (Camera& cam : cameras_) {
+        cam.initialized = cam.pipeline->init(cam.config);
+        if (cam.initialized) {
+            ready++;
+        } else if (cameras_.size() > 1) {
+            std::cerr << "[Host] Camera " << cam.streamKey << " failed to initialize, skipping it" << std::endl;
+        }
+    }
+    if (cameras_.size() > 1) {
+        std::cout << "[Host] " << ready << "/" << cameras_.size() << " camera(s) ready" << std::endl;
+    }
+    return ready > 0;
+}
+
+bool PipelineHost::start() {
+    size_t started = 0;
+    for (Camera& cam : cameras_) {
+        if (!cam.initialized) continue;
+        if (cam.pipeline->start()) {
+            started++;
+        } else if (cameras_.size() > 1) {
+            std::cerr << "[Host] Camera " << cam.streamKey << " failed to start" << std::endl;
+        }
+    }
+    return started > 0;
+}
+
+void PipelineHost::stop() {
+    for (Camera& cam : cameras_) {
+        cam.pipeline->stop();
+    }
+}
+
+bool PipelineHost::isRunning() const {
+    return std::any_of(cameras_.begin(), cameras_.end(),
+                       [](const Camera& cam) { return cam.pipeline->isRunning(); });
+}
+
+Pipeline* PipelineHost::find(const std::string& streamKey) const {
+    if (cameras_.empty()) return nullptr;
+    if (streamKey.empty()) return cameras_.front().pipeline.get();
+    for (const Camera& cam : cameras_) {
+        if (cam.streamKey == streamKey) return cam.pipeline.get();
+    }
+    return nullptr;
+}
+
+void PipelineHost::setDetectionEventHandler(HostDetectionEventHandler handler) {
+    for (Camera& cam : cameras_) {
+        const std::string key = cam.streamKey;
+        cam.pipeline->setDetectionEventHandler([handler, key](const DetectionEvent& event) {
+            if (handler) handler(key, event);
+        });
+    }
+}
+
+std::string PipelineHost::renderMetrics() const {
+    if (cameras_.size() == 1) {
+        return cameras_.front().pipeline->metrics().renderPrometheus();
+    }
+
+    // Each pipeline renders the same families; regroup them so HELP/TYPE
+    // appear once per family and the samples differ only by stream_key.
+    struct Family {
+        std::string help;
+        std::string type;
+        std::vector<std::string> samples;
+    };
+    std::vector<std::string> order;
+    std::unordered_map<std::string, Family> families;
+    for (const Camera& cam : cameras_) {
+        const std::string label = "stream_key=\"" + labelValue(cam.streamKey) + "\"";
+        std::istringstream in(cam.pipeline->metrics().renderPrometheus());
+        std::string line;
+        Family* current = nullptr;
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            if (line.rfind("# HELP ", 0) == 0 || line.rfind("# TYPE ", 0) == 0) {
+                const size_t nameStart = 7;
+                const size_t nameEnd = line.find(' ', nameStart);
+                const std::string name = line.substr(nameStart, nameEnd == std::string::npos
+                                                                    ? std::string::npos
+                                                                    : nameEnd - nameStart);
+                auto it = families.find(name);
+                if (it == families.end()) {
+                    order.push_back(name);
+                    it = families.emplace(name, Family{}).first;
+                }
+                current = &it->second;
+                std::string& slot = line[2] == 'H' ? current->help : current->type;
+                if (slot.empty()) slot = line;
+                continue;
+            }
+            if (line[0] == '#' || !current) continue;
+            current->samples.push_back(withStreamKeyLabel(line, label));
+        }
+    }
+
+    std::ostringstream oss;
+    for (const std::string& name : order) {
+        const Family& family = families[name];
+        if (!family.help.empty()) oss << family.help << "\n";
+        if (!family.type.empty()) oss << family.type << "\n";
+        for (const std::string& sample : family.samples) {
+            oss << sample << "\n";
+        }
+    }
+    return oss.str();
+}
+
+} // namespace reallive
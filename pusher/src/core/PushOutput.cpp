@@ -0,0 +1,350 @@
+#include "core/PushOutput.h"
+#include "core/Metrics.h"
+#include "core/Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace reallive {
+
+namespace {
+
+// Audio is small and not worth a policy: past this the oldest frame goes.
+constexpr size_t kAudioQueueMax = 32;
+
+int64_t steadyClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+PushOutput::PushOutput(Options options, StreamerPtr streamer)
+    : options_(std::move(options)), streamer_(std::move(streamer)) {
+    options_.queueMax = std::max<size_t>(1, options_.queueMax);
+    enabled_ = options_.enabled;
+    threadName_ = options_.name.empty() ? "send" : "send:" + options_.name;
+    if (options_.metrics && !options_.metricPrefix.empty()) {
+        const std::string& p = options_.metricPrefix;
+        MetricsRegistry& m = *options_.metrics;
+        queueWaitHist_ = &m.histogram(p + "_queue_wait_seconds", "Time packets wait in the send queue");
+        sendHist_ = &m.histogram(p + "_seconds", "Streamer send time per packet");
+        droppedCounter_ = &m.counter(p + "_dropped_total", "Encoded packets dropped before sending");
+        errorsCounter_ = &m.counter(p + "_errors_total", "Packets the streamer failed to send");
+        queueDepth_ = &m.gauge(p + "_queue_depth", "Packets waiting in the send queue");
+        connectHist_ = &m.histogram(p + "_connect_seconds", "Time spent in connect attempts, failed ones included");
+    }
+}
+
+PushOutput::~PushOutput() {
+    stop();
+}
+
+bool PushOutput::parseDropPolicy(const std::string& text, DropPolicy& out) {
+    if (text.empty() || text == "frame") {
+        out = DropPolicy::Frame;
+        return true;
+    }
+    if (text == "gop") {
+        out = DropPolicy::Gop;
+        return true;
+    }
+    return false;
+}
+
+bool PushOutput::connect() {
+    std::lock_guard<std::mutex> lock(streamerMutex_);
+    if (!enabled_) return true;
+    if (!streamer_->isConnected() && !streamer_->connect(options_.stream)) {
+        connected_ = false;
+        return false;
+    }
+    connected_ = true;
+    needKeyframe_ = true;
+    everConnected_ = true;
+    return true;
+}
+
+void PushOutput::start() {
+    if (running_) return;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = false;
+        queue_.clear();
+        queuedVideo_ = 0;
+        skipToKeyframe_ = false;
+    }
+    packetsSent_ = 0;
+    bytesSent_ = 0;
+    running_ = true;
+    thread_ = std::thread(&PushOutput::sendLoop, this);
+}
+
+void PushOutput::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    queueCv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_ = false;
+
+    std::lock_guard<std::mutex> lock(streamerMutex_);
+    if (streamer_ && streamer_->isConnected()) {
+        streamer_->disconnect();
+    }
+    connected_ = false;
+}
+
+void PushOutput::pushVideo(std::shared_ptr<const EncodedPacket> packet) {
+    if (!packet || packet->empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stopping_ || !running_) return;
+        if (skipToKeyframe_) {
+            if (!packet->isKeyframe) {
+                dropped_++;
+                if (droppedCounter_) droppedCounter_->inc();
+                return;
+            }
+            skipToKeyframe_ = false;
+        }
+        if (queuedVideo_ >= options_.queueMax) {
+            dropForVideo();
+            if (skipToKeyframe_ && !packet->isKeyframe) {
+                dropped_++;
+                if (droppedCounter_) droppedCounter_->inc();
+                return;
+            }
+            skipToKeyframe_ = false;
+        }
+        queue_.push_back({std::move(packet), nullptr, steadyClockUs()});
+        queuedVideo_++;
+        queued_ = queue_.size();
+        if (queueDepth_) queueDepth_->set(static_cast<double>(queuedVideo_));
+    }
+    queueCv_.notify_one();
+}
+
+// Called with queueMutex_ held and the video backlog at queueMax.
+void PushOutput::dropForVideo() {
+    size_t removed = 0;
+    if (options_.dropPolicy == DropPolicy::Gop) {
+        // Everything queued belongs to a GOP the receiver will now see only
+        // part of; drop it all and restart clean on the next keyframe.
+        for (auto it = queue_.begin(); it != queue_.end();) {
+            if (it->video) {
+                it = queue_.erase(it);
+                removed++;
+            } else {
+                ++it;
+            }
+        }
+        queuedVideo_ = 0;
+        skipToKeyframe_ = true;
+    } else {
+        auto victim = queue_.end();
+        for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+            if (!it->video) continue;
+            if (victim == queue_.end()) victim = it;  // oldest, if all are keyframes
+            if (!it->video->isKeyframe) {
+                victim = it;
+                break;
+            }
+        }
+        if (victim != queue_.end()) {
+            queue_.erase(victim);
+            queuedVideo_--;
+            removed = 1;
+        }
+    }
+    dropped_ += removed;
+    if (droppedCounter_) droppedCounter_->inc(removed);
+}
+
+void PushOutput::pushAudio(std::shared_ptr<const AudioFrame> frame) {
+    if (!frame || frame->empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stopping_ || !running_) return;
+        if (queue_.size() - queuedVideo_ >= kAudioQueueMax) {
+            for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+                if (it->audio) {
+                    queue_.erase(it);
+                    break;
+                }
+            }
+        }
+        queue_.push_back({nullptr, std::move(frame), steadyClockUs()});
+        queued_ = queue_.size();
+    }
+    queueCv_.notify_one();
+}
+
+void PushOutput::sendLoop() {
+    Tracer::instance().setThreadName(threadName_.c_str());
+    // Connect before the first packet arrives so the handshake overlaps
+    // camera start-up; nothing upstream ever waits on it.
+    if (enabled_) {
+        std::lock_guard<std::mutex> lock(streamerMutex_);
+        if (enabled_) ensureConnected();
+    }
+    while (true) {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [&]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) break;
+            item = std::move(queue_.front());
+            queue_.pop_front();
+            if (item.video) queuedVideo_--;
+            queued_ = queue_.size();
+            if (queueDepth_) queueDepth_->set(static_cast<double>(queuedVideo_));
+        }
+        if (item.video) {
+            if (queueWaitHist_) queueWaitHist_->observe(steadyClockUs() - item.queuedAt);
+            sendVideo(item);
+        } else {
+            sendAudio(item);
+        }
+    }
+}
+
+bool PushOutput::ensureConnected() {
+    if (streamer_->isConnected()) return true;
+    if (connected_.exchange(false)) {
+        std::cerr << "[Push:" << options_.name << "] Connection lost" << std::endl;
+    }
+    const int64_t now = steadyClockUs();
+    if (now < nextConnectUs_) return false;
+    const bool ok = streamer_->connect(options_.stream);
+    const int64_t connectUs = steadyClockUs() - now;
+    if (connectHist_) connectHist_->observe(connectUs);
+    if (ok) {
+        connected_ = true;
+        needKeyframe_ = true;
+        backoffMs_ = 0;
+        if (everConnected_) {
+            reconnects_++;
+            std::cout << "[Push:" << options_.name << "] Push resumed" << std::endl;
+        } else {
+            std::cout << "[Push:" << options_.name << "] Connected to " << options_.stream.url << " in "
+                      << connectUs / 1000 << "ms" << std::endl;
+        }
+        everConnected_ = true;
+        return true;
+    }
+    // Back off so a dead destination costs one connect attempt per interval,
+    // not one (blocking) attempt per packet.
+    backoffMs_ = backoffMs_ == 0 ? options_.reconnectMinMs : std::min(options_.reconnectMaxMs, backoffMs_ * 2);
+    nextConnectUs_ = steadyClockUs() + static_cast<int64_t>(backoffMs_) * 1000;
+    std::cerr << "[Push:" << options_.name << "] " << (everConnected_ ? "Reconnect" : "Connect")
+              << " failed, retrying in " << backoffMs_
+              << "ms" << std::endl;
+    return false;
+}
+
+void PushOutput::sendVideo(const Item& item) {
+    auto drop = [this]() {
+        dropped_++;
+        if (droppedCounter_) droppedCounter_->inc();
+    };
+    if (!enabled_) {
+        drop();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(streamerMutex_);
+    if (!enabled_ || !ensureConnected()) {
+        drop();
+        return;
+    }
+    if (needKeyframe_) {
+        if (!item.video->isKeyframe) {
+            drop();
+            return;
+        }
+        needKeyframe_ = false;
+    }
+
+    const EncodedPacket* packet = item.video.get();
+    if (options_.beforeSend) {
+        // The shared packet stays untouched; stamped_ keeps its capacity, so
+        // after the first packet this is a plain copy with no allocation.
+        stamped_ = *item.video;
+        options_.beforeSend(stamped_, lastSendUs_);
+        packet = &stamped_;
+    }
+    const int64_t sendStartUs = steadyClockUs();
+    const bool ok = streamer_->sendVideoPacket(*packet);
+    lastSendUs_ = steadyClockUs() - sendStartUs;
+    Tracer::instance().record("sendVideoPacket", sendStartUs, sendStartUs + lastSendUs_, packet->frameSeq);
+    if (sendHist_) sendHist_->observe(lastSendUs_);
+    if (!ok) {
+        errors_++;
+        if (errorsCounter_) errorsCounter_->inc();
+        std::cerr << "[Push:" << options_.name << "] Failed to send video packet" << std::endl;
+        if (!streamer_->isConnected()) connected_ = false;
+        return;
+    }
+    packetsSent_++;
+    bytesSent_ += packet->size();
+}
+
+void PushOutput::sendAudio(const Item& item) {
+    if (!enabled_) return;
+    std::lock_guard<std::mutex> lock(streamerMutex_);
+    if (!enabled_ || !ensureConnected()) return;
+    if (!streamer_->sendAudioPacket(*item.audio)) {
+        std::cerr << "[Push:" << options_.name << "] Failed to send audio packet" << std::endl;
+        if (!streamer_->isConnected()) connected_ = false;
+    }
+}
+
+bool PushOutput::setEnabled(bool enabled) {
+    enabled_ = enabled;
+    std::lock_guard<std::mutex> lock(streamerMutex_);
+    if (!enabled) {
+        if (streamer_->isConnected()) {
+            streamer_->disconnect();
+        }
+        connected_ = false;
+        return true;
+    }
+    if (!running_) {
+        return true;
+    }
+    if (!streamer_->isConnected()) {
+        if (!streamer_->connect(options_.stream)) {
+            connected_ = false;
+            return false;
+        }
+        needKeyframe_ = true;
+        everConnected_ = true;
+        backoffMs_ = 0;
+        nextConnectUs_ = 0;
+    }
+    connected_ = streamer_->isConnected();
+    return connected_;
+}
+
+PushOutput::Stats PushOutput::stats() const {
+    Stats s;
+    s.name = options_.name;
+    s.url = options_.stream.url;
+    s.enabled = enabled_.load();
+    s.connected = connected_.load();
+    s.packetsSent = packetsSent_.load();
+    s.bytesSent = bytesSent_.load();
+    s.dropped = dropped_.load();
+    s.errors = errors_.load();
+    s.reconnects = reconnects_.load();
+    s.queued = queued_.load();
+    return s;
+}
+
+} // namespace reallive
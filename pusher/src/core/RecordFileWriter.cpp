@@ -0,0 +1,164 @@
+#include "core/RecordFileWriter.h"
+#include "core/Metrics.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace reallive {
+
+namespace {
+
+int64_t steadyUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void observeSince(Histogram* hist, int64_t startUs) {
+    if (hist) hist->observe(steadyUs() - startUs);
+}
+
+} // namespace
+
+RecordFileWriter::~RecordFileWriter() {
+    close();
+}
+
+bool RecordFileWriter::open(const std::string& path, const Options& options) {
+    close();
+    options_ = options;
+    path_ = path;
+    pos_ = 0;
+    size_ = 0;
+    written_ = 0;
+    syncStart_ = 0;
+    pendingStart_ = 0;
+    pendingLen_ = 0;
+    failed_ = false;
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "[RecordFile] open " << path << " failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (options_.preallocateBytes > 0) {
+        // Mode 0 so the whole range is allocated now; close() truncates back.
+        if (::fallocate(fd_, 0, 0, static_cast<off_t>(options_.preallocateBytes)) != 0 &&
+            errno != EOPNOTSUPP && errno != ENOSYS) {
+            std::cerr << "[RecordFile] fallocate " << options_.preallocateBytes
+                      << " bytes failed: " << std::strerror(errno) << std::endl;
+        }
+    }
+
+    const size_t bufferBytes = std::max<size_t>(64 * 1024, options_.bufferBytes);
+    auto* buffer = static_cast<unsigned char*>(av_malloc(bufferBytes));
+    if (!buffer) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    avio_ = avio_alloc_context(buffer, static_cast<int>(bufferBytes), 1, this,
+                               nullptr, &RecordFileWriter::writePacket, &RecordFileWriter::seekPacket);
+    if (!avio_) {
+        av_free(buffer);
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+bool RecordFileWriter::close() {
+    if (fd_ < 0) return true;
+
+    if (avio_) {
+        avio_flush(avio_);
+        av_freep(&avio_->buffer);
+        avio_context_free(&avio_);
+    }
+
+    bool ok = !failed_;
+    if (::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+        std::cerr << "[RecordFile] truncate " << path_ << " failed: " << std::strerror(errno) << std::endl;
+        ok = false;
+    }
+    const int64_t syncStartUs = steadyUs();
+    if (::fdatasync(fd_) != 0) {
+        ok = false;
+    }
+    observeSince(options_.syncHist, syncStartUs);
+    ::close(fd_);
+    fd_ = -1;
+    return ok;
+}
+
+int RecordFileWriter::writePacket(void* opaque, WriteBuf buf, int size) {
+    return static_cast<RecordFileWriter*>(opaque)->write(buf, size);
+}
+
+int64_t RecordFileWriter::seekPacket(void* opaque, int64_t offset, int whence) {
+    auto* self = static_cast<RecordFileWriter*>(opaque);
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE: return self->size_;
+        case SEEK_SET: self->pos_ = offset; break;
+        case SEEK_CUR: self->pos_ += offset; break;
+        case SEEK_END: self->pos_ = self->size_ + offset; break;
+        default: return AVERROR(EINVAL);
+    }
+    return self->pos_;
+}
+
+int RecordFileWriter::write(const uint8_t* buf, int size) {
+    const int64_t startUs = steadyUs();
+    int done = 0;
+    while (done < size) {
+        const ssize_t n = ::pwrite(fd_, buf + done, static_cast<size_t>(size - done), static_cast<off_t>(pos_));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            const int err = errno;
+            if (!failed_) {
+                std::cerr << "[RecordFile] write " << path_ << " failed: " << std::strerror(err) << std::endl;
+            }
+            failed_ = true;
+            return AVERROR(err);
+        }
+        done += static_cast<int>(n);
+        pos_ += n;
+    }
+    observeSince(options_.writeHist, startUs);
+    if (pos_ > size_) size_ = pos_;
+    written_ = size_;
+    paceWriteback();
+    return size;
+}
+
+void RecordFileWriter::paceWriteback() {
+    if (options_.syncChunkBytes == 0) return;
+    const int64_t dirty = size_ - syncStart_;
+    if (dirty < static_cast<int64_t>(options_.syncChunkBytes)) return;
+
+    // Start writeback of the new chunk without waiting, then wait for the
+    // chunk started last time; at most ~2 chunks are ever dirty.
+    ::sync_file_range(fd_, syncStart_, dirty, SYNC_FILE_RANGE_WRITE);
+    if (pendingLen_ > 0) {
+        const int64_t startUs = steadyUs();
+        ::sync_file_range(fd_, pendingStart_, pendingLen_,
+                          SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        observeSince(options_.syncHist, startUs);
+    }
+    pendingStart_ = syncStart_;
+    pendingLen_ = dirty;
+    syncStart_ = size_;
+}
+
+} // namespace reallive
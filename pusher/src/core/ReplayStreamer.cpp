@@ -0,0 +1,219 @@
+#include "core/ReplayStreamer.h"
+#include "core/SegmentReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/error.h>
+}
+
+namespace reallive {
+
+namespace {
+
+// Falling further behind than this (slow RTMP peer) re-anchors the pacing
+// clock instead of bursting to catch up.
+constexpr int64_t kMaxLagUs = 1000000;
+
+int64_t steadyUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string ffErr(int code) {
+    char buf[256];
+    av_strerror(code, buf, sizeof(buf));
+    return std::string(buf);
+}
+
+} // namespace
+
+ReplayStreamer::~ReplayStreamer() {
+    stop();
+}
+
+bool ReplayStreamer::start(const Options& options) {
+    stop();
+    if (options.segments.empty() || options.url.empty()) return false;
+    options_ = options;
+    speed_ = std::max(kMinSpeed, std::min(kMaxSpeed, options.speed));
+    stopRequested_ = false;
+    running_ = true;
+    thread_ = std::thread(&ReplayStreamer::run, this);
+    return true;
+}
+
+void ReplayStreamer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+        stopRequested_ = true;
+    }
+    waitCv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void ReplayStreamer::setSpeed(double speed) {
+    speed_ = std::max(kMinSpeed, std::min(kMaxSpeed, speed));
+}
+
+int ReplayStreamer::interruptCallback(void* opaque) {
+    return static_cast<ReplayStreamer*>(opaque)->stopRequested_.load() ? 1 : 0;
+}
+
+void ReplayStreamer::run() {
+    segmentBaseUs_ = 0;
+    lastMediaUs_ = -1;
+    outUs_ = 0;
+    lastOutMs_ = -1;
+    anchorSteadyUs_ = -1;
+    packetsSent_ = 0;
+    outputFailed_ = false;
+
+    for (size_t i = 0; i < options_.segments.size() && !stopRequested_; i++) {
+        const Segment& segment = options_.segments[i];
+        // A broken segment is skipped; a dead output ends the session.
+        if (!playSegment(segment, i == 0 ? options_.startOffsetMs : 0) && outputFailed_) break;
+        // Collapse the boundary (and any recording gap) to one frame step.
+        if (lastMediaUs_ >= 0) segmentBaseUs_ = lastMediaUs_ + frameStepUs_;
+    }
+
+    std::cout << "[Replay] " << options_.url << " finished after " << packetsSent_ << " packet(s)"
+              << (stopRequested_ ? " (stopped)" : "") << std::endl;
+    closeOutput();
+    running_ = false;
+}
+
+bool ReplayStreamer::playSegment(const Segment& segment, int64_t offsetMs) {
+    const AVIOInterruptCB interrupt{&ReplayStreamer::interruptCallback, this};
+    SegmentReader reader;
+    if (!reader.open(segment.path, segment.indexPath, &interrupt)) return false;
+    if (!out_ && !openOutput(reader.codecpar())) {
+        outputFailed_ = true;
+        return false;
+    }
+
+    segmentFirstDtsUs_ = -1;
+    reader.seekKeyframe(offsetMs);
+    AVPacket* pkt = av_packet_alloc();
+    if (!pkt) return false;
+    int ret = 0;
+    bool ok = true;
+    while (ok && !stopRequested_ && (ret = reader.read(pkt, keyframeOnly())) > 0) {
+        ok = emit(pkt, pkt->pts, pkt->dts, (pkt->flags & AV_PKT_FLAG_KEY) != 0);
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    return ok && ret >= 0;
+}
+
+bool ReplayStreamer::openOutput(const AVCodecParameters* codecpar) {
+    int ret = avformat_alloc_output_context2(&out_, nullptr, "flv", options_.url.c_str());
+    if (ret < 0 || !out_) {
+        std::cerr << "[Replay] Failed to allocate output context: " << ffErr(ret) << std::endl;
+        return false;
+    }
+    out_->interrupt_callback.callback = &ReplayStreamer::interruptCallback;
+    out_->interrupt_callback.opaque = this;
+    out_->flags |= AVFMT_FLAG_FLUSH_PACKETS;
+
+    AVStream* stream = avformat_new_stream(out_, nullptr);
+    if (!stream || avcodec_parameters_copy(stream->codecpar, codecpar) < 0) {
+        closeOutput();
+        return false;
+    }
+    stream->codecpar->codec_tag = 0;
+    stream->time_base = {1, 1000};
+
+    AVDictionary* ioOpts = nullptr;
+    av_dict_set(&ioOpts, "rtmp_live", "live", 0);
+    av_dict_set(&ioOpts, "tcp_nodelay", "1", 0);
+    ret = avio_open2(&out_->pb, options_.url.c_str(), AVIO_FLAG_WRITE, &out_->interrupt_callback, &ioOpts);
+    av_dict_free(&ioOpts);
+    if (ret < 0) {
+        std::cerr << "[Replay] Failed to open " << options_.url << ": " << ffErr(ret) << std::endl;
+        closeOutput();
+        return false;
+    }
+
+    AVDictionary* opts = nullptr;
+    av_dict_set(&opts, "flvflags", "no_duration_filesize", 0);
+    ret = avformat_write_header(out_, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        std::cerr << "[Replay] Failed to write header: " << ffErr(ret) << std::endl;
+        closeOutput();
+        return false;
+    }
+    headerWritten_ = true;
+    return true;
+}
+
+void ReplayStreamer::closeOutput() {
+    if (!out_) return;
+    if (headerWritten_ && out_->pb) av_write_trailer(out_);
+    if (out_->pb) avio_closep(&out_->pb);
+    avformat_free_context(out_);
+    out_ = nullptr;
+    headerWritten_ = false;
+}
+
+bool ReplayStreamer::emit(AVPacket* pkt, int64_t ptsUs, int64_t dtsUs, bool keyframe) {
+    if (segmentFirstDtsUs_ < 0) segmentFirstDtsUs_ = dtsUs;
+    const int64_t mediaUs = segmentBaseUs_ + std::max<int64_t>(0, dtsUs - segmentFirstDtsUs_);
+    const double speed = speed_.load();
+
+    // Advance the output clock by the scaled media delta so speed changes
+    // bend the timeline instead of rewinding it.
+    if (lastMediaUs_ >= 0) {
+        const int64_t deltaUs = std::max<int64_t>(0, mediaUs - lastMediaUs_);
+        if (deltaUs > 0 && !keyframeOnly()) frameStepUs_ = deltaUs;
+        outUs_ += static_cast<int64_t>(static_cast<double>(deltaUs) / speed);
+    }
+    lastMediaUs_ = mediaUs;
+
+    if (anchorSteadyUs_ < 0) anchorSteadyUs_ = steadyUs() - outUs_;
+    if (!waitUntilUs(anchorSteadyUs_ + outUs_)) return false;
+
+    int64_t outMs = std::max(lastOutMs_ + 1, outUs_ / 1000);
+    lastOutMs_ = outMs;
+    const int64_t ctsMs = keyframeOnly()
+        ? 0
+        : static_cast<int64_t>(static_cast<double>(std::max<int64_t>(0, ptsUs - dtsUs)) / speed / 1000.0);
+
+    AVStream* stream = out_->streams[0];
+    pkt->stream_index = 0;
+    pkt->dts = av_rescale_q(outMs, {1, 1000}, stream->time_base);
+    pkt->pts = av_rescale_q(outMs + ctsMs, {1, 1000}, stream->time_base);
+    pkt->duration = 0;
+    pkt->pos = -1;
+    if (keyframe) pkt->flags |= AV_PKT_FLAG_KEY;
+
+    const int ret = av_write_frame(out_, pkt);
+    if (ret < 0) {
+        outputFailed_ = true;
+        if (!stopRequested_) {
+            std::cerr << "[Replay] write to " << options_.url << " failed: " << ffErr(ret) << std::endl;
+        }
+        return false;
+    }
+    packetsSent_++;
+    return true;
+}
+
+bool ReplayStreamer::waitUntilUs(int64_t targetUs) {
+    const int64_t now = steadyUs();
+    if (now - targetUs > kMaxLagUs) {
+        anchorSteadyUs_ += now - targetUs;
+        return !stopRequested_;
+    }
+    if (targetUs <= now) return !stopRequested_;
+    std::unique_lock<std::mutex> lock(waitMutex_);
+    waitCv_.wait_for(lock, std::chrono::microseconds(targetUs - now),
+                     [this]() { return stopRequested_.load(); });
+    return !stopRequested_;
+}
+
+} // namespace reallive
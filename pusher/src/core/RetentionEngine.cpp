@@ -0,0 +1,288 @@
+#include "core/RetentionEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace reallive {
+
+namespace {
+
+constexpr int64_t kHourMs = 3600LL * 1000LL;
+
+int64_t nowWallMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+// "segment_<start>_<end>" -> start/end; false for anything else.
+bool parseSegmentStem(const std::string& stem, int64_t& startMs, int64_t& endMs) {
+    long long s = 0;
+    long long e = 0;
+    int consumed = 0;
+    if (std::sscanf(stem.c_str(), "segment_%lld_%lld%n", &s, &e, &consumed) != 2) return false;
+    if (static_cast<size_t>(consumed) != stem.size()) return false;
+    startMs = s;
+    endMs = std::max<int64_t>(s, e);
+    return true;
+}
+
+std::string formatMb(uint64_t bytes) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1fMB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    return buf;
+}
+
+} // namespace
+
+RetentionEngine::~RetentionEngine() {
+    stop();
+}
+
+void RetentionEngine::start(const std::string& streamDir, const Policy& policy, int intervalSec) {
+    stop();
+    streamDir_ = streamDir;
+    intervalSec_ = std::max(5, intervalSec);
+    eventTs_.clear();
+    eventsOffset_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        policy_ = policy;
+        running_ = true;
+        passRequested_ = true;
+    }
+    thread_ = std::thread(&RetentionEngine::run, this);
+}
+
+void RetentionEngine::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void RetentionEngine::setPolicy(const Policy& policy) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        policy_ = policy;
+        passRequested_ = true;
+    }
+    cv_.notify_all();
+}
+
+RetentionEngine::Policy RetentionEngine::policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+void RetentionEngine::requestPass() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        passRequested_ = true;
+    }
+    cv_.notify_all();
+}
+
+void RetentionEngine::run() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::seconds(intervalSec_),
+                         [this]() { return !running_ || passRequested_; });
+            if (!running_) return;
+            passRequested_ = false;
+        }
+        runPass();
+    }
+}
+
+std::vector<RetentionEngine::Segment> RetentionEngine::scanSegments(uint64_t& openBytes) const {
+    std::vector<Segment> segments;
+    std::unordered_map<std::string, uint64_t> sidecarBytes;
+    openBytes = 0;
+
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(streamDir_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        const std::filesystem::path& path = it->path();
+        const std::string stem = path.stem().string();
+        if (path.extension() == ".writing") {
+            const uint64_t bytes = it->file_size(ec);
+            if (!ec) openBytes += bytes;
+            ec.clear();
+            continue;
+        }
+        int64_t startMs = 0;
+        int64_t endMs = 0;
+        if (!parseSegmentStem(stem, startMs, endMs)) continue;
+
+        const uint64_t bytes = it->file_size(ec);
+        if (ec) {
+            ec.clear();
+            continue;
+        }
+        if (path.extension() == ".mp4") {
+            Segment seg;
+            seg.startMs = startMs;
+            seg.endMs = endMs;
+            seg.bytes = bytes;
+            seg.path = path.string();
+            segments.push_back(std::move(seg));
+        } else {
+            sidecarBytes[stem] += bytes;
+        }
+    }
+
+    for (Segment& seg : segments) {
+        auto it = sidecarBytes.find(std::filesystem::path(seg.path).stem().string());
+        if (it != sidecarBytes.end()) seg.bytes += it->second;
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        return a.startMs < b.startMs;
+    });
+    return segments;
+}
+
+void RetentionEngine::loadNewEvents() {
+    const std::string path = streamDir_ + "/events.ndjson";
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return;
+
+    file.seekg(0, std::ios::end);
+    const uint64_t size = static_cast<uint64_t>(file.tellg());
+    if (size < eventsOffset_) {
+        // Journal was truncated or replaced.
+        eventTs_.clear();
+        eventsOffset_ = 0;
+    }
+    file.seekg(static_cast<std::streamoff>(eventsOffset_));
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (file.eof()) break;  // partial line still being written
+        eventsOffset_ += line.size() + 1;
+        if (line.find("\"type\":\"person\"") == std::string::npos) continue;
+        const size_t p = line.find("\"ts\":");
+        if (p == std::string::npos) continue;
+        const int64_t ts = std::strtoll(line.c_str() + p + 5, nullptr, 10);
+        if (ts <= 0) continue;
+        if (eventTs_.empty() || ts >= eventTs_.back()) {
+            eventTs_.push_back(ts);
+        } else {
+            eventTs_.insert(std::upper_bound(eventTs_.begin(), eventTs_.end(), ts), ts);
+        }
+    }
+}
+
+bool RetentionEngine::overlapsEvent(int64_t startMs, int64_t endMs) const {
+    auto it = std::lower_bound(eventTs_.begin(), eventTs_.end(), startMs);
+    return it != eventTs_.end() && *it <= endMs;
+}
+
+uint64_t RetentionEngine::removeSegment(const Segment& seg) {
+    std::error_code ec;
+    if (!std::filesystem::remove(seg.path, ec) || ec) {
+        return 0;
+    }
+    for (const char* sidecar : {".jpg", ".idx"}) {
+        std::filesystem::remove(std::filesystem::path(seg.path).replace_extension(sidecar), ec);
+    }
+    return seg.bytes;
+}
+
+void RetentionEngine::runPass() {
+    loadNewEvents();
+    uint64_t openBytes = 0;
+    std::vector<Segment> segments = scanSegments(openBytes);
+    if (segments.size() <= 1) return;
+
+    const Policy p = policy();
+    const int64_t nowMs = nowWallMs();
+    const size_t deletable = segments.size() - 1;  // never the newest
+
+    uint64_t totalBytes = openBytes;
+    for (Segment& seg : segments) {
+        seg.eventTier = overlapsEvent(seg.startMs, seg.endMs);
+        totalBytes += seg.bytes;
+    }
+
+    std::vector<bool> doomed(segments.size(), false);
+    uint64_t plannedBytes = 0;
+    size_t agedCount = 0;
+    size_t eventCount = 0;
+
+    const int eventMaxAgeHours = p.eventMaxAgeHours > 0 ? p.eventMaxAgeHours : p.maxAgeHours;
+    for (size_t i = 0; i < deletable; i++) {
+        const int limitHours = segments[i].eventTier ? eventMaxAgeHours : p.maxAgeHours;
+        if (limitHours <= 0 || segments[i].endMs >= nowMs - limitHours * kHourMs) continue;
+        doomed[i] = true;
+        plannedBytes += segments[i].bytes;
+        agedCount++;
+        if (segments[i].eventTier) eventCount++;
+    }
+
+    uint64_t bytesToFree = 0;
+    if (p.quotaBytes > 0 && totalBytes > p.quotaBytes) {
+        bytesToFree = totalBytes - p.quotaBytes;
+    }
+    std::error_code ec;
+    const auto space = std::filesystem::space(streamDir_, ec);
+    if (!ec && space.capacity > 0) {
+        const double freePct = static_cast<double>(space.available) * 100.0 / static_cast<double>(space.capacity);
+        if (freePct < static_cast<double>(p.minFreePercent)) {
+            const uint64_t targetAvailable = static_cast<uint64_t>(
+                static_cast<double>(space.capacity) * static_cast<double>(p.targetFreePercent) / 100.0);
+            if (targetAvailable > space.available) {
+                bytesToFree = std::max(bytesToFree, targetAvailable - space.available);
+            }
+        }
+    }
+
+    // Normal tier oldest-first, then event tier oldest-first.
+    for (int tier = 0; tier < 2 && plannedBytes < bytesToFree; tier++) {
+        for (size_t i = 0; i < deletable && plannedBytes < bytesToFree; i++) {
+            if (doomed[i] || segments[i].eventTier != (tier == 1)) continue;
+            doomed[i] = true;
+            plannedBytes += segments[i].bytes;
+            if (segments[i].eventTier) eventCount++;
+        }
+    }
+
+    size_t removedCount = 0;
+    uint64_t removedBytes = 0;
+    for (size_t i = 0; i < deletable; i++) {
+        if (!doomed[i]) continue;
+        const uint64_t freed = removeSegment(segments[i]);
+        if (freed == 0) continue;
+        removedCount++;
+        removedBytes += freed;
+    }
+
+    // Events older than every remaining segment can no longer matter.
+    int64_t oldestKeptMs = segments.back().startMs;
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!doomed[i]) {
+            oldestKeptMs = segments[i].startMs;
+            break;
+        }
+    }
+    eventTs_.erase(eventTs_.begin(), std::lower_bound(eventTs_.begin(), eventTs_.end(), oldestKeptMs));
+
+    if (removedCount > 0) {
+        std::cout << "[Retention] Removed " << removedCount << " segment(s), "
+                  << formatMb(removedBytes) << " (aged=" << agedCount
+                  << ", event-tier=" << eventCount << "), stream now "
+                  << formatMb(totalBytes - std::min(totalBytes, removedBytes)) << std::endl;
+    }
+}
+
+} // namespace reallive
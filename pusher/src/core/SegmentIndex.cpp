@@ -0,0 +1,152 @@
+#include "core/SegmentIndex.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace reallive {
+
+namespace {
+
+constexpr char kMagic[4] = {'R', 'L', 'I', 'X'};
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kFrameSize = 16;
+constexpr size_t kGopSize = 16;
+constexpr uint32_t kKeyBit = 0x80000000u;
+
+void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 24));
+}
+
+void putU64(std::vector<uint8_t>& out, uint64_t v) {
+    putU32(out, static_cast<uint32_t>(v));
+    putU32(out, static_cast<uint32_t>(v >> 32));
+}
+
+uint32_t getU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t getU64(const uint8_t* p) {
+    return static_cast<uint64_t>(getU32(p)) | (static_cast<uint64_t>(getU32(p + 4)) << 32);
+}
+
+} // namespace
+
+void SegmentIndex::clear() {
+    frames_.clear();
+    gops_.clear();
+}
+
+void SegmentIndex::addFrame(uint32_t ptsMs, uint64_t offset, uint32_t size, bool keyframe) {
+    Frame f;
+    f.ptsMs = ptsMs;
+    f.offset = offset;
+    f.size = std::min(size, kKeyBit - 1);
+    f.keyframe = keyframe;
+
+    if (keyframe || gops_.empty()) {
+        if (!gops_.empty() && ptsMs > gops_.back().ptsMs) {
+            gops_.back().durationMs = ptsMs - gops_.back().ptsMs;
+        }
+        Gop g;
+        g.ptsMs = ptsMs;
+        g.firstFrame = static_cast<uint32_t>(frames_.size());
+        gops_.push_back(g);
+    }
+    Gop& gop = gops_.back();
+    gop.bytes += f.size;
+    if (ptsMs > gop.ptsMs) gop.durationMs = std::max(gop.durationMs, ptsMs - gop.ptsMs);
+    frames_.push_back(f);
+}
+
+bool SegmentIndex::save(const std::string& path) const {
+    std::vector<uint8_t> out;
+    out.reserve(kHeaderSize + frames_.size() * kFrameSize + gops_.size() * kGopSize);
+    out.insert(out.end(), kMagic, kMagic + 4);
+    out.push_back(kVersion);
+    out.insert(out.end(), 3, 0);
+    putU32(out, static_cast<uint32_t>(frames_.size()));
+    putU32(out, static_cast<uint32_t>(gops_.size()));
+    for (const Frame& f : frames_) {
+        putU32(out, f.ptsMs);
+        putU64(out, f.offset);
+        putU32(out, f.size | (f.keyframe ? kKeyBit : 0));
+    }
+    for (const Gop& g : gops_) {
+        putU32(out, g.ptsMs);
+        putU32(out, g.firstFrame);
+        putU32(out, g.bytes);
+        putU32(out, g.durationMs);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    return file.good();
+}
+
+bool SegmentIndex::load(const std::string& path) {
+    clear();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (in.size() < kHeaderSize || std::memcmp(in.data(), kMagic, 4) != 0 ||
+        in[4] != kVersion) {
+        return false;
+    }
+    const uint32_t frameCount = getU32(&in[8]);
+    const uint32_t gopCount = getU32(&in[12]);
+    if (in.size() < kHeaderSize + static_cast<size_t>(frameCount) * kFrameSize +
+                        static_cast<size_t>(gopCount) * kGopSize) {
+        return false;
+    }
+
+    const uint8_t* p = in.data() + kHeaderSize;
+    frames_.resize(frameCount);
+    for (Frame& f : frames_) {
+        f.ptsMs = getU32(p);
+        f.offset = getU64(p + 4);
+        const uint32_t sizeAndKey = getU32(p + 12);
+        f.size = sizeAndKey & ~kKeyBit;
+        f.keyframe = (sizeAndKey & kKeyBit) != 0;
+        p += kFrameSize;
+    }
+    gops_.resize(gopCount);
+    for (Gop& g : gops_) {
+        g.ptsMs = getU32(p);
+        g.firstFrame = getU32(p + 4);
+        g.bytes = getU32(p + 8);
+        g.durationMs = getU32(p + 12);
+        p += kGopSize;
+    }
+    return true;
+}
+
+const SegmentIndex::Frame* SegmentIndex::keyframeAtOrBefore(uint32_t ptsMs) const {
+    const Frame* best = nullptr;
+    for (const Gop& g : gops_) {
+        if (g.firstFrame >= frames_.size()) break;
+        const Frame& f = frames_[g.firstFrame];
+        if (!f.keyframe) continue;
+        if (f.ptsMs > ptsMs && best) break;
+        best = &f;
+        if (f.ptsMs > ptsMs) break;
+    }
+    return best;
+}
+
+std::string SegmentIndex::pathFor(const std::string& mp4Path) {
+    const size_t dot = mp4Path.rfind('.');
+    const size_t slash = mp4Path.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return mp4Path + ".idx";
+    return mp4Path.substr(0, dot) + ".idx";
+}
+
+} // namespace reallive
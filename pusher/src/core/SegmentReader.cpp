@@ -0,0 +1,161 @@
+#include "core/SegmentReader.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/error.h>
+}
+
+namespace reallive {
+
+namespace {
+
+std::string ffErr(int code) {
+    char buf[256];
+    av_strerror(code, buf, sizeof(buf));
+    return std::string(buf);
+}
+
+} // namespace
+
+SegmentReader::~SegmentReader() {
+    close();
+}
+
+bool SegmentReader::open(const std::string& path, const std::string& indexPath,
+                         const AVIOInterruptCB* interrupt) {
+    close();
+    path_ = path;
+
+    in_ = avformat_alloc_context();
+    if (!in_) return false;
+    if (interrupt) in_->interrupt_callback = *interrupt;
+    const int ret = avformat_open_input(&in_, path.c_str(), nullptr, nullptr);
+    if (ret < 0) {
+        std::cerr << "[SegmentReader] open " << path << " failed: " << ffErr(ret) << std::endl;
+        return false;
+    }
+    streamIdx_ = av_find_best_stream(in_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (streamIdx_ < 0) {
+        close();
+        return false;
+    }
+
+    if (!indexPath.empty() && index_.load(indexPath) && !index_.empty()) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            std::cerr << "[SegmentReader] open " << path << " failed: " << std::strerror(errno) << std::endl;
+        }
+    }
+    gop_ = 0;
+    frame_ = 0;
+    needKeyframe_ = true;
+    return true;
+}
+
+void SegmentReader::close() {
+    if (in_) avformat_close_input(&in_);
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    index_.clear();
+    streamIdx_ = -1;
+}
+
+const AVCodecParameters* SegmentReader::codecpar() const {
+    return in_ && streamIdx_ >= 0 ? in_->streams[streamIdx_]->codecpar : nullptr;
+}
+
+void SegmentReader::seekKeyframe(int64_t offsetMs) {
+    needKeyframe_ = true;
+    if (indexed()) {
+        const auto& gops = index_.gops();
+        gop_ = 0;
+        while (gop_ + 1 < gops.size() && gops[gop_ + 1].ptsMs <= offsetMs) gop_++;
+        frame_ = gops.empty() ? 0 : gops[gop_].firstFrame;
+        return;
+    }
+    if (in_ && offsetMs > 0) {
+        const AVRational tb = in_->streams[streamIdx_]->time_base;
+        av_seek_frame(in_, streamIdx_, av_rescale_q(offsetMs, {1, 1000}, tb), AVSEEK_FLAG_BACKWARD);
+    }
+}
+
+int64_t SegmentReader::seekNearestKeyframe(int64_t offsetMs) {
+    seekKeyframe(offsetMs);
+    if (!indexed() || index_.gops().empty()) return offsetMs;
+    const auto& gops = index_.gops();
+    if (gop_ + 1 < gops.size() &&
+        std::llabs(static_cast<int64_t>(gops[gop_ + 1].ptsMs) - offsetMs) <
+        std::llabs(offsetMs - static_cast<int64_t>(gops[gop_].ptsMs))) {
+        gop_++;
+        frame_ = gops[gop_].firstFrame;
+    }
+    return gops[gop_].ptsMs;
+}
+
+int SegmentReader::read(AVPacket* pkt, bool keyframesOnly) {
+    if (!in_) return AVERROR(EINVAL);
+    return indexed() ? readIndexed(pkt, keyframesOnly) : readDemuxed(pkt, keyframesOnly);
+}
+
+int SegmentReader::readIndexed(AVPacket* pkt, bool keyframesOnly) {
+    const auto& frames = index_.frames();
+    const auto& gops = index_.gops();
+    while (true) {
+        if (frame_ >= frames.size()) return 0;
+        while (gop_ + 1 < gops.size() && frame_ >= gops[gop_ + 1].firstFrame) gop_++;
+        const bool gopStart = !gops.empty() && frame_ == gops[gop_].firstFrame;
+        const SegmentIndex::Frame& frame = frames[frame_];
+        if ((needKeyframe_ || keyframesOnly) && !(gopStart && frame.keyframe)) {
+            // Jump to the next GOP rather than stepping through its frames.
+            if (gop_ + 1 >= gops.size()) return 0;
+            frame_ = gops[++gop_].firstFrame;
+            continue;
+        }
+        needKeyframe_ = false;
+        frame_++;
+
+        const int ret = av_new_packet(pkt, static_cast<int>(frame.size));
+        if (ret < 0) return ret;
+        if (::pread(fd_, pkt->data, frame.size, frame.offset) != static_cast<ssize_t>(frame.size)) {
+            std::cerr << "[SegmentReader] short read in " << path_ << " at " << frame.offset << std::endl;
+            av_packet_unref(pkt);
+            return AVERROR(EIO);
+        }
+        pkt->pts = pkt->dts = static_cast<int64_t>(frame.ptsMs) * 1000;
+        if (frame.keyframe) pkt->flags |= AV_PKT_FLAG_KEY;
+        return 1;
+    }
+}
+
+int SegmentReader::readDemuxed(AVPacket* pkt, bool keyframesOnly) {
+    const AVRational tb = in_->streams[streamIdx_]->time_base;
+    while (true) {
+        const int ret = av_read_frame(in_, pkt);
+        if (ret == AVERROR_EOF) return 0;
+        if (ret < 0) return ret;
+        const bool key = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+        if (pkt->stream_index != streamIdx_ || ((needKeyframe_ || keyframesOnly) && !key)) {
+            av_packet_unref(pkt);
+            continue;
+        }
+        needKeyframe_ = false;
+        const int64_t dts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+        const int64_t pts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : dts;
+        pkt->pts = av_rescale_q(pts, tb, {1, 1000000});
+        pkt->dts = av_rescale_q(dts, tb, {1, 1000000});
+        pkt->stream_index = 0;
+        pkt->pos = -1;
+        return 1;
+    }
+}
+
+} // namespace reallive
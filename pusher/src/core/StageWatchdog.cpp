@@ -0,0 +1,59 @@
+#include "core/StageWatchdog.h"
+#include "core/Metrics.h"
+
+#include <chrono>
+#include <utility>
+
+namespace reallive {
+
+namespace {
+
+int64_t steadyClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+StageWatchdog::StageWatchdog(std::string name, int deadlineMs, MetricsRegistry* metrics)
+    : name_(std::move(name)), deadlineUs_(deadlineMs > 0 ? static_cast<int64_t>(deadlineMs) * 1000 : 0) {
+    if (metrics) {
+        const std::string prefix = "reallive_watchdog_" + name_;
+        restarts_ = &metrics->counter(prefix + "_restarts_total",
+                                      "Restarts of the " + name_ + " stage after it missed its deadline");
+        failures_ = &metrics->counter(prefix + "_restart_failures_total",
+                                      "Watchdog restarts of the " + name_ + " stage that failed");
+    }
+}
+
+void StageWatchdog::beat() {
+    lastBeatUs_.store(steadyClockUs(), std::memory_order_relaxed);
+}
+
+void StageWatchdog::idle() {
+    lastBeatUs_.store(0, std::memory_order_relaxed);
+}
+
+bool StageWatchdog::overdue() const {
+    if (deadlineUs_ <= 0) return false;
+    const int64_t last = lastBeatUs_.load(std::memory_order_relaxed);
+    return last > 0 && steadyClockUs() - last > deadlineUs_;
+}
+
+int64_t StageWatchdog::stalledMs() const {
+    const int64_t last = lastBeatUs_.load(std::memory_order_relaxed);
+    return last > 0 ? (steadyClockUs() - last) / 1000 : 0;
+}
+
+void StageWatchdog::restarted(bool ok) {
+    if (restarts_) restarts_->inc();
+    if (!ok && failures_) failures_->inc();
+    beat();
+}
+
+uint64_t StageWatchdog::restarts() const {
+    return restarts_ ? restarts_->value() : 0;
+}
+
+} // namespace reallive
@@ -0,0 +1,238 @@
+#include "core/SystemSampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace reallive {
+
+namespace {
+
+// statvfs on an SD card can stall; storage moves slowly anyway.
+constexpr int64_t kStorageRefreshMs = 10000;
+
+double clampPercent(double value) {
+    if (!std::isfinite(value)) return 0.0;
+    if (value < 0.0) return 0.0;
+    if (value > 100.0) return 100.0;
+    return value;
+}
+
+int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Parses up to |max| unsigned decimal fields starting at |p|; stops at the
+// end of the line.
+size_t parseFields(const char*& p, const char* end, uint64_t* out, size_t max) {
+    size_t n = 0;
+    while (p < end && *p != '\n' && n < max) {
+        while (p < end && *p == ' ') p++;
+        if (p >= end || *p < '0' || *p > '9') break;
+        uint64_t v = 0;
+        while (p < end && *p >= '0' && *p <= '9') v = v * 10 + static_cast<uint64_t>(*p++ - '0');
+        out[n++] = v;
+    }
+    while (p < end && *p != '\n') p++;
+    if (p < end) p++;
+    return n;
+}
+
+} // namespace
+
+SystemSampler& SystemSampler::instance() {
+    static SystemSampler sampler;
+    return sampler;
+}
+
+SystemSampler::~SystemSampler() {
+    if (thread_.joinable()) {
+        running_ = false;
+        wakeCv_.notify_all();
+        thread_.join();
+    }
+    if (statFd_ >= 0) ::close(statFd_);
+    if (meminfoFd_ >= 0) ::close(meminfoFd_);
+}
+
+void SystemSampler::start(int intervalMs) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    if (users_++ > 0) return;
+
+    intervalMs_ = std::max(100, intervalMs);
+    if (statFd_ < 0) statFd_ = ::open("/proc/stat", O_RDONLY | O_CLOEXEC);
+    if (meminfoFd_ < 0) meminfoFd_ = ::open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    if (statFd_ < 0 || meminfoFd_ < 0) {
+        std::cerr << "[Sampler] /proc unavailable, cpu/memory telemetry disabled" << std::endl;
+    }
+
+    // Prime the CPU counters and storage so the first consumer read is useful.
+    sample(true);
+    running_ = true;
+    thread_ = std::thread(&SystemSampler::run, this);
+}
+
+void SystemSampler::stop() {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    if (users_ == 0 || --users_ > 0) return;
+    {
+        std::lock_guard<std::mutex> wake(wakeMutex_);
+        running_ = false;
+    }
+    wakeCv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+SystemTelemetry SystemSampler::latest() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latest_;
+}
+
+void SystemSampler::run() {
+    int64_t lastStorageMs = steadyMs();
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCv_.wait_for(lock, std::chrono::milliseconds(intervalMs_), [this]() { return !running_; });
+        }
+        if (!running_) break;
+
+        const int64_t now = steadyMs();
+        const bool withStorage = now - lastStorageMs >= kStorageRefreshMs;
+        if (withStorage) lastStorageMs = now;
+        sample(withStorage);
+    }
+}
+
+void SystemSampler::sample(bool withStorage) {
+    SystemTelemetry next;
+    sampleCpu(next);
+    sampleMemory(next);
+    if (withStorage) {
+        sampleStorage(next);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!withStorage) {
+        next.storagePct = latest_.storagePct;
+        next.storageUsedGb = latest_.storageUsedGb;
+        next.storageTotalGb = latest_.storageTotalGb;
+    }
+    latest_ = std::move(next);
+}
+
+bool SystemSampler::readProc(int fd, std::vector<char>& buf, size_t& len) {
+    len = 0;
+    if (fd < 0) return false;
+    if (buf.empty()) buf.resize(4096);
+    // procfs regenerates the file on every read from offset 0; grow until the
+    // whole thing fits so the snapshot is consistent.
+    for (;;) {
+        const ssize_t n = ::pread(fd, buf.data(), buf.size(), 0);
+        if (n < 0) return false;
+        if (static_cast<size_t>(n) < buf.size()) {
+            len = static_cast<size_t>(n);
+            return true;
+        }
+        buf.resize(buf.size() * 2);
+    }
+}
+
+void SystemSampler::sampleCpu(SystemTelemetry& out) {
+    size_t len = 0;
+    if (!readProc(statFd_, statBuf_, len)) return;
+
+    CpuCounters total;
+    std::vector<CpuCounters> cores;
+    const char* p = statBuf_.data();
+    const char* end = p + len;
+    while (p + 3 < end && std::strncmp(p, "cpu", 3) == 0) {
+        p += 3;
+        long coreIndex = -1;
+        if (*p >= '0' && *p <= '9') {
+            coreIndex = 0;
+            while (p < end && *p >= '0' && *p <= '9') coreIndex = coreIndex * 10 + (*p++ - '0');
+        }
+        // user nice system idle iowait irq softirq steal guest guest_nice
+        uint64_t f[10] = {};
+        const size_t n = parseFields(p, end, f, 10);
+        if (n < 4) continue;
+        CpuCounters c;
+        c.idle = f[3] + f[4];
+        for (size_t i = 0; i < n; i++) c.total += f[i];
+        c.valid = true;
+        if (coreIndex < 0) {
+            total = c;
+        } else {
+            if (static_cast<size_t>(coreIndex) >= cores.size()) cores.resize(static_cast<size_t>(coreIndex) + 1);
+            cores[static_cast<size_t>(coreIndex)] = c;
+        }
+    }
+
+    auto usage = [](const CpuCounters& cur, const CpuCounters& prev) {
+        if (!cur.valid || !prev.valid || cur.total <= prev.total) return 0.0;
+        const double totalDelta = static_cast<double>(cur.total - prev.total);
+        const double idleDelta = static_cast<double>(cur.idle - prev.idle);
+        return clampPercent((1.0 - idleDelta / totalDelta) * 100.0);
+    };
+
+    out.cpuPct = usage(total, prevTotal_);
+    if (total.valid) prevTotal_ = total;
+
+    out.cpuCorePct.assign(cores.size(), 0.0);
+    for (size_t i = 0; i < cores.size() && i < prevCores_.size(); i++) {
+        out.cpuCorePct[i] = usage(cores[i], prevCores_[i]);
+    }
+    prevCores_ = std::move(cores);
+}
+
+void SystemSampler::sampleMemory(SystemTelemetry& out) {
+    size_t len = 0;
+    if (!readProc(meminfoFd_, meminfoBuf_, len)) return;
+
+    uint64_t memTotalKb = 0;
+    uint64_t memAvailableKb = 0;
+    const char* p = meminfoBuf_.data();
+    const char* end = p + len;
+    while (p < end && (memTotalKb == 0 || memAvailableKb == 0)) {
+        uint64_t* target = nullptr;
+        if (end - p > 9 && std::strncmp(p, "MemTotal:", 9) == 0) {
+            target = &memTotalKb;
+            p += 9;
+        } else if (end - p > 13 && std::strncmp(p, "MemAvailable:", 13) == 0) {
+            target = &memAvailableKb;
+            p += 13;
+        }
+        if (target) {
+            parseFields(p, end, target, 1);
+            continue;
+        }
+        while (p < end && *p != '\n') p++;
+        if (p < end) p++;
+    }
+
+    if (memTotalKb > 0) {
+        const uint64_t memUsedKb = memTotalKb > memAvailableKb ? (memTotalKb - memAvailableKb) : 0;
+        out.memoryTotalMb = static_cast<double>(memTotalKb) / 1024.0;
+        out.memoryUsedMb = static_cast<double>(memUsedKb) / 1024.0;
+        out.memoryPct = clampPercent(static_cast<double>(memUsedKb) * 100.0 / static_cast<double>(memTotalKb));
+    }
+}
+
+void SystemSampler::sampleStorage(SystemTelemetry& out) {
+    std::error_code ec;
+    const auto space = std::filesystem::space("/", ec);
+    if (ec || space.capacity == 0) return;
+    const uint64_t used = space.capacity > space.available ? (space.capacity - space.available) : 0;
+    out.storageTotalGb = static_cast<double>(space.capacity) / (1024.0 * 1024.0 * 1024.0);
+    out.storageUsedGb = static_cast<double>(used) / (1024.0 * 1024.0 * 1024.0);
+    out.storagePct = clampPercent(static_cast<double>(used) * 100.0 / static_cast<double>(space.capacity));
+}
+
+} // namespace reallive
@@ -0,0 +1,221 @@
+#include "core/TelemetrySei.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace reallive {
+
+namespace {
+
+// "RealLiveTelemTLV"
+constexpr std::array<uint8_t, 16> kTelemetryUuid = {
+    0x52, 0x65, 0x61, 0x6C, 0x4C, 0x69, 0x76, 0x65,
+    0x54, 0x65, 0x6C, 0x65, 0x6D, 0x54, 0x4C, 0x56
+};
+
+// Values offered to the web UI; fixed for a given firmware build.
+constexpr std::array<std::array<int, 2>, 3> kConfigurableResolutions = {{
+    {640, 480}, {1280, 720}, {1920, 1080}
+}};
+constexpr std::array<int, 7> kConfigurableFps = {10, 15, 24, 25, 30, 50, 60};
+constexpr std::array<const char*, 3> kConfigurableProfiles = {"baseline", "main", "high"};
+// {min, max, step}: bitrate, gop, person score threshold (x100), infer interval ms
+constexpr std::array<std::array<int, 3>, 4> kConfigurableRanges = {{
+    {300000, 8000000, 100000},
+    {10, 120, 5},
+    {30, 95, 1},
+    {10, 1000, 10},
+}};
+
+int64_t fixedPoint(double value, double scale) {
+    if (!std::isfinite(value)) return 0;
+    return static_cast<int64_t>(std::llround(value * scale));
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putZigzag(std::vector<uint8_t>& out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void putString(std::vector<uint8_t>& out, const std::string& value) {
+    putVarint(out, value.size());
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+void putRecord(std::vector<uint8_t>& out, uint8_t tag, const std::vector<uint8_t>& body) {
+    out.push_back(tag);
+    putVarint(out, body.size());
+    out.insert(out.end(), body.begin(), body.end());
+}
+
+void putSeiField(std::vector<uint8_t>& out, size_t value) {
+    while (value >= 0xFF) {
+        out.push_back(0xFF);
+        value -= 0xFF;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+} // namespace
+
+bool TelemetrySeiEncoder::wantsKeyMessage(bool isKeyframe, int64_t nowMs) const {
+    return isKeyframe && (!haveBase_ || keyRequested_ || nowMs - lastKeyMs_ >= kKeyRefreshMs);
+}
+
+void TelemetrySeiEncoder::putDynamic(size_t slot, uint8_t tag, const std::vector<int64_t>& values, bool key) {
+    std::vector<int64_t>& last = lastDynamic_[slot];
+    record_.clear();
+    if (key || last.size() != values.size()) {
+        for (int64_t v : values) putZigzag(record_, v);
+        putRecord(payload_, tag, record_);
+    } else {
+        bool changed = false;
+        for (size_t i = 0; i < values.size(); i++) {
+            const int64_t delta = values[i] - last[i];
+            changed = changed || delta != 0;
+            putZigzag(record_, delta);
+        }
+        if (!changed) return;
+        putRecord(payload_, static_cast<uint8_t>(tag | kTagDelta), record_);
+    }
+    last = values;
+}
+
+void TelemetrySeiEncoder::encode(const TelemetrySnapshot& snap, bool key) {
+    payload_.clear();
+    payload_.insert(payload_.end(), kTelemetryUuid.begin(), kTelemetryUuid.end());
+    payload_.push_back(kVersion);
+    payload_.push_back(key ? 0x01 : 0x00);
+    putVarint(payload_, seq_++);
+
+    // Static records are rebuilt every time (a few dozen bytes) and only
+    // emitted when they differ from what the decoder already has.
+    staticRecords_.clear();
+    record_.assign(snap.streamKey.begin(), snap.streamKey.end());
+    putRecord(staticRecords_, kTagStreamKey, record_);
+
+    record_.clear();
+    putString(record_, snap.pixelFormat);
+    putString(record_, snap.codec);
+    putString(record_, snap.profile);
+    for (int64_t v : {int64_t{snap.width}, int64_t{snap.height}, int64_t{snap.fps}, int64_t{snap.bitrate},
+                      int64_t{snap.gop}, int64_t{snap.audioEnabled}, int64_t{snap.tfliteEnabled},
+                      int64_t{snap.inferOnMotionOnly}, fixedPoint(snap.personScoreThreshold, 100.0)}) {
+        putZigzag(record_, v);
+    }
+    putRecord(staticRecords_, kTagCamera, record_);
+
+    record_.clear();
+    putVarint(record_, kConfigurableResolutions.size());
+    for (const auto& res : kConfigurableResolutions) {
+        putVarint(record_, static_cast<uint64_t>(res[0]));
+        putVarint(record_, static_cast<uint64_t>(res[1]));
+    }
+    putVarint(record_, kConfigurableFps.size());
+    for (int fps : kConfigurableFps) putVarint(record_, static_cast<uint64_t>(fps));
+    putVarint(record_, kConfigurableProfiles.size());
+    for (const char* profile : kConfigurableProfiles) putString(record_, profile);
+    for (const auto& range : kConfigurableRanges) {
+        for (int v : range) putVarint(record_, static_cast<uint64_t>(v));
+    }
+    putRecord(staticRecords_, kTagConfigurable, record_);
+
+    if (key || staticRecords_ != lastStatic_) {
+        payload_.insert(payload_.end(), staticRecords_.begin(), staticRecords_.end());
+        lastStatic_ = staticRecords_;
+    }
+
+    // The timestamp is always absolute so events stay decodable after a gap.
+    values_.assign({snap.tsMs});
+    putDynamic(0, kTagTimestamp, values_, true);
+
+    const SystemTelemetry& d = snap.device;
+    values_.assign({
+        fixedPoint(d.cpuPct, 10.0), fixedPoint(d.memoryPct, 10.0),
+        fixedPoint(d.memoryUsedMb, 10.0), fixedPoint(d.memoryTotalMb, 10.0),
+        fixedPoint(d.storagePct, 10.0), fixedPoint(d.storageUsedGb, 100.0), fixedPoint(d.storageTotalGb, 100.0)
+    });
+    for (double core : d.cpuCorePct) values_.push_back(fixedPoint(core, 10.0));
+    putDynamic(1, kTagDevice, values_, key);
+
+    const DetectionScheduler::Snapshot& s = snap.detectSched;
+    values_.assign({
+        int64_t{s.adaptive}, static_cast<int64_t>(s.state),
+        s.cadence.intervalFrames, s.cadence.inferMinIntervalMs, s.cadence.inferTiles,
+        fixedPoint(s.encodeAvgMs, 100.0), fixedPoint(s.encodeMaxMs, 100.0),
+        fixedPoint(s.detectAvgMs, 100.0), fixedPoint(s.inferAvgMs, 100.0),
+        static_cast<int64_t>(s.skippedFrames)
+    });
+    putDynamic(2, kTagDetectSched, values_, key);
+
+    const TelemetryPerson& p = snap.person;
+    values_.assign({int64_t{p.active}, fixedPoint(p.score, 1000.0), p.ts, p.x, p.y, p.w, p.h});
+    putDynamic(3, kTagPerson, values_, key);
+
+    if (!snap.events.empty()) {
+        record_.clear();
+        for (const TelemetryPerson& evt : snap.events) {
+            putZigzag(record_, evt.ts - snap.tsMs);
+            putZigzag(record_, fixedPoint(evt.score, 1000.0));
+            putZigzag(record_, evt.x);
+            putZigzag(record_, evt.y);
+            putZigzag(record_, evt.w);
+            putZigzag(record_, evt.h);
+        }
+        putRecord(payload_, kTagEvents, record_);
+    }
+
+    if (key) {
+        lastKeyMs_ = snap.tsMs;
+        haveBase_ = true;
+        keyRequested_ = false;
+    }
+}
+
+void TelemetrySeiEncoder::inject(EncodedPacket& packet, const TelemetrySnapshot& snap) {
+    if (packet.empty()) return;
+
+    encode(snap, !haveBase_ || wantsKeyMessage(packet.isKeyframe, snap.tsMs));
+
+    rbsp_.clear();
+    rbsp_.push_back(0x06);  // NAL type = SEI
+    putSeiField(rbsp_, 5);  // user_data_unregistered
+    putSeiField(rbsp_, payload_.size());
+    rbsp_.insert(rbsp_.end(), payload_.begin(), payload_.end());
+    rbsp_.push_back(0x80);  // RBSP stop bit
+
+    ebsp_.clear();
+    int zeros = 0;
+    for (uint8_t b : rbsp_) {
+        if (zeros >= 2 && b <= 0x03) {
+            ebsp_.push_back(0x03);
+            zeros = 0;
+        }
+        ebsp_.push_back(b);
+        zeros = (b == 0x00) ? zeros + 1 : 0;
+    }
+
+    const uint8_t* data = packet.bytes();
+    const bool annexB = packet.size() >= 4 && data[0] == 0x00 && data[1] == 0x00 &&
+                        (data[2] == 0x01 || (data[2] == 0x00 && data[3] == 0x01));
+    uint8_t* dst = packet.prepend(4 + ebsp_.size());
+    if (annexB) {
+        dst[0] = 0x00; dst[1] = 0x00; dst[2] = 0x00; dst[3] = 0x01;
+    } else {
+        const uint32_t naluSize = static_cast<uint32_t>(ebsp_.size());
+        dst[0] = static_cast<uint8_t>((naluSize >> 24) & 0xFF);
+        dst[1] = static_cast<uint8_t>((naluSize >> 16) & 0xFF);
+        dst[2] = static_cast<uint8_t>((naluSize >> 8) & 0xFF);
+        dst[3] = static_cast<uint8_t>(naluSize & 0xFF);
+    }
+    std::memcpy(dst + 4, ebsp_.data(), ebsp_.size());
+}
+
+} // namespace reallive
@@ -0,0 +1,175 @@
+#include "core/Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace reallive {
+
+namespace {
+
+constexpr size_t kMinEventsPerThread = 256;
+
+thread_local const char* t_threadName = nullptr;
+
+} // namespace
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+int64_t Tracer::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::configure(bool enabled, size_t eventsPerThread) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        eventsPerThread_ = std::max(kMinEventsPerThread, eventsPerThread);
+    }
+    setEnabled(enabled);
+}
+
+void Tracer::setEnabled(bool enabled) {
+    if (enabled_.exchange(enabled) != enabled) {
+        std::cout << "[Tracer] " << (enabled ? "enabled" : "disabled")
+                  << " (" << eventsPerThread_ << " events/thread)" << std::endl;
+    }
+}
+
+void Tracer::setThreadName(const char* name) {
+    t_threadName = name;
+}
+
+Tracer::ThreadRing* Tracer::ring() {
+    // Gives the ring back when the thread exits, so threads that come and go
+    // (respawned detectors, replay sessions) reuse rings instead of each
+    // leaving ~400 KB behind.
+    struct Lease {
+        ThreadRing* ring = nullptr;
+        ~Lease() {
+            if (ring) Tracer::instance().release(ring);
+        }
+    };
+    thread_local Lease t_lease;
+    if (t_lease.ring) return t_lease.ring;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ThreadRing* r = nullptr;
+    if (!freeRings_.empty()) {
+        r = freeRings_.back();
+        freeRings_.pop_back();
+        r->head.store(0, std::memory_order_relaxed);
+    } else {
+        rings_.push_back(std::make_unique<ThreadRing>());
+        r = rings_.back().get();
+    }
+    // Dumps hold mutex_, so nothing reads the old slots while they go.
+    r->events.reset(new Event[eventsPerThread_]);
+    r->capacity = eventsPerThread_;
+    r->tid = static_cast<int>(::syscall(SYS_gettid));
+    r->threadName = t_threadName ? t_threadName : "thread";
+    t_lease.ring = r;
+    return r;
+}
+
+void Tracer::release(ThreadRing* r) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    freeRings_.push_back(r);
+}
+
+void Tracer::record(const char* name, int64_t startUs, int64_t endUs, uint32_t frameId) {
+    if (!enabled()) return;
+    ThreadRing* r = ring();
+    const uint64_t head = r->head.load(std::memory_order_relaxed);
+    Event& e = r->events[head % r->capacity];
+    e.seq.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.name.store(name, std::memory_order_relaxed);
+    e.startUs.store(startUs, std::memory_order_relaxed);
+    e.durUs.store(static_cast<uint32_t>(std::max<int64_t>(0, endUs - startUs)), std::memory_order_relaxed);
+    e.frameId.store(frameId, std::memory_order_relaxed);
+    e.seq.store(2 * head + 2, std::memory_order_release);
+    r->head.store(head + 1, std::memory_order_release);
+}
+
+std::string Tracer::dumpJson(int seconds) const {
+    const int64_t cutoffUs = seconds > 0 ? nowUs() - static_cast<int64_t>(seconds) * 1000000 : 0;
+    const int pid = static_cast<int>(::getpid());
+
+    std::ostringstream oss;
+    oss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto sep = [&]() {
+        if (!first) oss << ",";
+        first = false;
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& r : rings_) {
+        sep();
+        oss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << r->tid
+            << ",\"args\":{\"name\":\"" << r->threadName << "\"}}";
+
+        const uint64_t head = r->head.load(std::memory_order_acquire);
+        const uint64_t count = std::min<uint64_t>(head, r->capacity);
+        for (uint64_t i = head - count; i < head; i++) {
+            // Copy the slot, then keep it only if it still holds event i,
+            // complete, both before and after the copy.
+            const Event& slot = r->events[i % r->capacity];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * i + 2) continue;
+            const char* name = slot.name.load(std::memory_order_relaxed);
+            const int64_t startUs = slot.startUs.load(std::memory_order_relaxed);
+            const uint32_t durUs = slot.durUs.load(std::memory_order_relaxed);
+            const uint32_t frameId = slot.frameId.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+
+            if (!name || startUs + durUs < cutoffUs) continue;
+            sep();
+            oss << "{\"name\":\"" << name << "\",\"cat\":\"pipeline\",\"ph\":\"X\""
+                << ",\"ts\":" << startUs << ",\"dur\":" << durUs
+                << ",\"pid\":" << pid << ",\"tid\":" << r->tid;
+            if (frameId) oss << ",\"args\":{\"frame\":" << frameId << "}";
+            oss << "}";
+        }
+    }
+    oss << "]}";
+    return oss.str();
+}
+
+bool Tracer::dumpToFile(const std::string& dir, int seconds, std::string& pathOut) const {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    const time_t now = time(nullptr);
+    struct tm lt;
+    localtime_r(&now, &lt);
+    char name[64];
+    std::strftime(name, sizeof(name), "reallive-trace-%Y%m%d-%H%M%S.json", &lt);
+    pathOut = (std::filesystem::path(dir) / name).string();
+
+    std::ofstream out(pathOut, std::ios::trunc);
+    if (!out) {
+        std::cerr << "[Tracer] Failed to open " << pathOut << std::endl;
+        return false;
+    }
+    out << dumpJson(seconds);
+    if (!out.good()) {
+        std::cerr << "[Tracer] Failed to write " << pathOut << std::endl;
+        return false;
+    }
+    std::cout << "[Tracer] Wrote " << pathOut << std::endl;
+    return true;
+}
+
+} // namespace reallive
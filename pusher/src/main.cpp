@@ -1,7 +1,8 @@
 #include "core/Config.h"
 #include "core/ControlServer.h"
 #include "core/MqttRuntimeClient.h"
-#include "core/Pipeline.h"
+#include "core/PipelineHost.h"
+#include "core/Tracer.h"
 
 #include <csignal>
 #include <iostream>
@@ -11,14 +12,15 @@ using namespace reallive;
 
 namespace {
 
-Pipeline* g_pipeline = nullptr;
+PipelineHost* g_host = nullptr;
 ControlServer* g_controlServer = nullptr;
 MqttRuntimeClient* g_mqttClient = nullptr;
+volatile std::sig_atomic_t g_traceDumpRequested = 0;
 
 void signalHandler(int sig) {
     std::cout << "\n[Main] Signal " << sig << " received, stopping..." << std::endl;
-    if (g_pipeline) {
-        g_pipeline->stop();
+    if (g_host) {
+        g_host->stop();
     }
     if (g_controlServer) {
         g_controlServer->stop();
@@ -28,6 +30,11 @@ void signalHandler(int sig) {
     }
 }
 
+// SIGUSR1: dump the trace from the main loop, not from the handler.
+void traceSignalHandler(int) {
+    g_traceDumpRequested = 1;
+}
+
 } // anonymous namespace
 
 int main(int argc, char* argv[]) {
@@ -42,45 +49,60 @@ int main(int argc, char* argv[]) {
     // Set up signal handlers
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
+    std::signal(SIGUSR1, traceSignalHandler);
+    // A viewer hanging up must surface as EPIPE on the socket, not kill the process.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const TraceConfig& traceConfig = config.get().trace;
+    Tracer::instance().configure(traceConfig.enabled, static_cast<size_t>(traceConfig.bufferEvents));
 
-    // Create and run pipeline
-    Pipeline pipeline;
-    g_pipeline = &pipeline;
-    ControlServer controlServer(config.get(), &pipeline);
+    // Create and run one pipeline per camera
+    PipelineHost host(config);
+    g_host = &host;
+    ControlServer controlServer(config.get(), &host);
     g_controlServer = &controlServer;
-    MqttRuntimeClient mqttClient(config.get(), &pipeline);
+    MqttRuntimeClient mqttClient(config.get(), &host);
     g_mqttClient = &mqttClient;
+    host.setDetectionEventHandler([&mqttClient](const std::string& streamKey, const DetectionEvent& event) {
+        mqttClient.publishDetectionEvent(streamKey, event);
+    });
 
     if (!controlServer.start()) {
         std::cerr << "[Main] Failed to start control server." << std::endl;
         return 1;
     }
 
-    if (!pipeline.init(config.get())) {
+    if (!host.init()) {
         std::cerr << "[Main] Failed to initialize pipeline." << std::endl;
         return 1;
     }
 
-    if (!pipeline.start()) {
+    if (!host.start()) {
         std::cerr << "[Main] Failed to start pipeline." << std::endl;
         return 1;
     }
     if (!mqttClient.start()) {
         std::cerr << "[Main] Failed to start MQTT runtime client." << std::endl;
+        host.stop();
         return 1;
     }
 
     std::cout << "[Main] Pipeline running. Press Ctrl+C to stop." << std::endl;
 
     // Wait for the pipeline to finish (blocks until stop() or stream end)
-    while (pipeline.isRunning()) {
+    while (host.isRunning()) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (g_traceDumpRequested) {
+            g_traceDumpRequested = 0;
+            std::string tracePath;
+            Tracer::instance().dumpToFile(traceConfig.outputDir, traceConfig.dumpSeconds, tracePath);
+        }
     }
 
-    pipeline.stop();
+    host.stop();
     mqttClient.stop();
     controlServer.stop();
-    g_pipeline = nullptr;
+    g_host = nullptr;
     g_controlServer = nullptr;
     g_mqttClient = nullptr;
 
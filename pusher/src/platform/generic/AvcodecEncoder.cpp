@@ -1,8 +1,15 @@
-#include "platform/rpi5/AvcodecEncoder.h"
+#include "platform/generic/AvcodecEncoder.h"
 
 #include <iostream>
 #include <cstring>
 
+// AV_PROFILE_* replaced FF_PROFILE_* in FFmpeg 6.1; FFmpeg 8 dropped the old names.
+#ifndef AV_PROFILE_H264_BASELINE
+#define AV_PROFILE_H264_BASELINE FF_PROFILE_H264_BASELINE
+#define AV_PROFILE_H264_MAIN FF_PROFILE_H264_MAIN
+#define AV_PROFILE_H264_HIGH FF_PROFILE_H264_HIGH
+#endif
+
 namespace reallive {
 
 namespace {
@@ -46,12 +53,19 @@ AVPixelFormat pickPixelFormat(const AVCodecContext* ctx, const AVCodec* codec) {
 AvcodecEncoder::AvcodecEncoder() = default;
 
 AvcodecEncoder::~AvcodecEncoder() {
+    release();
+}
+
+void AvcodecEncoder::release() {
     if (avPacket_) av_packet_free(&avPacket_);
     if (avFrame_) av_frame_free(&avFrame_);
     if (ctx_) avcodec_free_context(&ctx_);
+    initialized_ = false;
 }
 
 bool AvcodecEncoder::init(const EncoderConfig& config) {
+    // Also the watchdog's reinit path: start from a clean context.
+    release();
     config_ = config;
 
     // Use libx264 software encoder (no hardware encoder on Pi 5)
@@ -84,14 +98,17 @@ bool AvcodecEncoder::init(const EncoderConfig& config) {
     ctx_->bit_rate = config.bitrate;
     ctx_->gop_size = config.gopSize;
     ctx_->max_b_frames = 0;  // no B-frames for low latency
+    if (config.threads > 0) {
+        ctx_->thread_count = config.threads;  // split between cameras by PipelineHost
+    }
 
     // Set profile
     if (config.profile == "baseline") {
-        ctx_->profile = FF_PROFILE_H264_BASELINE;
+        ctx_->profile = AV_PROFILE_H264_BASELINE;
     } else if (config.profile == "high") {
-        ctx_->profile = FF_PROFILE_H264_HIGH;
+        ctx_->profile = AV_PROFILE_H264_HIGH;
     } else {
-        ctx_->profile = FF_PROFILE_H264_MAIN;
+        ctx_->profile = AV_PROFILE_H264_MAIN;
     }
 
     // Put SPS/PPS in extradata for the muxer
@@ -135,6 +152,7 @@ bool AvcodecEncoder::init(const EncoderConfig& config) {
 
     initialized_ = true;
     frameCount_ = 0;
+    forceKeyframe_ = true;
     return true;
 }
 
@@ -193,6 +211,11 @@ EncodedPacket AvcodecEncoder::encode(const Frame& frame) {
         avFrame_->pts = frameCount_++;
     }
 
+    // The first frame after (re)init is an IDR, so the recorder and the push
+    // outputs can resume on it without waiting for the next GOP.
+    avFrame_->pict_type = forceKeyframe_ ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+    forceKeyframe_ = false;
+
     // Send frame to encoder
     ret = avcodec_send_frame(ctx_, avFrame_);
     if (ret < 0) {
@@ -208,8 +231,10 @@ EncodedPacket AvcodecEncoder::encode(const Frame& frame) {
         return result;
     }
 
-    // Copy to our EncodedPacket
-    result.data.assign(avPacket_->data, avPacket_->data + avPacket_->size);
+    // Copy to our EncodedPacket, leaving headroom for SEI NALUs
+    result.data.resize(EncodedPacket::kHeadroom + static_cast<size_t>(avPacket_->size));
+    std::memcpy(result.data.data() + EncodedPacket::kHeadroom, avPacket_->data, avPacket_->size);
+    result.offset = EncodedPacket::kHeadroom;
 
     // Convert pts from encoder timebase to microseconds
     result.pts = av_rescale_q(avPacket_->pts, ctx_->time_base, {1, 1000000});
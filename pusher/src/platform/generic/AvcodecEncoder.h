@@ -29,6 +29,8 @@ public:
     int getExtraDataSize() const;
 
 private:
+    void release();
+
     const AVCodec* codec_ = nullptr;
     AVCodecContext* ctx_ = nullptr;
     AVFrame* avFrame_ = nullptr;
@@ -37,6 +39,7 @@ private:
     EncoderConfig config_;
     bool initialized_ = false;
     int64_t frameCount_ = 0;
+    bool forceKeyframe_ = false;
     std::string encoderName_;
 };
 
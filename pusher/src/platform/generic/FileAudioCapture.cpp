@@ -0,0 +1,172 @@
+#include "platform/generic/FileAudioCapture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace reallive {
+
+namespace {
+
+constexpr int kPeriodFrames = 1024;  // same as AlsaCapture
+
+uint32_t readLe32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t readLe16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    if (s.size() < suffix.size()) return false;
+    return std::equal(suffix.rbegin(), suffix.rend(), s.rbegin(), [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == b;
+    });
+}
+
+} // namespace
+
+FileAudioCapture::FileAudioCapture() = default;
+
+FileAudioCapture::~FileAudioCapture() {
+    close();
+}
+
+bool FileAudioCapture::open(const AudioConfig& config) {
+    close();
+    config_ = config;
+    if (config_.source.empty()) {
+        std::cerr << "[FileAudio] audio_source is required for the file backend" << std::endl;
+        return false;
+    }
+    if (config_.sampleRate <= 0 || config_.channels <= 0 || config_.bitsPerSample != 16) {
+        std::cerr << "[FileAudio] Unsupported format: " << config_.sampleRate << " Hz, "
+                  << config_.channels << " ch, " << config_.bitsPerSample << " bit" << std::endl;
+        return false;
+    }
+    file_ = std::fopen(config_.source.c_str(), "rb");
+    if (!file_) {
+        std::cerr << "[FileAudio] Cannot open " << config_.source << std::endl;
+        return false;
+    }
+    dataOffset_ = 0;
+    dataBytes_ = -1;
+    if (endsWith(config_.source, ".wav") && !parseWav()) {
+        close();
+        return false;
+    }
+    std::fseek(file_, dataOffset_, SEEK_SET);
+    position_ = 0;
+    sampleCount_ = 0;
+    opened_ = true;
+    std::cout << "[FileAudio] Replaying " << config_.source << std::endl;
+    return true;
+}
+
+bool FileAudioCapture::parseWav() {
+    uint8_t riff[12];
+    if (std::fread(riff, 1, sizeof(riff), file_) != sizeof(riff) ||
+        std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        std::cerr << "[FileAudio] " << config_.source << " is not a RIFF/WAVE file" << std::endl;
+        return false;
+    }
+    bool haveFormat = false;
+    uint8_t chunk[8];
+    while (std::fread(chunk, 1, sizeof(chunk), file_) == sizeof(chunk)) {
+        const uint32_t size = readLe32(chunk + 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < sizeof(fmt) || std::fread(fmt, 1, sizeof(fmt), file_) != sizeof(fmt)) break;
+            const uint16_t format = readLe16(fmt);
+            const uint16_t channels = readLe16(fmt + 2);
+            const uint32_t rate = readLe32(fmt + 4);
+            const uint16_t bits = readLe16(fmt + 14);
+            if (format != 1 || bits != 16 || channels != config_.channels ||
+                rate != static_cast<uint32_t>(config_.sampleRate)) {
+                std::cerr << "[FileAudio] " << config_.source << " is format " << format << ", " << rate
+                          << " Hz, " << channels << " ch, " << bits << " bit; expected 16-bit PCM at "
+                          << config_.sampleRate << " Hz, " << config_.channels << " ch" << std::endl;
+                return false;
+            }
+            haveFormat = true;
+            std::fseek(file_, static_cast<long>(size - sizeof(fmt) + (size & 1)), SEEK_CUR);
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) break;
+            dataOffset_ = std::ftell(file_);
+            dataBytes_ = static_cast<long>(size);
+            return true;
+        } else {
+            std::fseek(file_, static_cast<long>(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    std::cerr << "[FileAudio] No PCM data in " << config_.source << std::endl;
+    return false;
+}
+
+void FileAudioCapture::close() {
+    started_ = false;
+    opened_ = false;
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool FileAudioCapture::start() {
+    if (!opened_) return false;
+    pacer_.reset(static_cast<int64_t>(kPeriodFrames) * 1000000 / config_.sampleRate);
+    started_ = true;
+    return true;
+}
+
+bool FileAudioCapture::stop() {
+    started_ = false;
+    return true;
+}
+
+AudioFrame FileAudioCapture::captureFrame() {
+    AudioFrame frame;
+    if (!started_ || !file_) return frame;
+    pacer_.wait();
+
+    const size_t bytesPerFrame = static_cast<size_t>(config_.channels) * sizeof(int16_t);
+    const size_t want = kPeriodFrames * bytesPerFrame;
+    frame.data.resize(want);
+    size_t filled = 0;
+    bool rewound = false;
+    while (filled < want) {
+        size_t chunk = want - filled;
+        if (dataBytes_ >= 0) chunk = std::min(chunk, static_cast<size_t>(std::max(0L, dataBytes_ - position_)));
+        const size_t got = chunk ? std::fread(frame.data.data() + filled, 1, chunk, file_) : 0;
+        filled += got;
+        position_ += static_cast<long>(got);
+        if (got == 0) {
+            if (rewound) break;  // empty file
+            std::fseek(file_, dataOffset_, SEEK_SET);
+            position_ = 0;
+            rewound = true;
+        }
+    }
+    filled -= filled % bytesPerFrame;
+    if (filled == 0) return AudioFrame{};
+    frame.data.resize(filled);
+
+    frame.samples = static_cast<int>(filled / bytesPerFrame);
+    frame.sampleRate = config_.sampleRate;
+    frame.channels = config_.channels;
+    frame.pts = sampleCount_ * 1000000LL / config_.sampleRate;
+    sampleCount_ += frame.samples;
+    return frame;
+}
+
+bool FileAudioCapture::isOpen() const {
+    return opened_;
+}
+
+std::string FileAudioCapture::getName() const {
+    return "File audio replay";
+}
+
+} // namespace reallive
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "platform/IAudioCapture.h"
+#include "platform/generic/FramePacer.h"
+
+#include <atomic>
+#include <cstdio>
+
+namespace reallive {
+
+// Replays a PCM file as the microphone, paced like a sound card and looped.
+// `source` is a 16-bit PCM .wav whose rate and channel count match the
+// config, or raw S16LE in the configured format.
+class FileAudioCapture : public IAudioCapture {
+public:
+    FileAudioCapture();
+    ~FileAudioCapture() override;
+
+    bool open(const AudioConfig& config) override;
+    bool start() override;
+    bool stop() override;
+    AudioFrame captureFrame() override;
+    bool isOpen() const override;
+    std::string getName() const override;
+
+private:
+    bool parseWav();
+    void close();
+
+    AudioConfig config_;
+    std::FILE* file_ = nullptr;
+    long dataOffset_ = 0;
+    long dataBytes_ = -1;  // -1: to end of file
+    long position_ = 0;    // bytes into the data
+    FramePacer pacer_;
+    int64_t sampleCount_ = 0;
+    bool opened_ = false;
+    std::atomic<bool> started_{false};
+};
+
+} // namespace reallive
@@ -0,0 +1,322 @@
+#include "platform/generic/FileCapture.h"
+#include "core/FramePool.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/pixfmt.h>
+}
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+namespace reallive {
+
+namespace {
+
+int64_t steadyClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+std::string lowerExtension(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext;
+}
+
+// Reads up to and including '\n'; false at end of file or on an overlong line.
+bool readLine(std::FILE* file, std::string& line) {
+    line.clear();
+    int ch = 0;
+    while ((ch = std::fgetc(file)) != EOF) {
+        if (ch == '\n') return true;
+        if (line.size() >= 1024) return false;
+        line.push_back(static_cast<char>(ch));
+    }
+    return false;
+}
+
+void copyPlane(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int widthBytes, int rows) {
+    for (int y = 0; y < rows; y++) {
+        std::memcpy(dst + static_cast<size_t>(y) * dstStride, src + static_cast<size_t>(y) * srcStride,
+                    static_cast<size_t>(widthBytes));
+    }
+}
+
+void i420ToNv12(const uint8_t* srcY, int strideY, const uint8_t* srcU, int strideU, const uint8_t* srcV,
+                int strideV, int width, int height, uint8_t* dst) {
+    copyPlane(dst, width, srcY, strideY, width, height);
+    uint8_t* uv = dst + static_cast<size_t>(width) * height;
+    for (int y = 0; y < height / 2; y++) {
+        const uint8_t* u = srcU + static_cast<size_t>(y) * strideU;
+        const uint8_t* v = srcV + static_cast<size_t>(y) * strideV;
+        uint8_t* row = uv + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width / 2; x++) {
+            row[2 * x] = u[x];
+            row[2 * x + 1] = v[x];
+        }
+    }
+}
+
+} // namespace
+
+FileCapture::FileCapture() = default;
+
+FileCapture::~FileCapture() {
+    close();
+}
+
+bool FileCapture::open(const CaptureConfig& config) {
+    close();
+    config_ = config;
+    if (config_.source.empty()) {
+        std::cerr << "[FileCapture] camera_source is required for the file backend" << std::endl;
+        return false;
+    }
+    if (config_.width <= 0 || config_.height <= 0 || (config_.width % 2) || (config_.height % 2) ||
+        config_.fps <= 0) {
+        std::cerr << "[FileCapture] Invalid size or fps: " << config_.width << "x" << config_.height
+                  << "@" << config_.fps << std::endl;
+        return false;
+    }
+    frameSize_ = static_cast<size_t>(config_.width) * config_.height * 3 / 2;
+
+    const std::string ext = lowerExtension(config_.source);
+    bool ok = false;
+    if (ext == ".y4m") {
+        kind_ = Kind::Y4m;
+        ok = openY4m();
+    } else if (ext == ".nv12" || ext == ".yuv" || ext == ".raw") {
+        kind_ = Kind::RawNv12;
+        file_ = std::fopen(config_.source.c_str(), "rb");
+        ok = file_ != nullptr;
+        if (!ok) std::cerr << "[FileCapture] Cannot open " << config_.source << std::endl;
+        dataOffset_ = 0;
+    } else {
+        kind_ = Kind::Container;
+        ok = openContainer();
+    }
+    if (!ok) {
+        close();
+        return false;
+    }
+
+    opened_ = true;
+    std::cout << "[FileCapture] Replaying " << config_.source << " at " << config_.width << "x"
+              << config_.height << "@" << config_.fps << "fps" << std::endl;
+    return true;
+}
+
+bool FileCapture::checkSize(int width, int height) const {
+    if (width == config_.width && height == config_.height) return true;
+    std::cerr << "[FileCapture] " << config_.source << " is " << width << "x" << height
+              << ", the camera is configured for " << config_.width << "x" << config_.height << std::endl;
+    return false;
+}
+
+bool FileCapture::openY4m() {
+    file_ = std::fopen(config_.source.c_str(), "rb");
+    if (!file_) {
+        std::cerr << "[FileCapture] Cannot open " << config_.source << std::endl;
+        return false;
+    }
+    std::string header;
+    if (!readLine(file_, header) || header.rfind("YUV4MPEG2", 0) != 0) {
+        std::cerr << "[FileCapture] " << config_.source << " is not a YUV4MPEG2 file" << std::endl;
+        return false;
+    }
+    int width = 0;
+    int height = 0;
+    std::string colorspace = "420jpeg";  // the format's default
+    std::istringstream tokens(header.substr(9));
+    std::string token;
+    while (tokens >> token) {
+        if (token[0] == 'W') width = std::atoi(token.c_str() + 1);
+        if (token[0] == 'H') height = std::atoi(token.c_str() + 1);
+        if (token[0] == 'C') colorspace = token.substr(1);
+    }
+    if (colorspace.rfind("420", 0) != 0) {
+        std::cerr << "[FileCapture] Only 4:2:0 Y4M is supported, got C" << colorspace << std::endl;
+        return false;
+    }
+    if (!checkSize(width, height)) return false;
+    planar_.resize(frameSize_);
+    dataOffset_ = std::ftell(file_);
+    return true;
+}
+
+bool FileCapture::openContainer() {
+    if (avformat_open_input(&format_, config_.source.c_str(), nullptr, nullptr) < 0) {
+        std::cerr << "[FileCapture] Cannot open " << config_.source << std::endl;
+        return false;
+    }
+    if (avformat_find_stream_info(format_, nullptr) < 0) {
+        std::cerr << "[FileCapture] No stream info in " << config_.source << std::endl;
+        return false;
+    }
+    const AVCodec* codec = nullptr;
+    streamIndex_ = av_find_best_stream(format_, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (streamIndex_ < 0 || !codec) {
+        std::cerr << "[FileCapture] No decodable video stream in " << config_.source << std::endl;
+        return false;
+    }
+    const AVCodecParameters* params = format_->streams[streamIndex_]->codecpar;
+    if (!checkSize(params->width, params->height)) return false;
+
+    decoder_ = avcodec_alloc_context3(codec);
+    if (!decoder_ || avcodec_parameters_to_context(decoder_, params) < 0 ||
+        avcodec_open2(decoder_, codec, nullptr) < 0) {
+        std::cerr << "[FileCapture] Cannot open the " << codec->name << " decoder" << std::endl;
+        return false;
+    }
+    packet_ = av_packet_alloc();
+    decoded_ = av_frame_alloc();
+    draining_ = false;
+    return packet_ && decoded_;
+}
+
+bool FileCapture::start() {
+    if (!opened_) return false;
+    pacer_.reset(1000000 / config_.fps);
+    started_ = true;
+    return true;
+}
+
+bool FileCapture::stop() {
+    started_ = false;
+    return true;
+}
+
+void FileCapture::close() {
+    started_ = false;
+    opened_ = false;
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    planar_.clear();
+    if (decoded_) av_frame_free(&decoded_);
+    if (packet_) av_packet_free(&packet_);
+    if (decoder_) avcodec_free_context(&decoder_);
+    if (format_) avformat_close_input(&format_);
+    streamIndex_ = -1;
+}
+
+bool FileCapture::readFrame(uint8_t* out) {
+    switch (kind_) {
+        case Kind::RawNv12:
+            return std::fread(out, 1, frameSize_, file_) == frameSize_;
+        case Kind::Y4m:
+            return readY4mFrame(out);
+        case Kind::Container:
+            return readContainerFrame(out);
+    }
+    return false;
+}
+
+bool FileCapture::readY4mFrame(uint8_t* out) {
+    std::string frameHeader;
+    if (!readLine(file_, frameHeader) || frameHeader.rfind("FRAME", 0) != 0) return false;
+    if (std::fread(planar_.data(), 1, frameSize_, file_) != frameSize_) return false;
+    const int w = config_.width;
+    const int h = config_.height;
+    const uint8_t* y = planar_.data();
+    const uint8_t* u = y + static_cast<size_t>(w) * h;
+    const uint8_t* v = u + static_cast<size_t>(w / 2) * (h / 2);
+    i420ToNv12(y, w, u, w / 2, v, w / 2, w, h, out);
+    return true;
+}
+
+bool FileCapture::readContainerFrame(uint8_t* out) {
+    while (true) {
+        const int ret = avcodec_receive_frame(decoder_, decoded_);
+        if (ret == 0) {
+            const int w = config_.width;
+            const int h = config_.height;
+            bool ok = true;
+            if (decoded_->width != w || decoded_->height != h) {
+                ok = false;
+            } else if (decoded_->format == AV_PIX_FMT_YUV420P || decoded_->format == AV_PIX_FMT_YUVJ420P) {
+                i420ToNv12(decoded_->data[0], decoded_->linesize[0], decoded_->data[1], decoded_->linesize[1],
+                           decoded_->data[2], decoded_->linesize[2], w, h, out);
+            } else if (decoded_->format == AV_PIX_FMT_NV12) {
+                copyPlane(out, w, decoded_->data[0], decoded_->linesize[0], w, h);
+                copyPlane(out + static_cast<size_t>(w) * h, w, decoded_->data[1], decoded_->linesize[1], w, h / 2);
+            } else {
+                ok = false;
+            }
+            if (!ok) {
+                std::cerr << "[FileCapture] Decoded frame is " << decoded_->width << "x" << decoded_->height
+                          << " format " << decoded_->format << "; expected " << w << "x" << h
+                          << " yuv420p or nv12 (re-encode with -pix_fmt yuv420p)" << std::endl;
+            }
+            av_frame_unref(decoded_);
+            return ok;
+        }
+        if (ret != AVERROR(EAGAIN)) return false;  // drained: end of file
+        if (draining_) return false;
+
+        if (av_read_frame(format_, packet_) < 0) {
+            draining_ = true;
+            avcodec_send_packet(decoder_, nullptr);
+            continue;
+        }
+        if (packet_->stream_index == streamIndex_) {
+            avcodec_send_packet(decoder_, packet_);
+        }
+        av_packet_unref(packet_);
+    }
+}
+
+void FileCapture::rewind() {
+    if (file_) {
+        std::fseek(file_, dataOffset_, SEEK_SET);
+    }
+    if (format_ && decoder_) {
+        av_seek_frame(format_, streamIndex_, 0, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(decoder_);
+        draining_ = false;
+    }
+}
+
+Frame FileCapture::captureFrame() {
+    if (!started_) return Frame{};
+    pacer_.wait();
+
+    Frame frame;
+    frame.data = FramePool::instance().acquire(frameSize_);
+    bool ok = readFrame(frame.data.data());
+    if (!ok) {
+        rewind();
+        ok = readFrame(frame.data.data());
+    }
+    if (!ok) {
+        // Unreadable even from the start; let the camera watchdog reopen it.
+        FramePool::instance().release(std::move(frame.data));
+        return Frame{};
+    }
+
+    frame.width = config_.width;
+    frame.height = config_.height;
+    frame.stride = config_.width;
+    frame.pixelFormat = "NV12";
+    frame.pts = steadyClockUs();
+    return frame;
+}
+
+bool FileCapture::isOpen() const {
+    return opened_;
+}
+
+std::string FileCapture::getName() const {
+    return "File replay (" + std::filesystem::path(config_.source).filename().string() + ")";
+}
+
+} // namespace reallive
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "platform/ICameraCapture.h"
+#include "platform/generic/FramePacer.h"
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVPacket;
+struct AVFrame;
+
+namespace reallive {
+
+// Replays a recorded clip as if it were the camera, paced at the configured
+// fps and looped at the end, so runs are repeatable. `source` is a .y4m
+// (4:2:0), a raw NV12 file (.nv12/.yuv/.raw) or any container FFmpeg can
+// decode to yuv420p/nv12 (e.g. .mp4). The clip must already have the
+// configured size; nothing is scaled.
+class FileCapture : public ICameraCapture {
+public:
+    FileCapture();
+    ~FileCapture() override;
+
+    bool open(const CaptureConfig& config) override;
+    bool start() override;
+    bool stop() override;
+    void close() override;
+    Frame captureFrame() override;
+    bool isOpen() const override;
+    std::string getName() const override;
+
+private:
+    enum class Kind { RawNv12, Y4m, Container };
+
+    bool openY4m();
+    bool openContainer();
+    bool checkSize(int width, int height) const;
+    // Next frame as NV12 into |out| (frame-sized); false at end of file.
+    bool readFrame(uint8_t* out);
+    bool readY4mFrame(uint8_t* out);
+    bool readContainerFrame(uint8_t* out);
+    void rewind();
+
+    CaptureConfig config_;
+    Kind kind_ = Kind::RawNv12;
+    size_t frameSize_ = 0;
+
+    std::FILE* file_ = nullptr;  // raw and y4m
+    long dataOffset_ = 0;        // first frame, for rewinding
+    std::vector<uint8_t> planar_;  // y4m I420 frame before interleaving
+
+    AVFormatContext* format_ = nullptr;
+    AVCodecContext* decoder_ = nullptr;
+    AVPacket* packet_ = nullptr;
+    AVFrame* decoded_ = nullptr;
+    int streamIndex_ = -1;
+    bool draining_ = false;
+
+    FramePacer pacer_;
+    bool opened_ = false;
+    std::atomic<bool> started_{false};
+};
+
+} // namespace reallive
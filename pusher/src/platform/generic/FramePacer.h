@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace reallive {
+
+// Hands out one tick per interval on the steady clock, the way a sensor or
+// sound card delivers at a fixed rate. A consumer that falls more than a
+// tick behind skips the backlog instead of bursting to catch up.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void reset(int64_t intervalUs) {
+        interval_ = std::chrono::microseconds(intervalUs > 0 ? intervalUs : 1);
+        next_ = Clock::now();
+    }
+
+    void wait() {
+        const auto now = Clock::now();
+        if (next_ > now) {
+            std::this_thread::sleep_until(next_);
+        } else if (now - next_ > interval_) {
+            next_ = now;
+        }
+        next_ += interval_;
+    }
+
+private:
+    Clock::duration interval_ = std::chrono::milliseconds(33);
+    Clock::time_point next_ = Clock::now();
+};
+
+} // namespace reallive
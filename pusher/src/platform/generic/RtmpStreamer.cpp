@@ -1,8 +1,7 @@
-#include "platform/rpi5/RtmpStreamer.h"
+#include "platform/generic/RtmpStreamer.h"
 
 #include <iostream>
 #include <cstring>
-#include <chrono>
 
 namespace reallive {
 
@@ -130,13 +129,11 @@ bool RtmpStreamer::sendVideoPacket(const EncodedPacket& packet) {
     if (videoStreamIdx_ < 0) return false;
     std::lock_guard<std::mutex> lock(writeMutex_);
 
-    auto sendStart = std::chrono::steady_clock::now();
-
     AVPacket* avpkt = av_packet_alloc();
     if (!avpkt) return false;
 
-    avpkt->data = const_cast<uint8_t*>(packet.data.data());
-    avpkt->size = static_cast<int>(packet.data.size());
+    avpkt->data = const_cast<uint8_t*>(packet.bytes());
+    avpkt->size = static_cast<int>(packet.size());
     avpkt->stream_index = videoStreamIdx_;
 
     // Rebase PTS relative to first frame
@@ -162,24 +159,6 @@ bool RtmpStreamer::sendVideoPacket(const EncodedPacket& packet) {
     int ret = av_interleaved_write_frame(formatCtx_, avpkt);
     av_packet_free(&avpkt);
 
-    auto sendEnd = std::chrono::steady_clock::now();
-    auto sendTime = std::chrono::duration_cast<std::chrono::microseconds>(sendEnd - sendStart);
-
-    static uint64_t sendCount = 0;
-    static uint64_t totalSendTime = 0;
-    sendCount++;
-    totalSendTime += sendTime.count();
-    
-    // Log every 30 frames (approx 1 second at 30fps)
-    if (sendCount % 30 == 0) {
-        std::cout << "[RTMP Send] Avg: " << (totalSendTime / sendCount / 1000.0) << "ms, "
-                  << "Last: " << (sendTime.count() / 1000.0) << "ms, "
-                  << "Size: " << packet.data.size() << "B"
-                  << (packet.isKeyframe ? " [KEY]" : "") << std::endl;
-        totalSendTime = 0;
-        sendCount = 0;
-    }
-
     if (ret < 0) {
         char errbuf[256];
         av_strerror(ret, errbuf, sizeof(errbuf));
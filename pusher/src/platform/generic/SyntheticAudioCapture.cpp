@@ -0,0 +1,81 @@
+#include "platform/generic/SyntheticAudioCapture.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace reallive {
+
+namespace {
+
+constexpr int kPeriodFrames = 1024;   // same as AlsaCapture
+constexpr double kToneHz = 440.0;
+constexpr double kAmplitude = 3276.0;  // about -20 dBFS
+
+} // namespace
+
+SyntheticAudioCapture::SyntheticAudioCapture() = default;
+
+SyntheticAudioCapture::~SyntheticAudioCapture() {
+    stop();
+}
+
+bool SyntheticAudioCapture::open(const AudioConfig& config) {
+    if (config.sampleRate <= 0 || config.channels <= 0 || config.bitsPerSample != 16) {
+        std::cerr << "[SyntheticAudio] Unsupported format: " << config.sampleRate << " Hz, "
+                  << config.channels << " ch, " << config.bitsPerSample << " bit" << std::endl;
+        return false;
+    }
+    config_ = config;
+    phase_ = 0.0;
+    sampleCount_ = 0;
+    opened_ = true;
+    return true;
+}
+
+bool SyntheticAudioCapture::start() {
+    if (!opened_) return false;
+    pacer_.reset(static_cast<int64_t>(kPeriodFrames) * 1000000 / config_.sampleRate);
+    started_ = true;
+    return true;
+}
+
+bool SyntheticAudioCapture::stop() {
+    started_ = false;
+    return true;
+}
+
+AudioFrame SyntheticAudioCapture::captureFrame() {
+    AudioFrame frame;
+    if (!started_) return frame;
+    pacer_.wait();
+
+    frame.data.resize(static_cast<size_t>(kPeriodFrames) * config_.channels * sizeof(int16_t));
+    int16_t* out = reinterpret_cast<int16_t*>(frame.data.data());
+    const double step = 2.0 * M_PI * kToneHz / config_.sampleRate;
+    for (int i = 0; i < kPeriodFrames; i++) {
+        const int16_t sample = static_cast<int16_t>(std::lround(kAmplitude * std::sin(phase_)));
+        phase_ += step;
+        for (int ch = 0; ch < config_.channels; ch++) {
+            *out++ = sample;
+        }
+    }
+    phase_ = std::fmod(phase_, 2.0 * M_PI);
+
+    frame.samples = kPeriodFrames;
+    frame.sampleRate = config_.sampleRate;
+    frame.channels = config_.channels;
+    frame.pts = sampleCount_ * 1000000LL / config_.sampleRate;
+    sampleCount_ += kPeriodFrames;
+    return frame;
+}
+
+bool SyntheticAudioCapture::isOpen() const {
+    return opened_;
+}
+
+std::string SyntheticAudioCapture::getName() const {
+    return "Synthetic 440 Hz tone";
+}
+
+} // namespace reallive
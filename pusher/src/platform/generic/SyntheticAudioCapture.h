@@ -0,0 +1,33 @@
+#pragma once
+
+#include "platform/IAudioCapture.h"
+#include "platform/generic/FramePacer.h"
+
+#include <atomic>
+
+namespace reallive {
+
+// 440 Hz tone in ALSA-sized periods of S16LE at the configured rate, paced
+// like a sound card. Needs no hardware.
+class SyntheticAudioCapture : public IAudioCapture {
+public:
+    SyntheticAudioCapture();
+    ~SyntheticAudioCapture() override;
+
+    bool open(const AudioConfig& config) override;
+    bool start() override;
+    bool stop() override;
+    AudioFrame captureFrame() override;
+    bool isOpen() const override;
+    std::string getName() const override;
+
+private:
+    AudioConfig config_;
+    FramePacer pacer_;
+    double phase_ = 0.0;
+    int64_t sampleCount_ = 0;
+    bool opened_ = false;
+    std::atomic<bool> started_{false};
+};
+
+} // namespace reallive
@@ -0,0 +1,145 @@
+#include "platform/generic/SyntheticCapture.h"
+#include "core/FramePool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace reallive {
+
+namespace {
+
+struct Bar {
+    uint8_t y;
+    uint8_t u;
+    uint8_t v;
+};
+
+// 75% colour bars, BT.601 limited range.
+constexpr Bar kBars[] = {
+    {180, 128, 128}, {162, 44, 142}, {131, 156, 44}, {112, 72, 58},
+    {84, 184, 198},  {65, 100, 212}, {35, 212, 114}, {16, 128, 128},
+};
+constexpr int kBarCount = sizeof(kBars) / sizeof(kBars[0]);
+
+int64_t steadyClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+SyntheticCapture::SyntheticCapture() = default;
+
+SyntheticCapture::~SyntheticCapture() {
+    close();
+}
+
+bool SyntheticCapture::open(const CaptureConfig& config) {
+    close();
+    if (config.width <= 0 || config.height <= 0 || (config.width % 2) || (config.height % 2) || config.fps <= 0) {
+        std::cerr << "[SyntheticCapture] Invalid size or fps: " << config.width << "x" << config.height
+                  << "@" << config.fps << std::endl;
+        return false;
+    }
+    config_ = config;
+
+    // Bars over the top two thirds, a luma ramp below.
+    const int w = config_.width;
+    const int h = config_.height;
+    background_.assign(static_cast<size_t>(w) * h * 3 / 2, 128);
+    uint8_t* luma = background_.data();
+    uint8_t* chroma = luma + static_cast<size_t>(w) * h;
+    const int barsBottom = (h * 2 / 3) & ~1;
+    for (int y = 0; y < h; y++) {
+        uint8_t* row = luma + static_cast<size_t>(y) * w;
+        for (int x = 0; x < w; x++) {
+            row[x] = y < barsBottom ? kBars[x * kBarCount / w].y : static_cast<uint8_t>(16 + x * 219 / w);
+        }
+    }
+    for (int y = 0; y < barsBottom / 2; y++) {
+        uint8_t* row = chroma + static_cast<size_t>(y) * w;
+        for (int x = 0; x < w; x += 2) {
+            const Bar& bar = kBars[x * kBarCount / w];
+            row[x] = bar.u;
+            row[x + 1] = bar.v;
+        }
+    }
+
+    frameIndex_ = 0;
+    opened_ = true;
+    std::cout << "[SyntheticCapture] Opened " << w << "x" << h << "@" << config_.fps << "fps" << std::endl;
+    return true;
+}
+
+bool SyntheticCapture::start() {
+    if (!opened_) return false;
+    pacer_.reset(1000000 / config_.fps);
+    started_ = true;
+    return true;
+}
+
+bool SyntheticCapture::stop() {
+    started_ = false;
+    return true;
+}
+
+void SyntheticCapture::close() {
+    started_ = false;
+    opened_ = false;
+    background_.clear();
+}
+
+void SyntheticCapture::drawBox(uint8_t* nv12) const {
+    // Sweeps left to right and back every 4 s while bobbing up and down,
+    // roughly the size of a person at a few metres.
+    const int w = config_.width;
+    const int h = config_.height;
+    const int boxW = std::max(2, w / 8) & ~1;
+    const int boxH = std::max(2, h / 3) & ~1;
+    const uint64_t sweep = static_cast<uint64_t>(config_.fps) * 4;
+    const uint64_t phase = frameIndex_ % (sweep * 2);
+    const double along = static_cast<double>(phase < sweep ? phase : sweep * 2 - phase) / sweep;
+    const double bob = std::sin(static_cast<double>(frameIndex_) * 2.0 * M_PI / (config_.fps * 3.0));
+    const int x0 = static_cast<int>(along * (w - boxW)) & ~1;
+    const int y0 = std::max(0, std::min(h - boxH, (h - boxH) / 2 + static_cast<int>(bob * h / 6))) & ~1;
+
+    uint8_t* luma = nv12;
+    for (int y = y0; y < y0 + boxH; y++) {
+        std::memset(luma + static_cast<size_t>(y) * w + x0, 220, static_cast<size_t>(boxW));
+    }
+    uint8_t* chroma = nv12 + static_cast<size_t>(w) * h;
+    for (int y = y0 / 2; y < (y0 + boxH) / 2; y++) {
+        std::memset(chroma + static_cast<size_t>(y) * w + x0, 128, static_cast<size_t>(boxW));
+    }
+}
+
+Frame SyntheticCapture::captureFrame() {
+    if (!started_) return Frame{};
+    pacer_.wait();
+
+    Frame frame;
+    frame.data = FramePool::instance().acquire(background_.size());
+    std::memcpy(frame.data.data(), background_.data(), background_.size());
+    drawBox(frame.data.data());
+    frameIndex_++;
+
+    frame.width = config_.width;
+    frame.height = config_.height;
+    frame.stride = config_.width;
+    frame.pixelFormat = "NV12";
+    frame.pts = steadyClockUs();
+    return frame;
+}
+
+bool SyntheticCapture::isOpen() const {
+    return opened_;
+}
+
+std::string SyntheticCapture::getName() const {
+    return "Synthetic test pattern";
+}
+
+} // namespace reallive
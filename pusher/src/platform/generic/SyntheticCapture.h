@@ -0,0 +1,39 @@
+#pragma once
+
+#include "platform/ICameraCapture.h"
+#include "platform/generic/FramePacer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace reallive {
+
+// NV12 test pattern at the configured size and fps: colour bars over a luma
+// ramp with a bright box sweeping across, so the motion gate, tracker and
+// encoder all see work. Needs no hardware.
+class SyntheticCapture : public ICameraCapture {
+public:
+    SyntheticCapture();
+    ~SyntheticCapture() override;
+
+    bool open(const CaptureConfig& config) override;
+    bool start() override;
+    bool stop() override;
+    void close() override;
+    Frame captureFrame() override;
+    bool isOpen() const override;
+    std::string getName() const override;
+
+private:
+    void drawBox(uint8_t* nv12) const;
+
+    CaptureConfig config_;
+    std::vector<uint8_t> background_;  // NV12, copied into every frame
+    FramePacer pacer_;
+    uint64_t frameIndex_ = 0;
+    bool opened_ = false;
+    std::atomic<bool> started_{false};
+};
+
+} // namespace reallive
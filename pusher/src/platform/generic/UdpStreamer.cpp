@@ -0,0 +1,306 @@
+#include "platform/generic/UdpStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace reallive {
+
+namespace {
+
+constexpr int kTsDatagramBytes = 7 * 188;  // fits a 1500-byte MTU with IP/UDP headers
+constexpr int kRtpDatagramBytes = 1400;    // leaves room for FEC / tunnel overhead
+constexpr int kDefaultBurstKb = 16;
+constexpr int kFallbackPaceKbps = 20000;
+constexpr int64_t kMuxDelayUs = 50000;     // PCR lead over DTS; the TS default is 700 ms
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+using WriteBuf = const uint8_t*;
+#else
+using WriteBuf = uint8_t*;
+#endif
+
+int writeCallback(void* opaque, WriteBuf buf, int size) {
+    return static_cast<UdpStreamer*>(opaque)->writeDatagram(buf, size);
+}
+
+std::string ffErr(int code) {
+    char buf[256];
+    av_strerror(code, buf, sizeof(buf));
+    return std::string(buf);
+}
+
+int64_t steadyUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Splits our own options off the query; the rest stays in |url| for
+// libavformat.
+std::string takeParam(std::string& url, const std::string& key) {
+    const size_t q = url.find('?');
+    if (q == std::string::npos) return "";
+    std::string kept;
+    std::string value;
+    size_t pos = q + 1;
+    while (pos <= url.size()) {
+        size_t end = url.find('&', pos);
+        if (end == std::string::npos) end = url.size();
+        const std::string pair = url.substr(pos, end - pos);
+        const size_t eq = pair.find('=');
+        if (pair.substr(0, eq) == key) {
+            value = eq == std::string::npos ? "" : pair.substr(eq + 1);
+        } else if (!pair.empty()) {
+            kept += (kept.empty() ? "" : "&") + pair;
+        }
+        pos = end + 1;
+    }
+    url = url.substr(0, q) + (kept.empty() ? "" : "?" + kept);
+    return value;
+}
+
+bool hasQueryParam(const std::string& url, const std::string& key) {
+    const size_t q = url.find('?');
+    if (q == std::string::npos) return false;
+    const std::string query = "&" + url.substr(q + 1);
+    return query.find("&" + key + "=") != std::string::npos;
+}
+
+// True when the access unit carries its own SPS before the first slice.
+bool hasInbandSps(const uint8_t* data, size_t size) {
+    for (size_t i = 0; i + 3 < size; i++) {
+        if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1) continue;
+        const int type = data[i + 3] & 0x1F;
+        if (type == 7) return true;
+        if (type == 1 || type == 5) return false;
+        i += 2;
+    }
+    return false;
+}
+
+} // namespace
+
+UdpStreamer::UdpStreamer() {
+    avformat_network_init();
+}
+
+UdpStreamer::~UdpStreamer() {
+    disconnect();
+    avformat_network_deinit();
+}
+
+bool UdpStreamer::handlesUrl(const std::string& url) {
+    return url.rfind("udp://", 0) == 0 || url.rfind("rtp://", 0) == 0;
+}
+
+bool UdpStreamer::connect(const StreamConfig& config) {
+    disconnect();
+    std::lock_guard<std::mutex> lock(writeMutex_);
+
+    // The stream key names an RTMP stream; a group:port needs none.
+    std::string url = config.url;
+    rtp_ = url.rfind("rtp://", 0) == 0;
+    const std::string paceRaw = takeParam(url, "pace_kbps");
+    const std::string burstRaw = takeParam(url, "burst_kb");
+    const std::string sdpFile = takeParam(url, "sdp_file");
+
+    int paceKbps = paceRaw.empty() ? 0 : std::atoi(paceRaw.c_str());
+    if (paceKbps <= 0) {
+        paceKbps = config.videoBitrate > 0 ? config.videoBitrate / 1000 * 4 : kFallbackPaceKbps;
+    }
+    const int burstKb = burstRaw.empty() ? kDefaultBurstKb : std::max(2, std::atoi(burstRaw.c_str()));
+    bytesPerUs_ = paceKbps * 1000.0 / 8.0 / 1e6;
+    burstBytes_ = burstKb * 1024.0;
+    tokens_ = burstBytes_;
+    lastRefillUs_ = steadyUs();
+
+    const int datagramBytes = rtp_ ? kRtpDatagramBytes : kTsDatagramBytes;
+    if (!hasQueryParam(url, "pkt_size")) {
+        url += (url.find('?') == std::string::npos ? "?" : "&") + std::string("pkt_size=") +
+               std::to_string(datagramBytes);
+    }
+
+    int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, rtp_ ? "rtp" : "mpegts", url.c_str());
+    if (ret < 0 || !formatCtx_) {
+        std::cerr << "[UdpStreamer] Failed to allocate output context: " << ffErr(ret) << std::endl;
+        formatCtx_ = nullptr;
+        return false;
+    }
+    formatCtx_->max_delay = kMuxDelayUs;
+
+    AVStream* videoStream = avformat_new_stream(formatCtx_, nullptr);
+    if (!videoStream) {
+        std::cerr << "[UdpStreamer] Failed to create video stream" << std::endl;
+        close();
+        return false;
+    }
+    videoStream->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    videoStream->codecpar->codec_id = AV_CODEC_ID_H264;
+    videoStream->time_base = {1, 90000};
+    if (config.videoWidth > 0 && config.videoHeight > 0) {
+        videoStream->codecpar->width = config.videoWidth;
+        videoStream->codecpar->height = config.videoHeight;
+    }
+    extraData_.clear();
+    if (config.videoExtraData && config.videoExtraDataSize > 0) {
+        extraData_.assign(config.videoExtraData, config.videoExtraData + config.videoExtraDataSize);
+        videoStream->codecpar->extradata = static_cast<uint8_t*>(
+            av_mallocz(config.videoExtraDataSize + AV_INPUT_BUFFER_PADDING_SIZE));
+        memcpy(videoStream->codecpar->extradata, config.videoExtraData, config.videoExtraDataSize);
+        videoStream->codecpar->extradata_size = config.videoExtraDataSize;
+    }
+
+    // The protocol does the socket work (multicast TTL, FEC, DSCP); the muxer
+    // writes into our AVIO so every datagram goes through the pacer first.
+    ret = avio_open2(&sink_, url.c_str(), AVIO_FLAG_WRITE, nullptr, nullptr);
+    if (ret < 0) {
+        std::cerr << "[UdpStreamer] Failed to open " << url << ": " << ffErr(ret) << std::endl;
+        close();
+        return false;
+    }
+    auto* buffer = static_cast<unsigned char*>(av_malloc(datagramBytes));
+    formatCtx_->pb = buffer ? avio_alloc_context(buffer, datagramBytes, 1, this, nullptr, &writeCallback, nullptr)
+                            : nullptr;
+    if (!formatCtx_->pb) {
+        av_free(buffer);
+        close();
+        return false;
+    }
+    formatCtx_->pb->max_packet_size = datagramBytes;
+    formatCtx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    // mpegts already repeats PAT/PMT (and the SPS/PPS) at every keyframe, so
+    // a receiver joining the group locks on at the next IDR.
+    ret = avformat_write_header(formatCtx_, nullptr);
+    if (ret < 0) {
+        std::cerr << "[UdpStreamer] Failed to write header: " << ffErr(ret) << std::endl;
+        close();
+        return false;
+    }
+    headerWritten_ = true;
+
+    if (rtp_) {
+        char sdp[2048];
+        if (av_sdp_create(&formatCtx_, 1, sdp, sizeof(sdp)) == 0) {
+            std::cout << "[UdpStreamer] SDP:\n" << sdp << std::endl;
+            if (!sdpFile.empty()) {
+                std::ofstream out(sdpFile, std::ios::trunc);
+                out << sdp;
+            }
+        }
+    }
+
+    connected_ = true;
+    videoStartPts_ = -1;
+    std::cout << "[UdpStreamer] Sending " << (rtp_ ? "RTP/H.264" : "MPEG-TS") << " to " << config.url
+              << " paced at " << paceKbps << " kbps" << std::endl;
+    return true;
+}
+
+void UdpStreamer::pace(size_t bytes) {
+    const int64_t now = steadyUs();
+    tokens_ = std::min(burstBytes_, tokens_ + (now - lastRefillUs_) * bytesPerUs_);
+    lastRefillUs_ = now;
+    tokens_ -= static_cast<double>(bytes);
+    if (tokens_ < 0) {
+        const auto waitUs = static_cast<int64_t>(-tokens_ / bytesPerUs_);
+        std::this_thread::sleep_for(std::chrono::microseconds(waitUs));
+    }
+}
+
+int UdpStreamer::writeDatagram(const uint8_t* buf, int size) {
+    if (!sink_) return AVERROR(EIO);
+    pace(static_cast<size_t>(size));
+    avio_write(sink_, buf, size);
+    avio_flush(sink_);
+    return sink_->error < 0 ? sink_->error : size;
+}
+
+bool UdpStreamer::sendVideoPacket(const EncodedPacket& packet) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (!connected_ || !formatCtx_ || !headerWritten_) return false;
+
+    const uint8_t* data = packet.bytes();
+    size_t size = packet.size();
+    // The RTP payloader sends only what is in the packet; mpegts inserts
+    // the extradata on its own.
+    if (rtp_ && packet.isKeyframe && !extraData_.empty() && !hasInbandSps(data, size)) {
+        scratch_.assign(extraData_.begin(), extraData_.end());
+        scratch_.insert(scratch_.end(), data, data + size);
+        data = scratch_.data();
+        size = scratch_.size();
+    }
+
+    AVPacket* avpkt = av_packet_alloc();
+    if (!avpkt) return false;
+    avpkt->data = const_cast<uint8_t*>(data);
+    avpkt->size = static_cast<int>(size);
+    avpkt->stream_index = 0;
+
+    if (videoStartPts_ < 0) {
+        videoStartPts_ = packet.pts;
+    }
+    const int64_t pts = std::max<int64_t>(0, packet.pts - videoStartPts_);
+    const int64_t dts = std::max<int64_t>(0, packet.dts - videoStartPts_);
+    const AVRational tb = formatCtx_->streams[0]->time_base;
+    avpkt->pts = av_rescale_q(pts, {1, 1000000}, tb);
+    avpkt->dts = av_rescale_q(dts, {1, 1000000}, tb);
+    if (packet.isKeyframe) {
+        avpkt->flags |= AV_PKT_FLAG_KEY;
+    }
+
+    int ret = av_write_frame(formatCtx_, avpkt);
+    av_packet_free(&avpkt);
+    if (ret >= 0) {
+        avio_flush(formatCtx_->pb);  // the tail of the frame, not the next one
+        ret = formatCtx_->pb->error;
+    }
+    if (ret < 0) {
+        std::cerr << "[UdpStreamer] Failed to send video packet: " << ffErr(ret) << std::endl;
+        connected_ = false;
+        return false;
+    }
+    return true;
+}
+
+bool UdpStreamer::sendAudioPacket(const AudioFrame& frame) {
+    (void)frame;
+    return true;
+}
+
+void UdpStreamer::close() {
+    if (formatCtx_) {
+        if (headerWritten_) {
+            av_write_trailer(formatCtx_);
+            headerWritten_ = false;
+        }
+        if (formatCtx_->pb && (formatCtx_->flags & AVFMT_FLAG_CUSTOM_IO)) {
+            av_freep(&formatCtx_->pb->buffer);
+            avio_context_free(&formatCtx_->pb);
+        }
+        avformat_free_context(formatCtx_);
+        formatCtx_ = nullptr;
+    }
+    if (sink_) {
+        avio_closep(&sink_);
+    }
+    connected_ = false;
+}
+
+void UdpStreamer::disconnect() {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    close();
+}
+
+bool UdpStreamer::isConnected() const {
+    return connected_;
+}
+
+std::string UdpStreamer::getName() const {
+    return rtp_ ? "RTP/H.264 Streamer (FFmpeg/libavformat)" : "MPEG-TS/UDP Streamer (FFmpeg/libavformat)";
+}
+
+} // namespace reallive
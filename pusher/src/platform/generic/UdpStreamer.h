@@ -0,0 +1,69 @@
+#pragma once
+
+#include "platform/IStreamer.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace reallive {
+
+// Connectionless push for LAN monitoring walls, usually to a multicast group:
+//   udp://239.1.1.1:5000  MPEG-TS, 7 TS packets per datagram
+//   rtp://239.1.1.1:5004  RTP/H.264 (RFC 6184), SPS/PPS in-band before every IDR
+// Unlike RTMP there is no TCP head-of-line blocking and no per-packet
+// round trip; a lost datagram costs one slice, not a stall.
+//
+// Datagrams leave through a token bucket so an IDR is spread over a few ms
+// instead of hitting the switch as one burst. Query parameters consumed here:
+//   pace_kbps  pacing rate (default 4x the encoder bitrate)
+//   burst_kb   bucket depth (default 16)
+//   sdp_file   rtp only: where to write the SDP receivers need
+// Everything else goes to the libavformat protocol (ttl, localaddr, dscp,
+// buffer_size, and for rtp "fec=prompeg=l=5:d=5" for SMPTE 2022-1 FEC).
+// The telemetry/timing SEI ride in the H.264 bitstream as with RTMP.
+// Video only: sendAudioPacket() accepts and discards.
+class UdpStreamer : public IStreamer {
+public:
+    UdpStreamer();
+    ~UdpStreamer() override;
+
+    static bool handlesUrl(const std::string& url);
+
+    bool connect(const StreamConfig& config) override;
+    bool sendVideoPacket(const EncodedPacket& packet) override;
+    bool sendAudioPacket(const AudioFrame& frame) override;
+    void disconnect() override;
+    bool isConnected() const override;
+    std::string getName() const override;
+
+    // Muxer output, one datagram per call (AVIO write callback).
+    int writeDatagram(const uint8_t* buf, int size);
+
+private:
+    void pace(size_t bytes);
+    void close();
+
+    bool rtp_ = false;
+    AVFormatContext* formatCtx_ = nullptr;
+    AVIOContext* sink_ = nullptr;  // udp:// or rtp:// protocol, one datagram per flush
+    bool headerWritten_ = false;
+    bool connected_ = false;
+    std::vector<uint8_t> extraData_;  // Annex-B SPS/PPS for rtp keyframes
+    std::vector<uint8_t> scratch_;
+
+    double bytesPerUs_ = 0.0;
+    double burstBytes_ = 0.0;
+    double tokens_ = 0.0;
+    int64_t lastRefillUs_ = 0;
+
+    int64_t videoStartPts_ = -1;
+    std::mutex writeMutex_;
+};
+
+} // namespace reallive
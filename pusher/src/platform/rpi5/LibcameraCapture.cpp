@@ -1,4 +1,5 @@
 #include "platform/rpi5/LibcameraCapture.h"
+#include "core/FramePool.h"
 
 #include <libcamera/libcamera.h>
 #include <libcamera/controls.h>
@@ -8,39 +9,89 @@
 #include <iostream>
 #include <cstring>
 #include <chrono>
+#include <ctime>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <map>
 
 namespace reallive {
 
-LibcameraCapture::LibcameraCapture() {
-    // Pre-allocate circular buffer to avoid runtime allocation
-    frameQueue_.reserve(kMaxQueueSize);
+namespace {
+
+// libcamera reports SensorTimestamp in nanoseconds on CLOCK_BOOTTIME, while
+// frame pts live in the steady_clock (CLOCK_MONOTONIC) domain.
+int64_t bootTimeNsToSteadyUs(int64_t bootNs) {
+    timespec boot{};
+    timespec mono{};
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    const int64_t offsetNs = (static_cast<int64_t>(boot.tv_sec) - mono.tv_sec) * 1000000000LL +
+                             (static_cast<int64_t>(boot.tv_nsec) - mono.tv_nsec);
+    return (bootNs - offsetNs) / 1000;
 }
 
-LibcameraCapture::~LibcameraCapture() {
-    stop();
-    if (camera_) {
-        camera_->release();
+// libcamera allows a single CameraManager per process; every capture (one
+// per camera in a multi-camera process) shares it. Stopped with the last user.
+std::shared_ptr<libcamera::CameraManager> acquireCameraManager() {
+    static std::mutex mutex;
+    static std::weak_ptr<libcamera::CameraManager> shared;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto manager = shared.lock()) return manager;
+    auto manager = std::make_unique<libcamera::CameraManager>();
+    const int ret = manager->start();
+    if (ret != 0) {
+        std::cerr << "[LibcameraCapture] Failed to start CameraManager: " << ret << std::endl;
+        return nullptr;
     }
-    if (cameraManager_) {
-        cameraManager_->stop();
+    std::shared_ptr<libcamera::CameraManager> started(manager.release(), [](libcamera::CameraManager* m) {
+        m->stop();
+        delete m;
+    });
+    shared = started;
+    return started;
+}
+
+// |device| is empty (first camera), an index, a full libcamera id or a
+// unique part of one such as "imx708@1a" or "i2c@80000".
+std::shared_ptr<libcamera::Camera> pickCamera(const std::vector<std::shared_ptr<libcamera::Camera>>& cameras,
+                                              const std::string& device) {
+    if (device.empty()) return cameras.front();
+    const bool numeric = std::all_of(device.begin(), device.end(),
+                                     [](unsigned char ch) { return std::isdigit(ch) != 0; });
+    if (numeric) {
+        const size_t index = static_cast<size_t>(std::atoi(device.c_str()));
+        return index < cameras.size() ? cameras[index] : nullptr;
     }
-    // Unmap all regions
-    for (auto& region : mmapRegions_) {
-        if (region.ptr && region.ptr != MAP_FAILED) {
-            munmap(region.ptr, region.length);
+    std::shared_ptr<libcamera::Camera> match;
+    for (const auto& camera : cameras) {
+        if (camera->id() == device) return camera;
+        if (camera->id().find(device) != std::string::npos) {
+            if (match) return nullptr;  // ambiguous
+            match = camera;
         }
     }
+    return match;
+}
+
+} // namespace
+
+LibcameraCapture::LibcameraCapture() {
+    // Pre-allocate circular buffer to avoid runtime allocation
+    frameQueue_.reserve(kMaxQueueSize);
+}
+
+LibcameraCapture::~LibcameraCapture() {
+    close();
 }
 
 bool LibcameraCapture::open(const CaptureConfig& config) {
+    // libcamera allows one CameraManager per process; drop the old one first.
+    close();
     config_ = config;
 
-    // Start camera manager
-    cameraManager_ = std::make_unique<libcamera::CameraManager>();
-    int ret = cameraManager_->start();
-    if (ret != 0) {
-        std::cerr << "[LibcameraCapture] Failed to start CameraManager: " << ret << std::endl;
+    cameraManager_ = acquireCameraManager();
+    if (!cameraManager_) {
         return false;
     }
 
@@ -51,12 +102,19 @@ bool LibcameraCapture::open(const CaptureConfig& config) {
         return false;
     }
 
-    // Use first camera
-    camera_ = cameras[0];
+    camera_ = pickCamera(cameras, config.device);
+    if (!camera_) {
+        std::cerr << "[LibcameraCapture] No single camera matches '" << config.device << "'; available:";
+        for (const auto& camera : cameras) {
+            std::cerr << " " << camera->id();
+        }
+        std::cerr << std::endl;
+        return false;
+    }
     std::cout << "[LibcameraCapture] Using camera: " << camera_->id() << std::endl;
 
-    // Acquire camera
-    ret = camera_->acquire();
+    // Acquire camera (fails if another pipeline already holds it)
+    int ret = camera_->acquire();
     if (ret != 0) {
         std::cerr << "[LibcameraCapture] Failed to acquire camera: " << ret << std::endl;
         return false;
@@ -212,6 +270,34 @@ bool LibcameraCapture::stop() {
     return true;
 }
 
+void LibcameraCapture::close() {
+    stop();
+    requests_.clear();
+    bufferPlanes_.clear();
+    // Unmap all regions
+    for (auto& region : mmapRegions_) {
+        if (region.ptr && region.ptr != MAP_FAILED) {
+            munmap(region.ptr, region.length);
+        }
+    }
+    mmapRegions_.clear();
+    allocator_.reset();
+    if (camera_) {
+        camera_->requestCompleted.disconnect(this);
+        camera_->release();
+        camera_.reset();
+    }
+    cameraConfig_.reset();
+    cameraManager_.reset();
+    {
+        std::lock_guard<std::mutex> lock(frameMutex_);
+        queueCount_ = 0;
+        queueHead_ = 0;
+        queueTail_ = 0;
+    }
+    opened_ = false;
+}
+
 void LibcameraCapture::requestComplete(libcamera::Request* request) {
     if (request->status() == libcamera::Request::RequestCancelled) {
         return;
@@ -234,7 +320,7 @@ void LibcameraCapture::requestComplete(libcamera::Request* request) {
 
         // Create new frame
         Frame newFrame;
-        newFrame.data.resize(totalSize);
+        newFrame.data = FramePool::instance().acquire(totalSize);
 
         // Copy from the correct mmap'd planes
         size_t offset = 0;
@@ -251,8 +337,19 @@ void LibcameraCapture::requestComplete(libcamera::Request* request) {
         newFrame.height = config_.height;
         newFrame.stride = config_.width;
         newFrame.pixelFormat = "NV12";
-        newFrame.pts = std::chrono::duration_cast<std::chrono::microseconds>(
+        // Stamp with the sensor exposure time so downstream latency covers
+        // ISP and request completion; fall back to "now" if it is missing or
+        // implausible (later than now or over a second old).
+        const int64_t completeUs = std::chrono::duration_cast<std::chrono::microseconds>(
             std::chrono::steady_clock::now().time_since_epoch()).count();
+        newFrame.pts = completeUs;
+        const auto sensorNs = request->metadata().get(libcamera::controls::SensorTimestamp);
+        if (sensorNs) {
+            const int64_t sensorUs = bootTimeNsToSteadyUs(*sensorNs);
+            if (sensorUs <= completeUs && completeUs - sensorUs < 1000000) {
+                newFrame.pts = sensorUs;
+            }
+        }
 
         // Add to circular queue with lock
         {
@@ -269,16 +366,11 @@ void LibcameraCapture::requestComplete(libcamera::Request* request) {
             if (frameQueue_.size() < kMaxQueueSize) {
                 frameQueue_.push_back(std::move(newFrame));
             } else {
+                FramePool::instance().release(std::move(frameQueue_[queueTail_].data));
                 frameQueue_[queueTail_] = std::move(newFrame);
             }
             queueTail_ = (queueTail_ + 1) % kMaxQueueSize;
             queueCount_++;
-            
-            // Also update legacy single-frame for compatibility
-            if (!frameQueue_.empty()) {
-                latestFrame_ = frameQueue_[(queueTail_ + kMaxQueueSize - 1) % kMaxQueueSize];
-                frameReady_ = true;
-            }
         }
         
         frameCv_.notify_one();
@@ -309,7 +401,6 @@ Frame LibcameraCapture::captureFrame() {
     queueCount_ = 0;
     queueHead_ = 0;
     queueTail_ = 0;
-    frameReady_ = false;
     
     return result;
 }
@@ -31,6 +31,7 @@ public:
     bool open(const CaptureConfig& config) override;
     bool start() override;
     bool stop() override;
+    void close() override;
     Frame captureFrame() override;
     bool isOpen() const override;
     std::string getName() const override;
@@ -38,7 +39,7 @@ public:
 private:
     void requestComplete(libcamera::Request* request);
 
-    std::unique_ptr<libcamera::CameraManager> cameraManager_;
+    std::shared_ptr<libcamera::CameraManager> cameraManager_;  // process-wide
     std::shared_ptr<libcamera::Camera> camera_;
     std::unique_ptr<libcamera::CameraConfiguration> cameraConfig_;
     std::unique_ptr<libcamera::FrameBufferAllocator> allocator_;
@@ -60,10 +61,6 @@ private:
     
     // Dropped frames counter
     std::atomic<uint64_t> droppedFrames_{0};
-    
-    // Legacy single frame support (for compatibility)
-    Frame latestFrame_;
-    bool frameReady_ = false;
 
     // Memory-mapped regions (for cleanup)
     struct MmapRegion {
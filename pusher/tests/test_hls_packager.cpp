@@ -0,0 +1,145 @@
+/**
+ * HLS Packager Tests
+ *
+ * Records a few GOPs with the real LocalRecorder, packages the segment that
+ * is still being written into an init segment plus an LL-HLS part, and
+ * demuxes the result to check the samples survive intact.
+ */
+
+#include <gtest/gtest.h>
+#include "core/HlsPackager.h"
+#include "core/LocalRecorder.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace reallive;
+namespace fs = std::filesystem;
+
+namespace {
+
+// High profile 320x240 SPS and a matching PPS, as an encoder hands them out.
+const std::vector<uint8_t> kSps = {0x67, 0x64, 0x00, 0x1e, 0xac, 0xb4, 0x0a, 0x0f, 0xc8};
+const std::vector<uint8_t> kPps = {0x68, 0xce, 0x3c, 0x80};
+
+std::vector<uint8_t> annexB(const std::vector<std::vector<uint8_t>>& nals) {
+    std::vector<uint8_t> out;
+    for (const auto& nal : nals) {
+        out.insert(out.end(), {0, 0, 0, 1});
+        out.insert(out.end(), nal.begin(), nal.end());
+    }
+    return out;
+}
+
+std::vector<uint8_t> lengthPrefixed(const std::vector<uint8_t>& nal) {
+    const uint32_t n = static_cast<uint32_t>(nal.size());
+    std::vector<uint8_t> out = {static_cast<uint8_t>(n >> 24), static_cast<uint8_t>(n >> 16),
+                                static_cast<uint8_t>(n >> 8), static_cast<uint8_t>(n)};
+    out.insert(out.end(), nal.begin(), nal.end());
+    return out;
+}
+
+// A slice NAL whose payload is just a recognisable pattern; nothing here
+// decodes it.
+std::vector<uint8_t> sliceNal(int frame, bool keyframe) {
+    std::vector<uint8_t> nal = {static_cast<uint8_t>(keyframe ? 0x65 : 0x41)};
+    for (int i = 0; i < 200 + frame; i++) {
+        nal.push_back(static_cast<uint8_t>(0x10 + (frame * 7 + i) % 0xE0));
+    }
+    return nal;
+}
+
+class HlsPackagerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        tempDir = fs::temp_directory_path() / ("reallive_hls_test_" + std::to_string(::getpid()));
+        fs::create_directories(tempDir);
+    }
+
+    void TearDown() override {
+        recorder.close();
+        fs::remove_all(tempDir);
+    }
+
+    fs::path tempDir;
+    LocalRecorder recorder;
+};
+
+} // namespace
+
+TEST_F(HlsPackagerTest, LivePartDemuxesToTheRecordedSamples) {
+    RecordConfig config;
+    config.enabled = true;
+    config.outputDir = tempDir.string();
+    config.preallocate = false;
+    config.generateThumbnails = false;
+    const std::vector<uint8_t> extra = annexB({kSps, kPps});
+    ASSERT_TRUE(recorder.init(config, "cam", extra.data(), static_cast<int>(extra.size()), 320, 240, 1000000));
+
+    // Following the live segment makes the recorder flush at every keyframe.
+    LocalRecorder::LiveSegment snapshot;
+    recorder.liveSegment(snapshot);
+
+    constexpr int kGopFrames = 3;
+    std::vector<std::vector<uint8_t>> firstGop;
+    for (int f = 0; f < 3 * kGopFrames; f++) {
+        const bool key = f % kGopFrames == 0;
+        const std::vector<uint8_t> nal = sliceNal(f, key);
+        if (f < kGopFrames) firstGop.push_back(nal);
+        EncodedPacket pkt;
+        pkt.data = annexB({nal});
+        pkt.pts = pkt.dts = f * 33333;
+        pkt.isKeyframe = key;
+        ASSERT_TRUE(recorder.writeVideoPacket(pkt));
+    }
+
+    ASSERT_TRUE(recorder.liveSegment(snapshot));
+    ASSERT_GE(snapshot.index.gops().size(), 1u);
+    ASSERT_FALSE(snapshot.avcc.empty());
+    EXPECT_EQ(snapshot.avcc[0], 1);
+
+    const HlsPackager::LiveSource live = [this](LocalRecorder::LiveSegment& out) {
+        return recorder.liveSegment(out);
+    };
+    HlsPackager packager(tempDir.string());
+    std::string init;
+    std::string part;
+    ASSERT_TRUE(packager.initSegment("cam", snapshot.startMs, live, init));
+    ASSERT_TRUE(packager.fragment("cam", snapshot.startMs, 0, 1, live, part));
+
+    const fs::path packaged = tempDir / "part.mp4";
+    {
+        std::ofstream f(packaged, std::ios::binary);
+        f << init << part;
+    }
+
+    AVFormatContext* in = nullptr;
+    ASSERT_EQ(avformat_open_input(&in, packaged.c_str(), nullptr, nullptr), 0);
+    ASSERT_EQ(in->nb_streams, 1u);
+    const AVCodecParameters* par = in->streams[0]->codecpar;
+    EXPECT_EQ(par->codec_id, AV_CODEC_ID_H264);
+    ASSERT_GT(par->extradata_size, 0);
+    EXPECT_EQ(par->extradata[0], 1);  // avcC, not Annex-B
+
+    AVPacket* pkt = av_packet_alloc();
+    size_t count = 0;
+    while (av_read_frame(in, pkt) >= 0) {
+        ASSERT_LT(count, firstGop.size());
+        const std::vector<uint8_t> expected = lengthPrefixed(firstGop[count]);
+        EXPECT_EQ(std::vector<uint8_t>(pkt->data, pkt->data + pkt->size), expected) << "sample " << count;
+        EXPECT_EQ((pkt->flags & AV_PKT_FLAG_KEY) != 0, count == 0);
+        av_packet_unref(pkt);
+        count++;
+    }
+    EXPECT_EQ(count, firstGop.size());
+    av_packet_free(&pkt);
+    avformat_close_input(&in);
+}
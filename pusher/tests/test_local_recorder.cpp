@@ -0,0 +1,108 @@
+/**
+ * Local Recorder Tests
+ *
+ * Startup handling of segment_<ms>_open.writing files left behind by a
+ * crash: a complete file is finalized, one without a moov is deleted.
+ */
+
+#include <gtest/gtest.h>
+#include "core/LocalRecorder.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace reallive;
+namespace fs = std::filesystem;
+
+namespace {
+
+// High profile 320x240 SPS and PPS; the slices are never decoded.
+const std::vector<uint8_t> kExtra = {0, 0, 0, 1, 0x67, 0x64, 0x00, 0x1e, 0xac, 0xb4, 0x0a, 0x0f, 0xc8,
+                                     0, 0, 0, 1, 0x68, 0xce, 0x3c, 0x80};
+
+EncodedPacket slicePacket(int frame, bool keyframe) {
+    EncodedPacket pkt;
+    pkt.data = {0, 0, 0, 1, static_cast<uint8_t>(keyframe ? 0x65 : 0x41)};
+    for (int i = 0; i < 200; i++) pkt.data.push_back(static_cast<uint8_t>(0x10 + (frame + i) % 0xE0));
+    pkt.pts = pkt.dts = frame * 33333;
+    pkt.isKeyframe = keyframe;
+    return pkt;
+}
+
+std::vector<fs::path> filesWithExtension(const fs::path& dir, const std::string& ext) {
+    std::vector<fs::path> out;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().extension() == ext) out.push_back(entry.path());
+    }
+    return out;
+}
+
+class LocalRecorderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        tempDir = fs::temp_directory_path() / ("reallive_recorder_test_" + std::to_string(::getpid()));
+        fs::create_directories(tempDir);
+        config.enabled = true;
+        config.outputDir = tempDir.string();
+        config.preallocate = false;
+        config.generateThumbnails = false;
+    }
+
+    void TearDown() override {
+        recorder.close();
+        fs::remove_all(tempDir);
+    }
+
+    bool init() {
+        return recorder.init(config, "cam", kExtra.data(), static_cast<int>(kExtra.size()), 320, 240, 1000000);
+    }
+
+    fs::path tempDir;
+    RecordConfig config;
+    LocalRecorder recorder;
+};
+
+} // namespace
+
+TEST_F(LocalRecorderTest, CompleteOrphanIsFinalizedUnderItsIndexName) {
+    ASSERT_TRUE(init());
+    for (int f = 0; f < 6; f++) {
+        ASSERT_TRUE(recorder.writeVideoPacket(slicePacket(f, f % 3 == 0)));
+    }
+    recorder.close();
+
+    const std::vector<fs::path> segments = filesWithExtension(tempDir / "cam", ".mp4");
+    ASSERT_EQ(segments.size(), 1u);
+    const fs::path finalPath = segments[0];
+    ASSERT_TRUE(fs::exists(fs::path(finalPath).replace_extension(".idx")));
+
+    // As if the process died between saving the index and the rename.
+    const std::string stem = finalPath.stem().string();
+    const std::string startMs = stem.substr(8, stem.find('_', 8) - 8);
+    const fs::path orphan = tempDir / "cam" / ("segment_" + startMs + "_open.writing");
+    fs::rename(finalPath, orphan);
+
+    config.mode = "event";  // opens nothing new at init
+    ASSERT_TRUE(init());
+    EXPECT_FALSE(fs::exists(orphan));
+    EXPECT_TRUE(fs::exists(finalPath));
+}
+
+TEST_F(LocalRecorderTest, OrphanWithoutMoovIsDeleted) {
+    fs::create_directories(tempDir / "cam");
+    const fs::path orphan = tempDir / "cam" / "segment_1700000000000_open.writing";
+    {
+        std::ofstream f(orphan, std::ios::binary);
+        const std::string ftyp("\0\0\0\x18" "ftypisom\0\0\x02\0isomiso2", 24);
+        f << ftyp << std::string(4096, '\0');
+    }
+
+    config.mode = "event";
+    ASSERT_TRUE(init());
+    EXPECT_FALSE(fs::exists(orphan));
+    EXPECT_TRUE(filesWithExtension(tempDir / "cam", ".mp4").empty());
+}
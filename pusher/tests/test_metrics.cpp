@@ -0,0 +1,61 @@
+/**
+ * Metrics Tests
+ *
+ * Histogram bucket bounds and the cumulative le buckets rendered for
+ * Prometheus, around power-of-two boundaries.
+ */
+
+#include <gtest/gtest.h>
+#include "core/Metrics.h"
+
+#include <string>
+
+using namespace reallive;
+
+namespace {
+
+// Value of `<name>_bucket{le="<le>"}` in a rendered exposition.
+std::string bucketLine(const std::string& text, const std::string& name, const std::string& le) {
+    const std::string key = name + "_bucket{le=\"" + le + "\"} ";
+    const size_t pos = text.find(key);
+    if (pos == std::string::npos) return "missing";
+    const size_t end = text.find('\n', pos);
+    return text.substr(pos + key.size(), end - pos - key.size());
+}
+
+} // namespace
+
+TEST(MetricsTest, SampleOnABoundCountsIntoThatBound) {
+    MetricsRegistry registry;
+    Histogram& h = registry.histogram("test_seconds", "Test histogram");
+    h.observe(1024);
+    h.observe(1025);
+
+    const std::string text = registry.renderPrometheus();
+    EXPECT_EQ(bucketLine(text, "test_seconds", "0.000512"), "0");
+    EXPECT_EQ(bucketLine(text, "test_seconds", "0.001024"), "1");
+    EXPECT_EQ(bucketLine(text, "test_seconds", "0.002048"), "2");
+    EXPECT_EQ(bucketLine(text, "test_seconds", "+Inf"), "2");
+}
+
+TEST(MetricsTest, BucketUpperBoundIsInclusive) {
+    Histogram h;
+    h.observe(64);
+    Histogram::Snapshot s = h.snapshot();
+    EXPECT_EQ(s.quantileUs(1.0), 64u);
+
+    h.observe(65);
+    s = h.snapshot();
+    EXPECT_GT(s.quantileUs(1.0), 64u);
+    EXPECT_EQ(s.quantileUs(0.0), 64u);
+}
+
+TEST(MetricsTest, ZeroAndOneShareTheFirstBucket) {
+    Histogram h;
+    h.observe(0);
+    h.observe(-5);
+    h.observe(1);
+    const Histogram::Snapshot s = h.snapshot();
+    EXPECT_EQ(s.count, 3u);
+    EXPECT_EQ(s.quantileUs(1.0), 1u);
+}
@@ -0,0 +1,171 @@
+/**
+ * Motion Zones Tests
+ *
+ * Parses detect_zones through Config, then rasterizes zones onto a grid
+ * wider than one 64-bit mask word and checks the thresholded cells, the
+ * exclusion mask and the per-region scores.
+ */
+
+#include <gtest/gtest.h>
+#include "core/Config.h"
+#include "core/MotionZones.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace reallive;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kGridW = 70;  // 4 SIMD blocks + a scalar tail per row, 2 mask words
+constexpr int kGridH = 4;
+constexpr size_t kCells = static_cast<size_t>(kGridW) * kGridH;
+
+MotionZoneConfig rect(bool exclude, double x0, double x1) {
+    MotionZoneConfig zone;
+    zone.exclude = exclude;
+    zone.points = {{x0, 0.0}, {x1, 0.0}, {x1, 1.0}, {x0, 1.0}};
+    return zone;
+}
+
+// Previous frame flat at 100, current one 100 + delta per cell.
+struct Frames {
+    std::vector<uint8_t> prev = std::vector<uint8_t>(kCells, 100);
+    std::vector<uint8_t> cur = std::vector<uint8_t>(kCells, 100);
+    std::vector<uint8_t> out = std::vector<uint8_t>(kCells, 0xAA);
+
+    void set(int delta) { std::fill(cur.begin(), cur.end(), static_cast<uint8_t>(100 + delta)); }
+    void setRow(int y, int delta) {
+        std::fill(cur.begin() + y * kGridW, cur.begin() + (y + 1) * kGridW, static_cast<uint8_t>(100 + delta));
+    }
+};
+
+size_t countSet(const std::vector<uint8_t>& cells) {
+    return static_cast<size_t>(std::count(cells.begin(), cells.end(), 0xFF));
+}
+
+} // namespace
+
+TEST(MotionZonesTest, ParsesZonesFromConfig) {
+    const fs::path path = fs::temp_directory_path() / ("reallive_zones_" + std::to_string(::getpid()) + ".json");
+    {
+        std::ofstream f(path);
+        f << R"({
+  "detect_enable": true,
+  "detect_zones": [
+    {"name": "street", "points": [[0, 0], [1.5, 0], [1, 0.3], [0, 0.3]]},
+    {"name": "line", "mode": "include", "points": [[0, 0], [1, 1]]},
+    {"name": "door", "mode": "include", "points": [[0.4, 0.3], [0.8, 0.3], [0.8, 1]],
+     "diff_threshold": 300, "motion_ratio": 0.02},
+    {"name": "yard", "mode": "include", "points": [[0, 0.5], [0.3, 0.5], [0.3, 1]],
+     "diff_threshold": 16, "motion_ratio": 1.5}
+  ]
+})";
+    }
+    Config config;
+    ASSERT_TRUE(config.loadFromFile(path.string()));
+    fs::remove(path);
+
+    const std::vector<MotionZoneConfig>& zones = config.get().detection.zones;
+    ASSERT_EQ(zones.size(), 3u);  // "line" has too few points
+
+    EXPECT_EQ(zones[0].name, "street");
+    EXPECT_TRUE(zones[0].exclude);
+    ASSERT_EQ(zones[0].points.size(), 4u);
+    EXPECT_DOUBLE_EQ(zones[0].points[1].first, 1.0);  // clamped
+    EXPECT_DOUBLE_EQ(zones[0].points[2].second, 0.3);
+
+    EXPECT_EQ(zones[1].name, "door");
+    EXPECT_FALSE(zones[1].exclude);
+    EXPECT_EQ(zones[1].diffThreshold, 255);
+    EXPECT_DOUBLE_EQ(zones[1].motionRatio, 0.02);
+
+    EXPECT_EQ(zones[2].diffThreshold, 16);
+    EXPECT_DOUBLE_EQ(zones[2].motionRatio, 0.0);  // out of range keeps the global ratio
+}
+
+TEST(MotionZonesTest, DiffMustExceedTheThreshold) {
+    MotionZones zones;
+    zones.configure({}, 20, 0.5);
+    zones.prepare(kGridW, kGridH);
+    Frames f;
+
+    f.set(20);
+    zones.thresholdDiff(f.cur.data(), f.prev.data(), f.out.data());
+    EXPECT_EQ(countSet(f.out), 0u);
+    EXPECT_FALSE(zones.score(f.out.data()).triggered);
+
+    f.set(-21);
+    zones.thresholdDiff(f.cur.data(), f.prev.data(), f.out.data());
+    EXPECT_EQ(countSet(f.out), kCells);
+    const MotionZones::Result r = zones.score(f.out.data());
+    EXPECT_TRUE(r.triggered);
+    EXPECT_EQ(r.changedCells, static_cast<int>(kCells));
+    EXPECT_DOUBLE_EQ(r.ratio, 1.0);
+    EXPECT_EQ(r.minX, 0);
+    EXPECT_EQ(r.maxX, kGridW - 1);
+    EXPECT_EQ(r.minY, 0);
+    EXPECT_EQ(r.maxY, kGridH - 1);
+}
+
+TEST(MotionZonesTest, ExcludedCellsNeverCount) {
+    MotionZones zones;
+    zones.configure({rect(true, 0.0, 0.5)}, 20, 0.5);
+    zones.prepare(kGridW, kGridH);
+    ASSERT_TRUE(zones.hasZones());
+
+    // Cell centres left of x = 35 fall inside the exclude zone.
+    for (int x = 0; x < kGridW; x++) {
+        EXPECT_EQ(zones.activeCells()[x], x < 35 ? 0x00 : 0xFF) << "x=" << x;
+    }
+
+    Frames f;
+    f.set(50);
+    zones.thresholdDiff(f.cur.data(), f.prev.data(), f.out.data());
+    for (size_t i = 0; i < kCells; i++) {
+        ASSERT_EQ(f.out[i], static_cast<int>(i % kGridW) < 35 ? 0x00 : 0xFF) << "cell " << i;
+    }
+    const MotionZones::Result r = zones.score(f.out.data());
+    EXPECT_EQ(r.changedCells, 35 * kGridH);
+    EXPECT_EQ(r.minX, 35);
+    EXPECT_EQ(r.maxX, kGridW - 1);  // second mask word
+    EXPECT_DOUBLE_EQ(r.ratio, 1.0);
+    EXPECT_TRUE(r.triggered);
+}
+
+TEST(MotionZonesTest, IncludeZoneUsesItsOwnThresholdAndRatio) {
+    MotionZoneConfig door = rect(false, 0.7, 1.0);  // x >= 49: 21 columns
+    door.diffThreshold = 5;
+    door.motionRatio = 0.5;
+    MotionZones zones;
+    zones.configure({door}, 20, 0.01);
+    zones.prepare(kGridW, kGridH);
+    Frames f;
+
+    // Below the global threshold but above the zone's; outside cells are
+    // not active at all.
+    f.setRow(0, 10);
+    zones.thresholdDiff(f.cur.data(), f.prev.data(), f.out.data());
+    EXPECT_EQ(countSet(f.out), 21u);
+    MotionZones::Result r = zones.score(f.out.data());
+    EXPECT_EQ(r.changedCells, 21);
+    EXPECT_EQ(r.minX, 49);
+    EXPECT_DOUBLE_EQ(r.ratio, 0.25);  // reported even though below the zone ratio
+    EXPECT_FALSE(r.triggered);
+
+    f.setRow(1, 10);
+    zones.thresholdDiff(f.cur.data(), f.prev.data(), f.out.data());
+    r = zones.score(f.out.data());
+    EXPECT_DOUBLE_EQ(r.ratio, 0.5);
+    EXPECT_TRUE(r.triggered);
+
+    f.set(5);
+    zones.thresholdDiff(f.cur.data(), f.prev.data(), f.out.data());
+    EXPECT_EQ(countSet(f.out), 0u);
+}
@@ -0,0 +1,77 @@
+/**
+ * Segment Index Tests
+ *
+ * Save/load round trips of the .idx sidecar, including sample offsets
+ * past 4 GiB (long or high-bitrate segments).
+ */
+
+#include <gtest/gtest.h>
+#include "core/SegmentIndex.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+using namespace reallive;
+namespace fs = std::filesystem;
+
+namespace {
+
+class SegmentIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        tempDir = fs::temp_directory_path() / ("reallive_idx_test_" + std::to_string(::getpid()));
+        fs::create_directories(tempDir);
+    }
+
+    void TearDown() override {
+        fs::remove_all(tempDir);
+    }
+
+    fs::path tempDir;
+};
+
+} // namespace
+
+TEST_F(SegmentIndexTest, RoundTripsOffsetsPastFourGiB) {
+    constexpr uint64_t kFourGiB = 4ULL * 1024 * 1024 * 1024;
+    SegmentIndex index;
+    index.addFrame(0, 48, 1000, true);
+    index.addFrame(33, 1048, 200, false);
+    index.addFrame(1000, kFourGiB + 12345, 900, true);
+    index.addFrame(1033, kFourGiB + 13245, 150, false);
+
+    const std::string path = (tempDir / "segment_1_2.idx").string();
+    ASSERT_TRUE(index.save(path));
+
+    SegmentIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    ASSERT_EQ(loaded.frames().size(), 4u);
+    EXPECT_EQ(loaded.frames()[2].offset, kFourGiB + 12345);
+    EXPECT_EQ(loaded.frames()[3].offset, kFourGiB + 13245);
+    EXPECT_EQ(loaded.frames()[2].size, 900u);
+    EXPECT_TRUE(loaded.frames()[2].keyframe);
+    EXPECT_FALSE(loaded.frames()[3].keyframe);
+
+    ASSERT_EQ(loaded.gops().size(), 2u);
+    EXPECT_EQ(loaded.gops()[0].bytes, 1200u);
+    EXPECT_EQ(loaded.gops()[0].durationMs, 1000u);
+    EXPECT_EQ(loaded.gops()[1].firstFrame, 2u);
+
+    const SegmentIndex::Frame* key = loaded.keyframeAtOrBefore(1500);
+    ASSERT_NE(key, nullptr);
+    EXPECT_EQ(key->offset, kFourGiB + 12345);
+}
+
+TEST_F(SegmentIndexTest, RejectsTruncatedFiles) {
+    SegmentIndex index;
+    index.addFrame(0, 0, 10, true);
+    const std::string path = (tempDir / "short.idx").string();
+    ASSERT_TRUE(index.save(path));
+    fs::resize_file(path, fs::file_size(path) - 1);
+
+    SegmentIndex loaded;
+    EXPECT_FALSE(loaded.load(path));
+    EXPECT_TRUE(loaded.empty());
+}
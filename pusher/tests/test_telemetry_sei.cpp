@@ -0,0 +1,411 @@
+/**
+ * Telemetry SEI Tests
+ *
+ * Encodes snapshots with TelemetrySeiEncoder and decodes the NAL units
+ * again, following the same steps as the reference decoder in
+ * server/src/services/seiMonitor.js: unescape, SEI header, UUID, version,
+ * flags, sequence, then tag/length/value records. The byte stream from
+ * FixtureMatchesEncoder is checked in for the server's own decoder tests.
+ */
+
+#include <gtest/gtest.h>
+#include "core/TelemetrySei.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace reallive;
+
+namespace {
+
+const std::vector<uint8_t> kSlice = {0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x21};
+const uint8_t kUuid[16] = {0x52, 0x65, 0x61, 0x6C, 0x4C, 0x69, 0x76, 0x65,
+                           0x54, 0x65, 0x6C, 0x65, 0x6D, 0x54, 0x4C, 0x56};
+
+struct Message {
+    uint8_t version = 0;
+    uint8_t flags = 0;
+    uint64_t seq = 0;
+    std::vector<std::pair<uint8_t, std::vector<uint8_t>>> records;
+
+    const std::vector<uint8_t>* find(uint8_t tag) const {
+        for (const auto& r : records) {
+            if (r.first == tag) return &r.second;
+        }
+        return nullptr;
+    }
+};
+
+class Reader {
+public:
+    explicit Reader(const std::vector<uint8_t>& bytes) : bytes_(bytes) {}
+
+    bool done() const { return pos_ >= bytes_.size(); }
+    uint8_t byte() { return pos_ < bytes_.size() ? bytes_[pos_++] : 0; }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64 && pos_ < bytes_.size(); shift += 7) {
+            const uint8_t b = bytes_[pos_++];
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        return v;
+    }
+    int64_t zigzag() {
+        const uint64_t v = varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+    std::string string() {
+        const size_t n = static_cast<size_t>(varint());
+        std::string s(bytes_.begin() + pos_, bytes_.begin() + pos_ + n);
+        pos_ += n;
+        return s;
+    }
+    std::vector<int64_t> zigzags() {
+        std::vector<int64_t> out;
+        while (!done()) out.push_back(zigzag());
+        return out;
+    }
+
+private:
+    const std::vector<uint8_t>& bytes_;
+    size_t pos_ = 0;
+};
+
+std::vector<uint8_t> unescape(const uint8_t* data, size_t size) {
+    std::vector<uint8_t> out;
+    int zeros = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (zeros >= 2 && data[i] == 0x03) {
+            zeros = 0;
+            continue;
+        }
+        out.push_back(data[i]);
+        zeros = data[i] == 0x00 ? zeros + 1 : 0;
+    }
+    return out;
+}
+
+size_t seiField(const std::vector<uint8_t>& rbsp, size_t& pos) {
+    size_t v = 0;
+    while (pos < rbsp.size() && rbsp[pos] == 0xFF) {
+        v += 0xFF;
+        pos++;
+    }
+    return v + rbsp[pos++];
+}
+
+bool decode(const uint8_t* nal, size_t size, Message& out) {
+    const std::vector<uint8_t> rbsp = unescape(nal, size);
+    if (rbsp.size() < 3 || (rbsp[0] & 0x1F) != 0x06) return false;
+    size_t pos = 1;
+    if (seiField(rbsp, pos) != 5) return false;
+    const size_t payloadSize = seiField(rbsp, pos);
+    if (pos + payloadSize + 1 != rbsp.size() || rbsp.back() != 0x80) return false;
+    if (payloadSize < 16 || std::memcmp(rbsp.data() + pos, kUuid, 16) != 0) return false;
+
+    const std::vector<uint8_t> payload(rbsp.begin() + pos + 16, rbsp.begin() + pos + payloadSize);
+    Reader r(payload);
+    out.version = r.byte();
+    out.flags = r.byte();
+    out.seq = r.varint();
+    out.records.clear();
+    while (!r.done()) {
+        const uint8_t tag = r.byte();
+        const size_t len = static_cast<size_t>(r.varint());
+        std::vector<uint8_t> body;
+        for (size_t i = 0; i < len; i++) body.push_back(r.byte());
+        out.records.emplace_back(tag, std::move(body));
+    }
+    return true;
+}
+
+EncodedPacket makePacket(bool keyframe, bool annexB = true) {
+    EncodedPacket packet;
+    packet.offset = EncodedPacket::kHeadroom;
+    packet.data.assign(packet.offset, 0);
+    if (annexB) {
+        packet.data.insert(packet.data.end(), kSlice.begin(), kSlice.end());
+    } else {
+        packet.data.insert(packet.data.end(), {0x00, 0x00, 0x00, static_cast<uint8_t>(kSlice.size() - 4)});
+        packet.data.insert(packet.data.end(), kSlice.begin() + 4, kSlice.end());
+    }
+    packet.isKeyframe = keyframe;
+    return packet;
+}
+
+// The SEI NAL the encoder put in front of the slice (start code stripped).
+std::pair<const uint8_t*, size_t> seiNal(const EncodedPacket& packet) {
+    return {packet.bytes() + 4, packet.size() - 4 - kSlice.size()};
+}
+
+TelemetrySnapshot sampleSnapshot() {
+    TelemetrySnapshot snap;
+    snap.tsMs = 1700000000123;
+    snap.streamKey = "cam-1";
+    snap.width = 1280;
+    snap.height = 720;
+    snap.fps = 30;
+    snap.bitrate = 2500000;
+    snap.gop = 60;
+    snap.pixelFormat = "NV12";
+    snap.codec = "h264";
+    snap.profile = "high";
+    snap.audioEnabled = true;
+    snap.tfliteEnabled = true;
+    snap.personScoreThreshold = 0.55;
+    snap.device.cpuPct = 37.4;
+    snap.device.cpuCorePct = {40.1, 34.7};
+    snap.device.memoryPct = 51.2;
+    snap.device.memoryUsedMb = 2048.5;
+    snap.device.memoryTotalMb = 4000.0;
+    snap.device.storagePct = 12.3;
+    snap.device.storageUsedGb = 7.25;
+    snap.device.storageTotalGb = 58.99;
+    snap.detectSched.adaptive = true;
+    snap.detectSched.state = DetectionScheduler::State::Steady;
+    snap.detectSched.encodeAvgMs = 9.87;
+    snap.detectSched.skippedFrames = 4;
+    snap.person.active = true;
+    snap.person.score = 0.812;
+    snap.person.ts = snap.tsMs - 40;
+    snap.person.x = 100;
+    snap.person.y = 50;
+    snap.person.w = 64;
+    snap.person.h = 128;
+    return snap;
+}
+
+// Annex-B stream of the SEI NALs for: a key message, a delta, an event and
+// a key message asked for at a segment start. Mirrored by
+// server/test/telemetrySei.test.js.
+std::vector<uint8_t> fixtureStream() {
+    TelemetrySeiEncoder encoder;
+    std::vector<uint8_t> out;
+    auto append = [&](EncodedPacket packet, const TelemetrySnapshot& snap) {
+        encoder.inject(packet, snap);
+        out.insert(out.end(), packet.bytes(), packet.bytes() + packet.size() - kSlice.size());
+    };
+
+    TelemetrySnapshot snap = sampleSnapshot();
+    append(makePacket(true), snap);
+
+    snap.tsMs += 1000;
+    snap.device.cpuPct = 35.0;
+    snap.device.cpuCorePct[1] = 40.0;
+    append(makePacket(false), snap);
+
+    snap.tsMs += 1000;
+    TelemetryPerson evt;
+    evt.ts = snap.tsMs - 250;
+    evt.score = 0.9;
+    evt.x = 10;
+    evt.y = 20;
+    evt.w = 30;
+    evt.h = 40;
+    snap.events = {evt};
+    append(makePacket(false), snap);
+
+    snap.tsMs += 1000;
+    snap.events.clear();
+    encoder.requestKeyMessage();
+    append(makePacket(true), snap);
+    return out;
+}
+
+} // namespace
+
+TEST(TelemetrySeiTest, KeyMessageRoundTrip) {
+    TelemetrySeiEncoder encoder;
+    const TelemetrySnapshot snap = sampleSnapshot();
+    EncodedPacket packet = makePacket(true);
+    encoder.inject(packet, snap);
+
+    Message msg;
+    const auto nal = seiNal(packet);
+    ASSERT_TRUE(decode(nal.first, nal.second, msg));
+    EXPECT_EQ(msg.version, TelemetrySeiEncoder::kVersion);
+    EXPECT_EQ(msg.flags & 0x01, 0x01);
+    EXPECT_EQ(msg.seq, 0u);
+    EXPECT_EQ(std::vector<uint8_t>(packet.data.end() - kSlice.size(), packet.data.end()), kSlice);
+
+    const auto* key = msg.find(TelemetrySeiEncoder::kTagStreamKey);
+    ASSERT_NE(key, nullptr);
+    EXPECT_EQ(std::string(key->begin(), key->end()), "cam-1");
+
+    const auto* camera = msg.find(TelemetrySeiEncoder::kTagCamera);
+    ASSERT_NE(camera, nullptr);
+    Reader cam(*camera);
+    EXPECT_EQ(cam.string(), "NV12");
+    EXPECT_EQ(cam.string(), "h264");
+    EXPECT_EQ(cam.string(), "high");
+    EXPECT_EQ(cam.zigzags(), (std::vector<int64_t>{1280, 720, 30, 2500000, 60, 1, 1, 0, 55}));
+    EXPECT_NE(msg.find(TelemetrySeiEncoder::kTagConfigurable), nullptr);
+
+    const auto* ts = msg.find(TelemetrySeiEncoder::kTagTimestamp);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(Reader(*ts).zigzags(), std::vector<int64_t>{snap.tsMs});
+
+    const auto* device = msg.find(TelemetrySeiEncoder::kTagDevice);
+    ASSERT_NE(device, nullptr);
+    EXPECT_EQ(Reader(*device).zigzags(), (std::vector<int64_t>{374, 512, 20485, 40000, 123, 725, 5899, 401, 347}));
+
+    const auto* person = msg.find(TelemetrySeiEncoder::kTagPerson);
+    ASSERT_NE(person, nullptr);
+    EXPECT_EQ(Reader(*person).zigzags(), (std::vector<int64_t>{1, 812, snap.tsMs - 40, 100, 50, 64, 128}));
+    EXPECT_EQ(msg.find(TelemetrySeiEncoder::kTagEvents), nullptr);
+}
+
+TEST(TelemetrySeiTest, DeltaMessageCarriesOnlyChanges) {
+    TelemetrySeiEncoder encoder;
+    TelemetrySnapshot snap = sampleSnapshot();
+    EncodedPacket first = makePacket(true);
+    encoder.inject(first, snap);
+
+    snap.tsMs += 1000;
+    snap.device.cpuPct = 35.0;
+    snap.device.cpuCorePct[1] = 40.0;
+    EncodedPacket second = makePacket(false);
+    encoder.inject(second, snap);
+
+    Message msg;
+    const auto nal = seiNal(second);
+    ASSERT_TRUE(decode(nal.first, nal.second, msg));
+    EXPECT_EQ(msg.flags & 0x01, 0x00);
+    EXPECT_EQ(msg.seq, 1u);
+    EXPECT_EQ(msg.find(TelemetrySeiEncoder::kTagStreamKey), nullptr);
+    EXPECT_EQ(msg.find(TelemetrySeiEncoder::kTagCamera), nullptr);
+    EXPECT_EQ(msg.find(TelemetrySeiEncoder::kTagPerson | TelemetrySeiEncoder::kTagDelta), nullptr);
+
+    // The timestamp stays absolute; the device record is field-wise deltas.
+    const auto* ts = msg.find(TelemetrySeiEncoder::kTagTimestamp);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(Reader(*ts).zigzags(), std::vector<int64_t>{snap.tsMs});
+    const auto* device = msg.find(TelemetrySeiEncoder::kTagDevice | TelemetrySeiEncoder::kTagDelta);
+    ASSERT_NE(device, nullptr);
+    EXPECT_EQ(Reader(*device).zigzags(), (std::vector<int64_t>{-24, 0, 0, 0, 0, 0, 0, 0, 53}));
+}
+
+TEST(TelemetrySeiTest, KeyframeAfterRefreshIntervalResendsKeyMessage) {
+    TelemetrySeiEncoder encoder;
+    TelemetrySnapshot snap = sampleSnapshot();
+    EncodedPacket first = makePacket(true);
+    encoder.inject(first, snap);
+
+    EXPECT_FALSE(encoder.wantsKeyMessage(true, snap.tsMs + 1000));
+    EXPECT_FALSE(encoder.wantsKeyMessage(false, snap.tsMs + TelemetrySeiEncoder::kKeyRefreshMs));
+    EXPECT_TRUE(encoder.wantsKeyMessage(true, snap.tsMs + TelemetrySeiEncoder::kKeyRefreshMs));
+
+    snap.tsMs += TelemetrySeiEncoder::kKeyRefreshMs;
+    EncodedPacket second = makePacket(true);
+    encoder.inject(second, snap);
+    Message msg;
+    const auto nal = seiNal(second);
+    ASSERT_TRUE(decode(nal.first, nal.second, msg));
+    EXPECT_EQ(msg.flags & 0x01, 0x01);
+    EXPECT_NE(msg.find(TelemetrySeiEncoder::kTagStreamKey), nullptr);
+    EXPECT_NE(msg.find(TelemetrySeiEncoder::kTagDevice), nullptr);
+}
+
+TEST(TelemetrySeiTest, EmulationPreventionRoundTrip) {
+    TelemetrySeiEncoder encoder;
+    TelemetrySnapshot snap = sampleSnapshot();
+    // Raw bytes that would form start codes inside the NAL unless escaped.
+    snap.streamKey = std::string("\x00\x00\x01\x00\x00\x00\x00\x00\x03", 9);
+    snap.person = TelemetryPerson();  // all-zero record
+    EncodedPacket packet = makePacket(true);
+    encoder.inject(packet, snap);
+
+    const auto nal = seiNal(packet);
+    bool escaped = false;
+    for (size_t i = 0; i + 2 < nal.second; i++) {
+        EXPECT_FALSE(nal.first[i] == 0x00 && nal.first[i + 1] == 0x00 && nal.first[i + 2] <= 0x02)
+            << "start code emulated at " << i;
+        escaped = escaped || (nal.first[i] == 0x00 && nal.first[i + 1] == 0x00 && nal.first[i + 2] == 0x03);
+    }
+    EXPECT_TRUE(escaped);
+
+    Message msg;
+    ASSERT_TRUE(decode(nal.first, nal.second, msg));
+    const auto* key = msg.find(TelemetrySeiEncoder::kTagStreamKey);
+    ASSERT_NE(key, nullptr);
+    EXPECT_EQ(std::string(key->begin(), key->end()), snap.streamKey);
+    const auto* person = msg.find(TelemetrySeiEncoder::kTagPerson);
+    ASSERT_NE(person, nullptr);
+    EXPECT_EQ(Reader(*person).zigzags(), std::vector<int64_t>(7, 0));
+}
+
+TEST(TelemetrySeiTest, AvccFramingAndEvents) {
+    TelemetrySeiEncoder encoder;
+    TelemetrySnapshot snap = sampleSnapshot();
+    TelemetryPerson evt;
+    evt.ts = snap.tsMs - 250;
+    evt.score = 0.9;
+    evt.x = 10;
+    evt.y = 20;
+    evt.w = 30;
+    evt.h = 40;
+    snap.events = {evt};
+    EncodedPacket packet = makePacket(true, false);
+    encoder.inject(packet, snap);
+
+    const uint8_t* p = packet.bytes();
+    const size_t nalSize = (static_cast<size_t>(p[0]) << 24) | (static_cast<size_t>(p[1]) << 16) |
+                           (static_cast<size_t>(p[2]) << 8) | p[3];
+    ASSERT_EQ(4 + nalSize + kSlice.size(), packet.size());
+    Message msg;
+    ASSERT_TRUE(decode(p + 4, nalSize, msg));
+    const auto* events = msg.find(TelemetrySeiEncoder::kTagEvents);
+    ASSERT_NE(events, nullptr);
+    EXPECT_EQ(Reader(*events).zigzags(), (std::vector<int64_t>{-250, 900, 10, 20, 30, 40}));
+}
+
+TEST(TelemetrySeiTest, RequestedKeyMessageGoesOnNextKeyframe) {
+    TelemetrySeiEncoder encoder;
+    TelemetrySnapshot snap = sampleSnapshot();
+    EncodedPacket first = makePacket(true);
+    encoder.inject(first, snap);
+
+    encoder.requestKeyMessage();
+    EXPECT_FALSE(encoder.wantsKeyMessage(false, snap.tsMs + 1000));
+    EXPECT_TRUE(encoder.wantsKeyMessage(true, snap.tsMs + 1000));
+
+    snap.tsMs += 1000;
+    EncodedPacket delta = makePacket(false);
+    encoder.inject(delta, snap);
+    Message msg;
+    auto nal = seiNal(delta);
+    ASSERT_TRUE(decode(nal.first, nal.second, msg));
+    EXPECT_EQ(msg.flags & 0x01, 0x00);
+
+    snap.tsMs += 1000;
+    EncodedPacket key = makePacket(true);
+    encoder.inject(key, snap);
+    nal = seiNal(key);
+    ASSERT_TRUE(decode(nal.first, nal.second, msg));
+    EXPECT_EQ(msg.flags & 0x01, 0x01);
+    EXPECT_NE(msg.find(TelemetrySeiEncoder::kTagStreamKey), nullptr);
+    EXPECT_FALSE(encoder.wantsKeyMessage(true, snap.tsMs + 1000));
+}
+
+// REALLIVE_UPDATE_FIXTURES=1 rewrites the fixture after a wire-format change.
+TEST(TelemetrySeiTest, FixtureMatchesEncoder) {
+    const std::string path = std::string(REALLIVE_SERVER_FIXTURES) + "/telemetry_sei.h264";
+    const std::vector<uint8_t> stream = fixtureStream();
+    if (std::getenv("REALLIVE_UPDATE_FIXTURES")) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(stream.data()), static_cast<std::streamsize>(stream.size()));
+        ASSERT_TRUE(out.good()) << path;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    ASSERT_TRUE(in.is_open()) << path;
+    const std::vector<uint8_t> fixture((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(fixture, stream) << "re-run with REALLIVE_UPDATE_FIXTURES=1 and update the server decoder";
+}
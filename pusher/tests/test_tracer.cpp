@@ -0,0 +1,55 @@
+/**
+ * Tracer Tests
+ *
+ * Dumps the trace while another thread keeps lapping its ring, and checks
+ * that every event in the JSON is one the writer actually recorded.
+ */
+
+#include <gtest/gtest.h>
+#include "core/Tracer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <thread>
+
+using namespace reallive;
+
+TEST(TracerTest, DumpNeverReadsATornEvent) {
+    Tracer& tracer = Tracer::instance();
+    tracer.configure(true, 256);
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> written{0};
+    std::thread writer([&]() {
+        tracer.setThreadName("writer");
+        // Every field is derived from k, so a mix of two events shows.
+        for (uint32_t k = 1; !stop.load(std::memory_order_relaxed); k++) {
+            tracer.record("span", k, k + k % 1000, k);
+            written.store(k, std::memory_order_relaxed);
+        }
+    });
+    while (written.load() < 1024) std::this_thread::yield();
+
+    const std::regex span(R"re("name":"span","cat":"pipeline","ph":"X","ts":(\d+),"dur":(\d+),"pid":\d+,"tid":\d+,"args":\{"frame":(\d+)\})re");
+    size_t checked = 0;
+    for (int dump = 0; dump < 50; dump++) {
+        const std::string json = tracer.dumpJson(0);
+        uint64_t last = 0;
+        for (std::sregex_iterator it(json.begin(), json.end(), span), end; it != end; ++it) {
+            const uint64_t ts = std::stoull((*it)[1]);
+            const uint64_t dur = std::stoull((*it)[2]);
+            const uint64_t frame = std::stoull((*it)[3]);
+            ASSERT_EQ(ts, frame);
+            ASSERT_EQ(dur, ts % 1000);
+            ASSERT_GT(ts, last);  // one lap at most, oldest first
+            last = ts;
+            checked++;
+        }
+    }
+    stop = true;
+    writer.join();
+    tracer.setEnabled(false);
+    EXPECT_GT(checked, 0u);
+}
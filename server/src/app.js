@@ -3,6 +3,7 @@ const cors = require('cors');
 const path = require('path');
 const { createProxyMiddleware } = require('http-proxy-middleware');
 const { RECORDINGS_ROOTS } = require('./services/historyService');
+const edgeReplayService = require('./services/edgeReplayService');
 
 const authRoutes = require('./routes/auth');
 const cameraRoutes = require('./routes/cameras');
@@ -31,6 +32,40 @@ app.use(createProxyMiddleware({
   proxyTimeout: 0,
 }));
 
+// Recorded files on the edge device. Range, ETag and conditional headers
+// pass straight through to the pusher's sendfile() endpoint.
+if (edgeReplayService.isEnabled()) {
+  app.use(createProxyMiddleware({
+    target: edgeReplayService.getEdgeUrl(),
+    pathFilter: (pathname) => pathname.startsWith('/edge-files/'),
+    pathRewrite: (pathname) => {
+      const [, , streamKey = '', name = ''] = pathname.split('/');
+      return `/api/record/file?stream_key=${streamKey}&name=${name}`;
+    },
+    changeOrigin: true,
+    timeout: 0,
+    proxyTimeout: 0,
+  }));
+
+  // HLS packaged on the edge from its recordings. The path's stream key is
+  // appended last so it wins over whatever the playlist URIs carry.
+  app.use(createProxyMiddleware({
+    target: edgeReplayService.getEdgeUrl(),
+    pathFilter: (pathname) => pathname.startsWith('/edge-hls/'),
+    pathRewrite: (pathWithQuery) => {
+      const [pathname, query = ''] = pathWithQuery.split('?');
+      const [, , streamKey = '', file = ''] = pathname.split('/');
+      const qs = new URLSearchParams(query);
+      qs.delete('stream_key');
+      qs.set('stream_key', decodeURIComponent(streamKey));
+      return `/api/record/hls/${file}?${qs.toString()}`;
+    },
+    changeOrigin: true,
+    timeout: 0,
+    proxyTimeout: 0,
+  }));
+}
+
 // Serve Vue frontend static files
 app.use(express.static(path.join(__dirname, '..', 'web', 'dist')));
 RECORDINGS_ROOTS.forEach((root, idx) => {
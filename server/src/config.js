@@ -38,6 +38,7 @@ const defaults = {
     topicPrefix: 'reallive/device',
     commandQos: 1,
     stateQos: 0,
+    eventQos: 1,
     commandRetain: true,
     stateStaleMs: 12000,
   },
@@ -1,4 +1,5 @@
 const express = require('express');
+const { Readable } = require('stream');
 const { v4: uuidv4 } = require('uuid');
 const authMiddleware = require('../middleware/auth');
 const Camera = require('../models/camera');
@@ -7,7 +8,13 @@ const { getSeiInfo } = require('../services/seiMonitor');
 const { getDeviceState } = require('../services/mqttControlService');
 const edgeReplayService = require('../services/edgeReplayService');
 const liveDemandService = require('../services/liveDemandService');
-const { getHistoryOverview, getTimeline, getPlayback, getLatestThumbnail } = require('../services/historyService');
+const {
+  getHistoryOverview,
+  getTimeline,
+  getPlayback,
+  getBitrate,
+  getLatestThumbnail,
+} = require('../services/historyService');
 const config = require('../config');
 
 const router = express.Router();
@@ -285,7 +292,100 @@ router.get('/:id/history/timeline', async (req, res) => {
   });
 });
 
-// GET /api/cameras/:id/history/play?ts=...
+// GET /api/cameras/:id/history/bitrate?start=...&end=...
+router.get('/:id/history/bitrate', async (req, res) => {
+  const camera = Camera.findById(req.params.id);
+  if (!camera) {
+    return res.status(404).json({ error: 'Camera not found' });
+  }
+  if (camera.user_id !== req.user.id) {
+    return res.status(403).json({ error: 'Forbidden' });
+  }
+
+  let bitrate = null;
+  let source = 'edge';
+
+  const localBitrate = getBitrate(camera.stream_key, req.query || {});
+  if (localBitrate.points.length > 0) {
+    bitrate = localBitrate;
+    source = 'local';
+  } else if (edgeReplayService.isEnabled()) {
+    bitrate = await edgeReplayService.getBitrate(camera.stream_key, req.query || {});
+  }
+  if (!bitrate) {
+    bitrate = localBitrate;
+    source = 'local';
+  }
+
+  res.json({
+    stream_key: camera.stream_key,
+    source,
+    ...bitrate,
+  });
+});
+
+// GET /api/cameras/:id/history/hls?start=...&end=...&at=...
+// Returns the playlist URL for a standard HLS player; without end the
+// playlist follows the recording in progress.
+router.get('/:id/history/hls', (req, res) => {
+  const camera = Camera.findById(req.params.id);
+  if (!camera) {
+    return res.status(404).json({ error: 'Camera not found' });
+  }
+  if (camera.user_id !== req.user.id) {
+    return res.status(403).json({ error: 'Forbidden' });
+  }
+  if (!edgeReplayService.isEnabled()) {
+    return res.status(409).json({ error: 'edge replay disabled' });
+  }
+  const query = req.query || {};
+  if (query.start == null && query.at == null) {
+    return res.status(400).json({ error: 'start or at required' });
+  }
+  res.json({
+    stream_key: camera.stream_key,
+    url: edgeReplayService.edgeHlsUrl(camera.stream_key, query),
+  });
+});
+
+// GET /api/cameras/:id/history/export?start=...&end=...&mode=keyframe|exact
+// Streams a fragmented MP4 cut by the edge device; nothing is buffered here.
+router.get('/:id/history/export', async (req, res) => {
+  const camera = Camera.findById(req.params.id);
+  if (!camera) {
+    return res.status(404).json({ error: 'Camera not found' });
+  }
+  if (camera.user_id !== req.user.id) {
+    return res.status(403).json({ error: 'Forbidden' });
+  }
+  if (!edgeReplayService.isEnabled()) {
+    return res.status(409).json({ error: 'edge replay disabled' });
+  }
+
+  const upstream = await edgeReplayService.openExport(camera.stream_key, req.query || {});
+  if (!upstream) {
+    return res.status(502).json({ error: 'Edge export unavailable' });
+  }
+  const { response, controller } = upstream;
+  if (!response.ok || !response.body) {
+    const body = await response.json().catch(() => ({}));
+    return res.status(response.status || 502).json({ error: body.error || 'Export failed' });
+  }
+
+  res.status(200);
+  res.setHeader('Content-Type', 'video/mp4');
+  res.setHeader('Content-Disposition', response.headers.get('content-disposition') || 'attachment');
+  res.setHeader('Cache-Control', 'no-store');
+  const body = Readable.fromWeb(response.body);
+  req.on('close', () => {
+    controller.abort();
+    body.destroy();
+  });
+  body.on('error', () => res.destroy());
+  body.pipe(res);
+});
+
+// GET /api/cameras/:id/history/play?ts=...&speed=...
 router.get('/:id/history/play', async (req, res) => {
   const camera = Camera.findById(req.params.id);
   if (!camera) {
@@ -297,7 +397,11 @@ router.get('/:id/history/play', async (req, res) => {
 
   const requestedTs = Number(req.query?.ts);
   const forceMode = String(req.query?.mode || req.query?.source || '').toLowerCase();
-  const preferEdge = forceMode === 'edge' || forceMode === 'replay';
+  const speed = Number(req.query?.speed);
+  // Only the edge replay can fast-forward without the viewer decoding every
+  // frame (keyframe-only above its threshold), so speed > 1 prefers it.
+  const fastForward = Number.isFinite(speed) && speed > 1;
+  const preferEdge = forceMode === 'edge' || forceMode === 'replay' || fastForward;
   const localPlayback = getPlayback(camera.stream_key, req.query || {});
 
   let playback = null;
@@ -313,7 +417,8 @@ router.get('/:id/history/play', async (req, res) => {
   } else if (edgeReplayService.isEnabled()) {
     playback = await edgeReplayService.startReplay(
       camera.stream_key,
-      Number.isFinite(requestedTs) ? requestedTs : Date.now()
+      Number.isFinite(requestedTs) ? requestedTs : Date.now(),
+      Number.isFinite(speed) ? speed : 1
     );
     if (playback) {
       source = 'edge';
@@ -356,4 +461,30 @@ router.post('/:id/history/replay/stop', async (req, res) => {
   return res.json({ ok: true, stopped: true });
 });
 
+// POST /api/cameras/:id/history/replay/speed
+router.post('/:id/history/replay/speed', async (req, res) => {
+  const camera = Camera.findById(req.params.id);
+  if (!camera) {
+    return res.status(404).json({ error: 'Camera not found' });
+  }
+  if (camera.user_id !== req.user.id) {
+    return res.status(403).json({ error: 'Forbidden' });
+  }
+
+  const sessionId = req.body?.sessionId || null;
+  const speed = Number(req.body?.speed);
+  if (!sessionId || !Number.isFinite(speed) || speed <= 0) {
+    return res.status(400).json({ error: 'sessionId and speed required' });
+  }
+  if (!edgeReplayService.isEnabled()) {
+    return res.status(409).json({ error: 'edge replay disabled' });
+  }
+
+  const result = await edgeReplayService.setReplaySpeed(sessionId, speed);
+  if (!result) {
+    return res.status(404).json({ error: 'Replay session not found' });
+  }
+  return res.json({ ok: true, ...result });
+});
+
 module.exports = router;
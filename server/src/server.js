@@ -4,10 +4,14 @@ const app = require('./app');
 const config = require('./config');
 const initSignaling = require('./signaling');
 const { startSrsSync } = require('./services/srsSync');
-const { setSeiEventEmitter } = require('./services/seiMonitor');
+const { setSeiEventEmitter, ingestDetectionEvent } = require('./services/seiMonitor');
 const { RECORDINGS_ROOTS, getLatestThumbnail } = require('./services/historyService');
 const liveDemandService = require('./services/liveDemandService');
-const { start: startMqttControl, setStateEventEmitter } = require('./services/mqttControlService');
+const {
+  start: startMqttControl,
+  setStateEventEmitter,
+  setDetectionEventHandler,
+} = require('./services/mqttControlService');
 const Camera = require('./models/camera');
 const Alert = require('./models/alert');
 
@@ -52,6 +56,9 @@ setSeiEventEmitter((streamKey, event) => {
   });
 });
 
+// Person events arrive over MQTT right away, also while no live stream is up.
+setDetectionEventHandler(ingestDetectionEvent);
+
 setStateEventEmitter((streamKey, payload) => {
   const camera = Camera.findByStreamKey(streamKey);
   if (!camera) return;
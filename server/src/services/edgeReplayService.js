@@ -7,6 +7,30 @@ function isEnabled() {
   return EDGE_REPLAY_URL.length > 0;
 }
 
+function getEdgeUrl() {
+  return EDGE_REPLAY_URL;
+}
+
+// The edge serves recorded files at /api/record/file?stream_key=&name=;
+// clients reach them through the /edge-files/<stream_key>/<name> proxy.
+function edgeFileUrl(streamKey, rawUrl) {
+  if (!rawUrl) return null;
+  const match = /[?&]name=([^&]+)/.exec(rawUrl);
+  if (!match) return rawUrl;
+  return `/edge-files/${encodeURIComponent(streamKey)}/${match[1]}`;
+}
+
+// HLS over the edge recordings: the playlist uses relative URIs, so init
+// and fragment requests come back through the same /edge-hls/<stream_key>/
+// proxy prefix.
+function edgeHlsUrl(streamKey, query = {}) {
+  const qs = new URLSearchParams();
+  ['start', 'end', 'at'].forEach((key) => {
+    if (query[key] != null && query[key] !== '') qs.set(key, String(query[key]));
+  });
+  return `/edge-hls/${encodeURIComponent(streamKey)}/playlist.m3u8?${qs.toString()}`;
+}
+
 function toNum(value, fallback = null) {
   const n = Number(value);
   return Number.isFinite(n) ? n : fallback;
@@ -102,6 +126,7 @@ function normalizeTimeline(raw) {
       playable: toBool(seg.playable, !!seg.url),
       isOpen: toBool(seg.isOpen ?? seg.is_open, false),
       isActive: toBool(seg.isActive ?? seg.is_active, false),
+      indexed: toBool(seg.indexed, false),
     })).filter((seg) => seg.startMs != null && seg.endMs != null)
     : [];
 
@@ -153,7 +178,11 @@ function normalizePlayback(raw) {
     requestedTs: toNum(raw.requestedTs ?? raw.requested_ts, Date.now()),
     playbackUrl,
     offsetSec: toNum(raw.offsetSec ?? raw.offset_sec, 0),
+    offsetMs: toNum(raw.offsetMs ?? raw.offset_ms, null),
+    keyframeOffset: toNum(raw.keyframeOffset ?? raw.keyframe_offset, -1),
     sessionId: raw.sessionId || raw.session_id || null,
+    speed: toNum(raw.speed, 1),
+    keyframeOnly: toBool(raw.keyframeOnly ?? raw.keyframe_only, false),
     transport: inferTransport(playbackUrl, raw.transport),
     segment: raw.segment || null,
   };
@@ -171,17 +200,90 @@ async function getTimeline(streamKey, query = {}) {
   if (query.end != null) qs.set('end', String(query.end));
 
   const response = await edgeRequest('GET', `/api/record/timeline?${qs.toString()}`);
-  return normalizeTimeline(response);
+  const timeline = normalizeTimeline(response);
+  if (timeline) {
+    for (const seg of timeline.segments) {
+      seg.url = edgeFileUrl(streamKey, seg.url);
+      seg.thumbnailUrl = edgeFileUrl(streamKey, seg.thumbnailUrl);
+    }
+  }
+  return timeline;
+}
+
+function normalizeBitrate(raw) {
+  if (!raw || typeof raw !== 'object') return null;
+  return {
+    startMs: toNum(raw.startMs ?? raw.start_ms, null),
+    endMs: toNum(raw.endMs ?? raw.end_ms, null),
+    points: Array.isArray(raw.points)
+      ? raw.points.map((p) => ({
+        ts: toNum(p.ts, null),
+        durationMs: toNum(p.durationMs ?? p.duration_ms, 0),
+        bytes: toNum(p.bytes, 0),
+        kbps: toNum(p.kbps, 0),
+      })).filter((p) => p.ts != null)
+      : [],
+    nowMs: toNum(raw.nowMs ?? raw.now_ms, Date.now()),
+  };
+}
+
+async function getBitrate(streamKey, query = {}) {
+  const qs = new URLSearchParams();
+  qs.set('stream_key', streamKey);
+  if (query.start != null) qs.set('start', String(query.start));
+  if (query.end != null) qs.set('end', String(query.end));
+
+  const response = await edgeRequest('GET', `/api/record/bitrate?${qs.toString()}`);
+  return normalizeBitrate(response);
+}
+
+// Streams a clip export from the edge. Resolves to the fetch Response (body
+// not yet consumed) or null; no timeout once headers arrive, since long
+// clips take a while to produce.
+async function openExport(streamKey, query = {}) {
+  if (!isEnabled()) return null;
+  const qs = new URLSearchParams();
+  qs.set('stream_key', streamKey);
+  if (query.start != null) qs.set('start', String(query.start));
+  if (query.end != null) qs.set('end', String(query.end));
+  if (query.mode) qs.set('mode', String(query.mode));
+
+  const controller = new AbortController();
+  const timer = setTimeout(() => controller.abort(), EDGE_REPLAY_TIMEOUT_MS * 4);
+  try {
+    const res = await fetch(`${EDGE_REPLAY_URL}/api/record/export?${qs.toString()}`, {
+      signal: controller.signal,
+    });
+    clearTimeout(timer);
+    return { response: res, controller };
+  } catch {
+    clearTimeout(timer);
+    return null;
+  }
 }
 
-async function startReplay(streamKey, tsMs) {
+async function startReplay(streamKey, tsMs, speed = 1) {
   const response = await edgeRequest('POST', '/api/record/replay/start', {
     stream_key: streamKey,
     ts: toNum(tsMs, Date.now()),
+    speed: toNum(speed, 1),
   });
   return normalizePlayback(response);
 }
 
+async function setReplaySpeed(sessionId, speed) {
+  const response = await edgeRequest('POST', '/api/record/replay/speed', {
+    session_id: sessionId,
+    speed: toNum(speed, 1),
+  });
+  if (!response || typeof response !== 'object' || !response.ok) return null;
+  return {
+    sessionId: response.sessionId || sessionId,
+    speed: toNum(response.speed, 1),
+    keyframeOnly: toBool(response.keyframeOnly, false),
+  };
+}
+
 async function stopReplay(streamKey, sessionId) {
   const response = await edgeRequest('POST', '/api/record/replay/stop', {
     stream_key: streamKey,
@@ -219,9 +321,14 @@ async function getRuntimeStatus(streamKey) {
 
 module.exports = {
   isEnabled,
+  getEdgeUrl,
+  edgeHlsUrl,
   getOverview,
   getTimeline,
+  getBitrate,
+  openExport,
   startReplay,
+  setReplaySpeed,
   stopReplay,
   setLivePush,
   getRuntimeStatus,
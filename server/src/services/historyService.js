@@ -43,6 +43,12 @@ const DEFAULT_SEGMENT_MS = Number(process.env.HISTORY_DEFAULT_SEGMENT_MS || 6000
 const CACHE_TTL_MS = Number(process.env.HISTORY_CACHE_TTL_MS || 2000);
 const EPOCH_MS_MIN = 946684800000;   // 2000-01-01
 const EPOCH_MS_MAX = 4102444800000;  // 2100-01-01
+const INDEX_MAGIC = 'RLIX';
+const INDEX_VERSION = 1;
+const INDEX_HEADER_SIZE = 16;
+const INDEX_FRAME_SIZE = 16;
+const INDEX_GOP_SIZE = 16;
+const MAX_BITRATE_POINTS = 5000;
 
 const cache = new Map();
 const relativeAlignStateByStream = new Map();
@@ -109,6 +115,53 @@ function parseTimesFromName(filename) {
   return { startMs: null, endMs: null };
 }
 
+function indexPathFor(filePath) {
+  return filePath.replace(/\.[^./]+$/, '') + '.idx';
+}
+
+// Reads the pusher's per-segment keyframe index (see pusher SegmentIndex.h).
+// Returns null when the sidecar is missing or malformed.
+function readSegmentIndex(indexPath) {
+  let buf;
+  try {
+    buf = fs.readFileSync(indexPath);
+  } catch {
+    return null;
+  }
+  if (buf.length < INDEX_HEADER_SIZE
+      || buf.toString('latin1', 0, 4) !== INDEX_MAGIC
+      || buf[4] !== INDEX_VERSION) {
+    return null;
+  }
+  const frameCount = buf.readUInt32LE(8);
+  const gopCount = buf.readUInt32LE(12);
+  if (buf.length < INDEX_HEADER_SIZE + frameCount * INDEX_FRAME_SIZE + gopCount * INDEX_GOP_SIZE) {
+    return null;
+  }
+
+  const keyframes = [];
+  let pos = INDEX_HEADER_SIZE;
+  for (let i = 0; i < frameCount; i += 1, pos += INDEX_FRAME_SIZE) {
+    const sizeAndKey = buf.readUInt32LE(pos + 12);
+    if (sizeAndKey & 0x80000000) {
+      keyframes.push({
+        ptsMs: buf.readUInt32LE(pos),
+        offset: Number(buf.readBigUInt64LE(pos + 4)),
+        size: sizeAndKey & 0x7fffffff,
+      });
+    }
+  }
+  const gops = [];
+  for (let i = 0; i < gopCount; i += 1, pos += INDEX_GOP_SIZE) {
+    gops.push({
+      ptsMs: buf.readUInt32LE(pos),
+      bytes: buf.readUInt32LE(pos + 8),
+      durationMs: buf.readUInt32LE(pos + 12),
+    });
+  }
+  return { keyframes, gops };
+}
+
 function safeRel(root, target) {
   const rel = path.relative(root, target).replace(/\\/g, '/');
   if (rel.startsWith('..')) return null;
@@ -330,6 +383,7 @@ function buildSegments(streamKey) {
 
       const thumbCandidate = filePath.replace(/\.[^.]+$/, '.jpg');
       const thumbRel = fs.existsSync(thumbCandidate) ? safeRel(root, thumbCandidate) : null;
+      const indexCandidate = isOpen ? null : indexPathFor(filePath);
       const idRaw = `${rootIndex}:${relPath}`;
 
       segments.push({
@@ -344,6 +398,7 @@ function buildSegments(streamKey) {
         durationMs: Math.max(1000, Math.floor(endMs - startMs)),
         sizeBytes: stat.size,
         thumbnailUrl: thumbRel ? `/history-files/${rootIndex}/${encodeURI(thumbRel)}` : null,
+        indexPath: indexCandidate && fs.existsSync(indexCandidate) ? indexCandidate : null,
         isOpen,
         isActive,
         playable: !isOpen,
@@ -483,6 +538,7 @@ function getTimeline(streamKey, query = {}) {
       playable: !!seg.playable,
       isOpen: !!seg.isOpen,
       isActive: !!seg.isActive,
+      indexed: !!seg.indexPath,
     })),
     events,
     nowMs: Date.now(),
@@ -515,12 +571,30 @@ function getPlayback(streamKey, query = {}) {
     target = segments[0];
   }
 
-  const offsetSec = Math.max(0, Math.floor((ts - target.startMs) / 1000));
+  // Land on the keyframe at or before ts when the segment has an index, so
+  // the player can seek there without decoding from the previous second.
+  let offsetMs = Math.max(0, ts - target.startMs);
+  let keyframeOffset = -1;
+  const index = target.indexPath ? readSegmentIndex(target.indexPath) : null;
+  if (index && index.keyframes.length) {
+    let key = index.keyframes[0];
+    for (const frame of index.keyframes) {
+      if (frame.ptsMs > offsetMs) break;
+      key = frame;
+    }
+    offsetMs = key.ptsMs;
+    keyframeOffset = key.offset;
+  } else {
+    offsetMs = Math.floor(offsetMs / 1000) * 1000;
+  }
+
   return {
     mode: 'history',
     requestedTs: ts,
     playbackUrl: target.url,
-    offsetSec,
+    offsetSec: offsetMs / 1000,
+    offsetMs,
+    keyframeOffset,
     segment: {
       id: target.id,
       startMs: target.startMs,
@@ -530,6 +604,38 @@ function getPlayback(streamKey, query = {}) {
   };
 }
 
+function getBitrate(streamKey, query = {}) {
+  const all = loadSegments(streamKey).segments;
+  const startMs = ensureNumber(query.start, all.length ? all[0].startMs : 0);
+  const endMs = ensureNumber(query.end, all.length ? all[all.length - 1].endMs : 0);
+
+  const points = [];
+  for (const seg of all) {
+    if (points.length >= MAX_BITRATE_POINTS) break;
+    if (!seg.indexPath || seg.endMs < startMs || seg.startMs > endMs) continue;
+    const index = readSegmentIndex(seg.indexPath);
+    if (!index) continue;
+    for (const gop of index.gops) {
+      const gopTs = seg.startMs + gop.ptsMs;
+      if (gopTs < startMs || gopTs > endMs || !gop.durationMs) continue;
+      points.push({
+        ts: gopTs,
+        durationMs: gop.durationMs,
+        bytes: gop.bytes,
+        kbps: Math.floor((gop.bytes * 8) / gop.durationMs),
+      });
+      if (points.length >= MAX_BITRATE_POINTS) break;
+    }
+  }
+
+  return {
+    startMs,
+    endMs,
+    points,
+    nowMs: Date.now(),
+  };
+}
+
 function getLatestThumbnail(streamKey) {
   const segments = loadSegments(streamKey).segments;
   if (!segments.length) return null;
@@ -546,5 +652,7 @@ module.exports = {
   getHistoryOverview,
   getTimeline,
   getPlayback,
+  getBitrate,
   getLatestThumbnail,
+  readSegmentIndex,
 };
@@ -17,6 +17,7 @@ const topicPrefixRaw = String(mqttCfg.topicPrefix || 'reallive/device');
 const topicPrefix = topicPrefixRaw.replace(/\/+$/, '');
 const commandQos = Math.max(0, Math.min(2, Number(mqttCfg.commandQos ?? 1)));
 const stateQos = Math.max(0, Math.min(2, Number(mqttCfg.stateQos ?? 0)));
+const eventQos = Math.max(0, Math.min(2, Number(mqttCfg.eventQos ?? 1)));
 const commandRetain = mqttCfg.commandRetain !== false;
 const stateStaleMs = Math.max(3000, Number(mqttCfg.stateStaleMs ?? 12000));
 
@@ -26,6 +27,7 @@ const stateByStream = new Map();
 const lastStatusByStream = new Map();
 let staleTimer = null;
 let stateEventEmitter = null;
+let detectionEventHandler = null;
 let seq = Date.now();
 
 function nowMs() {
@@ -45,6 +47,15 @@ function stateTopicWildcard() {
   return `${topicPrefix}/+/state`;
 }
 
+function eventTopicWildcard() {
+  return `${topicPrefix}/+/event`;
+}
+
+function topicStreamKey(topic) {
+  const parts = String(topic || '').split('/');
+  return parts.length >= 2 ? parts[parts.length - 2] : '';
+}
+
 function parseJsonSafe(payload) {
   if (!payload) return null;
   try {
@@ -153,6 +164,11 @@ function start() {
         console.log(`[MQTT Control] Connected ${brokerUrl}, subscribed ${stateTopicWildcard()}`);
       }
     });
+    client.subscribe(eventTopicWildcard(), { qos: eventQos }, (err) => {
+      if (err) {
+        console.error('[MQTT Control] subscribe event failed:', err.message);
+      }
+    });
   });
 
   client.on('reconnect', () => {
@@ -170,12 +186,17 @@ function start() {
   client.on('message', (topic, payloadBuf) => {
     const payload = payloadBuf ? payloadBuf.toString('utf8') : '';
     const parsed = parseJsonSafe(payload);
+    if (String(topic || '').endsWith('/event')) {
+      const streamKey = sanitizeToken(parsed?.stream_key || parsed?.streamKey || '') || topicStreamKey(topic);
+      if (parsed && streamKey && typeof detectionEventHandler === 'function') {
+        detectionEventHandler(streamKey, parsed);
+      }
+      return;
+    }
     const runtime = normalizeRuntimeState(parsed);
     if (!runtime) return;
     const payloadKey = sanitizeToken(parsed?.stream_key || parsed?.streamKey || '');
-    const parts = String(topic || '').split('/');
-    const topicKey = parts.length >= 2 ? parts[parts.length - 2] : '';
-    const streamKey = payloadKey || topicKey;
+    const streamKey = payloadKey || topicStreamKey(topic);
     if (!streamKey) return;
     stateByStream.set(streamKey, runtime);
     emitStateEvent(streamKey, runtime);
@@ -290,6 +311,10 @@ function setStateEventEmitter(fn) {
   stateEventEmitter = typeof fn === 'function' ? fn : null;
 }
 
+function setDetectionEventHandler(fn) {
+  detectionEventHandler = typeof fn === 'function' ? fn : null;
+}
+
 module.exports = {
   start,
   stop,
@@ -300,4 +325,5 @@ module.exports = {
   publishStorageQueryCommand,
   getDeviceState,
   setStateEventEmitter,
+  setDetectionEventHandler,
 };
@@ -6,10 +6,31 @@ const SEI_CACHE_STALE_MS = Math.max(1000, Number(process.env.SEI_CACHE_STALE_MS
 const EPOCH_MS_MIN = 946684800000;   // 2000-01-01
 const EPOCH_MS_MAX = 4102444800000;  // 2100-01-01
 
+// Legacy JSON telemetry ("RealLiveSeiMetric").
 const TELEMETRY_SEI_UUID = Buffer.from([
   0x52, 0x65, 0x61, 0x4c, 0x69, 0x76, 0x65, 0x53,
   0x65, 0x69, 0x4d, 0x65, 0x74, 0x72, 0x69, 0x63,
 ]);
+// Binary TLV telemetry ("RealLiveTelemTLV"), see pusher/include/core/TelemetrySei.h.
+const TELEMETRY_TLV_SEI_UUID = Buffer.from([
+  0x52, 0x65, 0x61, 0x6c, 0x4c, 0x69, 0x76, 0x65,
+  0x54, 0x65, 0x6c, 0x65, 0x6d, 0x54, 0x4c, 0x56,
+]);
+const TLV_VERSION = 1;
+const TLV_FLAG_KEY = 0x01;
+const TLV_TAG_DELTA = 0x80;
+const TLV_TAG = {
+  streamKey: 0x01,
+  camera: 0x02,
+  configurable: 0x03,
+  timestamp: 0x10,
+  device: 0x11,
+  detectSched: 0x12,
+  person: 0x13,
+  events: 0x20,
+};
+const TLV_DYNAMIC_TAGS = [TLV_TAG.timestamp, TLV_TAG.device, TLV_TAG.detectSched, TLV_TAG.person];
+const DETECT_SCHED_STATES = ['fixed', 'steady', 'backoff', 'boost', 'overload'];
 
 const monitors = new Map();
 const seiCache = new Map();
@@ -105,7 +126,239 @@ function normalizePersonEvent(event = {}, fallbackTs) {
   };
 }
 
-function extractSeiJson(rbsp) {
+class TlvReader {
+  constructor(buf) {
+    this.buf = buf;
+    this.pos = 0;
+  }
+
+  get done() {
+    return this.pos >= this.buf.length;
+  }
+
+  // Plain arithmetic instead of bit ops: values can exceed 32 bits (epoch ms).
+  varint() {
+    let value = 0;
+    let scale = 1;
+    while (this.pos < this.buf.length) {
+      const b = this.buf[this.pos];
+      this.pos += 1;
+      value += (b & 0x7f) * scale;
+      if ((b & 0x80) === 0) return value;
+      scale *= 128;
+    }
+    throw new Error('truncated varint');
+  }
+
+  zigzag() {
+    const n = this.varint();
+    return n % 2 === 0 ? n / 2 : -(n + 1) / 2;
+  }
+
+  string() {
+    const len = this.varint();
+    if (this.pos + len > this.buf.length) throw new Error('truncated string');
+    const text = this.buf.toString('utf8', this.pos, this.pos + len);
+    this.pos += len;
+    return text;
+  }
+
+  bytes(len) {
+    if (this.pos + len > this.buf.length) throw new Error('truncated record');
+    const out = this.buf.subarray(this.pos, this.pos + len);
+    this.pos += len;
+    return out;
+  }
+
+  zigzagList() {
+    const out = [];
+    while (!this.done) out.push(this.zigzag());
+    return out;
+  }
+}
+
+// Stateful decoder for one stream: dynamic records are deltas against the
+// previous message, so the decoder keeps the last absolute values per tag and
+// drops deltas after a sequence gap until the next key message. Returns
+// objects in the same shape as the legacy JSON payload.
+class TelemetryTlvDecoder {
+  constructor() {
+    this.reset();
+  }
+
+  reset() {
+    this.lastSeq = null;
+    this.dynamic = new Map();
+    this.streamKey = '';
+  }
+
+  decode(body) {
+    if (body.length < 3 || body[0] !== TLV_VERSION) return null;
+    const flags = body[1];
+    const reader = new TlvReader(body);
+    reader.pos = 2;
+    const seq = reader.varint();
+    const key = (flags & TLV_FLAG_KEY) !== 0;
+
+    const inSequence = this.lastSeq !== null && seq === this.lastSeq + 1;
+    this.lastSeq = seq;
+    if (key || !inSequence) {
+      this.dynamic.clear();
+    }
+
+    const out = {};
+    const events = [];
+    while (!reader.done) {
+      const tag = body[reader.pos];
+      reader.pos += 1;
+      const len = reader.varint();
+      const record = new TlvReader(reader.bytes(len));
+      const baseTag = tag & ~TLV_TAG_DELTA;
+
+      if (TLV_DYNAMIC_TAGS.includes(baseTag)) {
+        const values = record.zigzagList();
+        if (tag & TLV_TAG_DELTA) {
+          const prev = this.dynamic.get(baseTag);
+          if (!prev || prev.length !== values.length) continue;
+          this.dynamic.set(baseTag, values.map((delta, i) => prev[i] + delta));
+        } else {
+          this.dynamic.set(baseTag, values);
+        }
+        continue;
+      }
+
+      switch (tag) {
+        case TLV_TAG.streamKey:
+          this.streamKey = record.buf.toString('utf8');
+          break;
+        case TLV_TAG.camera:
+          out.camera = decodeTlvCamera(record);
+          break;
+        case TLV_TAG.configurable:
+          out.configurable = decodeTlvConfigurable(record);
+          break;
+        case TLV_TAG.events:
+          events.push(...decodeTlvEvents(record));
+          break;
+        default:
+          break; // unknown record, skip
+      }
+    }
+
+    const ts = this.dynamic.get(TLV_TAG.timestamp);
+    if (!ts) return null;
+    out.v = 2;
+    out.ts = ts[0];
+    if (this.streamKey) out.stream_key = this.streamKey;
+
+    const device = this.dynamic.get(TLV_TAG.device);
+    if (device && device.length >= 7) {
+      out.device = {
+        cpu_pct: device[0] / 10,
+        mem_pct: device[1] / 10,
+        mem_used_mb: device[2] / 10,
+        mem_total_mb: device[3] / 10,
+        storage_pct: device[4] / 10,
+        storage_used_gb: device[5] / 100,
+        storage_total_gb: device[6] / 100,
+        cpu_core_pct: device.slice(7).map((v) => v / 10),
+      };
+    }
+
+    const sched = this.dynamic.get(TLV_TAG.detectSched);
+    if (sched && sched.length >= 10) {
+      out.detect_sched = {
+        adaptive: sched[0] !== 0,
+        state: DETECT_SCHED_STATES[sched[1]] || 'unknown',
+        interval_frames: sched[2],
+        infer_interval_ms: sched[3],
+        tiles: sched[4],
+        encode_avg_ms: sched[5] / 100,
+        encode_max_ms: sched[6] / 100,
+        detect_avg_ms: sched[7] / 100,
+        infer_avg_ms: sched[8] / 100,
+        skipped_frames: sched[9],
+      };
+    }
+
+    const person = this.dynamic.get(TLV_TAG.person);
+    if (person && person.length >= 7) {
+      out.person = {
+        active: person[0] !== 0,
+        score: person[1] / 1000,
+        ts: person[2],
+        bbox: { x: person[3], y: person[4], w: person[5], h: person[6] },
+      };
+    }
+
+    out.events = events.map((evt) => ({ ...evt, ts: out.ts + evt.ts }));
+    return out;
+  }
+}
+
+function decodeTlvCamera(record) {
+  const pixelFormat = record.string();
+  const codec = record.string();
+  const profile = record.string();
+  const v = record.zigzagList();
+  return {
+    width: v[0],
+    height: v[1],
+    fps: v[2],
+    pixel_format: pixelFormat,
+    codec,
+    bitrate: v[3],
+    profile,
+    gop: v[4],
+    audio_enabled: v[5] !== 0,
+    detect_tflite_enabled: v[6] !== 0,
+    detect_infer_on_motion_only: v[7] !== 0,
+    detect_person_score_threshold: (v[8] || 0) / 100,
+  };
+}
+
+function decodeTlvConfigurable(record) {
+  const resolution = [];
+  for (let n = record.varint(); n > 0; n -= 1) {
+    resolution.push({ width: record.varint(), height: record.varint() });
+  }
+  const fps = [];
+  for (let n = record.varint(); n > 0; n -= 1) fps.push(record.varint());
+  const profile = [];
+  for (let n = record.varint(); n > 0; n -= 1) profile.push(record.string());
+  const range = (scale = 1) => {
+    const min = record.varint();
+    const max = record.varint();
+    const step = record.varint();
+    return { min: min / scale, max: max / scale, step: step / scale };
+  };
+  return {
+    resolution,
+    fps,
+    profile,
+    bitrate: range(),
+    gop: range(),
+    person_score_threshold: range(100),
+    detect_infer_interval_ms: range(),
+  };
+}
+
+// Event timestamps are relative to the message timestamp.
+function decodeTlvEvents(record) {
+  const v = record.zigzagList();
+  const events = [];
+  for (let i = 0; i + 6 <= v.length; i += 6) {
+    events.push({
+      type: 'person_detected',
+      ts: v[i],
+      score: v[i + 1] / 1000,
+      bbox: { x: v[i + 2], y: v[i + 3], w: v[i + 4], h: v[i + 5] },
+    });
+  }
+  return events;
+}
+
+function extractSeiJson(rbsp, tlvDecoder) {
   let offset = 0;
   while (offset < rbsp.length) {
     if (offset === rbsp.length - 1 && rbsp[offset] === 0x80) {
@@ -139,6 +392,16 @@ function extractSeiJson(rbsp) {
     }
 
     const uuid = payload.subarray(0, 16);
+    if (uuid.equals(TELEMETRY_TLV_SEI_UUID)) {
+      if (!tlvDecoder || payload.length < 19) continue;
+      try {
+        const decoded = tlvDecoder.decode(payload.subarray(16));
+        if (decoded) return decoded;
+      } catch {
+        tlvDecoder.reset();
+      }
+      continue;
+    }
     if (!uuid.equals(TELEMETRY_SEI_UUID)) {
       continue;
     }
@@ -182,12 +445,12 @@ function findStartCode(data, from) {
   return null;
 }
 
-function parseNaluForSei(nalu) {
+function parseNaluForSei(nalu, tlvDecoder) {
   if (!nalu || nalu.length < 2) return null;
   const nalType = nalu[0] & 0x1f;
   if (nalType !== 6) return null;
   const rbsp = ebspToRbsp(nalu.subarray(1));
-  return extractSeiJson(rbsp);
+  return extractSeiJson(rbsp, tlvDecoder);
 }
 
 class FlvSeiParser {
@@ -196,6 +459,7 @@ class FlvSeiParser {
     this.buffer = Buffer.alloc(0);
     this.headerParsed = false;
     this.naluLengthSize = 4;
+    this.tlvDecoder = new TelemetryTlvDecoder();
   }
 
   push(chunk) {
@@ -294,7 +558,7 @@ class FlvSeiParser {
       }
       foundAny = true;
       const nalu = payload.subarray(offset, offset + naluSize);
-      const sei = parseNaluForSei(nalu);
+      const sei = parseNaluForSei(nalu, this.tlvDecoder);
       if (sei) this.onSeiJson(sei);
       offset += naluSize;
     }
@@ -311,7 +575,7 @@ class FlvSeiParser {
       const naluEnd = next ? next.index : payload.length;
       if (naluEnd > naluStart) {
         const nalu = payload.subarray(naluStart, naluEnd);
-        const sei = parseNaluForSei(nalu);
+        const sei = parseNaluForSei(nalu, this.tlvDecoder);
         if (sei) this.onSeiJson(sei);
       }
       if (!next) break;
@@ -415,6 +679,17 @@ function updateSeiCache(streamKey, payload) {
   seiCache.set(cacheKey, item);
 }
 
+// Detection events published by the device over MQTT. They share the SEI
+// event cache, so an event seen on both paths is only emitted once.
+function ingestDetectionEvent(streamKey, event) {
+  if (!event || typeof event !== 'object') return;
+  updateSeiCache(streamKey, {
+    stream_key: event.stream_key || streamKey,
+    ts: event.ts,
+    events: [event],
+  });
+}
+
 async function runMonitorLoop(streamKey, state) {
   const app = state.app || 'live';
   const url = `${FLV_BASE_URL}/${encodeURIComponent(app)}/${encodeURIComponent(streamKey)}.flv`;
@@ -522,5 +797,8 @@ module.exports = {
   stopSeiMonitor,
   stopAllSeiMonitors,
   setSeiEventEmitter,
+  ingestDetectionEvent,
   getSeiInfo,
+  TelemetryTlvDecoder,
+  parseNaluForSei,
 };
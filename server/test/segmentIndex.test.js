@@ -0,0 +1,83 @@
+/**
+ * Segment index sidecar tests
+ *
+ * Reads .idx files laid out like the pusher's SegmentIndex writes them,
+ * including keyframes past 4 GiB.
+ */
+
+const { describe, it, before, after } = require('node:test');
+const assert = require('node:assert/strict');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const { readSegmentIndex } = require('../src/services/historyService');
+
+function header(version, frameCount, gopCount) {
+  const buf = Buffer.alloc(16);
+  buf.write('RLIX', 0, 'latin1');
+  buf[4] = version;
+  buf.writeUInt32LE(frameCount, 8);
+  buf.writeUInt32LE(gopCount, 12);
+  return buf;
+}
+
+function gop(ptsMs, firstFrame, bytes, durationMs) {
+  const buf = Buffer.alloc(16);
+  buf.writeUInt32LE(ptsMs, 0);
+  buf.writeUInt32LE(firstFrame, 4);
+  buf.writeUInt32LE(bytes, 8);
+  buf.writeUInt32LE(durationMs, 12);
+  return buf;
+}
+
+describe('readSegmentIndex', () => {
+  let dir;
+
+  before(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'reallive-idx-'));
+  });
+
+  after(() => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('reads 64-bit keyframe offsets', () => {
+    const frames = [
+      [0, 48, 1000, true],
+      [33, 1048, 200, false],
+      [1000, 5 * 1024 * 1024 * 1024 + 7, 900, true],
+    ].map(([ptsMs, offset, size, key]) => {
+      const buf = Buffer.alloc(16);
+      buf.writeUInt32LE(ptsMs, 0);
+      buf.writeBigUInt64LE(BigInt(offset), 4);
+      buf.writeUInt32LE((size | (key ? 0x80000000 : 0)) >>> 0, 12);
+      return buf;
+    });
+    const file = path.join(dir, 'segment.idx');
+    fs.writeFileSync(file, Buffer.concat([
+      header(1, 3, 2), ...frames, gop(0, 0, 1200, 1000), gop(1000, 2, 900, 0),
+    ]));
+
+    const index = readSegmentIndex(file);
+    assert.ok(index);
+    assert.deepEqual(index.keyframes, [
+      { ptsMs: 0, offset: 48, size: 1000 },
+      { ptsMs: 1000, offset: 5 * 1024 * 1024 * 1024 + 7, size: 900 },
+    ]);
+    assert.deepEqual(index.gops, [
+      { ptsMs: 0, bytes: 1200, durationMs: 1000 },
+      { ptsMs: 1000, bytes: 900, durationMs: 0 },
+    ]);
+  });
+
+  it('rejects truncated and unknown files', () => {
+    const truncated = path.join(dir, 'short.idx');
+    fs.writeFileSync(truncated, header(1, 4, 0));
+    assert.equal(readSegmentIndex(truncated), null);
+
+    const future = path.join(dir, 'v9.idx');
+    fs.writeFileSync(future, header(9, 0, 0));
+    assert.equal(readSegmentIndex(future), null);
+  });
+});
@@ -0,0 +1,91 @@
+/**
+ * Telemetry SEI decoder tests
+ *
+ * Feeds the SEI NAL units written by the pusher's TelemetrySeiEncoder
+ * (fixtures/telemetry_sei.h264, regenerated by the pusher test
+ * TelemetrySeiTest.FixtureMatchesEncoder) through the TLV decoder.
+ */
+
+const { describe, it } = require('node:test');
+const assert = require('node:assert/strict');
+const fs = require('fs');
+const path = require('path');
+
+const { TelemetryTlvDecoder, parseNaluForSei } = require('../src/services/seiMonitor');
+
+const TS_MS = 1700000000123;
+
+// Splits an Annex-B stream into NAL units without their start codes.
+function splitNalus(data) {
+  const starts = [];
+  for (let i = 0; i + 3 < data.length; i += 1) {
+    if (data[i] === 0x00 && data[i + 1] === 0x00 && data[i + 2] === 0x00 && data[i + 3] === 0x01) {
+      starts.push(i);
+      i += 3;
+    }
+  }
+  return starts.map((start, n) => data.subarray(start + 4, n + 1 < starts.length ? starts[n + 1] : data.length));
+}
+
+const nalus = splitNalus(fs.readFileSync(path.join(__dirname, 'fixtures', 'telemetry_sei.h264')));
+
+describe('TelemetryTlvDecoder', () => {
+  it('decodes the key message', () => {
+    assert.equal(nalus.length, 4);
+    const msg = parseNaluForSei(nalus[0], new TelemetryTlvDecoder());
+    assert.equal(msg.ts, TS_MS);
+    assert.equal(msg.stream_key, 'cam-1');
+    assert.equal(msg.camera.pixel_format, 'NV12');
+    assert.equal(msg.camera.width, 1280);
+    assert.equal(msg.camera.height, 720);
+    assert.equal(msg.device.cpu_pct, 37.4);
+    assert.deepEqual(msg.device.cpu_core_pct, [40.1, 34.7]);
+    assert.equal(msg.device.storage_total_gb, 58.99);
+    assert.equal(msg.detect_sched.state, 'steady');
+    assert.equal(msg.detect_sched.skipped_frames, 4);
+    assert.deepEqual(msg.person, {
+      active: true,
+      score: 0.812,
+      ts: TS_MS - 40,
+      bbox: { x: 100, y: 50, w: 64, h: 128 },
+    });
+    assert.deepEqual(msg.events, []);
+  });
+
+  it('applies deltas and events in sequence', () => {
+    const decoder = new TelemetryTlvDecoder();
+    const msgs = nalus.map((nalu) => parseNaluForSei(nalu, decoder));
+
+    assert.equal(msgs[1].ts, TS_MS + 1000);
+    assert.equal(msgs[1].stream_key, 'cam-1');
+    assert.equal(msgs[1].device.cpu_pct, 35);
+    assert.deepEqual(msgs[1].device.cpu_core_pct, [40.1, 40]);
+    assert.equal(msgs[1].person.score, 0.812);
+
+    assert.equal(msgs[2].ts, TS_MS + 2000);
+    assert.equal(msgs[2].events.length, 1);
+    assert.equal(msgs[2].events[0].ts, TS_MS + 2000 - 250);
+    assert.equal(msgs[2].events[0].score, 0.9);
+    assert.deepEqual(msgs[2].events[0].bbox, { x: 10, y: 20, w: 30, h: 40 });
+
+    assert.equal(msgs[3].ts, TS_MS + 3000);
+    assert.deepEqual(msgs[3].events, []);
+  });
+
+  it('drops deltas when joining mid-stream', () => {
+    const msg = parseNaluForSei(nalus[1], new TelemetryTlvDecoder());
+    assert.equal(msg.ts, TS_MS + 1000);
+    assert.equal(msg.device, undefined);
+    assert.equal(msg.person, undefined);
+  });
+
+  it('decodes fully from a segment-start key message', () => {
+    const msg = parseNaluForSei(nalus[3], new TelemetryTlvDecoder());
+    assert.equal(msg.ts, TS_MS + 3000);
+    assert.equal(msg.stream_key, 'cam-1');
+    assert.equal(msg.camera.width, 1280);
+    assert.equal(msg.device.cpu_pct, 35);
+    assert.deepEqual(msg.device.cpu_core_pct, [40.1, 40]);
+    assert.equal(msg.person.active, true);
+  });
+});